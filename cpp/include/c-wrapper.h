@@ -59,6 +59,8 @@ extern "C" {
                                            int width, int height);
     typedef void (*FrameFetched) (const cFrameInfo finfo, int width, int height, 
                                   const unsigned char* buffer);
+    typedef void (*RangeFetched) (const char* threadPrefix, int nFrames);
+    typedef void (*FrameReleased) (const unsigned char* yBuffer);
 
 	// params
 	//	base prefix
@@ -94,6 +96,19 @@ extern "C" {
 			const unsigned char* uBuffer,
 			const unsigned char* vBuffer);
 
+	// same as above, but frame planes are not copied: they must stay valid
+	// until frameReleased is called with yBuffer of this frame
+	int ndnrtc_LocalVideoStream_incomingI420FrameNoCopy(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			FrameReleased frameReleased);
+
 	int ndnrtc_LocalVideoStream_incomingNV21Frame(ndnrtc::LocalVideoStream *stream,
 			const unsigned int width,
 			const unsigned int height,
@@ -133,6 +148,19 @@ extern "C" {
                                    const char* frameName, 
                                    BufferAlloc bufferAllocFunc,
                                    FrameFetched frameFetchedFunc);
+
+    // fetch Delta frames start, start+stride, ... up to end (inclusive) of the
+    // stream's thread from local storage of the local stream; frames are
+    // returned in order through frameFetchedFunc (a call with null buffer
+    // reports failure and stops fetching), rangeFetchedFunc is called once
+    // all frames were returned
+    void ndnrtc_FrameFetcher_fetchRange(ndnrtc::IStream *stream,
+                                        const char* threadName,
+                                        unsigned int start, unsigned int end,
+                                        unsigned int stride,
+                                        BufferAlloc bufferAllocFunc,
+                                        FrameFetched frameFetchedFunc,
+                                        RangeFetched rangeFetchedFunc);
 }
 
 #endif
\ No newline at end of file
@@ -40,6 +40,8 @@ namespace ndnrtc {
                                  int width, int height, const uint8_t* buffer)> OnFrameFetched;
     typedef boost::function<void(const boost::shared_ptr<IFrameFetcher>&,
                                  std::string reason)> OnFetchFailure;
+    typedef boost::function<void(const boost::shared_ptr<IFrameFetcher>&,
+                                 int nFramesFetched)> OnRangeFetched;
 
     class IFrameFetcher {
     public:
@@ -47,6 +49,13 @@ namespace ndnrtc {
                            OnBufferAllocate onBufferAllocate,
                            OnFrameFetched onFrameFetched,
                            OnFetchFailure onFetchFailure) = 0;
+        virtual void fetchRange(const ndn::Name& threadPrefix,
+                                PacketNumber start, PacketNumber end,
+                                unsigned int stride,
+                                OnBufferAllocate onBufferAllocate,
+                                OnFrameFetched onFrameFetched,
+                                OnRangeFetched onRangeFetched,
+                                OnFetchFailure onFetchFailure) = 0;
         virtual const ndn::Name& getName() const = 0;
         virtual ~IFrameFetcher(){}
     };
@@ -65,6 +74,12 @@ namespace ndnrtc {
      * frames and 1 key frame must be fetched before decoding of #20 can be 
      * started.
      * If requested frame is a Key frame, no additional frames will be fetched.
+     * Frames of the GOP are fetched concurrently (up to Settings::window_
+     * frames ahead of the decoder) and decoded in order as soon as each one
+     * is complete. Decoder state is kept for the last Settings::nCachedGops_
+     * GOPs, so fetching a later frame of the same GOP continues decoding from
+     * the last decoded frame and seeking back within a GOP does not refetch
+     * its Key frame.
      */
     class FrameFetcher : public IFrameFetcher,
                          public ndnlog::new_api::ILoggingObject {
@@ -77,6 +92,13 @@ namespace ndnrtc {
             Completed
         };
 
+        typedef struct _Settings {
+            // maximum number of GOP frames fetched ahead of the decoder
+            unsigned int window_;
+            // number of GOPs to keep decoder state for
+            unsigned int nCachedGops_;
+        } Settings;
+
         /**
          * Fetches frames from local persistent storage.
          */
@@ -106,6 +128,31 @@ namespace ndnrtc {
                    OnFrameFetched onFrameFetched,
                    OnFetchFailure onFetchFailure);
 
+        /**
+         * Fetches Delta frames start, start+stride, ... up to end (inclusive)
+         * of the thread and returns them one by one, in order, through
+         * onFrameFetched. Frames are decoded sequentially, so each GOP is
+         * fetched once regardless of the number of frames taken from it
+         * (frames skipped by stride are fetched and decoded, but not
+         * returned).
+         * @param threadPrefix Thread prefix (<stream prefix>/<thread>)
+         * @param start First Delta frame sequence number
+         * @param end Last Delta frame sequence number
+         * @param stride Distance between returned frames
+         * @param onBufferAllocate Called for each returned frame
+         * @param onFrameFetched Called for each returned frame
+         * @param onRangeFetched Called once all frames were returned
+         * @param onFetchFailure Called if any frame of the range couldn't be
+         *  fetched; fetching of the range stops
+         */
+        void fetchRange(const ndn::Name& threadPrefix,
+                        PacketNumber start, PacketNumber end,
+                        unsigned int stride,
+                        OnBufferAllocate onBufferAllocate,
+                        OnFrameFetched onFrameFetched,
+                        OnRangeFetched onRangeFetched,
+                        OnFetchFailure onFetchFailure);
+
         /**
          * Returns name of a frame that is currently being fetched.
          */
@@ -116,6 +163,9 @@ namespace ndnrtc {
          */
         State getState() const;
 
+        void setSettings(const Settings& settings);
+        const Settings& getSettings() const;
+
         void setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger);
 
     private:
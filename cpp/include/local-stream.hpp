@@ -13,6 +13,7 @@
 #include "stream.hpp"
 
 #include <boost/asio.hpp>
+#include <boost/function.hpp>
 
 namespace ndn {
 	class KeyChain;
@@ -35,10 +36,27 @@ namespace ndnrtc {
 	{
 	public:
         MediaStreamSettings(boost::asio::io_service& faceIo,
-			const MediaStreamParams& params):sign_(true), faceIo_(faceIo), params_(params){}
+			const MediaStreamParams& params):sign_(true), signManifestsOnly_(true),
+            signingThreads_(0), cascadedScaling_(false), publishQueueSize_(3),
+            faceIo_(faceIo), params_(params){}
 		~MediaStreamSettings(){}
 
         bool sign_;
+        // video only: sign frame manifests with the key chain and give frame
+        // segments DigestSha256 signatures instead
+        bool signManifestsOnly_;
+        // number of threads signing segments of a frame in parallel;
+        // 0 - segments are signed by the publishing thread (face thread,
+        // or signing stage for video segments with digest signatures)
+        unsigned int signingThreads_;
+        // video only: scale each thread from the frame scaled for the next
+        // larger thread (e.g. 1080p->720p->360p) instead of the captured one
+        bool cascadedScaling_;
+        // video only: max number of captured frames in flight between FEC,
+        // segment/sign and cache insert stages (encoded frames of all threads
+        // of one captured frame count as one); encoders wait for the
+        // pipeline once it is full and captured frames are dropped instead
+        unsigned int publishQueueSize_;
 		boost::asio::io_service& faceIo_;
 		ndn::KeyChain* keyChain_;
 		ndn::Face* face_;
@@ -134,8 +152,14 @@ namespace ndnrtc {
 	 *  - adding/removing threads called on main or capture thread
 	 *  - incomingArgbFrame/incomingI420Frame called on capture thread
 	 *  - setLogger/getThreads/getPrefix called on main or capture thread
-	 * Consequently, LocalVideoStream ensures that any access to Face/KeyChain is 
-	 * performed on the face thread.
+	 * Consequently, LocalVideoStream ensures that any access to Face/memory 
+	 * cache is performed on the face thread. Each video thread encodes frames 
+	 * on its own worker thread; if encoder can't keep up with capture rate, the
+	 * oldest frame waiting for the encoder is dropped. Encoded frames are 
+	 * published by a pipeline of stages, each working on a different frame:
+	 * FEC (own thread), segmenting and PIT matching (face thread), signing
+	 * (own thread, KeyChain access is serialized) and cache insert (face 
+	 * thread).
 	 */
 	class LocalVideoStream : public IStream, public IExternalCapturer
 	{
@@ -173,7 +197,8 @@ namespace ndnrtc {
 		 * publishes encoded data according to NDN-RTC namespace. 
 		 * Call is asynchronous: returns immediately. Publishing is performed
 		 * on Face thread to avoid data races.
-		 * @return playback number of a frame, if is was published, -1 if it wasn't
+		 * @return playback number of the last published frame, if this frame was
+		 *         queued for encoding, -1 if it wasn't
 		 */
 		int incomingArgbFrame(const unsigned int width,
 			const unsigned int height,
@@ -186,7 +211,8 @@ namespace ndnrtc {
 		 * publishes encoded data according to NDN-RTC namespace. 
 		 * Call is asynchronous: returns immediately. Publishing is performed
 		 * on Face thread to avoid data races.
-		 * @return playback number of a frame, if is was published, -1 if it wasn't
+		 * @return playback number of the last published frame, if this frame was
+		 *         queued for encoding, -1 if it wasn't
 		 */
 		int incomingBgraFrame(const unsigned int width,
 			const unsigned int height,
@@ -209,6 +235,27 @@ namespace ndnrtc {
 			const unsigned char* uBuffer,
 			const unsigned char* vBuffer) override;
 
+		/**
+		 * Encode and publish I420 frame data without copying it.
+		 * Frame planes are handed over to encoders as they are, so the caller
+		 * keeps ownership of them and must keep them valid and unchanged until
+		 * onReleased is called. onReleased is called exactly once, after the
+		 * last encoder is done with the frame. It may be called on capture
+		 * thread (even before this call returns, e.g. if frame is dropped) or
+		 * on an encoder thread, so it must not block.
+		 * @return playback number of the last published frame, if this frame
+		 *         was queued for encoding, -1 if it wasn't
+		 */
+		int incomingI420Frame(const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			boost::function<void(void)> onReleased);
+
 		/**
 		 * Encode and publish NV21 frame data.
 		 * This initiates encoding of raw frames for each video thread and
@@ -224,9 +271,10 @@ namespace ndnrtc {
 			const unsigned char* uvBuffer) override;
 
         /**
-         * Returns information about last published frames, per thread. 
+         * Returns information about last published frames, per thread.
+         * Frames are published on encoder threads, so a copy is returned.
          */
-        const std::map<std::string, FrameInfo>& getLastPublishedInfo() const;
+        std::map<std::string, FrameInfo> getLastPublishedInfo() const;
 
 		/**
 		 * Returns full stream prefix used for publishing data
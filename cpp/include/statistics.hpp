@@ -46,6 +46,7 @@ namespace ndnrtc {
                 CurrentProducerFramerate,       // BufferControl
                 VerifySuccess,                  // SampleValidator
                 VerifyFailure,                  // SampleValidator
+                VerifyLatency,                  // ManifestValidator
                 LatencyControlStable,           // LatencyControl
                 LatencyControlCommand,          // LatencyControl
                 FrameFetchAvgDelta,             // Buffer
@@ -100,6 +101,20 @@ namespace ndnrtc {
                 PublishedKeyNum,
                 InterestsReceivedNum,
                 SignNum,
+                FecCoderCacheHitNum,            // VideoStreamImpl
+                FecCoderCacheMissNum,           // VideoStreamImpl
+                ParityPoolHitNum,               // VideoStreamImpl
+                ParityPoolMissNum,              // VideoStreamImpl
+                PublishLatency,                 // VideoStreamImpl
+                CaptureLatency,                 // VideoStreamImpl
+                EncodeLatency,                  // VideoStreamImpl
+                EncodeLatencyP95,               // VideoStreamImpl
+                FecLatency,                     // VideoStreamImpl
+                FecLatencyP95,                  // VideoStreamImpl
+                SignLatency,                    // VideoStreamImpl
+                SignLatencyP95,                 // VideoStreamImpl
+                CacheLatency,                   // VideoStreamImpl
+                CacheLatencyP95,                // VideoStreamImpl
                 
                 // encoder
                 // DroppedNum, // borrowed from buffer (above)
@@ -12,6 +12,8 @@
 #include <boost/asio.hpp>
 #include <boost/function.hpp>
 #include <ndn-cpp/name.hpp>
+#include <vector>
+#include <stdint.h>
 
 namespace ndn {
     class Data;
@@ -26,9 +28,54 @@ namespace ndnrtc {
      */
     class StorageEngine {
     public:
+        /**
+         * Controls how data packets are written into the storage.
+         * By default, every packet is written with a separate write call.
+         * In batch mode, packets are accumulated in a write batch which is
+         * committed when a frame is stored (see put(segments)), when batch
+         * reaches batchSize_ packets or when the oldest packet in the batch
+         * is older than batchBudgetMs_ (checked upon each put). Packets that
+         * are in the batch are not visible to get() and read() until the
+         * batch is flushed.
+         */
+        typedef struct _WriteSettings {
+            _WriteSettings():batch_(false), flushOnFrame_(true), batchSize_(0),
+                batchBudgetMs_(0), sync_(false), disableWal_(false){}
+
+            bool batch_;
+            bool flushOnFrame_;         // flush batch on every put(segments)
+            size_t batchSize_;          // 0 - no limit
+            unsigned int batchBudgetMs_;// 0 - no limit
+            bool sync_;                 // fsync every write
+            bool disableWal_;           // skip write-ahead log (RocksDB only)
+        } WriteSettings;
+
+        typedef struct _CacheStats {
+            uint64_t hits_, misses_, evictions_;
+            size_t nEntries_, sizeBytes_;
+        } CacheStats;
+
         StorageEngine(std::string dpPath, bool readOnly = false);
         ~StorageEngine();
 
+        /**
+         * Sets write settings. Accumulated batch is flushed first.
+         * Should be called before packets are written from other threads.
+         */
+        void setWriteSettings(const WriteSettings& settings);
+        const WriteSettings& getWriteSettings() const;
+
+        /**
+         * Enables in-memory LRU cache of decoded data packets used by get()
+         * and read(). Cache is split into shards with separate locks.
+         * Should be called before reading from other threads.
+         * @param capacityBytes Maximum total size of cached packets; 0
+         *                      disables cache
+         * @param nShards Number of shards
+         */
+        void setCacheSize(size_t capacityBytes, unsigned int nShards = 16);
+        CacheStats getCacheStats() const;
+
         /**
          * Puts new data packet into the storage.
          * Data is saved asynchronously, so the call returns immediately.
@@ -37,9 +84,22 @@ namespace ndnrtc {
         void put(const boost::shared_ptr<const ndn::Data>& data);
         void put(const ndn::Data& data);
 
+        /**
+         * Puts all segments of a frame into the storage with one write.
+         * In batch mode, segments are added to the current batch, which is
+         * flushed afterwards if flushOnFrame_ is set.
+         * The call is thread-safe.
+         */
+        void put(const std::vector<boost::shared_ptr<const ndn::Data>>& segments);
+
+        /**
+         * Writes accumulated batch (if any) into the storage.
+         */
+        void flush();
+
         /**
          * Tries to retrieve data from persistent storage. 
-         * The call is synchronous. 
+         * The call is synchronous and thread-safe. 
          * If data is not present in the persistent storage, returned pointer
          * is invalid.
          */
@@ -48,7 +108,16 @@ namespace ndnrtc {
         /**
          * Tries to retrieve data from persistent storage according to the 
          * interest received. 
-         * The call is synchronous. 
+         * If interest can be prefix, returns the last (rightmost) key under
+         * interest name or the first one if ChildSelector is 0, that satisfies
+         * Min/MaxSuffixComponents (counted without implicit digest).
+         * Children are ordered as DB keys, which differs between key formats
+         * (see hasBinaryKeys()): with binary keys, generic components (e.g.
+         * "_parity", "_manifest") sort before numeric ones (segments,
+         * sequence numbers), which are ordered by value; with name URI keys,
+         * children are ordered by their URI, so "_parity" sorts after
+         * segments and numbers are compared as strings.
+         * The call is synchronous and thread-safe.
          * If data is not present in the persistent storage, returned pointer
          * is invalid.
          */
@@ -64,6 +133,32 @@ namespace ndnrtc {
         void scanForLongestPrefixes(boost::asio::io_service& io, 
             boost::function<void(const std::vector<ndn::Name>&)> onCompleted);
 
+        /**
+         * Calls onName for names of all data packets in the storage, in key
+         * order, until it returns false. The call is synchronous.
+         */
+        void scanNames(boost::function<bool(const ndn::Name&)> onName);
+
+        /**
+         * Returns true if storage keys are binary-encoded names (see
+         * StorageKey). DBs created before binary keys were introduced are
+         * keyed by name URIs; they are still readable and can be converted
+         * with migrate().
+         */
+        bool hasBinaryKeys() const;
+
+        /**
+         * Copies all records of a DB keyed by name URIs into a new DB with
+         * binary keys.
+         * @param legacyDbPath Path to existing DB with name URI keys
+         * @param dbPath Path to new DB; must not exist or be empty
+         * @param onProgress Called periodically with number of copied keys
+         * @return Total number of copied keys
+         */
+        static size_t migrate(const std::string& legacyDbPath,
+                              const std::string& dbPath,
+                              boost::function<void(size_t)> onProgress = boost::function<void(size_t)>());
+
         /**
          * Returns approximate storage payload (all the values) size in bytes.
          */
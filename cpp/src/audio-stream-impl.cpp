@@ -196,8 +196,15 @@ void AudioStreamImpl::onSampleBundle(std::string threadName, uint64_t bundleNo,
             packetHdr.publishUnixTimestamp_ = clock::unixTimestamp();
             bundle->setHeader(packetHdr);
 
-            me->samplePublisher_->publish(n, *bundle);
-            (*statStorage_)[Indicator::PublishedNum]++;
+            try
+            {
+                me->samplePublisher_->publish(n, *bundle);
+                (*statStorage_)[Indicator::PublishedNum]++;
+            }
+            catch (std::exception &e)
+            {
+                LogErrorC << "dropped audio bundle " << n << ": " << e.what() << std::endl;
+            }
 
             {
                 boost::lock_guard<boost::mutex> scopedLock(me->internalMutex_);
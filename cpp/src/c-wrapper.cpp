@@ -269,6 +269,50 @@ void ndnrtc_FrameFetcher_fetch(ndnrtc::IStream *stream,
               });
 }
 
+void ndnrtc_FrameFetcher_fetchRange(ndnrtc::IStream *stream,
+                                    const char* threadName,
+                                    unsigned int start, unsigned int end,
+                                    unsigned int stride,
+                                    BufferAlloc bufferAllocFunc,
+                                    FrameFetched frameFetchedFunc,
+                                    RangeFetched rangeFetchedFunc)
+{
+    boost::shared_ptr<StorageEngine> storage = ((LocalVideoStream*)stream)->getStorage();
+    boost::shared_ptr<FrameFetcher> ff = boost::make_shared<FrameFetcher>(storage);
+    Name threadPrefix(stream->getPrefix());
+    threadPrefix.append(std::string(threadName));
+
+    std::string fkey(threadPrefix.toUri());
+    FrameFetchers[fkey] = ff;
+
+    ((LocalVideoStream*)stream)->getLogger()->log(ndnlog::NdnLoggerLevelInfo) << "Setting up frame-fetcher for range "
+        << start << "-" << end << " of " << fkey << std::endl;
+
+    ff->setLogger(((LocalVideoStream*)stream)->getLogger());
+    ff->fetchRange(threadPrefix, start, end, stride,
+              [bufferAllocFunc](const boost::shared_ptr<IFrameFetcher>& fetcher, 
+                                int width, int height)->uint8_t*
+              {
+                  return bufferAllocFunc(fetcher->getName().toUri().c_str(), width, height);
+              },
+              [frameFetchedFunc](const boost::shared_ptr<IFrameFetcher>& fetcher, 
+                 const FrameInfo fi, int nFetchedFrames,
+                 int width, int height, const uint8_t* buffer){
+                    cFrameInfo frameInfo({fi.timestamp_, fi.playbackNo_, (char*)fi.ndnName_.c_str()});
+                    frameFetchedFunc(frameInfo, width, height, buffer);
+              },
+              [fkey, rangeFetchedFunc](const boost::shared_ptr<IFrameFetcher>& fetcher, int nFrames){
+                    rangeFetchedFunc(fkey.c_str(), nFrames);
+                    FrameFetchers.erase(fkey);
+              },
+              [fkey, frameFetchedFunc](const boost::shared_ptr<IFrameFetcher>& ff, std::string reason){
+                    std::string frameName = ff->getName().toUri();
+                    cFrameInfo frameInfo({0,0,(char*)frameName.c_str()});
+                    frameFetchedFunc(frameInfo, 0, 0, nullptr);
+                    FrameFetchers.erase(fkey);
+              });
+}
+
 int ndnrtc_LocalVideoStream_incomingI420Frame(ndnrtc::LocalVideoStream *stream,
 			const unsigned int width,
 			const unsigned int height,
@@ -284,6 +328,27 @@ int ndnrtc_LocalVideoStream_incomingI420Frame(ndnrtc::LocalVideoStream *stream,
 	return -1;
 }
 
+int ndnrtc_LocalVideoStream_incomingI420FrameNoCopy(ndnrtc::LocalVideoStream *stream,
+			const unsigned int width,
+			const unsigned int height,
+			const unsigned int strideY,
+			const unsigned int strideU,
+			const unsigned int strideV,
+			const unsigned char* yBuffer,
+			const unsigned char* uBuffer,
+			const unsigned char* vBuffer,
+			FrameReleased frameReleased)
+{
+	if (stream)
+		return stream->incomingI420Frame(width, height, strideY, strideU, strideV, yBuffer, uBuffer, vBuffer,
+			[yBuffer, frameReleased](){
+				if (frameReleased) frameReleased(yBuffer);
+			});
+
+	if (frameReleased) frameReleased(yBuffer);
+	return -1;
+}
+
 int ndnrtc_LocalVideoStream_incomingNV21Frame(ndnrtc::LocalVideoStream *stream,
 			const unsigned int width,
 			const unsigned int height,
@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 #include "estimators.hpp"
 #include "clock.hpp"
@@ -114,6 +115,31 @@ FreqMeter::newValue(double value)
         value_ = 1000.*(double)samples_.size()/(samples_.back()-samples_.front());
 }
 
+//******************************************************************************
+Percentile::Percentile(boost::shared_ptr<SampleWindow> window, double percentile):
+Estimator(window), percentile_(percentile)
+{
+	assert(percentile_ >= 0 && percentile_ <= 1);
+}
+
+void
+Percentile::newValue(double value)
+{
+	window_->isLimitReached();
+	window_->cut(samples_);
+	nValues_++;
+	samples_.push_back(value);
+
+	// window is small, so partial sort of its copy is cheap enough; sorted_
+	// keeps its capacity between calls
+	sorted_.assign(samples_.begin(), samples_.end());
+	size_t rank = (size_t)ceil(percentile_*sorted_.size());
+	size_t idx = (rank ? rank-1 : 0);
+
+	nth_element(sorted_.begin(), sorted_.begin()+idx, sorted_.end());
+	value_ = sorted_[idx];
+}
+
 Filter::Filter(double smoothing):smoothing_(smoothing), value_(0){}
 
 void
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <deque>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/move/move.hpp>
 
@@ -122,6 +123,25 @@ namespace ndnrtc {
             bool run_;
 		};
 
+		/**
+		 * Sliding window percentile. Value is the smallest sample in the
+		 * window that is greater or equal to given share of samples (nearest
+		 * rank), e.g. 0.5 for the median or 0.95 for the 95th percentile.
+		 * Only sample windows are supported, as time windows cut samples by
+		 * their values.
+		 */
+		class Percentile : public Estimator {
+		public:
+			Percentile(boost::shared_ptr<SampleWindow> window, double percentile);
+
+			void newValue(double value);
+
+		private:
+			double percentile_;
+			std::deque<double> samples_;
+			std::vector<double> sorted_;
+		};
+
 		/**
 		 * A low pass filter class
 		 */
@@ -0,0 +1,363 @@
+//
+// fec-rs28.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <string.h>
+#include <algorithm>
+#include <boost/atomic.hpp>
+
+#include "fec-rs28.hpp"
+#include "fec.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FEC_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace fec;
+
+namespace
+{
+    // primitive polynomial x^8+x^4+x^3+x^2+1 (OpenFEC's "101110001")
+    const unsigned int Gf256Poly = 0x11d;
+
+    struct Gf256Tables
+    {
+        uint8_t exp_[510];
+        uint8_t log_[256];
+        uint8_t inv_[256];
+        uint8_t mul_[256][256];
+        // split tables for pshufb multiplication: c*x and c*(x<<4), x < 16
+        uint8_t mulLo_[256][16];
+        uint8_t mulHi_[256][16];
+
+        Gf256Tables()
+        {
+            unsigned int x = 1;
+            for (int i = 0; i < 255; ++i)
+            {
+                exp_[i] = exp_[i+255] = x;
+                log_[x] = i;
+                x <<= 1;
+                if (x & 0x100) x ^= Gf256Poly;
+            }
+            log_[0] = 0;
+
+            for (int a = 0; a < 256; ++a)
+                for (int b = 0; b < 256; ++b)
+                    mul_[a][b] = (a && b ? exp_[log_[a]+log_[b]] : 0);
+
+            inv_[0] = 0;
+            for (int a = 1; a < 256; ++a)
+                inv_[a] = exp_[255-log_[a]];
+
+            for (int c = 0; c < 256; ++c)
+                for (int x = 0; x < 16; ++x)
+                {
+                    mulLo_[c][x] = mul_[c][x];
+                    mulHi_[c][x] = mul_[c][x << 4];
+                }
+        }
+    };
+
+    const Gf256Tables& tables()
+    {
+        static const Gf256Tables t;
+        return t;
+    }
+
+    void addmulScalar(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+    {
+        const uint8_t *row = tables().mul_[c];
+        for (size_t i = 0; i < len; ++i)
+            dst[i] ^= row[src[i]];
+    }
+
+#ifdef FEC_HAVE_X86
+    __attribute__((target("ssse3")))
+    void addmulSsse3(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+    {
+        const __m128i lo = _mm_loadu_si128((const __m128i*)tables().mulLo_[c]);
+        const __m128i hi = _mm_loadu_si128((const __m128i*)tables().mulHi_[c]);
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        size_t i = 0;
+
+        for (; i+16 <= len; i += 16)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+            __m128i p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+                                      _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+            _mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(d, p));
+        }
+
+        addmulScalar(dst+i, src+i, c, len-i);
+    }
+
+    __attribute__((target("avx2")))
+    void addmulAvx2(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+    {
+        const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tables().mulLo_[c]));
+        const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)tables().mulHi_[c]));
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+        size_t i = 0;
+
+        for (; i+32 <= len; i += 32)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src+i));
+            __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask)),
+                                         _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask)));
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst+i));
+            _mm256_storeu_si256((__m256i*)(dst+i), _mm256_xor_si256(d, p));
+        }
+
+        addmulScalar(dst+i, src+i, c, len-i);
+    }
+#endif
+
+    SimdLevel bestSupportedLevel(SimdLevel requested)
+    {
+#ifdef FEC_HAVE_X86
+        __builtin_cpu_init();
+        bool hasAvx2 = __builtin_cpu_supports("avx2");
+        bool hasSsse3 = __builtin_cpu_supports("ssse3");
+
+        if ((requested == SimdLevel::Auto || requested == SimdLevel::Avx2) && hasAvx2)
+            return SimdLevel::Avx2;
+        if (requested != SimdLevel::Scalar && hasSsse3)
+            return SimdLevel::Ssse3;
+#endif
+        return SimdLevel::Scalar;
+    }
+
+    boost::atomic<SimdLevel>& simdLevel()
+    {
+        static boost::atomic<SimdLevel> level(bestSupportedLevel(SimdLevel::Auto));
+        return level;
+    }
+
+    /**
+     * Inverts square matrix in place using Gauss-Jordan elimination.
+     * @return false if matrix is singular
+     */
+    bool invertMatrix(std::vector<uint8_t> &m, unsigned int n)
+    {
+        std::vector<uint8_t> inv(n*n, 0);
+        for (unsigned int i = 0; i < n; ++i) inv[i*n+i] = 1;
+
+        for (unsigned int col = 0; col < n; ++col)
+        {
+            unsigned int pivot = col;
+            while (pivot < n && m[pivot*n+col] == 0) pivot++;
+            if (pivot == n) return false;
+
+            if (pivot != col)
+                for (unsigned int k = 0; k < n; ++k)
+                {
+                    std::swap(m[pivot*n+k], m[col*n+k]);
+                    std::swap(inv[pivot*n+k], inv[col*n+k]);
+                }
+
+            uint8_t c = gf256::inv(m[col*n+col]);
+            for (unsigned int k = 0; k < n; ++k)
+            {
+                m[col*n+k] = gf256::mul(m[col*n+k], c);
+                inv[col*n+k] = gf256::mul(inv[col*n+k], c);
+            }
+
+            for (unsigned int row = 0; row < n; ++row)
+                if (row != col && m[row*n+col])
+                {
+                    uint8_t f = m[row*n+col];
+                    for (unsigned int k = 0; k < n; ++k)
+                    {
+                        m[row*n+k] ^= gf256::mul(f, m[col*n+k]);
+                        inv[row*n+k] ^= gf256::mul(f, inv[col*n+k]);
+                    }
+                }
+        }
+
+        m.swap(inv);
+        return true;
+    }
+}
+
+//******************************************************************************
+void fec::setSimdLevel(SimdLevel level)
+{
+    simdLevel() = bestSupportedLevel(level);
+}
+
+SimdLevel fec::getSimdLevel()
+{
+    return simdLevel();
+}
+
+uint8_t fec::gf256::mul(uint8_t a, uint8_t b)
+{
+    return tables().mul_[a][b];
+}
+
+uint8_t fec::gf256::inv(uint8_t a)
+{
+    return tables().inv_[a];
+}
+
+void fec::gf256::addmul(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    if (c == 0)
+        return;
+
+    switch (simdLevel().load(boost::memory_order_relaxed))
+    {
+#ifdef FEC_HAVE_X86
+        case SimdLevel::Avx2: addmulAvx2(dst, src, c, len); break;
+        case SimdLevel::Ssse3: addmulSsse3(dst, src, c, len); break;
+#endif
+        default: addmulScalar(dst, src, c, len); break;
+    }
+}
+
+//******************************************************************************
+Rs28Codec::Rs28Codec(unsigned int nSourceSymbols,
+                     unsigned int nRepairSymbols,
+                     unsigned int symbolLength):
+isValid_(false),
+nSourceSymbols_(nSourceSymbols),
+nRepairSymbols_(nRepairSymbols),
+symbolLength_(symbolLength)
+{
+    unsigned int k = nSourceSymbols_, n = nSourceSymbols_+nRepairSymbols_;
+
+    if (k == 0 || n > 255)
+        return;
+
+    // Vandermonde matrix: row 0 is (1, 0, ..., 0), row r > 0 has elements
+    // a^((r-1)*col) - same as OpenFEC's of_rs_new()
+    const uint8_t *exp = tables().exp_;
+    std::vector<uint8_t> top(k*k);
+
+    for (unsigned int row = 0; row < k; ++row)
+        for (unsigned int col = 0; col < k; ++col)
+            top[row*k+col] = (row == 0 ? (col == 0) : exp[((row-1)*col)%255]);
+
+    if (!invertMatrix(top, k))
+        return;
+
+    // repair rows of systematic matrix: bottom part multiplied by inverse
+    // of the top square part
+    encMatrix_.assign(nRepairSymbols_*k, 0);
+    for (unsigned int r = 0; r < nRepairSymbols_; ++r)
+    {
+        unsigned int row = k+r;
+        for (unsigned int col = 0; col < k; ++col)
+        {
+            uint8_t acc = 0;
+            for (unsigned int i = 0; i < k; ++i)
+                acc ^= gf256::mul(exp[((row-1)*i)%255], top[i*k+col]);
+            encMatrix_[r*k+col] = acc;
+        }
+    }
+
+    isValid_ = true;
+}
+
+int
+Rs28Codec::encode(const uint8_t *data, uint8_t *parityData) const
+{
+    return encode(data, nSourceSymbols_*symbolLength_, parityData);
+}
+
+int
+Rs28Codec::encode(const uint8_t *data, size_t dataLength,
+                  uint8_t *parityData) const
+{
+    if (!isValid_ || dataLength > nSourceSymbols_*symbolLength_)
+        return -1;
+
+    for (unsigned int r = 0; r < nRepairSymbols_; ++r)
+    {
+        uint8_t *parity = parityData + r*symbolLength_;
+        const uint8_t *coeffs = &encMatrix_[r*nSourceSymbols_];
+
+        memset(parity, 0, symbolLength_);
+        // zero padding does not contribute to parity, hence symbols are
+        // simply truncated at the end of data
+        for (unsigned int i = 0; i < nSourceSymbols_ && i*symbolLength_ < dataLength; ++i)
+            gf256::addmul(parity, data + i*symbolLength_, coeffs[i],
+                          std::min<size_t>(symbolLength_, dataLength - i*symbolLength_));
+    }
+
+    return 0;
+}
+
+int
+Rs28Codec::decode(uint8_t *data, const uint8_t *parityData,
+                  uint8_t *rList) const
+{
+    if (!isValid_)
+        return -1;
+
+    unsigned int k = nSourceSymbols_, n = nSourceSymbols_+nRepairSymbols_;
+    std::vector<unsigned int> missingData, availableParity;
+    unsigned int nMissing = 0;
+
+    for (unsigned int i = 0; i < n; ++i)
+        if (rList[i] != FEC_RLIST_SYMREADY)
+        {
+            rList[i] = FEC_RLIST_INPROCESS;
+            nMissing++;
+            if (i < k) missingData.push_back(i);
+        }
+        else if (i >= k)
+            availableParity.push_back(i-k);
+
+    if (missingData.size() > availableParity.size())
+        return -1;
+
+    unsigned int m = missingData.size();
+
+    if (m)
+    {
+        availableParity.resize(m);
+
+        // syndromes: parity symbols with contribution of known data removed
+        std::vector<uint8_t> syndromes(m*symbolLength_);
+        for (unsigned int j = 0; j < m; ++j)
+        {
+            uint8_t *s = &syndromes[j*symbolLength_];
+            const uint8_t *coeffs = &encMatrix_[availableParity[j]*k];
+
+            memcpy(s, parityData + availableParity[j]*symbolLength_, symbolLength_);
+            for (unsigned int i = 0; i < k; ++i)
+                if (rList[i] == FEC_RLIST_SYMREADY)
+                    gf256::addmul(s, data + i*symbolLength_, coeffs[i], symbolLength_);
+        }
+
+        // syndromes = A * missing, where A is a submatrix of encoding matrix
+        std::vector<uint8_t> a(m*m);
+        for (unsigned int j = 0; j < m; ++j)
+            for (unsigned int d = 0; d < m; ++d)
+                a[j*m+d] = encMatrix_[availableParity[j]*k+missingData[d]];
+
+        if (!invertMatrix(a, m))
+            return -1;
+
+        for (unsigned int d = 0; d < m; ++d)
+        {
+            uint8_t *symbol = data + missingData[d]*symbolLength_;
+            memset(symbol, 0, symbolLength_);
+            for (unsigned int j = 0; j < m; ++j)
+                gf256::addmul(symbol, &syndromes[j*symbolLength_], a[d*m+j], symbolLength_);
+        }
+    }
+
+    for (unsigned int i = 0; i < n; ++i)
+        if (rList[i] == FEC_RLIST_INPROCESS)
+            rList[i] = FEC_RLIST_SYMREPAIRED;
+
+    return nMissing;
+}
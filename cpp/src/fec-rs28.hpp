@@ -0,0 +1,114 @@
+//
+// fec-rs28.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __ndnrtc__fec_rs28__
+#define __ndnrtc__fec_rs28__
+
+#include <stdint.h>
+#include <cstdlib>
+#include <vector>
+
+namespace fec
+{
+    /**
+     * Instruction set used by the in-tree Reed-Solomon codec for GF(2^8)
+     * multiply-add of symbols. Auto selects the best one supported by CPU.
+     */
+    enum class SimdLevel {
+        Auto,
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
+    /**
+     * Sets instruction set for the in-tree codec. If requested instruction
+     * set is not supported by CPU, the best supported one is used instead.
+     */
+    void setSimdLevel(SimdLevel level);
+
+    /**
+     * Returns instruction set currently used by the in-tree codec
+     */
+    SimdLevel getSimdLevel();
+
+    namespace gf256
+    {
+        /**
+         * Multiplies two elements of GF(2^8) (primitive polynomial
+         * x^8+x^4+x^3+x^2+1)
+         */
+        uint8_t mul(uint8_t a, uint8_t b);
+
+        /**
+         * Returns multiplicative inverse of non-zero element
+         */
+        uint8_t inv(uint8_t a);
+
+        /**
+         * dst[i] ^= c*src[i] for i in [0, len)
+         * Uses instruction set returned by getSimdLevel().
+         */
+        void addmul(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+    }
+
+    /**
+     * In-tree systematic Reed-Solomon codec over GF(2^8).
+     * Encoding matrix is built exactly like the one of OpenFEC's
+     * OF_CODEC_REED_SOLOMON_GF_2_8_STABLE codec (Vandermonde matrix with
+     * evaluation points 0, 1, a, a^2,... made systematic by multiplying
+     * it by inverse of its top square part), therefore parity symbols are
+     * bit-compatible with the ones generated by OpenFEC and symbols
+     * produced by either codec can be decoded by the other one.
+     * Data and parity symbols are expected to be laid out contiguously
+     * (nSourceSymbols*symbolLength and nRepairSymbols*symbolLength
+     * bytes respectively).
+     */
+    class Rs28Codec
+    {
+    public:
+        Rs28Codec(unsigned int nSourceSymbols,
+                  unsigned int nRepairSymbols,
+                  unsigned int symbolLength);
+
+        bool isValid() const { return isValid_; }
+
+        /**
+         * Computes parity symbols for given data symbols.
+         * @return 0 on success, -1 on error
+         */
+        int encode(const uint8_t *data, uint8_t *parityData) const;
+
+        /**
+         * Computes parity symbols for dataLength bytes of data. If data is
+         * shorter than nSourceSymbols*symbolLength, it is treated as if it
+         * was padded with zeros, so caller does not need to expand it.
+         * @return 0 on success, -1 on error
+         */
+        int encode(const uint8_t *data, size_t dataLength,
+                   uint8_t *parityData) const;
+
+        /**
+         * Recovers missing data symbols in place. Symbol list has the same
+         * semantics as for Rs28Decoder: FEC_RLIST_SYMREADY marks symbols
+         * that are present; upon successful decoding, all other symbols
+         * are marked as FEC_RLIST_SYMREPAIRED.
+         * @return number of repaired symbols or -1 if there were not enough
+         * symbols for recovery
+         */
+        int decode(uint8_t *data, const uint8_t *parityData,
+                   uint8_t *rList) const;
+
+    private:
+        bool isValid_;
+        unsigned int nSourceSymbols_, nRepairSymbols_, symbolLength_;
+        // rows of encoding matrix for repair symbols (nRepair x nSource)
+        std::vector<uint8_t> encMatrix_;
+    };
+}
+
+#endif
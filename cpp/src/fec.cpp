@@ -10,12 +10,29 @@
 
 #include <iostream>
 #include <string.h>
+#include <boost/atomic.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/tss.hpp>
+
 #include "fec.hpp"
+#include "fec-rs28.hpp"
 
 using namespace fec;
 
 namespace fec 
 {
+    static boost::atomic<Backend> backend(Backend::Native);
+
+    void setBackend(Backend b)
+    {
+        backend = b;
+    }
+
+    Backend getBackend()
+    {
+        return backend;
+    }
+
     double parityWeight()
     {
         return 0.5;
@@ -34,30 +51,66 @@ Rs28Coder(nSourceSymbols, nRepairSymbols, symbolLength)
 int
 Rs28Encoder::encode(unsigned char* data, unsigned char* parityData)
 {
-    initCoder();
+    return encode(data, nSourceSymbols_*symbolLength_, parityData);
+}
+
+int
+Rs28Encoder::encode(const unsigned char* data, size_t dataLength,
+                    unsigned char* parityData)
+{
+    if (dataLength > nSourceSymbols_*symbolLength_)
+        return -1;
+
+    if (getBackend() == Backend::Native)
+    {
+        if (!codec_)
+            codec_ = boost::make_shared<Rs28Codec>(nSourceSymbols_, nRepairSymbols_, symbolLength_);
+        return codec_->encode(data, dataLength, parityData);
+    }
+
+    if (!isCoderCreated_)
+        initCoder();
     
     if (!Rs28Coder<OF_ENCODER>::isCoderReady_)
         return -1;
     
     int ret = 0;
-    unsigned char** encodingSymbolTable = buildSymbolTable(data, parityData);
     of_parameters_t* params = Rs28Coder<OF_ENCODER>::coderParameters_;
     of_session_t* session = Rs28Coder<OF_ENCODER>::coderSession_;
+
+    // OpenFEC needs full symbols, so incomplete last symbol and symbols
+    // past the end of data are taken from zero-padded scratch memory, one
+    // scratch symbol per source symbol
+    unsigned int nFullSymbols = dataLength/symbolLength_;
+    size_t paddedOffset = nFullSymbols*symbolLength_;
+
+    paddedSymbols_.assign((nSourceSymbols_-nFullSymbols)*symbolLength_, 0);
+    if (paddedOffset < dataLength)
+        memcpy(paddedSymbols_.data(), &data[paddedOffset], dataLength-paddedOffset);
+
+    symbolTable_.resize(nSourceSymbols_+nRepairSymbols_);
+    for (unsigned int i = 0; i < nSourceSymbols_+nRepairSymbols_; ++i)
+    {
+        if (i < nFullSymbols)
+            symbolTable_[i] = (unsigned char*)&data[i*symbolLength_];
+        else if (i < nSourceSymbols_)
+            symbolTable_[i] = &paddedSymbols_[(i-nFullSymbols)*symbolLength_];
+        else
+            symbolTable_[i] = &parityData[(i-nSourceSymbols_)*symbolLength_];
+    }
     
     for (UINT32 esi = params->nb_source_symbols;
          esi < params->nb_source_symbols + params->nb_repair_symbols && ret >= 0;
          esi++)
     {
-				memset(encodingSymbolTable[esi], 0, params->encoding_symbol_length);
+				memset(symbolTable_[esi], 0, params->encoding_symbol_length);
         
-				if (of_build_repair_symbol(session, (void**)encodingSymbolTable, esi) != OF_STATUS_OK)
+				if (of_build_repair_symbol(session, (void**)symbolTable_.data(), esi) != OF_STATUS_OK)
 				{
             ret = -1;
 				}
     }
     
-    releaseSymbolTable(encodingSymbolTable);
-    
     return ret;
 }
 
@@ -74,6 +127,16 @@ int
 Rs28Decoder::decode(unsigned char* data, unsigned char* parityData,
                     unsigned char* rList)
 {
+    if (getBackend() == Backend::Native)
+    {
+        if (!codec_)
+            codec_ = boost::make_shared<Rs28Codec>(nSourceSymbols_, nRepairSymbols_, symbolLength_);
+        return codec_->decode(data, parityData, rList);
+    }
+
+    // OpenFEC decoding session can't be reused, start a new one
+    if (isCoderCreated_)
+        releaseCoder();
     initCoder();
     
     if (!Rs28Coder<OF_DECODER>::isCoderReady_)
@@ -117,3 +180,69 @@ Rs28Decoder::decode(unsigned char* data, unsigned char* parityData,
     
     return ret;
 }
+
+//******************************************************************************
+#pragma mark - construction/destruction
+Rs28CoderCache::Rs28CoderCache(size_t capacity):
+capacity_(capacity),
+hits_(0),
+misses_(0)
+{
+}
+
+#pragma mark - public
+Rs28CoderCache&
+Rs28CoderCache::getThreadInstance()
+{
+    static boost::thread_specific_ptr<Rs28CoderCache> instance;
+
+    if (!instance.get())
+        instance.reset(new Rs28CoderCache());
+    return *instance;
+}
+
+Rs28Encoder&
+Rs28CoderCache::getEncoder(unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                           unsigned int symbolLength)
+{
+    return get(encoders_, nSourceSymbols, nRepairSymbols, symbolLength);
+}
+
+Rs28Decoder&
+Rs28CoderCache::getDecoder(unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                           unsigned int symbolLength)
+{
+    return get(decoders_, nSourceSymbols, nRepairSymbols, symbolLength);
+}
+
+void
+Rs28CoderCache::clear()
+{
+    encoders_.clear();
+    decoders_.clear();
+}
+
+#pragma mark - private
+template <typename Coder>
+Coder&
+Rs28CoderCache::get(std::map<Key, boost::shared_ptr<Coder>>& coders,
+                    unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                    unsigned int symbolLength)
+{
+    Key key(nSourceSymbols, nRepairSymbols, symbolLength);
+    typename std::map<Key, boost::shared_ptr<Coder>>::iterator it = coders.find(key);
+
+    if (it != coders.end())
+    {
+        hits_++;
+        return *it->second;
+    }
+
+    misses_++;
+    if (coders.size() >= capacity_)
+        coders.erase(coders.begin());
+
+    boost::shared_ptr<Coder> coder = boost::make_shared<Coder>(nSourceSymbols, nRepairSymbols, symbolLength);
+    coders[key] = coder;
+    return *coder;
+}
@@ -12,6 +12,10 @@
 #define __ndnrtc__fec__
 
 #include <cstdlib>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 
 #define FEC_RLIST_SYMREADY '1'
 #define FEC_RLIST_SYMEMPTY '0'
@@ -32,6 +36,29 @@ typedef struct {
 
 namespace fec
 {
+    class Rs28Codec;
+
+    /**
+     * Reed-Solomon implementation used by Rs28Encoder and Rs28Decoder. 
+     * Native backend is the in-tree SIMD-accelerated codec (see 
+     * fec-rs28.hpp), it produces parity data identical to the one of OpenFEC.
+     */
+    enum class Backend {
+        OpenFec,
+        Native
+    };
+
+    /**
+     * Sets Reed-Solomon backend for all subsequently created coders.
+     * Default is Backend::Native.
+     */
+    void setBackend(Backend backend);
+
+    /**
+     * Returns current Reed-Solomon backend
+     */
+    Backend getBackend();
+
     /**
      * This returns a "weight" of parity segment in relation to normal
      * data segment. For example, if weight is 0.5, it means
@@ -57,6 +84,7 @@ namespace fec
         coderSession_(nullptr),
         coderParameters_(nullptr),
         isCoderCreated_(false),
+        isCoderReady_(false),
         coderId_(CoderID),
         coderType_(CoderType)
         {
@@ -170,9 +198,23 @@ namespace fec
         
         int
         encode(unsigned char* data, unsigned char* parityData);
+
+        /**
+         * Encodes dataLength bytes of data, which may be shorter than
+         * nSourceSymbols*symbolLength - missing tail of the last symbol is
+         * treated as zeros, so data does not need to be expanded by caller.
+         * Coder session and scratch memory are kept between calls, so
+         * repeated encoding with the same encoder does not allocate.
+         */
+        int
+        encode(const unsigned char* data, size_t dataLength,
+               unsigned char* parityData);
         
     private:
-        
+        boost::shared_ptr<Rs28Codec> codec_;
+        std::vector<unsigned char*> symbolTable_;
+        // zero-padded copies of source symbols past the end of data
+        std::vector<unsigned char> paddedSymbols_;
     };
     
     class Rs28Decoder : public Rs28Coder<OF_DECODER>
@@ -187,6 +229,54 @@ namespace fec
                unsigned char* rList);
         
     private:
+        boost::shared_ptr<Rs28Codec> codec_;
+    };
+
+    /**
+     * Per-thread cache of Reed-Solomon coders keyed by (nSourceSymbols, 
+     * nRepairSymbols, symbolLength). Cached coders keep their sessions 
+     * (OpenFEC session or native encoding matrix) between calls, so coding 
+     * frames of already seen geometry does not create new sessions and does
+     * not allocate memory. When cache is full, an arbitrary entry is evicted.
+     */
+    class Rs28CoderCache
+    {
+    public:
+        Rs28CoderCache(size_t capacity = 128);
+
+        /**
+         * Returns cache instance of the calling thread
+         */
+        static Rs28CoderCache&
+        getThreadInstance();
+
+        Rs28Encoder&
+        getEncoder(unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                   unsigned int symbolLength);
+
+        Rs28Decoder&
+        getDecoder(unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                   unsigned int symbolLength);
+
+        uint64_t getHitsNum() const { return hits_; }
+        uint64_t getMissesNum() const { return misses_; }
+        size_t size() const { return encoders_.size() + decoders_.size(); }
+        void clear();
+
+    private:
+        Rs28CoderCache(const Rs28CoderCache&) = delete;
+
+        typedef std::tuple<unsigned int, unsigned int, unsigned int> Key;
+
+        template <typename Coder>
+        Coder& get(std::map<Key, boost::shared_ptr<Coder>>& coders,
+                   unsigned int nSourceSymbols, unsigned int nRepairSymbols,
+                   unsigned int symbolLength);
+
+        size_t capacity_;
+        uint64_t hits_, misses_;
+        std::map<Key, boost::shared_ptr<Rs28Encoder>> encoders_;
+        std::map<Key, boost::shared_ptr<Rs28Decoder>> decoders_;
     };
     
 }
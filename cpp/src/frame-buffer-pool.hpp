@@ -0,0 +1,72 @@
+//
+// frame-buffer-pool.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __frame_buffer_pool_hpp__
+#define __frame_buffer_pool_hpp__
+
+#include <vector>
+#include <webrtc/base/refcount.h>
+
+#include "webrtc.hpp"
+
+namespace ndnrtc {
+    /**
+     * Pool of I420 frame buffers. A buffer is handed out again once the pool
+     * holds its last reference, i.e. all frames that used it were released.
+     * Buffers must be requested by one thread at a time; frames using them
+     * can be released on any thread.
+     */
+    class FrameBufferPool {
+    public:
+        FrameBufferPool(size_t maxSize = 4) : maxSize_(maxSize), nAllocated_(0) {}
+
+        /**
+         * Returns free buffer of given size with default strides. If all
+         * buffers are in use, allocates new one, which is kept in the pool
+         * unless the pool is full.
+         */
+        WebRtcSmartPtr<WebRtcVideoFrameBuffer> getBuffer(int width, int height)
+        {
+            for (size_t i = 0; i < pool_.size();)
+            {
+                if (pool_[i]->HasOneRef())
+                {
+                    if (pool_[i]->width() == width && pool_[i]->height() == height)
+                        return pool_[i];
+
+                    // frame size has changed
+                    pool_.erase(pool_.begin() + i);
+                    continue;
+                }
+                ++i;
+            }
+
+            WebRtcSmartPtr<PooledBuffer> buffer(new PooledBuffer(width, height));
+            nAllocated_++;
+
+            if (pool_.size() < maxSize_)
+                pool_.push_back(buffer);
+
+            return buffer;
+        }
+
+        size_t getSize() const { return pool_.size(); }
+
+        // number of buffers allocated so far, including those that did not
+        // fit into the pool
+        unsigned int getAllocatedNum() const { return nAllocated_; }
+
+    private:
+        typedef rtc::RefCountedObject<WebRtcVideoFrameBuffer> PooledBuffer;
+
+        size_t maxSize_;
+        unsigned int nAllocated_;
+        std::vector<WebRtcSmartPtr<PooledBuffer>> pool_;
+    };
+}
+
+#endif
@@ -10,6 +10,8 @@
 
 #include "frame-buffer.hpp"
 
+#include <algorithm>
+
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/data.hpp>
 
@@ -107,7 +109,18 @@ toString(int consistency)
     return str.str();
 }
 
-BufferSlot::BufferSlot(){ clear(); }
+namespace {
+    // whether two names belong to the same thread and sample class
+    bool sameThreadAndClass(const NamespaceInfo& a, const NamespaceInfo& b)
+    {
+        return a.class_ == b.class_ && a.threadName_ == b.threadName_ &&
+            a.streamName_ == b.streamName_ && a.streamType_ == b.streamType_ &&
+            a.streamTimestamp_ == b.streamTimestamp_ && 
+            a.apiVersion_ == b.apiVersion_ && a.basePrefix_.equals(b.basePrefix_);
+    }
+}
+
+BufferSlot::BufferSlot():generation_(0){ clear(); }
 
 void
 BufferSlot::segmentsRequested(const std::vector<boost::shared_ptr<const ndn::Interest>>& interests)
@@ -118,27 +131,28 @@ BufferSlot::segmentsRequested(const std::vector<boost::shared_ptr<const ndn::Int
     for (auto i:interests)
     {
         boost::shared_ptr<SlotSegment> segment(boost::make_shared<SlotSegment>(i));
+        const NamespaceInfo& info = segment->getInfo();
         
-        if (!segment->getInfo().hasSeqNo_ || !segment->getInfo().hasSegNo_)
+        if (!info.hasSeqNo_ || !info.hasSegNo_)
             throw std::runtime_error("No rightmost interests allowed: Interest should have segment-level info");
         
         if (name_.size() == 0) 
         {
-            nameInfo_ = segment->getInfo();
+            nameInfo_ = info;
             name_ = nameInfo_.getPrefix(prefix_filter::Sample);
             requestTimeUsec_ = segment->getRequestTimeUsec();
         }
-        else if (!name_.match(i->getName()))
+        else if (info.sampleNo_ != nameInfo_.sampleNo_ || !sameThreadAndClass(info, nameInfo_))
             throw std::runtime_error("Interest names should differ only after sample sequence number");
 
-        Name segmentKey = segment->getInfo().getSuffix(suffix_filter::Segment);
+        SegmentArray& segments = this->segments(info);
         
-        if (requested_.find(segmentKey) != requested_.end())
+        if (segments.isRequested(info.segNo_))
         {
             nRtx_++;
-            requested_[segmentKey]->incrementRequestNum();
+            segments.get(info.segNo_)->incrementRequestNum();
         }
-        else requested_[segmentKey] = segment;
+        else segments.add(info.segNo_, segment);
 
         if (state_ == Free) state_ = New;
     }
@@ -147,10 +161,12 @@ BufferSlot::segmentsRequested(const std::vector<boost::shared_ptr<const ndn::Int
 void 
 BufferSlot::clear()
 {
+    generation_++;
     name_.clear();
     nameInfo_ = NamespaceInfo();
-    requested_.clear();
-    fetched_.clear();
+    data_.clear();
+    parity_.clear();
+    nFetched_ = 0;
     consistency_ = Inconsistent;
     requestTimeUsec_ = 0;
     assembledSize_ = 0;
@@ -177,23 +193,29 @@ BufferSlot::segmentReceived(const boost::shared_ptr<WireSegment>& segment)
     if (state_ == Locked)
         return boost::shared_ptr<SlotSegment>();
     
-    if (!name_.match(segment->getData()->getName()))
+    const NamespaceInfo& info = segment->getInfo();
+
+    if (state_ != Free && 
+        (info.sampleNo_ != nameInfo_.sampleNo_ || !sameThreadAndClass(info, nameInfo_)))
         throw std::runtime_error("Attempt to add data segment with incorrect name");
 
-    Name segmentKey = segment->getInfo().getSuffix(suffix_filter::Segment);
+    SegmentArray& segments = this->segments(info);
 
-    if (!segment->getInfo().hasSeqNo_ || 
-        requested_.find(segmentKey) == requested_.end())
+    if (!info.hasSeqNo_ || !segments.isRequested(info.segNo_))
         throw std::runtime_error("Adding segment that was not previously requested");
     
-    if (fetched_.find(segmentKey) == fetched_.end())
+    const boost::shared_ptr<SlotSegment>& slotSegment = segments.get(info.segNo_);
+
+    if (!segments.isFetched(info.segNo_))
     {
-        lastFetched_ = fetched_[segmentKey] = requested_[segmentKey];
-        fetched_[segmentKey]->setData(segment);
-        updateConsistencyState(fetched_[segmentKey]);
+        segments.setFetched(info.segNo_);
+        nFetched_++;
+        lastFetched_ = slotSegment;
+        slotSegment->setData(segment);
+        updateConsistencyState(slotSegment);
     }
 
-    return fetched_[segmentKey];
+    return slotSegment;
 }
 
 std::vector<ndn::Name>
@@ -204,17 +226,11 @@ BufferSlot::getMissingSegments() const
     if (getFetchedNum() > 0)
     {
         for (unsigned int segNo = 0; segNo < nDataSegments_; ++segNo)
-        {
-            Name segKey = Name().appendSegment(segNo);
-            if (requested_.find(segKey) == requested_.end())
-                missing.push_back(Name(getPrefix()).append(segKey));
-        }
+            if (!data_.isRequested(segNo))
+                missing.push_back(Name(getPrefix()).appendSegment(segNo));
         for (unsigned int segNo = 0; segNo < nParitySegments_; ++segNo)
-        {
-            Name segKey = Name(NameComponents::NameComponentParity).appendSegment(segNo);
-            if (requested_.find(segKey) == requested_.end())
-                missing.push_back(Name(getPrefix()).append(segKey));
-        }
+            if (!parity_.isRequested(segNo))
+                missing.push_back(Name(getPrefix()).append(NameComponents::NameComponentParity).appendSegment(segNo));
     }
     
     return missing;
@@ -225,9 +241,10 @@ BufferSlot::getPendingInterests() const
 {
     std::vector<boost::shared_ptr<const ndn::Interest>> pendingInterests;
 
-    for (auto it:requested_)
-        if (fetched_.find(it.first) == fetched_.end())
-            pendingInterests.push_back(it.second->getInterest());
+    for (auto segments:{&data_, &parity_})
+        for (unsigned int segNo = 0; segNo < segments->size(); ++segNo)
+            if (segments->isRequested(segNo) && !segments->isFetched(segNo))
+                pendingInterests.push_back(segments->get(segNo)->getInterest());
 
     return pendingInterests;
 }
@@ -235,24 +252,24 @@ BufferSlot::getPendingInterests() const
 const std::vector<boost::shared_ptr<const SlotSegment>>
 BufferSlot::getFetchedSegments() const
 {
-    std::vector<boost::shared_ptr<const SlotSegment>> segments;
+    std::vector<boost::shared_ptr<const SlotSegment>> fetched;
+    fetched.reserve(nFetched_);
     
-    for (auto it:fetched_)
-        segments.push_back(it.second);
+    for (auto segments:{&data_, &parity_})
+        for (size_t segNo = segments->firstFetched(); segNo != SegmentArray::npos; 
+             segNo = segments->nextFetched(segNo))
+            fetched.push_back(segments->get(segNo));
 
-    return segments;
+    return fetched;
 }
 
 int 
 BufferSlot::getRtxNum(const ndn::Name& segmentName)
 {
     NamespaceInfo info;
-    if (NameComponents::extractInfo(segmentName, info))
-    {
-        Name segmentKey = info.getSuffix(suffix_filter::Segment);
-        if (requested_.find(segmentKey) != requested_.end())
-           return requested_[segmentKey]->getRequestNum()-1;
-    }
+    if (NameComponents::extractInfo(segmentName, info) && 
+        segments(info).isRequested(info.segNo_))
+        return segments(info).get(info.segNo_)->getRequestNum()-1;
 
     return -1;
 }
@@ -294,10 +311,10 @@ BufferSlot::dump(bool showLastSegment) const
 const CommonHeader
 BufferSlot::getHeader() const
 {
-    if (!consistency_&HeaderMeta)
+    if (!(consistency_&HeaderMeta) || !data_.isFetched(0))
         throw std::runtime_error("Packet header is not available");
 
-    return fetched_.at(nameInfo_.getSuffix(suffix_filter::Segment))->getData()->packetHeader();
+    return data_.get(0)->getData()->packetHeader();
 }
 
 void
@@ -338,10 +355,36 @@ void BufferSlot::updateAssembledLevel()
     if (consistency_&SegmentMeta)
     {
         asmLevel_ = 0;
-        for (auto& it:fetched_) asmLevel_ += it.second->getData()->getShareSize(nDataSegments_);
+        for (auto segments:{&data_, &parity_})
+            for (size_t segNo = segments->firstFetched(); segNo != SegmentArray::npos; 
+                 segNo = segments->nextFetched(segNo))
+                asmLevel_ += segments->get(segNo)->getData()->getShareSize(nDataSegments_);
     }
 }
 
+void
+BufferSlot::SegmentArray::clear()
+{
+    segments_.clear();
+    requested_.clear();
+    fetched_.clear();
+}
+
+void
+BufferSlot::SegmentArray::add(unsigned int segNo, 
+                              const boost::shared_ptr<SlotSegment>& segment)
+{
+    if (segNo >= segments_.size())
+    {
+        segments_.resize(segNo+1);
+        requested_.resize(segNo+1);
+        fetched_.resize(segNo+1);
+    }
+
+    segments_[segNo] = segment;
+    requested_[segNo] = true;
+}
+
 void
 BufferSlot::toggleLock()
 {
@@ -363,6 +406,47 @@ storage_(boost::make_shared<std::vector<uint8_t>>())
     fecList_.reserve(1000);
 }
 
+/**
+ * Writes payloads of fetched segments directly to their final offsets 
+ * (segNo*symbolLength) in buffer and marks them as ready in symbol list. 
+ * Short payloads (last data segment) are padded with zeros. Symbols which 
+ * were not written are zeroed afterwards, thus, buffer doesn't need to be 
+ * zero-initialized.
+ * @return Number of segments written
+ */
+unsigned int
+VideoFrameSlot::placeSegments(const BufferSlot::SegmentArray& segments,
+                              uint8_t *buffer, unsigned int nSymbols, size_t symbolLength,
+                              uint8_t *symbolList)
+{
+    unsigned int nPlaced = 0;
+
+    for (size_t segNo = segments.firstFetched(); 
+         segNo != BufferSlot::SegmentArray::npos && segNo < nSymbols; 
+         segNo = segments.nextFetched(segNo))
+    {
+        const boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd = 
+            boost::static_pointer_cast<WireData<VideoFrameSegmentHeader>>(segments.get(segNo)->getData());
+        ImmutableHeaderPacket<VideoFrameSegmentHeader> segment = wd->segment();
+        size_t payloadSize = std::min(segment.getPayload().size(), symbolLength);
+        uint8_t *symbol = buffer + segNo*symbolLength;
+
+        if (payloadSize)
+            memcpy(symbol, segment.getPayload().data(), payloadSize);
+        if (payloadSize < symbolLength)
+            memset(symbol+payloadSize, 0, symbolLength-payloadSize);
+
+        symbolList[segNo] = FEC_RLIST_SYMREADY;
+        nPlaced++;
+    }
+
+    for (unsigned int segNo = 0; segNo < nSymbols && nPlaced < nSymbols; ++segNo)
+        if (symbolList[segNo] == FEC_RLIST_SYMEMPTY)
+            memset(buffer + segNo*symbolLength, 0, symbolLength);
+
+    return nPlaced;
+}
+
 boost::shared_ptr<ImmutableVideoFramePacket>
 VideoFrameSlot::readPacket(const BufferSlot& slot, bool& recovered)
 {
@@ -371,89 +455,66 @@ VideoFrameSlot::readPacket(const BufferSlot& slot, bool& recovered)
         throw std::runtime_error("Wrong slot supplied: can not read video "
             "packet from audio slot");
 
-    // check if recovery is possible
-    Name parityKey(NameComponents::NameComponentParity);
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        dataSegments(slot.fetched_.begin(), slot.fetched_.lower_bound(parityKey));
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        paritySegments(slot.fetched_.upper_bound(parityKey), slot.fetched_.end());
+    recovered = false;
 
-    if ((!paritySegments.size() && 
-        dataSegments.size() < dataSegments.begin()->second->getData()->getSlicesNum()) ||
-        dataSegments.size() == 0)
-    {
-        recovered = false;
-        return boost::shared_ptr<ImmutableVideoFramePacket>();
-    }
+    size_t firstData = slot.data_.firstFetched();
+    size_t firstParity = slot.parity_.firstFetched();
 
-    boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstSeg = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(dataSegments.begin()->second->getData());
-    boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstParitySeg;
+    if (firstData == BufferSlot::SegmentArray::npos)
+        return boost::shared_ptr<ImmutableVideoFramePacket>();
 
-    if (paritySegments.size()) 
-        firstParitySeg = boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(paritySegments.begin()->second->getData());
+    size_t nParityFetched = 0;
+    for (size_t segNo = firstParity; segNo != BufferSlot::SegmentArray::npos; 
+         segNo = slot.parity_.nextFetched(segNo))
+        nParityFetched++;
+    size_t nDataFetched = slot.getFetchedNum() - nParityFetched;
 
-    size_t segmentSize = firstSeg->segment().getPayload().size();
-    size_t paritySegSize = (paritySegments.size() ? firstParitySeg->segment().getPayload().size() : 0);
+    boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstSeg = 
+        boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(slot.data_.get(firstData)->getData());
     unsigned int nDataSegmentsExpected = firstSeg->getSlicesNum();
-    unsigned int nParitySegmentsExpected = (paritySegments.size() ? paritySegments.begin()->second->getData()->getSlicesNum() : 0);
+    unsigned int nParitySegmentsExpected = (nParityFetched ? slot.parity_.get(firstParity)->getData()->getSlicesNum() : 0);
+    bool needRecovery = (nDataFetched < nDataSegmentsExpected);
 
-    fecList_.assign(nDataSegmentsExpected+nParitySegmentsExpected, FEC_RLIST_SYMEMPTY);
-    storage_->resize(segmentSize*(nDataSegmentsExpected+nParitySegmentsExpected));
+    // there is not enough data and parity segments for recovery - don't 
+    // bother assembling the frame
+    if (needRecovery && nDataFetched + nParityFetched < nDataSegmentsExpected)
+        return boost::shared_ptr<ImmutableVideoFramePacket>();
 
-    int segNo = 0;
-    for (auto it:dataSegments)
+    // parity segments are always full-sized, whereas first fetched data 
+    // segment may be the last (shorter) one
+    size_t segmentSize = firstSeg->segment().getPayload().size();
+    if (nParityFetched)
     {
-        const boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(it.second->getData());
-        
-        while (segNo != wd->getSegNo() && segNo < nDataSegmentsExpected)
-            storage_->insert(storage_->begin()+segmentSize*segNo++, segmentSize, 0);
-        
-        if (segNo < nDataSegmentsExpected)
-        {
-            storage_->insert(storage_->begin()+segmentSize*segNo, 
-                wd->segment().getPayload().begin(),
-                wd->segment().getPayload().end());
-            fecList_[segNo] = FEC_RLIST_SYMREADY;
-            segNo++;
-        }
+        boost::shared_ptr<WireData<VideoFrameSegmentHeader>> firstParitySeg = 
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(slot.parity_.get(firstParity)->getData());
+        segmentSize = std::max(segmentSize, firstParitySeg->segment().getPayload().size());
     }
 
-    bool frameExtracted = false;
-    if (dataSegments.size() < nDataSegmentsExpected)
-    {
-        segNo = 0;
-        for (auto it:paritySegments)
-        {
-            const boost::shared_ptr<WireData<VideoFrameSegmentHeader>> wd =
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(it.second->getData());
+    size_t dataSize = nDataSegmentsExpected*segmentSize;
+    unsigned int nSymbols = nDataSegmentsExpected + (needRecovery ? nParitySegmentsExpected : 0);
 
-            while (segNo != wd->getSegNo() && segNo < nParitySegmentsExpected)
-                storage_->insert(storage_->begin()+nDataSegmentsExpected*segmentSize + paritySegSize*segNo++, segmentSize, 0);
+    fecList_.assign(nSymbols, FEC_RLIST_SYMEMPTY);
+    storage_->resize(nSymbols*segmentSize);
 
-            if (segNo < nParitySegmentsExpected)
-            {
-                storage_->insert(storage_->begin()+nDataSegmentsExpected*segmentSize+paritySegSize*segNo, 
-                    wd->segment().getPayload().begin(),
-                    wd->segment().getPayload().end());            
+    placeSegments(slot.data_, storage_->data(), 
+                  nDataSegmentsExpected, segmentSize, fecList_.data());
 
-                fecList_[nDataSegmentsExpected+segNo] = FEC_RLIST_SYMREADY;
-                segNo++;
-            }
-        }
-        
-        fec::Rs28Decoder dec(nDataSegmentsExpected, nParitySegmentsExpected, segmentSize);
+    bool frameExtracted = !needRecovery;
+    if (needRecovery)
+    {
+        placeSegments(slot.parity_, storage_->data()+dataSize, 
+                      nParitySegmentsExpected, segmentSize, fecList_.data()+nDataSegmentsExpected);
+
+        fec::Rs28Decoder &dec = fec::Rs28CoderCache::getThreadInstance().getDecoder(nDataSegmentsExpected, 
+            nParitySegmentsExpected, segmentSize);
         int nRecovered = dec.decode(storage_->data(),
-            storage_->data()+nDataSegmentsExpected*segmentSize,
+            storage_->data()+dataSize,
             fecList_.data());
-        recovered = (nRecovered+dataSegments.size() >= nDataSegmentsExpected);
+        recovered = (nRecovered+nDataFetched >= nDataSegmentsExpected);
         frameExtracted = recovered;
     }
-    else 
-        frameExtracted = true;
 
-    storage_->resize(nDataSegmentsExpected*segmentSize);
+    storage_->resize(dataSize);
 
     return (frameExtracted ? boost::make_shared<ImmutableVideoFramePacket>(storage_) : 
                 boost::shared_ptr<ImmutableVideoFramePacket>());
@@ -467,14 +528,13 @@ VideoFrameSlot::readSegmentHeader(const BufferSlot& slot)
         throw std::runtime_error("Wrong slot supplied: can not read video "
             "packet from audio slot");
 
-    std::map<ndn::Name, boost::shared_ptr<SlotSegment>> 
-        dataSegments(slot.fetched_.begin(), slot.fetched_.lower_bound(Name(NameComponents::NameComponentParity)));
+    size_t firstData = slot.data_.firstFetched();
 
-    if (!dataSegments.size())
+    if (firstData == BufferSlot::SegmentArray::npos)
         return VideoFrameSegmentHeader();
 
     boost::shared_ptr<WireData<VideoFrameSegmentHeader>> seg = 
-            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(dataSegments.begin()->second->getData());
+            boost::dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(slot.data_.get(firstData)->getData());
 
     return seg->segment().getHeader();
 }
@@ -497,17 +557,18 @@ AudioBundleSlot::readBundle(const BufferSlot& slot)
     if (slot.getAssembledLevel() < 1.)
         return boost::shared_ptr<ImmutableAudioBundlePacket>();
 
+    const std::vector<boost::shared_ptr<const SlotSegment>> fetched = slot.getFetchedSegments();
     boost::shared_ptr<WireData<DataSegmentHeader>> firstSeg = 
-            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(slot.fetched_.begin()->second->getData());
+            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(fetched.front()->getData());
     size_t segmentSize = firstSeg->segment().getPayload().size();
     unsigned int nDataSegmentsExpected = firstSeg->getSlicesNum();
 
     storage_->resize(segmentSize*nDataSegmentsExpected);
 
-    for (auto it:slot.fetched_)
+    for (auto s:fetched)
     {
         const boost::shared_ptr<WireData<DataSegmentHeader>> wd = 
-            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(it.second->getData());
+            boost::dynamic_pointer_cast<WireData<DataSegmentHeader>>(s->getData());
         storage_->insert(storage_->begin(), 
                 wd->segment().getPayload().begin(),
                 wd->segment().getPayload().end());
@@ -527,6 +588,7 @@ capacity_(capacity)
 boost::shared_ptr<BufferSlot>
 SlotPool::pop()
 {
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
     if (pool_.size())
     {
         boost::shared_ptr<BufferSlot> slot = pool_.back();
@@ -539,9 +601,11 @@ SlotPool::pop()
 bool
 SlotPool::push(const boost::shared_ptr<BufferSlot>& slot)
 {
+    slot->clear();
+
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
     if (pool_.size() < capacity_)
     {
-        slot->clear();
         pool_.push_back(slot);
         return true;
     }
@@ -549,9 +613,19 @@ SlotPool::push(const boost::shared_ptr<BufferSlot>& slot)
     return false;
 }
 
+size_t
+SlotPool::size() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(mutex_);
+    return pool_.size();
+}
+
 //******************************************************************************
 Buffer::Buffer(boost::shared_ptr<StatisticsStorage> storage,
-               boost::shared_ptr<SlotPool> pool):pool_(pool),
+               boost::shared_ptr<SlotPool> pool, size_t ringSize):pool_(pool),
+ringSize_(ringSize < ShardsNum ? ShardsNum :
+    ringSize - ringSize%ShardsNum + (ringSize%ShardsNum ? ShardsNum : 0)),
+observers_(boost::make_shared<ObserverList>()),
 sstorage_(storage)
 {
     assert(sstorage_.get());
@@ -561,23 +635,41 @@ sstorage_(storage)
 void
 Buffer::reset()
 {   
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    
-    for (auto s:activeSlots_)
-        pool_->push(s.second);
-    activeSlots_.clear();
+    {
+        boost::shared_lock<boost::shared_mutex> ringsLock(ringsMutex_);
+        for (auto& r:rings_)
+            for (size_t shard = 0; shard < ShardsNum; ++shard)
+            {
+                boost::lock_guard<boost::mutex> scopedLock(shards_[shard]);
+                for (size_t i = shard; i < ringSize_; i += ShardsNum)
+                    if (r->entries_[i].slot_)
+                    {
+                        pool_->push(r->entries_[i].slot_);
+                        r->entries_[i].slot_.reset();
+                    }
+            }
+    }
+
+    size_t nReserved;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(reservedMutex_);
+        nReserved = reservedSlots_.size();
+    }
  
      LogDebugC << "slot pool capacity " << pool_->capacity()
         << " pool size " << pool_->size() << " "
-        << reservedSlots_.size() << " slot(s) locked for playback" << std::endl;
+        << nReserved << " slot(s) locked for playback" << std::endl;
 
-    for (auto o:observers_) o->onReset();
+    boost::shared_ptr<const ObserverList> observers = getObservers();
+    for (auto o:*observers) o->onReset();
 }
 
 bool
 Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& interests)
 {
-    std::map<Name, std::vector<boost::shared_ptr<const Interest>>> slotInterests;
+    // Interests are grouped by sample; batches usually have one or few 
+    // samples, so linear search is fine here
+    std::vector<std::pair<NamespaceInfo, std::vector<boost::shared_ptr<const Interest>>>> slotInterests;
     for (auto i:interests)
     {
         NamespaceInfo nameInfo;
@@ -589,33 +681,58 @@ Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& int
             throw std::runtime_error(ss.str());
         }
 
-        slotInterests[nameInfo.getPrefix(prefix_filter::Sample)].push_back(i);
+        auto it = std::find_if(slotInterests.begin(), slotInterests.end(), 
+            [&nameInfo](const std::pair<NamespaceInfo, std::vector<boost::shared_ptr<const Interest>>>& p){
+                return p.first.sampleNo_ == nameInfo.sampleNo_ && sameThreadAndClass(p.first, nameInfo);
+            });
+
+        if (it == slotInterests.end())
+            slotInterests.push_back(std::make_pair(nameInfo, 
+                std::vector<boost::shared_ptr<const Interest>>(1, i)));
+        else
+            it->second.push_back(i);
     }
 
-    for (auto it:slotInterests)
+    for (auto& it:slotInterests)
     {
         bool newRequest = false;
-        boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-        if (activeSlots_.find(it.first) == activeSlots_.end())
+        SlotRing* ring = addRing(it.first);
+        boost::shared_ptr<BufferSlot> slot;
+
         {
-            if (pool_->size() == 0)
+            boost::lock_guard<boost::mutex> scopedLock(getShard(it.first.sampleNo_));
+            RingEntry& entry = getEntry(ring, it.first.sampleNo_);
+
+            if (entry.slot_ && entry.sampleNo_ != it.first.sampleNo_)
             {
-                LogErrorC << "no free slots available" << std::endl;
-                return false;
+                LogWarnC << "ring overflow: dropping " << entry.slot_->dump() << std::endl;
+                dropSlot(entry);
             }
-            else
+
+            if (!entry.slot_)
             {
-                activeSlots_[it.first] = pool_->pop();
+                entry.slot_ = pool_->pop();
+                if (!entry.slot_)
+                {
+                    LogErrorC << "no free slots available" << std::endl;
+                    return false;
+                }
+
+                entry.sampleNo_ = it.first.sampleNo_;
                 newRequest = true;
             }
+
+            entry.slot_->segmentsRequested(it.second);
+            slot = entry.slot_;
         }
         
-        activeSlots_[it.first]->segmentsRequested(it.second);
-        
         if (newRequest) 
-            for (auto o:observers_) o->onNewRequest(activeSlots_[it.first]);
+        {
+            boost::shared_ptr<const ObserverList> observers = getObservers();
+            for (auto o:*observers) o->onNewRequest(slot);
+        }
 
-        LogTraceC << "▷▷▷" << activeSlots_[it.first]->dump()
+        LogTraceC << "▷▷▷" << slot->dump()
         << " x" << it.second.size() << std::endl;
         //LogDebugC << shortdump() << std::endl;
         LogTraceC << dump() << std::endl;
@@ -627,40 +744,58 @@ Buffer::requested(const std::vector<boost::shared_ptr<const ndn::Interest>>& int
 BufferReceipt
 Buffer::received(const boost::shared_ptr<WireSegment>& segment)
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    
     BufferReceipt receipt;
-    Name key = segment->getInfo().getPrefix(prefix_filter::Sample);
+    const NamespaceInfo& info = segment->getInfo();
+    SlotRing* ring = findRing(info);
+    // once shard lock is released, slot may be dropped and recycled for
+    // another sample, so everything needed afterwards (here and by observers)
+    // is taken under the lock
+    int64_t longestDrd;
+    std::string slotDump;
     
-    if (activeSlots_.find(key) == activeSlots_.end())
     {
-        stringstream ss;
-        ss << "Received data that was not previously requested: "
-        << key;
-        throw std::runtime_error(ss.str());
+        boost::lock_guard<boost::mutex> scopedLock(getShard(info.sampleNo_));
+
+        if (!ring || !getEntry(ring, info.sampleNo_).slot_ ||
+            getEntry(ring, info.sampleNo_).sampleNo_ != info.sampleNo_)
+        {
+            stringstream ss;
+            ss << "Received data that was not previously requested: "
+            << info.getPrefix(prefix_filter::Sample);
+            throw std::runtime_error(ss.str());
+        }
+
+        RingEntry& entry = getEntry(ring, info.sampleNo_);
+        receipt.oldState_ = entry.slot_->getState();
+        receipt.segment_ = entry.slot_->segmentReceived(segment);
+        receipt.slot_ = entry.slot_;
+        receipt.newState_ = entry.slot_->getState();
+        receipt.generation_ = entry.slot_->getGeneration();
+        receipt.missingSegments_ = entry.slot_->getMissingSegments();
+        if (receipt.newState_ == BufferSlot::Ready &&
+            entry.slot_->getConsistencyState()&BufferSlot::HeaderMeta &&
+            entry.slot_->data_.isFetched(0))
+            receipt.header_ = boost::make_shared<_CommonHeader>(entry.slot_->getHeader());
+        longestDrd = entry.slot_->getLongestDrd();
+        slotDump = entry.slot_->dump(true);
     }
     
-    BufferSlot::State oldState = activeSlots_[key]->getState();
-    receipt.segment_ = activeSlots_[key]->segmentReceived(segment);
-    receipt.slot_ = activeSlots_[key];
-    receipt.oldState_ = oldState;
-    
-    if (receipt.slot_->getState() == BufferSlot::Ready)
+    if (receipt.newState_ == BufferSlot::Ready)
     {
-        if (oldState != BufferSlot::Ready)
+        if (receipt.oldState_ != BufferSlot::Ready)
         {
-            LogTraceC << "►►►" << receipt.slot_->dump(true)
+            LogTraceC << "►►►" << slotDump
                 << " " << shortdump() << std::endl;
             
             (*sstorage_)[Indicator::AssembledNum]++;
-            if (receipt.slot_->getNameInfo().class_ == SampleClass::Key)
+            if (info.class_ == SampleClass::Key)
             {
                 (*sstorage_)[Indicator::AssembledKeyNum]++;
-                (*sstorage_)[Indicator::FrameFetchAvgKey] = (double)receipt.slot_->getLongestDrd()/1000.;
+                (*sstorage_)[Indicator::FrameFetchAvgKey] = (double)longestDrd/1000.;
             }
             else
             {
-                (*sstorage_)[Indicator::FrameFetchAvgDelta] = (double)receipt.slot_->getLongestDrd()/1000.;
+                (*sstorage_)[Indicator::FrameFetchAvgDelta] = (double)longestDrd/1000.;
             }
             
         }
@@ -669,13 +804,14 @@ Buffer::received(const boost::shared_ptr<WireSegment>& segment)
     {
         if (receipt.oldState_ == BufferSlot::New)
             LogDebugC << "new sample " 
-                      << receipt.segment_->getInfo().getSuffix(suffix_filter::Thread) 
+                      << info.getSuffix(suffix_filter::Thread) 
                       << std::endl;
-        LogTraceC << " ► " << receipt.slot_->dump(true)
-                  << receipt.segment_->getInfo().segNo_ << std::endl;
+        LogTraceC << " ► " << slotDump
+                  << info.segNo_ << std::endl;
     }
     
-    for (auto o:observers_) o->onNewData(receipt);
+    boost::shared_ptr<const ObserverList> observers = getObservers();
+    for (auto o:*observers) o->onNewData(receipt);
     
     return receipt;
 }
@@ -683,21 +819,43 @@ Buffer::received(const boost::shared_ptr<WireSegment>& segment)
 bool
 Buffer::isRequested(const boost::shared_ptr<WireSegment>& segment) const
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    Name key = segment->getInfo().getPrefix(prefix_filter::Sample);
+    const NamespaceInfo& info = segment->getInfo();
+    SlotRing* ring = findRing(info);
+
+    if (!ring)
+        return false;
 
-    return (activeSlots_.find(key) != activeSlots_.end());
+    boost::lock_guard<boost::mutex> scopedLock(getShard(info.sampleNo_));
+    const RingEntry& entry = getEntry(ring, info.sampleNo_);
+
+    return (entry.slot_ && entry.sampleNo_ == info.sampleNo_);
 }
 
 unsigned int 
 Buffer::getSlotsNum(const ndn::Name& prefix, int stateMask) const
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
+    boost::shared_lock<boost::shared_mutex> ringsLock(ringsMutex_);
     unsigned int nSlots = 0;
 
-    for (auto it:activeSlots_)
-        if (prefix.match(it.first) && it.second->getState()&stateMask)
-            nSlots++;
+    for (auto& r:rings_)
+    {
+        // whole ring matches or prefix is more specific than the ring's one
+        bool ringMatches = prefix.match(r->threadPrefix_);
+        if (!ringMatches && !r->threadPrefix_.match(prefix))
+            continue;
+
+        for (size_t shard = 0; shard < ShardsNum; ++shard)
+        {
+            boost::lock_guard<boost::mutex> scopedLock(shards_[shard]);
+            for (size_t i = shard; i < ringSize_; i += ShardsNum)
+            {
+                const boost::shared_ptr<BufferSlot>& slot = r->entries_[i].slot_;
+                if (slot && slot->getState()&stateMask &&
+                    (ringMatches || prefix.match(slot->getPrefix())))
+                    nSlots++;
+            }
+        }
+    }
 
     return nSlots;
 }
@@ -707,30 +865,101 @@ Buffer::attach(IBufferObserver* observer)
 {
     if (observer)
     {
-        boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-        observers_.push_back(observer);
+        boost::lock_guard<boost::mutex> scopedLock(observersMutex_);
+        boost::shared_ptr<ObserverList> observers = boost::make_shared<ObserverList>(*observers_);
+        
+        observers->push_back(observer);
+        boost::atomic_store(&observers_, boost::shared_ptr<const ObserverList>(observers));
     }
 }
 
 void
 Buffer::detach(IBufferObserver* observer)
 {
-    std::vector<IBufferObserver*>::iterator it = std::find(observers_.begin(), observers_.end(), observer);
-    if (it != observers_.end())
+    boost::lock_guard<boost::mutex> scopedLock(observersMutex_);
+    boost::shared_ptr<ObserverList> observers = boost::make_shared<ObserverList>(*observers_);
+    ObserverList::iterator it = std::find(observers->begin(), observers->end(), observer);
+
+    if (it != observers->end())
     {
-        boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-        observers_.erase(it);
+        observers->erase(it);
+        boost::atomic_store(&observers_, boost::shared_ptr<const ObserverList>(observers));
     }
 }
 
-void
-Buffer::invalidate(const Name& slotPrefix)
+Buffer::SlotRing*
+Buffer::findRing(const NamespaceInfo& info) const
+{
+    boost::shared_lock<boost::shared_mutex> ringsLock(ringsMutex_);
+
+    for (auto& r:rings_)
+        if (sameThreadAndClass(r->threadInfo_, info))
+            return r.get();
+
+    return nullptr;
+}
+
+Buffer::SlotRing*
+Buffer::addRing(const NamespaceInfo& info)
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    assert(activeSlots_.find(slotPrefix) != activeSlots_.end());
+    SlotRing* ring = findRing(info);
+
+    if (!ring)
+    {
+        boost::lock_guard<boost::shared_mutex> ringsLock(ringsMutex_);
+
+        for (auto& r:rings_)
+            if (sameThreadAndClass(r->threadInfo_, info))
+                return r.get();
+
+        boost::shared_ptr<SlotRing> r = boost::make_shared<SlotRing>();
+        r->threadInfo_ = info;
+        r->threadPrefix_ = info.getPrefix(prefix_filter::Thread);
+        r->entries_.resize(ringSize_);
+        rings_.push_back(r);
+        ring = r.get();
+
+        LogDebugC << "new slot ring " << r->threadPrefix_ << std::endl;
+    }
 
-    boost::shared_ptr<BufferSlot> slot = activeSlots_.find(slotPrefix)->second;
-    activeSlots_.erase(activeSlots_.find(slotPrefix));
+    return ring;
+}
+
+std::vector<boost::shared_ptr<BufferSlot>>
+Buffer::getActiveSlots() const
+{
+    // slots are returned in the order of their names
+    std::vector<std::pair<const ndn::Name*, boost::shared_ptr<BufferSlot>>> slots;
+    boost::shared_lock<boost::shared_mutex> ringsLock(ringsMutex_);
+
+    for (auto& r:rings_)
+        for (size_t shard = 0; shard < ShardsNum; ++shard)
+        {
+            boost::lock_guard<boost::mutex> scopedLock(shards_[shard]);
+            for (size_t i = shard; i < ringSize_; i += ShardsNum)
+                if (r->entries_[i].slot_)
+                    slots.push_back(std::make_pair(&r->threadPrefix_, r->entries_[i].slot_));
+        }
+
+    std::sort(slots.begin(), slots.end(), 
+        [](const std::pair<const ndn::Name*, boost::shared_ptr<BufferSlot>>& a,
+           const std::pair<const ndn::Name*, boost::shared_ptr<BufferSlot>>& b){
+            int res = a.first->compare(*b.first);
+            return (res == 0 ? a.second->getNameInfo().sampleNo_ < b.second->getNameInfo().sampleNo_ : res < 0);
+        });
+
+    std::vector<boost::shared_ptr<BufferSlot>> activeSlots;
+    activeSlots.reserve(slots.size());
+    for (auto& s:slots) activeSlots.push_back(s.second);
+
+    return activeSlots;
+}
+
+void
+Buffer::dropSlot(RingEntry& entry)
+{
+    boost::shared_ptr<BufferSlot> slot = entry.slot_;
+    entry.slot_.reset();
     
     (*sstorage_)[Indicator::DroppedNum]++;
     if (slot->getState() <= BufferSlot::Assembling)
@@ -746,79 +975,100 @@ Buffer::invalidate(const Name& slotPrefix)
 }
 
 void
-Buffer::invalidatePrevious(const Name& slotPrefix)
+Buffer::invalidatePrevious(const boost::shared_ptr<const BufferSlot>& slot)
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator lower = 
-        activeSlots_.lower_bound(slotPrefix);
-
-    while (activeSlots_.begin() != lower)
+    // drops all slots which names precede the name of given slot, i.e. all 
+    // slots of the threads which prefixes precede slot's thread prefix and
+    // slots of slot's thread with smaller sample numbers
+    const NamespaceInfo& info = slot->getNameInfo();
+    Name threadPrefix = info.getPrefix(prefix_filter::Thread);
+    boost::shared_lock<boost::shared_mutex> ringsLock(ringsMutex_);
+
+    for (auto& r:rings_)
     {
-        LogDebugC << "invalidate " << activeSlots_.begin()->first << std::endl;
-        boost::shared_ptr<BufferSlot> slot = activeSlots_.begin()->second;
-        
-        (*sstorage_)[Indicator::DroppedNum]++;
-        if (slot->getState() <= BufferSlot::Assembling)
-            (*sstorage_)[Indicator::IncompleteNum]++;
-        if (slot->getNameInfo().class_ == SampleClass::Key)
+        int order = r->threadPrefix_.compare(threadPrefix);
+        if (order > 0)
+            continue;
+
+        for (size_t shard = 0; shard < ShardsNum; ++shard)
         {
-            (*sstorage_)[Indicator::DroppedKeyNum]++;
-            if (slot->getState() <= BufferSlot::Assembling)
-                (*sstorage_)[Indicator::IncompleteKeyNum]++;
+            boost::lock_guard<boost::mutex> scopedLock(shards_[shard]);
+            for (size_t i = shard; i < ringSize_; i += ShardsNum)
+            {
+                RingEntry& entry = r->entries_[i];
+                if (entry.slot_ && (order < 0 || entry.sampleNo_ < info.sampleNo_))
+                {
+                    LogDebugC << "invalidate " << entry.slot_->getPrefix() << std::endl;
+                    dropSlot(entry);
+                }
+            }
         }
-        
-        pool_->push(activeSlots_.begin()->second);
-        activeSlots_.erase(activeSlots_.begin());
     }
 }
 
-#if 0
-void
-Buffer::invalidateOldKey(const Name& slotPrefix)
+bool
+Buffer::reserveSlot(const BufferReceipt& receipt)
 {
-    
-}
-#endif
+    // observers are notified outside of shard lock, so slot is looked up by
+    // the name of received segment: slot itself may have been cleared since
+    if (receipt.newState_ != BufferSlot::Ready)
+        return false;
 
-void
-Buffer::reserveSlot(const boost::shared_ptr<const BufferSlot>& slot)
-{
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator it =
-    activeSlots_.find(slot->getPrefix());
+    const NamespaceInfo& info = receipt.segment_->getInfo();
+    SlotRing* ring = findRing(info);
+
+    if (!ring)
+        return false;
+
+    boost::lock_guard<boost::mutex> scopedLock(getShard(info.sampleNo_));
+    RingEntry& entry = getEntry(ring, info.sampleNo_);
     
-    if (it != activeSlots_.end())
+    if (entry.slot_.get() != receipt.slot_.get() || 
+        entry.sampleNo_ != info.sampleNo_ ||
+        entry.slot_->getGeneration() != receipt.generation_ ||
+        entry.slot_->getState() != BufferSlot::Ready)
+        return false;
+
     {
-        reservedSlots_[slot->getPrefix()] = activeSlots_[slot->getPrefix()];
-        activeSlots_.erase(it);
-        reservedSlots_[slot->getPrefix()]->toggleLock();
+        boost::lock_guard<boost::mutex> reservedLock(reservedMutex_);
+        reservedSlots_[entry.slot_.get()] = entry.slot_;
     }
+    entry.slot_->toggleLock();
+    entry.slot_.reset();
+
+    return true;
 }
 
 void
 Buffer::releaseSlot(const boost::shared_ptr<const BufferSlot>& slot)
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-    std::map<ndn::Name, boost::shared_ptr<BufferSlot>>::iterator it =
-    reservedSlots_.find(slot->getPrefix());
-    
-    if (it != reservedSlots_.end())
+    boost::shared_ptr<BufferSlot> reserved;
+
     {
-        pool_->push(it->second);
-        reservedSlots_.erase(it);
+        boost::lock_guard<boost::mutex> scopedLock(reservedMutex_);
+        std::map<const BufferSlot*, boost::shared_ptr<BufferSlot>>::iterator it =
+        reservedSlots_.find(slot.get());
+
+        if (it != reservedSlots_.end())
+        {
+            reserved = it->second;
+            reservedSlots_.erase(it);
+        }
     }
+    
+    if (reserved)
+        pool_->push(reserved);
 }
 
 std::string
 Buffer::dump() const
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     int i = 0;
     stringstream ss;
     ss << "buffer dump:";
 
-    for (auto& s:activeSlots_)
-        ss << std::endl << ++i << " " << s.second->dump();
+    for (auto& s:getActiveSlots())
+        ss << std::endl << ++i << " " << s->dump();
 
     return ss.str();
 }
@@ -826,12 +1076,10 @@ Buffer::dump() const
 std::string
 Buffer::shortdump() const
 {
-    boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
     stringstream ss;
     ss << "[ ";
 
-    //dumpSlotDictionary(ss, reservedSlots_);
-    dumpSlotDictionary(ss, activeSlots_);
+    dumpSlotDictionary(ss, getActiveSlots());
 
     ss << " ]";
 
@@ -840,19 +1088,19 @@ Buffer::shortdump() const
 
 void
 Buffer::dumpSlotDictionary(stringstream& ss, 
-    const map<ndn::Name, boost::shared_ptr<BufferSlot>> &slotDict) const
+    const std::vector<boost::shared_ptr<BufferSlot>> &slots) const
 {
     int i = 0;
-    for (auto& s:slotDict)
+    for (auto& s:slots)
     {
-        if ((i++ % 10 == 0) || !s.second->getNameInfo().isDelta_ )
+        if ((i++ % 10 == 0) || !s->getNameInfo().isDelta_ )
         {
-            ss << s.second->getNameInfo().sampleNo_; 
-            ss << (s.second->getNameInfo().isDelta_ ? "" : "K");
+            ss << s->getNameInfo().sampleNo_; 
+            ss << (s->getNameInfo().isDelta_ ? "" : "K");
         }
 
-        ss << (s.second->getAssembledLevel() >= 1 ? "■" :
-            (s.second->getAssembledLevel() > 0 ? "◘" : "☐" ));
+        ss << (s->getAssembledLevel() >= 1 ? "■" :
+            (s->getAssembledLevel() > 0 ? "◘" : "☐" ));
     }
 }
 
@@ -902,7 +1150,7 @@ PlaybackQueue::pop(ExtractSlot extract)
         (*sstorage_)[Indicator::AcquiredNum]++;
         
         if (slot->getNameInfo().isDelta_)
-            buffer_->invalidatePrevious(slot->getPrefix());
+            buffer_->invalidatePrevious(slot);
         else
         {
             // TODO: invalidate old key frames
@@ -982,12 +1230,20 @@ PlaybackQueue::onNewRequest(const boost::shared_ptr<BufferSlot>&)
 void 
 PlaybackQueue::onNewData(const BufferReceipt& receipt)
 {
-    if (receipt.slot_->getState() == BufferSlot::Ready &&
-        streamPrefix_.match(receipt.slot_->getPrefix()))
+    if (receipt.newState_ == BufferSlot::Ready &&
+        streamPrefix_.match(receipt.segment_->getInfo().getPrefix(prefix_filter::Sample)))
     {
         boost::lock_guard<boost::recursive_mutex> scopedLock(mutex_);
-        buffer_->reserveSlot(receipt.slot_);
-        packetRate_ = receipt.slot_->getHeader().sampleRate_;
+        if (!buffer_->reserveSlot(receipt))
+        {
+            LogDebugC << "assembled frame was dropped before it was queued: "
+                      << receipt.segment_->getInfo().getSuffix(suffix_filter::Thread) << std::endl;
+            return;
+        }
+
+        // slot is locked for playback now and can't be reused
+        if (receipt.header_)
+            packetRate_ = receipt.header_->sampleRate_;
         queue_.insert(Sample(receipt.slot_));
 
         for (auto o:observers_) o->onNewSampleReady();
@@ -13,6 +13,7 @@
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread.hpp>
+#include <boost/dynamic_bitset.hpp>
 #include <ndn-cpp/name.hpp>
 
 #include "name-components.hpp"
@@ -143,7 +144,8 @@ namespace ndnrtc
         /**
          * Clears all internal structures of this slot and returns to Free state
          * as if slot has just been created. No memory deallocation/reallocation is
-         * performed, thus operation is not expensive.
+         * performed, thus operation is not expensive. Every clear starts new
+         * generation of the slot.
          */
         void
         clear();
@@ -182,6 +184,12 @@ namespace ndnrtc
         Verification getVerificationStatus() const { return verified_; }
 
         State getState() const { return state_; }
+
+        /**
+         * Returns number of times slot has been cleared; lets holders of a
+         * slot tell whether it still holds the same sample
+         */
+        uint64_t getGeneration() const { return generation_; }
         
         double getAssembledLevel() const { return asmLevel_; }
 
@@ -191,9 +199,9 @@ namespace ndnrtc
         unsigned int getRtxNum() const { return nRtx_; }
         int getRtxNum(const ndn::Name& segmentName);
         bool hasOriginalSegments() const { return hasOriginalSegments_; }
-        size_t getFetchedNum() const { return fetched_.size(); }
+        size_t getFetchedNum() const { return nFetched_; }
         void toggleLock();
-        bool hasAllSegmentsFetched() const { return nDataSegments_+nParitySegments_ == fetched_.size(); }
+        bool hasAllSegmentsFetched() const { return nDataSegments_+nParitySegments_ == nFetched_; }
         int64_t getAssemblingTime() const
         { return ( state_ >= Ready ? assembledTimeUsec_-firstSegmentTimeUsec_ : 0); }
         int64_t getShortestDrd() const
@@ -219,9 +227,38 @@ namespace ndnrtc
         friend ManifestValidator;
         friend Buffer;
 
+        /**
+         * Segments of one class (data or parity) indexed by segment number.
+         * Bitsets mark requested and fetched segments. Clearing keeps 
+         * allocated memory, so slots reused from the pool don't reallocate.
+         */
+        class SegmentArray {
+        public:
+            void clear();
+            void add(unsigned int segNo, const boost::shared_ptr<SlotSegment>& segment);
+            bool isRequested(unsigned int segNo) const
+            { return segNo < requested_.size() && requested_[segNo]; }
+            bool isFetched(unsigned int segNo) const
+            { return segNo < fetched_.size() && fetched_[segNo]; }
+            void setFetched(unsigned int segNo) { fetched_[segNo] = true; }
+            const boost::shared_ptr<SlotSegment>& get(unsigned int segNo) const
+            { return segments_[segNo]; }
+            size_t size() const { return segments_.size(); }
+            // iteration over fetched segment numbers in ascending order
+            size_t firstFetched() const { return fetched_.find_first(); }
+            size_t nextFetched(size_t segNo) const { return fetched_.find_next(segNo); }
+            static const size_t npos = boost::dynamic_bitset<>::npos;
+
+        private:
+            std::vector<boost::shared_ptr<SlotSegment>> segments_;
+            boost::dynamic_bitset<> requested_, fetched_;
+        };
+
         ndn::Name name_;
         NamespaceInfo nameInfo_;
-        std::map<ndn::Name, boost::shared_ptr<SlotSegment>> requested_, fetched_;
+        uint64_t generation_;
+        SegmentArray data_, parity_;
+        size_t nFetched_;
         boost::shared_ptr<SlotSegment> lastFetched_;
         unsigned int consistency_, nRtx_, assembledSize_;
         unsigned int nDataSegments_, nParitySegments_;
@@ -234,6 +271,11 @@ namespace ndnrtc
 
         virtual void updateConsistencyState(const boost::shared_ptr<SlotSegment>& segment);
         void updateAssembledLevel();
+
+        SegmentArray& segments(const NamespaceInfo& info)
+        { return (info.isParity_ ? parity_ : data_); }
+        const SegmentArray& segments(const NamespaceInfo& info) const
+        { return (info.isParity_ ? parity_ : data_); }
     };
 
     //******************************************************************************
@@ -264,6 +306,11 @@ namespace ndnrtc
     private:
         boost::shared_ptr<std::vector<uint8_t>> storage_;
         std::vector<uint8_t> fecList_;
+
+        static unsigned int
+        placeSegments(const BufferSlot::SegmentArray& segments,
+                      uint8_t *buffer, unsigned int nSymbols, size_t symbolLength,
+                      uint8_t *symbolList);
     };
 
     //******************************************************************************
@@ -289,6 +336,9 @@ namespace ndnrtc
     };
 
     //******************************************************************************
+    /**
+     * Thread-safe pool of buffer slots.
+     */
     class SlotPool {
     public:
         SlotPool(const size_t& capacity = 300);
@@ -297,11 +347,12 @@ namespace ndnrtc
         bool push(const boost::shared_ptr<BufferSlot>& slot);
 
         size_t capacity() const { return capacity_; }
-        size_t size() const { return pool_.size(); }
+        size_t size() const;
 
     private:
         SlotPool(const SlotPool&) = delete;
 
+        mutable boost::mutex mutex_;
         size_t capacity_;
         std::vector<boost::shared_ptr<BufferSlot>> pool_;
     };
@@ -310,10 +361,27 @@ namespace ndnrtc
     class IBufferObserver;
     class PlaybackQueue;
 
+    /**
+     * Result of adding received segment to the buffer. Besides the slot
+     * itself, receipt holds a snapshot of slot taken under buffer lock:
+     * observers are notified without buffer locks, so slot may be dropped
+     * and reused for another sample meanwhile. Slot can be accessed only if
+     * its generation is still the one of the receipt, see 
+     * BufferReceipt::isCurrent().
+     */
     typedef struct _BufferReceipt {
         boost::shared_ptr<const BufferSlot> slot_;
         boost::shared_ptr<const SlotSegment> segment_;
         BufferSlot::State oldState_;
+        // snapshot of the slot right after segment was added
+        BufferSlot::State newState_;
+        uint64_t generation_;
+        std::vector<ndn::Name> missingSegments_;
+        // set once slot is ready
+        boost::shared_ptr<const _CommonHeader> header_;
+
+        bool isCurrent() const 
+        { return slot_ && slot_->getGeneration() == generation_; }
     } BufferReceipt;
 
     class IBuffer {
@@ -328,11 +396,29 @@ namespace ndnrtc
         virtual void detach(IBufferObserver* observer) = 0;
     };
 
+    /**
+     * Buffer keeps slots of samples that are being fetched. Active slots are
+     * indexed by (thread, sample class, sample number): each thread and sample
+     * class (delta or key frames) has its own fixed-size ring of entries and
+     * slot of sample n lives in entry n % ringSize. Ring entries are guarded
+     * by striped locks (entry i of every ring belongs to shard i % ShardsNum),
+     * so segments of different samples can be processed concurrently. Ring
+     * of a segment is looked up by comparing its namespace info (including
+     * base prefix) with the one of each ring; there are few rings per buffer,
+     * and slots themselves are never looked up by name. Ring size is rounded
+     * up to a multiple of ShardsNum (and is at least ShardsNum). Should ring 
+     * entry be still occupied by a slot of an older sample when a new sample 
+     * is requested, older slot is dropped.
+     * Observers are notified without holding any buffer locks, hence slot of
+     * a receipt may be dropped by the time observer gets it; observers rely
+     * on receipt's snapshot and check slot generation before using the slot.
+     */
     class Buffer : public NdnRtcComponent, public IBuffer {
     public:
         Buffer(boost::shared_ptr<statistics::StatisticsStorage> storage,
                boost::shared_ptr<SlotPool> pool =
-                boost::shared_ptr<SlotPool>(new SlotPool()));
+                boost::shared_ptr<SlotPool>(new SlotPool()),
+               size_t ringSize = 256);
 
         void reset();
 
@@ -351,10 +437,31 @@ namespace ndnrtc
     private:
         friend PlaybackQueue;
 
-        mutable boost::recursive_mutex mutex_;
+        static const size_t ShardsNum = 16;
+
+        typedef struct _RingEntry {
+            PacketNumber sampleNo_;
+            boost::shared_ptr<BufferSlot> slot_;
+        } RingEntry;
+
+        typedef struct _SlotRing {
+            NamespaceInfo threadInfo_;
+            ndn::Name threadPrefix_;
+            std::vector<RingEntry> entries_;
+        } SlotRing;
+
+        typedef std::vector<IBufferObserver*> ObserverList;
+
         boost::shared_ptr<SlotPool> pool_;
-        std::map<ndn::Name, boost::shared_ptr<BufferSlot>> activeSlots_, reservedSlots_;
-        std::vector<IBufferObserver*> observers_;
+        size_t ringSize_;
+        // guards list of rings; rings are never removed, only added
+        mutable boost::shared_mutex ringsMutex_;
+        std::vector<boost::shared_ptr<SlotRing>> rings_;
+        mutable boost::mutex shards_[ShardsNum];
+        boost::mutex reservedMutex_;
+        std::map<const BufferSlot*, boost::shared_ptr<BufferSlot>> reservedSlots_;
+        boost::mutex observersMutex_;
+        boost::shared_ptr<const ObserverList> observers_;
         boost::shared_ptr<statistics::StatisticsStorage> sstorage_;
         
         std::string
@@ -362,12 +469,27 @@ namespace ndnrtc
 
         void 
         dumpSlotDictionary(std::stringstream&, 
-            const std::map<ndn::Name, boost::shared_ptr<BufferSlot>> &) const;
+            const std::vector<boost::shared_ptr<BufferSlot>> &) const;
         
-        void invalidate(const ndn::Name& slotPrefix);
-        void invalidatePrevious(const ndn::Name& slotPrefix);
+        SlotRing* findRing(const NamespaceInfo& info) const;
+        SlotRing* addRing(const NamespaceInfo& info);
+        boost::mutex& getShard(PacketNumber sampleNo) const 
+        { return shards_[sampleNo % ShardsNum]; }
+        RingEntry& getEntry(SlotRing* ring, PacketNumber sampleNo) const
+        { return ring->entries_[sampleNo % ringSize_]; }
+        boost::shared_ptr<const ObserverList> getObservers() const
+        { return boost::atomic_load(&observers_); }
+        std::vector<boost::shared_ptr<BufferSlot>> getActiveSlots() const;
+
+        void invalidatePrevious(const boost::shared_ptr<const BufferSlot>& slot);
+        void dropSlot(RingEntry& entry);
         
-        void reserveSlot(const boost::shared_ptr<const BufferSlot>& slot);
+        /**
+         * Takes assembled slot of receipt out of its ring, so it can not be
+         * dropped or reused while in playback queue. Returns false if slot
+         * was dropped (or reused) after receipt was issued.
+         */
+        bool reserveSlot(const BufferReceipt& receipt);
         void releaseSlot(const boost::shared_ptr<const BufferSlot>& slot);
     };
 
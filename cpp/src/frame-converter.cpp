@@ -6,12 +6,31 @@
 //
 
 #include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
+#include <webrtc/common_video/include/video_frame_buffer.h>
+#include <webrtc/base/callback.h>
 #include "frame-converter.hpp"
 #include <stdexcept>
+#include <cstring>
 
 using namespace ndnrtc;
 using namespace webrtc;
 #include <iostream>
+
+namespace {
+	void copyPlane(const unsigned char* src, unsigned int srcStride,
+		uint8_t* dst, int dstStride, unsigned int width, unsigned int height)
+	{
+		if (!height)
+			return;
+
+		if (srcStride == (unsigned int)dstStride)
+			memcpy(dst, src, srcStride*(height-1)+width);
+		else
+			for (unsigned int row = 0; row < height; ++row)
+				memcpy(dst+row*dstStride, src+row*srcStride, width);
+	}
+}
+
 WebRtcVideoFrame RawFrameConverter::operator<<(const struct _8bitFixedSizeRawFrameWrapper& wr)
 {
     // NOTE: after many hours debugging and reading bytes, it is still uknown 
@@ -28,15 +47,9 @@ WebRtcVideoFrame RawFrameConverter::operator<<(const struct _8bitFixedSizeRawFra
 WebRtcVideoFrame RawFrameConverter::convert(const ArgbRawFrameWrapper& wr, const VideoType& commonVideoType)
 {             
 	// make conversion to I420
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer = pool_.getBuffer(wr.width_, wr.height_);
 
-	int stride_y = wr.width_;
-	int stride_uv = (wr.width_ + 1) / 2;
-	int target_width = wr.width_;
-	int target_height = wr.height_;
-
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, stride_y, stride_uv, stride_uv);
-
-	if (!frameBuffer_)
+	if (!frameBuffer)
 		throw std::runtime_error("Failed to allocate I420 frame");
 
 	const int conversionResult = ConvertToI420(commonVideoType,
@@ -45,40 +58,54 @@ WebRtcVideoFrame RawFrameConverter::convert(const ArgbRawFrameWrapper& wr, const
                                                wr.width_, wr.height_,
                                                wr.frameSize_,
                                                kVideoRotation_0,
-                                               frameBuffer_.get());
+                                               frameBuffer.get());
 	if (conversionResult < 0)
 		throw std::runtime_error("Failed to convert capture frame to I420");
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
 }
 
 WebRtcVideoFrame RawFrameConverter::operator<<(const I420RawFrameWrapper& wr)
 {
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, wr.strideY_, wr.strideU_, wr.strideV_);
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer = pool_.getBuffer(wr.width_, wr.height_);
+
+	if (!frameBuffer)
+		throw std::runtime_error("Failed to allocate I420 frame");
+
+	// pooled buffers have default strides, so planes are copied row by row
+	unsigned int chromaWidth = (wr.width_+1)/2, chromaHeight = (wr.height_+1)/2;
+	copyPlane(wr.yBuffer_, wr.strideY_, frameBuffer->MutableDataY(), frameBuffer->StrideY(),
+		wr.width_, wr.height_);
+	copyPlane(wr.uBuffer_, wr.strideU_, frameBuffer->MutableDataU(), frameBuffer->StrideU(),
+		chromaWidth, chromaHeight);
+	copyPlane(wr.vBuffer_, wr.strideV_, frameBuffer->MutableDataV(), frameBuffer->StrideV(),
+		chromaWidth, chromaHeight);
 
-	unsigned int ySize = wr.strideY_*wr.height_;
-	unsigned int uSize = wr.strideU_*(wr.height_+1)/2;
-	unsigned int vSize = wr.strideV_*(wr.height_+1)/2;
-	memcpy(frameBuffer_->MutableDataY(), wr.yBuffer_, ySize);
-	memcpy(frameBuffer_->MutableDataU(), wr.uBuffer_, uSize);
-	memcpy(frameBuffer_->MutableDataV(), wr.vBuffer_, vSize);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
+}
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+WebRtcVideoFrame RawFrameConverter::wrap(const I420RawFrameWrapper& wr,
+	boost::function<void(void)> onReleased)
+{
+	WebRtcSmartPtr<VideoFrameBuffer> frameBuffer(
+		new rtc::RefCountedObject<WrappedI420Buffer>(wr.width_, wr.height_,
+			wr.yBuffer_, wr.strideY_,
+			wr.uBuffer_, wr.strideU_,
+			wr.vBuffer_, wr.strideV_,
+			rtc::Callback0<void>([onReleased](){
+				if (onReleased) onReleased();
+			})));
+
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
 }
 
 WebRtcVideoFrame RawFrameConverter::operator<<(const YUV_NV21FrameWrapper& wr)
 {             
 	// make conversion to I420
 	const VideoType commonVideoType = RawVideoTypeToCommonVideoVideoType(kVideoNV21);
+	WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer = pool_.getBuffer(wr.width_, wr.height_);
 
-	int stride_y = wr.width_;
-	int stride_uv = (wr.width_ + 1) / 2;
-	int target_width = wr.width_;
-	int target_height = wr.height_;
-
-	frameBuffer_ = I420Buffer::Create(wr.width_, wr.height_, stride_y, stride_uv, stride_uv);
-
-	if (!frameBuffer_)
+	if (!frameBuffer)
 		throw std::runtime_error("Failed to allocate I420 frame");
 
 	const int conversionResult = ConvertToI420(commonVideoType,
@@ -87,9 +114,9 @@ WebRtcVideoFrame RawFrameConverter::operator<<(const YUV_NV21FrameWrapper& wr)
                                                wr.width_, wr.height_,
                                                wr.strideY_+wr.strideUV_,
                                                kVideoRotation_0,
-                                               frameBuffer_.get());
+                                               frameBuffer.get());
 	if (conversionResult < 0)
 		throw std::runtime_error("Failed to convert capture frame to I420");
 
-	return WebRtcVideoFrame(frameBuffer_, webrtc::kVideoRotation_0, 0);
+	return WebRtcVideoFrame(frameBuffer, webrtc::kVideoRotation_0, 0);
 }
@@ -5,7 +5,10 @@
 //  Copyright 2013-2016 Regents of the University of California
 //
 
+#include <boost/function.hpp>
+
 #include "webrtc.hpp"
+#include "frame-buffer-pool.hpp"
 
 namespace ndnrtc {
 	struct _8bitFixedSizeRawFrameWrapper {
@@ -41,8 +44,9 @@ namespace ndnrtc {
 
 	/**
 	 * FrameConverter converts wrappers of raw video frames into a
-	 * WebRTC raw video frame object. Converted object is stored inside the
-	 * converter and is valid as long as converter lives.
+	 * WebRTC raw video frame object. Converted frames use buffers from the
+	 * converter's pool; a buffer is reused once all copies of the frame are
+	 * released. Conversions must be made on one thread at a time.
 	 */
 	class RawFrameConverter 
 	{
@@ -54,8 +58,19 @@ namespace ndnrtc {
 		WebRtcVideoFrame operator<<(const I420RawFrameWrapper&);
 		WebRtcVideoFrame operator<<(const YUV_NV21FrameWrapper&);
 
+		/**
+		 * Wraps I420 planes into a frame without copying them. Caller keeps
+		 * ownership of the planes and must keep them valid and unchanged
+		 * until onReleased is called. onReleased is called once, on the
+		 * thread that releases the last copy of the frame.
+		 */
+		static WebRtcVideoFrame wrap(const I420RawFrameWrapper&,
+			boost::function<void(void)> onReleased);
+
+		unsigned int getAllocatedNum() const { return pool_.getAllocatedNum(); }
+
 	private:
-		WebRtcSmartPtr<WebRtcVideoFrameBuffer> frameBuffer_;
+		FrameBufferPool pool_;
 
         WebRtcVideoFrame convert(const struct _8bitFixedSizeRawFrameWrapper&, 
                                  const webrtc::VideoType&);
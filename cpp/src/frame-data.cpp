@@ -21,6 +21,89 @@ using namespace webrtc;
 
 namespace ndnrtc {
 
+ParityBufferPool::ParityBufferPool(size_t capacity) : capacity_(capacity),
+                                                      hits_(0), misses_(0)
+{
+    buffers_.reserve(capacity_);
+}
+
+boost::shared_ptr<NetworkData>
+ParityBufferPool::acquire(size_t length, uint8_t **bufferData)
+{
+    boost::shared_ptr<Buffer> freeBuffer;
+
+    // buffer is free when the pool holds the only reference to it
+    for (auto &b : buffers_)
+        if (b.unique() && (!freeBuffer || b->capacity() > freeBuffer->capacity()))
+        {
+            freeBuffer = b;
+            if (freeBuffer->capacity() >= length)
+                break;
+        }
+
+    if (freeBuffer && freeBuffer->capacity() >= length)
+        hits_++;
+    else
+    {
+        misses_++;
+        if (!freeBuffer)
+        {
+            freeBuffer = boost::make_shared<Buffer>();
+            if (buffers_.size() < capacity_)
+                buffers_.push_back(freeBuffer);
+        }
+    }
+
+    *bufferData = freeBuffer->resize(length);
+    return freeBuffer;
+}
+
+VideoFramePacketPool::VideoFramePacketPool(size_t capacity) : capacity_(capacity),
+                                                              hits_(0), misses_(0),
+                                                              maxFrameLength_(0), maxOverhead_(0)
+{
+    packets_.reserve(capacity_);
+}
+
+boost::shared_ptr<VideoFramePacket>
+VideoFramePacketPool::acquire(const webrtc::EncodedImage &frame)
+{
+    boost::shared_ptr<VideoFramePacket> freePacket;
+
+    // packet is free when the pool holds the only reference to it; packets
+    // that were published tell how many bytes sync list and headers take
+    for (auto &p : packets_)
+        if (p.unique())
+        {
+            if (p->isValid())
+                maxOverhead_ = std::max(maxOverhead_, (size_t)p->getLength() - p->getPayload().size());
+            if (!freePacket || p->getCapacity() > freePacket->getCapacity())
+                freePacket = p;
+        }
+
+    // until some packet comes back, only common header is accounted for
+    maxFrameLength_ = std::max(maxFrameLength_, frame._length);
+    size_t reserveLength = maxFrameLength_ +
+                           std::max(maxOverhead_, VideoFramePacket::wireLength(0, sizeof(CommonHeader)));
+
+    if (freePacket && freePacket->getCapacity() >= reserveLength)
+        hits_++;
+    else
+    {
+        misses_++;
+        if (!freePacket)
+        {
+            freePacket = boost::make_shared<VideoFramePacket>(frame, reserveLength);
+            if (packets_.size() < capacity_)
+                packets_.push_back(freePacket);
+            return freePacket;
+        }
+    }
+
+    freePacket->reset(frame, reserveLength);
+    return freePacket;
+}
+
 template <>
 boost::shared_ptr<VideoFramePacket>
 VideoFramePacket::merge(const std::vector<ImmutableHeaderPacket<VideoFrameSegmentHeader>> &segments)
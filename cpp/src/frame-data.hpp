@@ -35,9 +35,10 @@ namespace ndnrtc
  * that data segments can't be created without corresponding data packet. 
  * Usually, one would use slice() static method to generate a vector of 
  * segments that altogether represent given data packet. As data segment 
- * doesn't carry additional storage, it's leightweight. A copy of NetworkData
- * is created when getNetworkData() is called. This must be called right before
- * transferring data over the wire (publishing).
+ * doesn't carry additional storage, it's leightweight. Segment's wire encoding
+ * (header followed by the payload view) is written in one pass by 
+ * getWireData() right before transferring data over the wire (publishing).
+ * getNetworkData() is kept for the code that needs NetworkData object.
  * Class can be instantiated with different headers.
  * @see slice()
  * @see VideoFrameSegment
@@ -71,6 +72,33 @@ class DataSegment : protected DataPacket::Blob
         return sp;
     }
 
+    /**
+     * Encodes segment into a new buffer which has exactly the same layout as
+     * the one returned by getNetworkData(), i.e.:
+     *
+     *      <1><header_size_byte0><header_size_byte1><header><payload>
+     *
+     * Header and payload are copied straight into their final positions,
+     * so payload bytes are copied only once. Returned buffer can be passed
+     * to ndn::Blob without copying.
+     */
+    const boost::shared_ptr<std::vector<uint8_t>> getWireData() const
+    {
+        boost::shared_ptr<std::vector<uint8_t>> wire =
+            boost::make_shared<std::vector<uint8_t>>();
+        uint16_t headerSize = sizeof(Header);
+
+        wire->reserve(size());
+        wire->push_back(1);
+        wire->push_back(headerSize & 0x00ff);
+        wire->push_back((headerSize & 0xff00) >> 8);
+        wire->insert(wire->end(), (const uint8_t *)&header_,
+                     (const uint8_t *)&header_ + sizeof(Header));
+        wire->insert(wire->end(), begin_, end_);
+
+        return wire;
+    }
+
     /**
      * This calculates total wire length for a segment with given payload 
      * length
@@ -105,6 +133,8 @@ class DataSegment : protected DataPacket::Blob
         if (payloadLength == 0)
             return segments;
 
+        segments.reserve(numSlices(nd, segmentWireLength));
+
         std::vector<uint8_t>::const_iterator p1 = nd.data().begin();
         std::vector<uint8_t>::const_iterator p2 = p1 + payloadLength;
 
@@ -129,6 +159,47 @@ class DataSegment : protected DataPacket::Blob
 typedef DataSegment<VideoFrameSegmentHeader> VideoFrameSegment;
 typedef DataSegment<DataSegmentHeader> CommonSegment;
 
+/*******************************************************************************
+ * Pool of buffers for FEC parity data. Buffer returned by acquire() goes back 
+ * to the pool once all outside references to it are released, so in steady
+ * state (frames of similar size) parity buffers are reused without heap
+ * allocations. Pool is not thread-safe and is meant to be used by one 
+ * publishing thread.
+ */
+class ParityBufferPool
+{
+  public:
+    ParityBufferPool(size_t capacity = 16);
+
+    /**
+     * Returns a buffer of given length. Contents of the buffer are undefined.
+     */
+    boost::shared_ptr<NetworkData> acquire(size_t length, uint8_t **bufferData);
+
+    uint64_t getHitsNum() const { return hits_; }
+    uint64_t getMissesNum() const { return misses_; }
+    size_t size() const { return buffers_.size(); }
+
+  private:
+    ParityBufferPool(const ParityBufferPool &) = delete;
+
+    class Buffer : public NetworkData
+    {
+      public:
+        Buffer() : NetworkData(std::vector<uint8_t>()) {}
+        uint8_t *resize(size_t length)
+        {
+            _data().resize(length);
+            return _data().data();
+        }
+        size_t capacity() const { return _data().capacity(); }
+    };
+
+    size_t capacity_;
+    uint64_t hits_, misses_;
+    std::vector<boost::shared_ptr<Buffer>> buffers_;
+};
+
 /*******************************************************************************
  * VideoFramePacket provides interface for preparing encoded video frame for
  * publishing as a data packet.
@@ -142,9 +213,26 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
     ENABLE_IF(T, Immutable)
     VideoFramePacketT(const boost::shared_ptr<const std::vector<uint8_t>> &data) : HeaderPacketT<CommonHeader, T>(data) {}
 
+    /**
+     * @param reserveLength Packet storage is reserved for this many bytes,
+     *                      so sync list and header can be added without
+     *                      reallocations
+     */
     ENABLE_IF(T, Mutable)
-    VideoFramePacketT(const webrtc::EncodedImage &frame) : HeaderPacketT<CommonHeader, T>(frame._length, frame._buffer),
-                                                           isSyncListSet_(false)
+    VideoFramePacketT(const webrtc::EncodedImage &frame, size_t reserveLength = 0)
+        : HeaderPacketT<CommonHeader, T>(std::vector<uint8_t>()),
+          isSyncListSet_(false)
+    {
+        reset(frame, reserveLength);
+    }
+
+    /**
+     * Re-initializes packet with new encoded frame, reusing packet's storage.
+     * Frame header is written before the frame is copied, so frame bytes are
+     * not moved. Sync list and header have to be set again.
+     */
+    ENABLE_IF(T, Mutable)
+    void reset(const webrtc::EncodedImage &frame, size_t reserveLength = 0)
     {
         assert(frame._encodedWidth);
         assert(frame._encodedHeight);
@@ -157,9 +245,19 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         hdr.frameType_ = frame._frameType;
         hdr.completeFrame_ = frame._completeFrame;
         hdr.frameLength_ = frame._length;
+
+        this->_data().reserve(std::max(reserveLength, this->wireLength(frame._length, sizeof(hdr))));
+        this->clear();
         this->addBlob(sizeof(hdr), (uint8_t *)&hdr);
+        this->_data().insert(this->_data().end(), frame._buffer, frame._buffer + frame._length);
+        this->reinit();
+        this->isValid_ = false;
+        isSyncListSet_ = false;
     }
 
+    ENABLE_IF(T, Mutable)
+    size_t getCapacity() const { return this->_data().capacity(); }
+
     ENABLE_IF(T, Mutable)
     VideoFramePacketT(NetworkData &&networkData) : CommonSamplePacket(boost::move(networkData)) {}
 
@@ -199,23 +297,33 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         if (!this->isValid_)
             throw std::runtime_error("Can't compute FEC parity data on invalid packet");
 
-        size_t nDataSegmets = this->getLength() / segmentLength + (this->getLength() % segmentLength ? 1 : 0);
-        size_t nParitySegments = ceil(ratio * nDataSegmets);
-        if (nParitySegments == 0)
-            nParitySegments = 1;
-
-        std::vector<uint8_t> fecData(nParitySegments * segmentLength, 0);
-        fec::Rs28Encoder enc(nDataSegmets, nParitySegments, segmentLength);
-        size_t padding = (nDataSegmets * segmentLength - this->getLength());
+        std::vector<uint8_t> fecData(getParityLength(segmentLength, ratio), 0);
         boost::shared_ptr<NetworkData> parityData;
 
-        // expand data with zeros
-        this->_data().resize(nDataSegmets * segmentLength, 0);
-        if (enc.encode(this->_data().data(), fecData.data()) >= 0)
+        if (encodeParity(segmentLength, fecData.size() / segmentLength, fecData.data()) >= 0)
             parityData = boost::make_shared<NetworkData>(boost::move(fecData));
-        // shrink data back
-        this->_data().resize(this->getLength() - padding);
-        this->reinit(); // data may have been relocated, so we need to reinit blobs
+
+        return parityData;
+    }
+
+    /**
+     * Same as above, but parity buffer is taken from the pool and coder 
+     * session is taken from the calling thread's fec::Rs28CoderCache. Once 
+     * pool and cache are warmed up, no heap allocations are performed.
+     */
+    ENABLE_IF(T, Mutable)
+    boost::shared_ptr<NetworkData>
+    getParityData(size_t segmentLength, double ratio, ParityBufferPool &pool)
+    {
+        if (!this->isValid_)
+            throw std::runtime_error("Can't compute FEC parity data on invalid packet");
+
+        size_t parityLength = getParityLength(segmentLength, ratio);
+        uint8_t *fecData;
+        boost::shared_ptr<NetworkData> parityData = pool.acquire(parityLength, &fecData);
+
+        if (encodeParity(segmentLength, parityLength / segmentLength, fecData) < 0)
+            parityData.reset();
 
         return parityData;
     }
@@ -229,12 +337,30 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
         if (isSyncListSet_)
             throw std::runtime_error("Sync list has been already set");
 
-        for (auto it : syncList)
+        // reserve room only for the blobs written below: as with addBlob,
+        // empty thread names are not written
+        size_t length = 0;
+        for (const auto &it : syncList)
         {
-            this->addBlob(it.first.size(), (uint8_t *)it.first.c_str());
-            this->addBlob(sizeof(it.second), (uint8_t *)&it.second);
+            if (it.first.size())
+                length += DataPacketT<T>::wireLength(it.first.size());
+            length += DataPacketT<T>::wireLength(sizeof(it.second));
         }
 
+        // blobs are written in place, in front of the payload
+        typename T::payload_iter p = this->_data().insert(this->payloadBegin_, length, 0);
+        for (const auto &it : syncList)
+        {
+            if (it.first.size())
+            {
+                p = this->writeBlob(p, it.first.size(), (const uint8_t *)it.first.c_str());
+                this->_data()[0]++;
+            }
+            p = this->writeBlob(p, sizeof(it.second), (const uint8_t *)&it.second);
+            this->_data()[0]++;
+        }
+        this->reinit();
+
         isSyncListSet_ = true;
     }
 
@@ -245,6 +371,29 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
     merge(const ImmutableVideoSegmentsVector &segments);
 
   private:
+    size_t getDataSegmentsNum(size_t segmentLength) const
+    {
+        return this->getLength() / segmentLength + (this->getLength() % segmentLength ? 1 : 0);
+    }
+
+    size_t getParityLength(size_t segmentLength, double ratio) const
+    {
+        size_t nParitySegments = ceil(ratio * getDataSegmentsNum(segmentLength));
+        if (nParitySegments == 0)
+            nParitySegments = 1;
+
+        return nParitySegments * segmentLength;
+    }
+
+    int encodeParity(size_t segmentLength, size_t nParitySegments, uint8_t *fecData) const
+    {
+        // data is not expanded to the whole number of segments - encoder 
+        // pads the last segment with zeros itself
+        fec::Rs28Encoder &enc = fec::Rs28CoderCache::getThreadInstance().getEncoder(getDataSegmentsNum(segmentLength),
+                                                                                    nParitySegments, segmentLength);
+        return enc.encode(this->_data().data(), this->getLength(), fecData);
+    }
+
     typedef struct _Header
     {
         uint32_t encodedWidth_;
@@ -263,6 +412,37 @@ class VideoFramePacketT : public HeaderPacketT<CommonHeader, T>
 typedef VideoFramePacketT<> VideoFramePacket;
 typedef VideoFramePacketT<Immutable> ImmutableVideoFramePacket;
 
+/*******************************************************************************
+ * Pool of video frame packets. Packet returned by acquire() goes back to the
+ * pool once all outside references to it are released. Packets are reserved
+ * for the largest frame seen so far plus the largest sync list and headers
+ * added to a returned packet, so in steady state encoded frames are turned
+ * into packets without heap allocations. Pool is not thread-safe and is
+ * meant to be used by one encoding thread.
+ */
+class VideoFramePacketPool
+{
+  public:
+    VideoFramePacketPool(size_t capacity = 8);
+
+    /**
+     * Returns packet holding a copy of the encoded frame.
+     */
+    boost::shared_ptr<VideoFramePacket> acquire(const webrtc::EncodedImage &frame);
+
+    uint64_t getHitsNum() const { return hits_; }
+    uint64_t getMissesNum() const { return misses_; }
+    size_t size() const { return packets_.size(); }
+
+  private:
+    VideoFramePacketPool(const VideoFramePacketPool &) = delete;
+
+    size_t capacity_;
+    uint64_t hits_, misses_;
+    size_t maxFrameLength_, maxOverhead_;
+    std::vector<boost::shared_ptr<VideoFramePacket>> packets_;
+};
+
 /*******************************************************************************
  * AudioBundlePacket provides interface for bundling audio samples and 
  * preparing them for publishing as a data packet.
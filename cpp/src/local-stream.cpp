@@ -132,6 +132,7 @@ pimpl_(boost::make_shared<VideoStreamImpl>(streamPrefix, settings, useFec))
 
 LocalVideoStream::~LocalVideoStream()
 {
+	pimpl_->stop();
 }
 
 void
@@ -174,6 +175,20 @@ int LocalVideoStream::incomingI420Frame(const unsigned int width,
 		strideV, yBuffer, uBuffer, vBuffer}));
 }
 
+int LocalVideoStream::incomingI420Frame(const unsigned int width,
+	const unsigned int height,
+	const unsigned int strideY,
+	const unsigned int strideU,
+	const unsigned int strideV,
+	const unsigned char* yBuffer,
+	const unsigned char* uBuffer,
+	const unsigned char* vBuffer,
+	boost::function<void(void)> onReleased)
+{
+	return pimpl_->incomingFrame(I420RawFrameWrapper({width, height, strideY, strideU,
+		strideV, yBuffer, uBuffer, vBuffer}), onReleased);
+}
+
 int LocalVideoStream::incomingNV21Frame(const unsigned int width,
 			const unsigned int height,
 			const unsigned int strideY,
@@ -185,7 +200,7 @@ int LocalVideoStream::incomingNV21Frame(const unsigned int width,
 		strideUV, yBuffer, uvBuffer}));
 }
 
-const std::map<std::string, FrameInfo>& 
+std::map<std::string, FrameInfo>
 LocalVideoStream::getLastPublishedInfo() const
 {
     return pimpl_->getLastPublished();
@@ -63,6 +63,13 @@ MediaStreamBase::MediaStreamBase(const std::string &basePrefix,
     ps.freshnessPeriodMs_ = settings_.params_.producerParams_.freshness_.metadataMs_;
     ps.statStorage_ = statStorage_.get();
 
+    // pool without threads signs on the calling thread; it is created anyway,
+    // as its mutex guards the key chain shared by the face thread and video
+    // stream's signing stage
+    signingPool_ = boost::make_shared<SigningPool>(settings_.signingThreads_);
+    signingPool_->setDescription("signing-pool-" + settings_.params_.streamName_);
+    ps.signingPool_ = signingPool_.get();
+
     if (settings_.storagePath_ != "")
     {
         storage_ = boost::make_shared<StorageEngine>(settings_.storagePath_);
@@ -101,6 +108,7 @@ void
 MediaStreamBase::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 {
     metadataPublisher_->setLogger(logger);
+    signingPool_->setLogger(logger);
 }
 
 void MediaStreamBase::publishMeta()
@@ -133,7 +141,7 @@ unsigned int MediaStreamBase::periodicInvocation()
 
 void MediaStreamBase::onSegmentsCached(std::vector<boost::shared_ptr<const ndn::Data>> segments)
 {
+    // segments of one frame are stored with a single write
     if (storage_)
-        for (auto& d:segments)
-            storage_->put(d);
+        storage_->put(segments);
 }
@@ -81,6 +81,7 @@ class MediaStreamBase : public NdnRtcComponent,
     ndn::Name streamPrefix_;
     boost::shared_ptr<ndn::MemoryContentCache> cache_;
     boost::shared_ptr<CommonPacketPublisher> metadataPublisher_;
+    boost::shared_ptr<SigningPool> signingPool_;
     boost::shared_ptr<statistics::StatisticsStorage> statStorage_;
     boost::shared_ptr<StorageEngine> storage_;
     uint64_t streamTimestamp_;
@@ -12,6 +12,7 @@
 #include <sstream>
 #include <algorithm>
 #include <iterator>
+#include <vector>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string.hpp>
@@ -184,7 +185,110 @@ NameComponents::videoStreamPrefix(string basePrefix)
 }
 
 //******************************************************************************
-bool extractMeta(const ndn::Name& name, NamespaceInfo& info)
+namespace {
+    enum class ComponentKind {
+        Other,
+        App,
+        Audio,
+        Video,
+        Meta,
+        Delta,
+        Key,
+        Parity,
+        Manifest
+    };
+
+    // name components known to NDN-RTC, built once so that parsing does not
+    // construct Name::Component for every comparison
+    class InternedComponents {
+    public:
+        InternedComponents():
+            app_(NameComponents::NameComponentApp),
+            audio_(NameComponents::NameComponentAudio),
+            video_(NameComponents::NameComponentVideo),
+            meta_(NameComponents::NameComponentMeta),
+            delta_(NameComponents::NameComponentDelta),
+            key_(NameComponents::NameComponentKey),
+            parity_(NameComponents::NameComponentParity),
+            manifest_(NameComponents::NameComponentManifest)
+        {
+            add(app_, ComponentKind::App);
+            add(audio_, ComponentKind::Audio);
+            add(video_, ComponentKind::Video);
+            add(meta_, ComponentKind::Meta);
+            add(delta_, ComponentKind::Delta);
+            add(key_, ComponentKind::Key);
+            add(parity_, ComponentKind::Parity);
+            add(manifest_, ComponentKind::Manifest);
+        }
+
+        const Name::Component app_, audio_, video_, meta_, delta_, key_,
+            parity_, manifest_;
+
+        // length and first byte of each component, for cheap pre-check
+        typedef struct _Candidate {
+            size_t size_;
+            uint8_t firstByte_;
+            const Name::Component *component_;
+            ComponentKind kind_;
+        } Candidate;
+
+        std::vector<Candidate> candidates_;
+
+    private:
+        void add(const Name::Component& c, ComponentKind kind)
+        {
+            if (c.getValue().size())
+                candidates_.push_back({c.getValue().size(), c.getValue().buf()[0], &c, kind});
+        }
+    };
+
+    const InternedComponents& interned()
+    {
+        static InternedComponents components;
+        return components;
+    }
+
+    // classifies component by its length and first byte; full comparison is
+    // done only against candidates that pass this check
+    ComponentKind classify(const Name::Component& c)
+    {
+        const Blob& value = c.getValue();
+
+        if (value.size() == 0)
+            return ComponentKind::Other;
+
+        for (const auto& candidate:interned().candidates_)
+            if (candidate.size_ == value.size() &&
+                candidate.firstByte_ == value.buf()[0] &&
+                c == *candidate.component_)
+                return candidate.kind_;
+
+        return ComponentKind::Other;
+    }
+
+    // components of a name starting at some offset; used instead of
+    // Name::getSubName() which copies components
+    class ComponentRange {
+    public:
+        ComponentRange(const Name& name, size_t offset):name_(name), offset_(offset){}
+
+        size_t size() const
+        { return (offset_ < name_.size() ? name_.size()-offset_ : 0); }
+
+        const Name::Component& operator[](size_t idx) const
+        { return name_.get(offset_+idx); }
+
+        ComponentRange from(size_t idx) const
+        { return ComponentRange(name_, offset_+idx); }
+
+    private:
+        const Name& name_;
+        size_t offset_;
+    };
+}
+
+bool extractMeta(const ComponentRange& name, NamespaceInfo& info)
 {
     // example: name == %FD%05/%00%00
     if (name.size() >= 1 && name[0].isVersion())
@@ -203,7 +307,7 @@ bool extractMeta(const ndn::Name& name, NamespaceInfo& info)
     return false;
 }
 
-bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
+bool extractVideoStreamInfo(const ComponentRange& name, NamespaceInfo& info)
 {
     if (name.size() == 1)
     {
@@ -223,13 +327,13 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
 
     int idx = 0;
     info.streamName_ = name[idx++].toEscapedString();
-    info.isMeta_ = (name[idx++] == Name::Component(NameComponents::NameComponentMeta));
+    info.isMeta_ = (classify(name[idx++]) == ComponentKind::Meta);
 
     if (info.isMeta_)
     {   // example: name == camera/_meta/%FD%05/%00%00
         info.segmentClass_ = SegmentClass::Meta;
         info.threadName_ = "";
-        return extractMeta(name.getSubName(idx), info);
+        return extractMeta(name.from(idx), info);
     }
     else
     {   // example: name == camera/%FC%00%00%01c_%27%DE%D6/hi/d/%FE%07/%00%00
@@ -242,20 +346,19 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
         if (name.size() <= idx)
             return true;
 
-        info.isMeta_ = (name[idx++] == Name::Component(NameComponents::NameComponentMeta));
+        ComponentKind kind = classify(name[idx++]);
+        info.isMeta_ = (kind == ComponentKind::Meta);
 
         if (info.isMeta_)
         {   // example: camera/%FC%00%00%01c_%27%DE%D6/hi/_meta/%FD%05/%00%00
             info.segmentClass_ = SegmentClass::Meta;
-            if(name.size() > idx-1 && extractMeta(name.getSubName(idx), info))
-                return true;
+            extractMeta(name.from(idx), info);
             return true;
         }
 
-        if (name[idx-1] == Name::Component(NameComponents::NameComponentDelta) || 
-            name[idx-1] == Name::Component(NameComponents::NameComponentKey))
+        if (kind == ComponentKind::Delta || kind == ComponentKind::Key)
         {
-            info.isDelta_ = (name[idx-1] == Name::Component(NameComponents::NameComponentDelta));
+            info.isDelta_ = (kind == ComponentKind::Delta);
             info.class_ = (info.isDelta_ ? SampleClass::Delta : SampleClass::Key);
 
             try{
@@ -270,7 +373,8 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
                 info.hasSeqNo_ = true;
                 if (name.size() > idx)
                 {
-                    info.isParity_ = (name[idx] == Name::Component(NameComponents::NameComponentParity));
+                    kind = classify(name[idx]);
+                    info.isParity_ = (kind == ComponentKind::Parity);
                     info.hasSegNo_ = true;
 
                     if (info.isParity_ && name.size() > idx+1)
@@ -285,7 +389,7 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
                             return false;
                         else
                         {
-                            if (name[idx] == Name::Component(NameComponents::NameComponentManifest))
+                            if (kind == ComponentKind::Manifest)
                                 info.segmentClass_ = SegmentClass::Manifest;
                             else
                             {
@@ -313,7 +417,7 @@ bool extractVideoStreamInfo(const ndn::Name& name, NamespaceInfo& info)
     return false;
 }
 
-bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
+bool extractAudioStreamInfo(const ComponentRange& name, NamespaceInfo& info)
 {
     if (name.size() == 1)
     {
@@ -333,7 +437,7 @@ bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
 
     int idx = 0;
     info.streamName_ = name[idx++].toEscapedString();
-    info.isMeta_ = (name[idx++] == Name::Component(NameComponents::NameComponentMeta));
+    info.isMeta_ = (classify(name[idx++]) == ComponentKind::Meta);
     
     if (info.isMeta_)
     {
@@ -342,7 +446,7 @@ bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
             return false;
 
         info.threadName_ = "";
-        return extractMeta(name.getSubName(idx), info);;
+        return extractMeta(name.from(idx), info);
     }
     else
     {
@@ -357,13 +461,13 @@ bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
             return true;
         }
 
-        info.isMeta_ = (name[idx] == Name::Component(NameComponents::NameComponentMeta));
+        info.isMeta_ = (classify(name[idx]) == ComponentKind::Meta);
 
         if (info.isMeta_)
         { 
             info.segmentClass_ = SegmentClass::Meta;
-            if (name.size() > idx+1 && extractMeta(name.getSubName(idx+1), info))
-                return true;
+            if (name.size() > idx+1)
+                extractMeta(name.from(idx+1), info);
             return true;
         }
 
@@ -378,7 +482,7 @@ bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
             info.hasSeqNo_ = true;
             if (name.size() > idx)
             {
-                if (name[idx] == Name::Component(NameComponents::NameComponentManifest))
+                if (classify(name[idx]) == ComponentKind::Manifest)
                     info.segmentClass_ = SegmentClass::Manifest;
                 else
                 {
@@ -406,39 +510,39 @@ bool extractAudioStreamInfo(const ndn::Name& name, NamespaceInfo& info)
 bool
 NameComponents::extractInfo(const ndn::Name& name, NamespaceInfo& info)
 {
-    bool goodName = false;
-    static Name ndnrtcSubName(NameComponents::NameComponentApp);
-    Name subName;
-    int i;
+    // find rightmost "ndnrtc" component that is followed by at least one
+    // more component
+    int appIdx;
 
-    for (i = name.size()-2; i > 0 && !goodName; --i)
-    {
-        subName = name.getSubName(i);
-        goodName = ndnrtcSubName.match(subName);
-    }
+    for (appIdx = (int)name.size()-2; appIdx > 0; --appIdx)
+        if (classify(name[appIdx]) == ComponentKind::App)
+            break;
 
-    if (goodName)
-    {
-        info.basePrefix_ = name.getSubName(0, i+1);
+    if (appIdx <= 0)
+        return false;
 
-        if ((goodName = subName[1].isVersion()))
-        {
-            info.apiVersion_ = subName[1].toVersion();
+    info.basePrefix_ = name.getSubName(0, appIdx);
 
-            if (subName.size() > 2 &&
-                (goodName = (subName[2] == Name::Component(NameComponents::NameComponentAudio) ||
-                            subName[2] == Name::Component(NameComponents::NameComponentVideo)))  )
-            {
-                info.streamType_ = (subName[2] == Name::Component(NameComponents::NameComponentAudio) ? 
-                                MediaStreamParams::MediaStreamType::MediaStreamTypeAudio : 
-                                MediaStreamParams::MediaStreamType::MediaStreamTypeVideo );
+    if (!name[appIdx+1].isVersion())
+        return false;
 
-                if (info.streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeAudio)
-                    return extractAudioStreamInfo(subName.getSubName(3), info);
-                else
-                    return extractVideoStreamInfo(subName.getSubName(3), info);
-            }
-        }
+    info.apiVersion_ = name[appIdx+1].toVersion();
+
+    if (name.size() <= (size_t)appIdx+2)
+        return false;
+
+    ComponentKind streamKind = classify(name[appIdx+2]);
+
+    if (streamKind == ComponentKind::Audio)
+    {
+        info.streamType_ = MediaStreamParams::MediaStreamType::MediaStreamTypeAudio;
+        return extractAudioStreamInfo(ComponentRange(name, appIdx+3), info);
+    }
+
+    if (streamKind == ComponentKind::Video)
+    {
+        info.streamType_ = MediaStreamParams::MediaStreamType::MediaStreamTypeVideo;
+        return extractVideoStreamInfo(ComponentRange(name, appIdx+3), info);
     }
 
     return false;
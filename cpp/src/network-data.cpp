@@ -7,6 +7,7 @@
 
 #include "network-data.hpp"
 
+#include <cstring>
 #include <ndn-cpp/data.hpp>
 #include <ndn-cpp/interest.hpp>
 #include "fec.hpp"
@@ -30,13 +31,14 @@ Manifest::Manifest(NetworkData &&nd) : DataPacket(boost::move(nd)) {}
 bool Manifest::hasData(const ndn::Data &data) const
 {
     ndn::Blob digest = (*data.getFullName())[-1].getValue();
+    return hasDigest(digest.buf(), digest.size());
+}
 
-    for (int i = 0; i < getBlobsNum(); ++i)
-    {
-        ndn::Blob b(getBlob(i).data(), getBlob(i).size());
-        if (b.equals(digest))
+bool Manifest::hasDigest(const uint8_t *digest, size_t size) const
+{
+    for (auto &b : blobs_)
+        if (b.size() == size && memcmp(b.data(), digest, size) == 0)
             return true;
-    }
     return false;
 }
 
@@ -7,6 +7,7 @@
 #ifndef __network_data_hpp__
 #define __network_data_hpp__
 
+#include <algorithm>
 #include <boost/crc.hpp>
 #include <boost/move/move.hpp>
 #include <boost/shared_ptr.hpp>
@@ -393,16 +394,24 @@ class DataPacketT : public NetworkDataT<T>
 
         // increase blob counter
         this->_data()[0]++;
-        // save blob size
-        uint8_t b1 = dataLength & 0x00ff, b2 = (dataLength & 0xff00) >> 8;
-        payloadBegin_ = this->_data().insert(payloadBegin_, b1);
-        payloadBegin_++;
-        payloadBegin_ = this->_data().insert(payloadBegin_, b2);
-        payloadBegin_++;
-        // insert blob
-        this->_data().insert(payloadBegin_, data, data + dataLength);
+        // make room for blob size and blob at once, so payload is moved once
+        writeBlob(this->_data().insert(payloadBegin_, wireLength(dataLength), 0),
+                  dataLength, data);
         this->reinit();
     }
+
+    /**
+     * Writes blob size and blob at given position, which must have room
+     * for wireLength(dataLength) bytes. Returns position right after the blob.
+     */
+    ENABLE_IF(T, Mutable)
+    static typename T::payload_iter writeBlob(typename T::payload_iter p, uint16_t dataLength,
+                                              const uint8_t *data)
+    {
+        *p++ = dataLength & 0x00ff;
+        *p++ = (dataLength & 0xff00) >> 8;
+        return std::copy(data, data + dataLength, p);
+    }
 };
 
 typedef DataPacketT<Immutable> ImmutableDataPacket;
@@ -558,6 +567,12 @@ class Manifest : public DataPacket
           */
     bool hasData(const ndn::Data &data) const;
 
+    /**
+          * Checks whether given implicit SHA-256 digest of a data object is
+          * listed in this manifest
+          */
+    bool hasDigest(const uint8_t *digest, size_t size) const;
+
     /**
           * Returns total number of data objects described by this manifest
           */
@@ -8,6 +8,7 @@
 #ifndef __packet_publisher_h__
 #define __packet_publisher_h__
 
+#include <algorithm>
 #include <boost/shared_ptr.hpp>
 #include <ndn-cpp/c/common.h>
 #include <ndn-cpp/interest.hpp>
@@ -19,6 +20,7 @@
 
 #include "frame-data.hpp"
 #include "ndnrtc-object.hpp"
+#include "signing-pool.hpp"
 #include "statistics.hpp"
 
 #define ADD_CRC 0
@@ -57,15 +59,23 @@ template <typename KeyChain, typename MemoryCache>
 struct _PublisherSettings
 {
     _PublisherSettings() : keyChain_(nullptr), memoryCache_(nullptr),
-                           statStorage_(nullptr) {}
+                           statStorage_(nullptr), signingPool_(nullptr) {}
 
     KeyChain *keyChain_;
     MemoryCache *memoryCache_;
     statistics::StatisticsStorage *statStorage_;
+    // if set, segments of a sample are signed by pool's worker threads;
+    // used together with batchPit_
+    SigningPool *signingPool_;
     OnSegmentsCached onSegmentsCached_;
     size_t segmentWireLength_;
     unsigned int freshnessPeriodMs_;
+    // sign with key chain; otherwise segments get DigestSha256 signature
     bool sign_ = true;
+    // when set, all segments of a sample are built before any of them is
+    // added to the cache and pending interests are matched against them in
+    // one pass over the PIT instead of querying it for every segment
+    bool batchPit_ = false;
 };
 
 typedef _PublisherSettings<ndn::KeyChain, ndn::MemoryContentCache> PublisherSettings;
@@ -98,6 +108,9 @@ class PacketPublisher : public NdnRtcComponent
                                    _DataSegmentHeader &commonHeader, int freshnessMs,
                                    bool forcePitClean = false, bool banPitClean = false)
     {
+        if (settings_.batchPit_)
+            return publishBatch(name, data, commonHeader, freshnessMs, forcePitClean, banPitClean);
+
         PublishedDataPtrVector ndnSegments;
         std::vector<SegmentType> segments = SegmentType::slice(data, settings_.segmentWireLength_);
         LogTraceC << "sliced into " << segments.size() << " segments" << std::endl;
@@ -109,7 +122,7 @@ class PacketPublisher : public NdnRtcComponent
         unsigned int segIdx = 0;
         freshnessMs = (freshnessMs == -1 ? settings_.freshnessPeriodMs_ : freshnessMs);
 
-        for (auto segment : segments)
+        for (auto &segment : segments)
         {
             ndn::Name segmentName(name);
             segmentName.appendSegment(segIdx);
@@ -120,19 +133,19 @@ class PacketPublisher : public NdnRtcComponent
             checkForPendingInterests(segmentName, commonHeader);
             segment.setHeader(commonHeader);
 
-            boost::shared_ptr<MutableNetworkData> segmentData = segment.getNetworkData();
             boost::shared_ptr<ndn::Data> ndnSegment(boost::make_shared<ndn::Data>(segmentName));
             ndnSegment->getMetaInfo().setFreshnessPeriod(freshnessMs);
             ndnSegment->getMetaInfo().setFinalBlockId(ndn::Name::Component::fromSegment(segments.size() - 1));
-            ndnSegment->setContent(segmentData->getData(), segment.size());
+            // segment is encoded straight from the packet's buffer and handed
+            // over to ndn::Data without copying
+            ndnSegment->setContent(ndn::Blob(segment.getWireData(), false));
             sign(ndnSegment);
-            settings_.memoryCache_->add(*ndnSegment);
+            if (settings_.sign_)
+                (*settings_.statStorage_)[statistics::Indicator::SignNum]++;
+            cache(ndnSegment);
             ++segIdx;
             ndnSegments.push_back(ndnSegment);
 
-            (*settings_.statStorage_)[statistics::Indicator::BytesPublished] += ndnSegment->getContent().size();
-            (*settings_.statStorage_)[statistics::Indicator::RawBytesPublished] += ndnSegment->getDefaultWireEncoding().size();
-
             LogTraceC << "cached " << segmentName << " ("
                       << ndnSegment->getContent().size() << "b payload, "
                       << ndnSegment->getDefaultWireEncoding().size() << "b wire, "
@@ -151,43 +164,248 @@ class PacketPublisher : public NdnRtcComponent
         return ndnSegments;
     }
 
+    typedef std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> PendingInterests;
+
+    /**
+     * Sample sliced into data packets that are not signed nor cached yet.
+     * Batched publishing can be split into slice(), sign() and cache()
+     * calls, so that one sample is signed while another one is cached.
+     * slice() and cache() access memory cache and must be called on the
+     * face thread. sign() can be called on any thread only if segments get
+     * digest signatures (see signsWithKeyChain()): key chain is not
+     * thread-safe and is shared with the face and other publishers.
+     */
+    struct SlicedSample
+    {
+        ndn::Name name_;
+        std::vector<boost::shared_ptr<ndn::Data>> segments_;
+        // pending interests that did not match any segment of the sample
+        PendingInterests unmatched_;
+    };
+
+    /**
+     * Slices data into segments and matches them against pending interests
+     * in one pass over the PIT. Common header is updated with PIT hit info.
+     */
+    SlicedSample slice(const ndn::Name &name, const MutableNetworkData &data,
+                       _DataSegmentHeader &commonHeader, int freshnessMs)
+    {
+        std::vector<SegmentType> segments = SegmentType::slice(data, settings_.segmentWireLength_);
+        SlicedSample sample;
+        LogTraceC << "sliced into " << segments.size() << " segments" << std::endl;
+
+        commonHeader.interestNonce_ = 0;
+        commonHeader.generationDelayMs_ = 0;
+        commonHeader.interestArrivalMs_ = 0;
+        freshnessMs = (freshnessMs == -1 ? settings_.freshnessPeriodMs_ : freshnessMs);
+
+        sample.name_ = name;
+        sample.segments_.reserve(segments.size());
+        for (unsigned int segIdx = 0; segIdx < segments.size(); ++segIdx)
+        {
+            ndn::Name segmentName(name);
+            segmentName.appendSegment(segIdx);
+            sample.segments_.push_back(boost::make_shared<ndn::Data>(segmentName));
+        }
+
+        // one PIT lookup for the whole sample; each pending interest is
+        // mapped to the segment it asks for
+        PendingInterests pendingInterests;
+        std::vector<int> lastHit(segments.size(), -1), nHits(segments.size(), 0);
+
+        settings_.memoryCache_->getPendingInterestsWithPrefix(name, pendingInterests);
+
+        for (int i = 0; i < pendingInterests.size(); ++i)
+        {
+            int segIdx = matchSegment(name, *pendingInterests[i]->getInterest(), sample.segments_);
+            if (segIdx >= 0)
+            {
+                lastHit[segIdx] = i;
+                nHits[segIdx]++;
+            }
+            else
+                sample.unmatched_.push_back(pendingInterests[i]);
+        }
+
+        for (unsigned int segIdx = 0; segIdx < segments.size(); ++segIdx)
+        {
+            if (lastHit[segIdx] >= 0)
+                setPitHit(*pendingInterests[lastHit[segIdx]], nHits[segIdx], commonHeader);
+            segments[segIdx].setHeader(commonHeader);
+
+            boost::shared_ptr<ndn::Data> ndnSegment = sample.segments_[segIdx];
+            ndnSegment->getMetaInfo().setFreshnessPeriod(freshnessMs);
+            ndnSegment->getMetaInfo().setFinalBlockId(ndn::Name::Component::fromSegment(segments.size() - 1));
+            ndnSegment->setContent(ndn::Blob(segments[segIdx].getWireData(), false));
+        }
+
+        LogTraceC << "matched " << name << " x" << segments.size()
+                  << " (" << pendingInterests.size() << " pending, "
+                  << pendingInterests.size() - sample.unmatched_.size() << " matched)"
+                  << std::endl;
+
+        return sample;
+    }
+
+    /**
+     * Whether segments are signed with the key chain rather than given
+     * DigestSha256 signatures.
+     */
+    bool signsWithKeyChain() const { return settings_.sign_; }
+
+    /**
+     * Signs segments of the sample, in parallel if there is a signing pool.
+     * Throws if any segment could not be signed.
+     */
+    void sign(const SlicedSample &sample)
+    {
+        if (settings_.signingPool_)
+            settings_.signingPool_->sign(sample.segments_.size(),
+                                         [this, &sample](size_t i) { sign(sample.segments_[i]); },
+                                         [](size_t) {});
+        else
+            for (auto &ndnSegment : sample.segments_)
+                sign(ndnSegment);
+    }
+
+    /**
+     * Adds signed segments of the sample to the cache, in order.
+     */
+    PublishedDataPtrVector cache(const SlicedSample &sample,
+                                 bool forcePitClean = false, bool banPitClean = false)
+    {
+        for (auto &ndnSegment : sample.segments_)
+            cache(ndnSegment);
+
+        return onSampleCached(sample, forcePitClean, banPitClean);
+    }
+
   private:
     Settings settings_;
     unsigned int fullPitClean_;
 
-    void checkForPendingInterests(const ndn::Name &name, _DataSegmentHeader &commonHeader)
+    PublishedDataPtrVector publishBatch(const ndn::Name &name, const MutableNetworkData &data,
+                                        _DataSegmentHeader &commonHeader, int freshnessMs,
+                                        bool forcePitClean, bool banPitClean)
     {
-        std::vector<boost::shared_ptr<const ndn::MemoryContentCache::PendingInterest>> pendingInterests;
-        settings_.memoryCache_->getPendingInterestsForName(name, pendingInterests);
+        SlicedSample sample = slice(name, data, commonHeader, freshnessMs);
+        std::vector<boost::shared_ptr<ndn::Data>> &batch = sample.segments_;
+
+        // segments are signed in parallel if there is a signing pool and
+        // added to the cache in order, so matching pending interests are
+        // satisfied back-to-back
+        if (settings_.signingPool_)
+            settings_.signingPool_->sign(batch.size(),
+                                         [this, &batch](size_t i) { sign(batch[i]); },
+                                         [this, &batch](size_t i) { cache(batch[i]); });
+        else
+            for (auto &ndnSegment : batch)
+            {
+                sign(ndnSegment);
+                cache(ndnSegment);
+            }
 
-        if (pendingInterests.size())
-        {
-            commonHeader.interestNonce_ = *(uint32_t *)(pendingInterests.back()->getInterest()->getNonce().buf());
-            commonHeader.interestArrivalMs_ = pendingInterests.back()->getTimeoutPeriodStart();
-            commonHeader.generationDelayMs_ = ndn_getNowMilliseconds() - pendingInterests.back()->getTimeoutPeriodStart();
+        return onSampleCached(sample, forcePitClean, banPitClean);
+    }
+
+    PublishedDataPtrVector onSampleCached(const SlicedSample &sample,
+                                          bool forcePitClean, bool banPitClean)
+    {
+        PublishedDataPtrVector ndnSegments(sample.segments_.begin(), sample.segments_.end());
+
+        if (settings_.sign_)
+            (*settings_.statStorage_)[statistics::Indicator::SignNum] += ndnSegments.size();
 
-            (*settings_.statStorage_)[statistics::Indicator::InterestsReceivedNum] += pendingInterests.size();
+        LogTraceC << "cached " << sample.name_ << " x" << ndnSegments.size() << std::endl;
 
-            LogTraceC << "PIT hit " << pendingInterests.back()->getInterest()->toUri() << std::endl;
+        if (!banPitClean)
+        {
+            // pending interests that did not match any segment are the ones
+            // cleanPit() would find after the sample is cached
+            for (auto &pi : sample.unmatched_)
+                publishNack(pi->getInterest()->getName());
+
+            if (fullPitClean_++ % FULL_PIT_FREQUENCY == 0 || forcePitClean)
+            {
+                if (!forcePitClean)
+                    fullPitClean_ = 0;
+                deepCleanPit(sample.name_);
+            }
         }
+
+        (*settings_.statStorage_)[statistics::Indicator::PublishedSegmentsNum] += ndnSegments.size();
+
+        if (settings_.onSegmentsCached_)
+            settings_.onSegmentsCached_(ndnSegments);
+
+        return ndnSegments;
+    }
+
+    /**
+     * Returns index of the segment that will satisfy given interest or -1 if
+     * interest does not match any segment of the sample
+     */
+    int matchSegment(const ndn::Name &name, const ndn::Interest &interest,
+                     const std::vector<boost::shared_ptr<ndn::Data>> &batch)
+    {
+        int segIdx = -1;
+
+        if (interest.getName().size() == name.size())
+            segIdx = 0;
+        else if (interest.getName().size() == name.size() + 1 &&
+                 interest.getName()[-1].isSegment())
+            segIdx = (int)interest.getName()[-1].toSegment();
+
+        if (segIdx >= 0 && segIdx < batch.size() &&
+            interest.matchesName(batch[segIdx]->getName()))
+            return segIdx;
+
+        return -1;
+    }
+
+    void setPitHit(const ndn::MemoryContentCache::PendingInterest &pendingInterest,
+                   size_t nInterests, _DataSegmentHeader &commonHeader)
+    {
+        commonHeader.interestNonce_ = *(uint32_t *)(pendingInterest.getInterest()->getNonce().buf());
+        commonHeader.interestArrivalMs_ = pendingInterest.getTimeoutPeriodStart();
+        commonHeader.generationDelayMs_ = ndn_getNowMilliseconds() - pendingInterest.getTimeoutPeriodStart();
+
+        (*settings_.statStorage_)[statistics::Indicator::InterestsReceivedNum] += nInterests;
+
+        LogTraceC << "PIT hit " << pendingInterest.getInterest()->toUri() << std::endl;
+    }
+
+    void checkForPendingInterests(const ndn::Name &name, _DataSegmentHeader &commonHeader)
+    {
+        PendingInterests pendingInterests;
+        settings_.memoryCache_->getPendingInterestsForName(name, pendingInterests);
+
+        if (pendingInterests.size())
+            setPitHit(*pendingInterests.back(), pendingInterests.size(), commonHeader);
     }
 
     void sign(boost::shared_ptr<ndn::Data> segment)
     {
         if (settings_.sign_)
         {
-            settings_.keyChain_->sign(*segment);
-            (*settings_.statStorage_)[statistics::Indicator::SignNum]++;
+            if (settings_.signingPool_)
+            {
+                boost::lock_guard<boost::mutex> scopedLock(settings_.signingPool_->keyChainMutex());
+                settings_.keyChain_->sign(*segment);
+            }
+            else
+                settings_.keyChain_->sign(*segment);
         }
         else
-        {
-            static uint8_t digest[ndn_SHA256_DIGEST_SIZE];
-            memset(digest, 0, ndn_SHA256_DIGEST_SIZE);
-            ndn::Blob signatureBits(digest, sizeof(digest));
-            segment->setSignature(ndn::DigestSha256Signature());
-            ndn::DigestSha256Signature *sha256Signature = (ndn::DigestSha256Signature *)segment->getSignature();
-            sha256Signature->setSignature(signatureBits);
-        }
+            SigningPool::digestSign(*segment);
+    }
+
+    void cache(const boost::shared_ptr<ndn::Data> &ndnSegment)
+    {
+        settings_.memoryCache_->add(*ndnSegment);
+
+        (*settings_.statStorage_)[statistics::Indicator::BytesPublished] += ndnSegment->getContent().size();
+        (*settings_.statStorage_)[statistics::Indicator::RawBytesPublished] += ndnSegment->getDefaultWireEncoding().size();
     }
 
     /**
@@ -0,0 +1,135 @@
+//
+// data-cache.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include "data-cache.hpp"
+
+#include <iterator>
+#include <functional>
+#include <boost/make_shared.hpp>
+#include <boost/atomic.hpp>
+#include <ndn-cpp/data.hpp>
+
+using namespace ndnrtc;
+using namespace ndn;
+
+namespace {
+    // shared by all caches, so that a version taken from a cache that was
+    // replaced is older than any version of the new one
+    boost::atomic<uint64_t> Version(0);
+
+    size_t entrySize(const Data& d)
+    {
+        return d.getDefaultWireEncoding().size();
+    }
+}
+
+DataCache::DataCache(size_t capacityBytes, unsigned int nShards)
+    : capacityBytes_(capacityBytes),
+      shardCapacity_(capacityBytes/(nShards ? nShards : 1))
+{
+    for (unsigned int i = 0; i < (nShards ? nShards : 1); ++i)
+        shards_.push_back(boost::make_shared<Shard>(Version.load()));
+}
+
+boost::shared_ptr<const Data>
+DataCache::get(const std::string& key)
+{
+    Shard& s = shard(key);
+    boost::lock_guard<boost::mutex> scopedLock(s.mutex_);
+
+    auto it = s.entries_.find(key);
+    if (it == s.entries_.end())
+    {
+        s.misses_++;
+        return boost::shared_ptr<const Data>();
+    }
+
+    s.hits_++;
+    s.lru_.splice(s.lru_.begin(), s.lru_, it->second);
+    return it->second->second;
+}
+
+void
+DataCache::put(const std::string& key, const boost::shared_ptr<const Data>& data,
+               uint64_t version)
+{
+    size_t size = entrySize(*data);
+    if (size > shardCapacity_)
+        return;
+
+    Shard& s = shard(key);
+    boost::lock_guard<boost::mutex> scopedLock(s.mutex_);
+
+    // data may have been overwritten after it was read
+    if (s.version_ > version)
+        return;
+
+    auto it = s.entries_.find(key);
+    if (it != s.entries_.end())
+        remove(s, it->second);
+
+    s.lru_.push_front(std::make_pair(key, data));
+    s.entries_[key] = s.lru_.begin();
+    s.sizeBytes_ += size;
+
+    while (s.sizeBytes_ > shardCapacity_)
+    {
+        remove(s, std::prev(s.lru_.end()));
+        s.evictions_++;
+    }
+}
+
+void
+DataCache::erase(const std::string& key)
+{
+    Shard& s = shard(key);
+    boost::lock_guard<boost::mutex> scopedLock(s.mutex_);
+
+    s.version_ = ++Version;
+    auto it = s.entries_.find(key);
+    if (it != s.entries_.end())
+        remove(s, it->second);
+}
+
+uint64_t
+DataCache::getVersion() const
+{
+    return Version.load();
+}
+
+DataCache::Stats
+DataCache::getStats() const
+{
+    Stats stats = {0, 0, 0, 0, 0};
+
+    for (auto& s:shards_)
+    {
+        boost::lock_guard<boost::mutex> scopedLock(s->mutex_);
+        stats.hits_ += s->hits_;
+        stats.misses_ += s->misses_;
+        stats.evictions_ += s->evictions_;
+        stats.nEntries_ += s->lru_.size();
+        stats.sizeBytes_ += s->sizeBytes_;
+    }
+
+    return stats;
+}
+
+//******************************************************************************
+DataCache::Shard&
+DataCache::shard(const std::string& key)
+{
+    return *shards_[std::hash<std::string>()(key) % shards_.size()];
+}
+
+void
+DataCache::remove(Shard& s, LruList::iterator it)
+{
+    s.sizeBytes_ -= entrySize(*it->second);
+    s.entries_.erase(it->first);
+    s.lru_.erase(it);
+}
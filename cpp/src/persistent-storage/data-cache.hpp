@@ -0,0 +1,77 @@
+//
+// data-cache.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __data_cache_hpp__
+#define __data_cache_hpp__
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace ndn {
+    class Data;
+}
+
+namespace ndnrtc {
+
+    /**
+     * Size-bounded LRU cache of decoded data packets, keyed by storage keys.
+     * Keys are distributed over several shards, each with its own lock and
+     * an equal share of the capacity, so that concurrent readers rarely
+     * contend. Size of an entry is the size of packet wire encoding.
+     *
+     * Entries are versioned so that a packet read from storage before it
+     * was overwritten does not get cached after the overwrite: readers take
+     * getVersion() before reading storage and pass it to put(), writers
+     * call erase() after the write; put() is ignored if the key's shard
+     * was invalidated since that version.
+     */
+    class DataCache {
+    public:
+        typedef struct _Stats {
+            uint64_t hits_, misses_, evictions_;
+            size_t nEntries_, sizeBytes_;
+        } Stats;
+
+        DataCache(size_t capacityBytes, unsigned int nShards);
+
+        boost::shared_ptr<const ndn::Data> get(const std::string& key);
+        void put(const std::string& key, const boost::shared_ptr<const ndn::Data>& data,
+                 uint64_t version);
+        void erase(const std::string& key);
+        uint64_t getVersion() const;
+
+        Stats getStats() const;
+        size_t getCapacity() const { return capacityBytes_; }
+
+    private:
+        typedef std::list<std::pair<std::string, boost::shared_ptr<const ndn::Data>>> LruList;
+
+        struct Shard {
+            Shard(uint64_t version) : sizeBytes_(0), hits_(0), misses_(0), evictions_(0),
+                                      version_(version) {}
+
+            mutable boost::mutex mutex_;
+            LruList lru_;
+            std::unordered_map<std::string, LruList::iterator> entries_;
+            size_t sizeBytes_;
+            uint64_t hits_, misses_, evictions_;
+            // version of the last erase() of a key of this shard
+            uint64_t version_;
+        };
+
+        size_t capacityBytes_, shardCapacity_;
+        std::vector<boost::shared_ptr<Shard>> shards_;
+
+        Shard& shard(const std::string& key);
+        void remove(Shard& s, LruList::iterator it);
+    };
+}
+
+#endif
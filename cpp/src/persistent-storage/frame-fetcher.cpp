@@ -12,6 +12,8 @@
 #include "frame-buffer.hpp"
 #include "video-decoder.hpp"
 
+#include <deque>
+#include <list>
 #include <ndn-cpp/name.hpp>
 
 using namespace ndnrtc;
@@ -31,6 +33,13 @@ namespace ndnrtc {
                    OnBufferAllocate onBufferAllocate,
                    OnFrameFetched onFrameFetched,
                    OnFetchFailure onFetchFailure);
+        void fetchRange(const ndn::Name& threadPrefix,
+                        PacketNumber start, PacketNumber end,
+                        unsigned int stride,
+                        OnBufferAllocate onBufferAllocate,
+                        OnFrameFetched onFrameFetched,
+                        OnRangeFetched onRangeFetched,
+                        OnFetchFailure onFetchFailure);
         const ndn::Name& getName() const
         {
             return frameNameInfo_.getPrefix(prefix_filter::Sample);
@@ -38,8 +47,30 @@ namespace ndnrtc {
 
         FrameFetcher::State getState() const { return state_; }
 
+        void setSettings(const FrameFetcher::Settings& settings);
+        const FrameFetcher::Settings& getSettings() const { return settings_; }
+
     private:
+        // decoder state of a GOP; decoder has consumed Key frame and all
+        // deltas up to (but not including) nextDelta_
+        typedef struct _GopState {
+            ndn::Name keyName_;
+            boost::shared_ptr<const BufferSlot> keySlot_;
+            PacketNumber firstDelta_, nextDelta_;
+            boost::shared_ptr<VideoDecoder> decoder_;
+        } GopState;
+
+        // GOP frame that must be decoded before the target frame
+        typedef struct _QueuedFrame {
+            ndn::Name name_;
+            bool isKey_;
+            PacketNumber sampleNo_;
+            boost::shared_ptr<FrameFetchingTask> task_;
+            boost::shared_ptr<const BufferSlot> slot_;
+        } QueuedFrame;
+
         FrameFetcher::State state_;
+        FrameFetcher::Settings settings_;
         FetchingTask::Settings fetchSettings_;
 
         boost::shared_ptr<StorageEngine> storage_;
@@ -47,16 +78,42 @@ namespace ndnrtc {
         OnBufferAllocate onBufferAllocate_;
         OnFrameFetched onFrameFetched_;
         OnFetchFailure onFetchFailure_;
+        OnRangeFetched onRangeFetched_;
+
+        ndn::Name rangePrefix_;
+        PacketNumber rangeNext_, rangeEnd_;
+        unsigned int rangeStride_;
+        int nRangeFetched_;
+        bool rangeActive_, rangeDriving_;
 
         boost::shared_ptr<IFetchMethod> fetchMethod_;
-        std::map<ndn::Name, boost::shared_ptr<FrameFetchingTask>> fetchingTasks_;
-        boost::shared_ptr<FrameFetchingTask> keyFrameTask_, targetFrameTask_;
-        std::map<ndn::Name, boost::shared_ptr<FrameFetchingTask>> deltasTasks_;
-
-        void fetchGopKey(const boost::shared_ptr<const SlotSegment>& deltaSegment);
-        void fetchGopDelta(const boost::shared_ptr<const SlotSegment>& segment);
-        void checkReadyDecode();
-        void decode();
+        boost::shared_ptr<FrameFetchingTask> targetFrameTask_;
+        boost::shared_ptr<const BufferSlot> targetSlot_;
+        std::deque<QueuedFrame> decodeQueue_;
+        boost::shared_ptr<GopState> gop_;
+        std::list<boost::shared_ptr<GopState>> gops_; // most recently used first
+        VideoFrameSlot frameSlot_;
+        int nFramesFetched_;
+        bool pumping_, repump_, decodingTarget_;
+
+        void startFetch(const ndn::Name& frameName);
+        void fetchNextInRange();
+        boost::shared_ptr<FrameFetchingTask>
+        spawnTask(const ndn::Name& frameName, OnSegment onFirstSegment = OnSegment());
+        void onTargetHeader(const boost::shared_ptr<const SlotSegment>& segment);
+        void onKeyHeader(const boost::shared_ptr<const SlotSegment>& segment);
+        void queueDeltas(PacketNumber from);
+
+        void pump();
+        void startTasks();
+        void decodeReady();
+        bool decodeFrame(const QueuedFrame& frame);
+        void decodeTarget();
+        void onFrameDecoded(const FrameInfo& fi, const WebRtcVideoFrame& f);
+
+        boost::shared_ptr<GopState> lookupGop(const ndn::Name& keyName);
+        void cacheGop(const boost::shared_ptr<GopState>& gop);
+        FrameInfo readFrameInfo(const BufferSlot& slot);
         void reset();
         void halt(std::string reason);
         VideoCoderParams setupDecoderParams(const boost::shared_ptr<ImmutableVideoFramePacket>&) const;
@@ -78,6 +135,19 @@ FrameFetcher::fetch(const ndn::Name& frameName,
     pimpl_->fetch(frameName, onBufferAllocate, onFrameFetched, onFetchFailure);
 }
 
+void
+FrameFetcher::fetchRange(const ndn::Name& threadPrefix,
+                         PacketNumber start, PacketNumber end,
+                         unsigned int stride,
+                         OnBufferAllocate onBufferAllocate,
+                         OnFrameFetched onFrameFetched,
+                         OnRangeFetched onRangeFetched,
+                         OnFetchFailure onFetchFailure)
+{
+    pimpl_->fetchRange(threadPrefix, start, end, stride,
+                       onBufferAllocate, onFrameFetched, onRangeFetched, onFetchFailure);
+}
+
 const ndn::Name&
 FrameFetcher::getName() const
 {
@@ -90,6 +160,18 @@ FrameFetcher::getState() const
     return pimpl_->getState(); 
 }
 
+void
+FrameFetcher::setSettings(const Settings& settings)
+{
+    pimpl_->setSettings(settings);
+}
+
+const FrameFetcher::Settings&
+FrameFetcher::getSettings() const
+{
+    return pimpl_->getSettings();
+}
+
 void
 FrameFetcher::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 { 
@@ -100,7 +182,11 @@ FrameFetcher::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logger)
 FrameFetcherImpl::FrameFetcherImpl(const boost::shared_ptr<StorageEngine>& storage)
     : storage_(storage), 
       state_(FrameFetcher::Idle), 
-      fetchSettings_({3,1000})
+      settings_({8, 4}),
+      fetchSettings_({3,1000}),
+      nFramesFetched_(0),
+      rangeActive_(false), rangeDriving_(false),
+      pumping_(false), repump_(false), decodingTarget_(false)
 {
     fetchMethod_ = make_shared<FetchMethodLocal>(storage_);
     description_ = "frame-fetcher";
@@ -108,325 +194,521 @@ FrameFetcherImpl::FrameFetcherImpl(const boost::shared_ptr<StorageEngine>& stora
 
 FrameFetcherImpl::FrameFetcherImpl(const boost::shared_ptr<Face>& face, const boost::shared_ptr<KeyChain>& keyChain)
     : state_(FrameFetcher::Idle), 
-      fetchSettings_({3,1000})
+      settings_({8, 4}),
+      fetchSettings_({3,1000}),
+      nFramesFetched_(0),
+      rangeActive_(false), rangeDriving_(false),
+      pumping_(false), repump_(false), decodingTarget_(false)
 {
     fetchMethod_ = make_shared<FetchMethodRemote>(face);
     description_ = "frame-fetcher";
 }
 
+void
+FrameFetcherImpl::setSettings(const FrameFetcher::Settings& settings)
+{
+    settings_ = settings;
+    if (settings_.window_ == 0)
+        settings_.window_ = 1;
+
+    while (gops_.size() > settings_.nCachedGops_)
+        gops_.pop_back();
+}
+
 void
 FrameFetcherImpl::fetch(const ndn::Name& frameName, 
                    OnBufferAllocate onBufferAllocate,
                    OnFrameFetched onFrameFetched,
                    OnFetchFailure onFetchFailure)
 {
-    if (NameComponents::extractInfo(frameName, frameNameInfo_))
+    // TODO: if fetching is asynchronous and multiple fetch calls invoked in
+    // rapid succession, these callbacks will be overwritten with the callbacks
+    // from the latest invocation.
+    // Needs to be fixed by storing callbacks per invocation.
+    onBufferAllocate_ = onBufferAllocate;
+    onFrameFetched_ = onFrameFetched;
+    onFetchFailure_ = onFetchFailure;
+    rangeActive_ = false;
+
+    startFetch(frameName);
+}
+
+void
+FrameFetcherImpl::fetchRange(const ndn::Name& threadPrefix,
+                             PacketNumber start, PacketNumber end,
+                             unsigned int stride,
+                             OnBufferAllocate onBufferAllocate,
+                             OnFrameFetched onFrameFetched,
+                             OnRangeFetched onRangeFetched,
+                             OnFetchFailure onFetchFailure)
+{
+    NamespaceInfo info;
+    Name firstFrameName(threadPrefix);
+    firstFrameName.append(NameComponents::NameComponentDelta).appendSequenceNumber(start);
+
+    if (!NameComponents::extractInfo(firstFrameName, info))
+        throw std::runtime_error("Bad thread prefix provided");
+    if (stride == 0 || end < start)
+        throw std::runtime_error("Bad frame range provided");
+
+    onBufferAllocate_ = onBufferAllocate;
+    onFrameFetched_ = onFrameFetched;
+    onRangeFetched_ = onRangeFetched;
+    onFetchFailure_ = onFetchFailure;
+
+    LogInfoC << "fetching range [" << start << ", " << end << "] stride " << stride
+             << " of " << threadPrefix << std::endl;
+
+    rangePrefix_ = threadPrefix;
+    rangeNext_ = start;
+    rangeEnd_ = end;
+    rangeStride_ = stride;
+    nRangeFetched_ = 0;
+    rangeActive_ = true;
+
+    fetchNextInRange();
+}
+
+void
+FrameFetcherImpl::fetchNextInRange()
+{
+    // called again once each frame is fetched; with local storage this
+    // happens before startFetch returns, so frames are fetched in this loop
+    if (rangeDriving_)
+        return;
+
+    shared_ptr<FrameFetcherImpl> self = shared_from_this();
+    rangeDriving_ = true;
+    while (rangeActive_ &&
+           state_ != FrameFetcher::Fetching && state_ != FrameFetcher::Decoding)
     {
-        // TODO: if fetching is asynchronous and multiple fetch calls invoked in
-        // rapid succession, these callbacks will be overwritten with the callbacks
-        // from the latest invocation.
-        // Needs to be fixed by storing callbacks per invocation.
-        onBufferAllocate_ = onBufferAllocate;
-        onFrameFetched_ = onFrameFetched;
-        onFetchFailure_ = onFetchFailure;
-        state_ = FrameFetcher::Fetching;
-
-        if (!frameNameInfo_.isDelta_) // if it's a key frame - all is easy, just fetch it and decode
+        if (rangeNext_ > rangeEnd_)
         {
-            shared_ptr<FrameFetcherImpl> self = shared_from_this();
-            shared_ptr<FrameFetchingTask> task 
-                = make_shared<FrameFetchingTask>(
-                    frameName,
-                    fetchMethod_,
-                    [self, this](const boost::shared_ptr<const FetchingTask>& task, 
-                       const boost::shared_ptr<const BufferSlot>& slot)
-                    {
-                        LogInfoC << "target frame fetched" << std::endl;
-                        checkReadyDecode();
-                    },
-                    [self, this](const boost::shared_ptr<const FetchingTask>& task,
-                      std::string reason)
-                    {
-                        LogErrorC << "failed to fetch target frame: " << reason << std::endl;
-                        halt(reason);
-                    },
-                    fetchSettings_);
+            LogInfoC << "fetched " << nRangeFetched_ << " frames of the range" << std::endl;
 
-            LogInfoC << "initiating fetching for target frame " << frameName << std::endl;
+            rangeActive_ = false;
+            if (onRangeFetched_) onRangeFetched_(self, nRangeFetched_);
+            break;
+        }
 
-            targetFrameTask_ = task;
-            keyFrameTask_ = task;
-            fetchingTasks_[frameName] = task;
+        Name frameName(rangePrefix_);
+        frameName.append(NameComponents::NameComponentDelta).appendSequenceNumber(rangeNext_);
+        rangeNext_ = (rangeEnd_ - rangeNext_ < rangeStride_ ? rangeEnd_+1 : rangeNext_+rangeStride_);
+        startFetch(frameName);
+    }
+    rangeDriving_ = false;
+}
 
-            task->setLogger(getLogger());
-            task->start();
+void
+FrameFetcherImpl::startFetch(const ndn::Name& frameName)
+{
+    if (!NameComponents::extractInfo(frameName, frameNameInfo_))
+        throw std::runtime_error("Bad frame name provided");
+
+    reset();
+    nFramesFetched_ = 0;
+    state_ = FrameFetcher::Fetching;
+
+    if (!frameNameInfo_.isDelta_)
+    {
+        // if it's a Key frame - all is easy, just fetch it (unless we have
+        // it already) and decode
+        gop_ = lookupGop(frameNameInfo_.getPrefix(prefix_filter::Sample));
+
+        if (gop_)
+        {
+            LogInfoC << "target frame is cached" << std::endl;
+            targetSlot_ = gop_->keySlot_;
         }
         else
         {
-            // spawn fetching target frame
-            shared_ptr<FrameFetcherImpl> self = shared_from_this();
-            shared_ptr<FrameFetchingTask> task 
-                = make_shared<FrameFetchingTask>(
-                    frameName,
-                    fetchMethod_,
-                    [self, this](const boost::shared_ptr<const FetchingTask>& task, 
-                       const boost::shared_ptr<const BufferSlot>& slot)
-                    {
-                        LogInfoC << "target frame fetched" << std::endl;
-                        checkReadyDecode();
-                    },
-                    [self, this](const boost::shared_ptr<const FetchingTask>& task,
-                      std::string reason)
-                    {
-                        LogErrorC << "failed to fetch target frame: " << reason << std::endl;
-                        halt(reason);
-                    },
-                    fetchSettings_,
-                    [self, this](const boost::shared_ptr<const FetchingTask>& task,
-                              const boost::shared_ptr<const SlotSegment>& segment)
-                    {
-                        // on first segment
-                        // figure out Key frame # and request it here
-                        fetchGopKey(segment);
-                    });
-
             LogInfoC << "initiating fetching for target frame " << frameName << std::endl;
-
-            targetFrameTask_ = task;
-            fetchingTasks_[frameName] = task;
-
-            task->setLogger(getLogger());
-            task->start();
+            targetFrameTask_ = spawnTask(frameName);
+            targetFrameTask_->start();
         }
     }
     else
-        throw std::runtime_error("Bad frame name provided");
+    {
+        LogInfoC << "initiating fetching for target frame " << frameName << std::endl;
+
+        // once first segment arrives, figure out Key frame # and plan
+        // fetching of the rest of the GOP
+        shared_ptr<FrameFetcherImpl> self = shared_from_this();
+        targetFrameTask_ = spawnTask(frameName,
+            [self, this](const boost::shared_ptr<const FetchingTask>& task,
+                         const boost::shared_ptr<const SlotSegment>& segment)
+            {
+                onTargetHeader(segment);
+            });
+        targetFrameTask_->start();
+    }
+
+    pump();
 }
 
-void 
-FrameFetcherImpl::fetchGopKey(const boost::shared_ptr<const SlotSegment>& deltaSegment)
+shared_ptr<FrameFetchingTask>
+FrameFetcherImpl::spawnTask(const ndn::Name& frameName, OnSegment onFirstSegment)
 {
-    const shared_ptr<WireData<VideoFrameSegmentHeader>> videoFrameSegment = 
-        dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(deltaSegment->getData());
-    
-    PacketNumber keyFrameNumber = videoFrameSegment->segment().getHeader().pairedSequenceNo_;
-    Name keyFrameName = frameNameInfo_.getPrefix(prefix_filter::ThreadNT)
-                                      .append(NameComponents::NameComponentKey)
-                                      .appendSequenceNumber(keyFrameNumber);
-    
-    LogInfoC << "will fetch Key frame " << keyFrameNumber
-             << " (" << keyFrameName << ")" << std::endl;
-    
     shared_ptr<FrameFetcherImpl> self = shared_from_this();
-    shared_ptr<FrameFetchingTask> task = 
+    shared_ptr<FrameFetchingTask> task =
         make_shared<FrameFetchingTask>(
-            keyFrameName,
+            frameName,
             fetchMethod_,
-            [self, this](const boost::shared_ptr<const FetchingTask>& task, 
+            [self, this](const boost::shared_ptr<const FetchingTask>& task,
                          const boost::shared_ptr<const BufferSlot>& slot)
             {
-                LogInfoC << "key frame fetched" << std::endl;
-                checkReadyDecode();
+                LogDebugC << task->getFrameName() << " fetched" << std::endl;
+                pump();
             },
             [self, this](const boost::shared_ptr<const FetchingTask>& task,
                          std::string reason)
             {
-                LogErrorC << "failed to fetch Key frame: " << reason << std::endl;
+                LogErrorC << "failed to fetch " << task->getFrameName()
+                          << ": " << reason << std::endl;
                 halt(reason);
             },
             fetchSettings_,
-            [self, this](const boost::shared_ptr<const FetchingTask>& task,
-                         const boost::shared_ptr<const SlotSegment>& segment)
-            {
-                // on first segment
-                // figure out First Delta gop number and request them all
-                fetchGopDelta(segment);
-            },
-            [](const boost::shared_ptr<const FetchingTask>& task,
-                     const boost::shared_ptr<const SlotSegment>& segment)
-            {
-            });
-
-    keyFrameTask_ = task;
-    fetchingTasks_[keyFrameName] = task;
+            onFirstSegment);
 
+    nFramesFetched_++;
     task->setLogger(getLogger());
-    task->start();
+
+    return task;
 }
 
 void
-FrameFetcherImpl::fetchGopDelta(const boost::shared_ptr<const SlotSegment>& segment)
+FrameFetcherImpl::onTargetHeader(const boost::shared_ptr<const SlotSegment>& deltaSegment)
 {
-    const shared_ptr<WireData<VideoFrameSegmentHeader>> videoFrameSegment = 
+    const shared_ptr<WireData<VideoFrameSegmentHeader>> videoFrameSegment =
+        dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(deltaSegment->getData());
+
+    PacketNumber keyFrameNumber = videoFrameSegment->segment().getHeader().pairedSequenceNo_;
+    Name keyFrameName = frameNameInfo_.getPrefix(prefix_filter::ThreadNT)
+                                      .append(NameComponents::NameComponentKey)
+                                      .appendSequenceNumber(keyFrameNumber);
+
+    gop_ = lookupGop(keyFrameName);
+
+    if (gop_ && gop_->nextDelta_ <= frameNameInfo_.sampleNo_)
+    {
+        LogInfoC << "continue decoding GOP of Key " << keyFrameNumber
+                 << " from delta " << gop_->nextDelta_ << std::endl;
+
+        queueDeltas(gop_->nextDelta_);
+    }
+    else if (gop_)
+    {
+        LogInfoC << "decoding GOP of Key " << keyFrameNumber
+                 << " from cached Key frame" << std::endl;
+
+        decodeQueue_.push_back({ keyFrameName, true, keyFrameNumber,
+                                 shared_ptr<FrameFetchingTask>(), gop_->keySlot_ });
+        queueDeltas(gop_->firstDelta_);
+    }
+    else
+    {
+        LogInfoC << "will fetch Key frame " << keyFrameNumber
+                 << " (" << keyFrameName << ")" << std::endl;
+
+        gop_ = make_shared<GopState>();
+        gop_->keyName_ = keyFrameName;
+        gop_->firstDelta_ = gop_->nextDelta_ = 0;
+
+        // deltas are queued once Key frame header tells us first delta #
+        decodeQueue_.push_back({ keyFrameName, true, keyFrameNumber,
+                                 shared_ptr<FrameFetchingTask>(), shared_ptr<const BufferSlot>() });
+    }
+
+    pump();
+}
+
+void
+FrameFetcherImpl::onKeyHeader(const boost::shared_ptr<const SlotSegment>& segment)
+{
+    const shared_ptr<WireData<VideoFrameSegmentHeader>> videoFrameSegment =
         dynamic_pointer_cast<WireData<VideoFrameSegmentHeader>>(segment->getData());
-    PacketNumber firstGopDeltaNumber = videoFrameSegment->segment().getHeader().pairedSequenceNo_;
 
-    // check, how many delta frames we need to fetch
-    int deltasToFetch = frameNameInfo_.sampleNo_ - firstGopDeltaNumber;
+    gop_->firstDelta_ = videoFrameSegment->segment().getHeader().pairedSequenceNo_;
+    gop_->nextDelta_ = gop_->firstDelta_;
+    queueDeltas(gop_->firstDelta_);
+    pump();
+}
 
-    if (deltasToFetch)
+void
+FrameFetcherImpl::queueDeltas(PacketNumber from)
+{
+    if (from > frameNameInfo_.sampleNo_)
     {
-        assert(deltasToFetch > 0);
+        halt("Target frame doesn't belong to its' GOP");
+        return;
+    }
 
-        LogInfoC << "will fetch " << deltasToFetch << " delta frames " << std::endl;
+    LogInfoC << "will fetch " << frameNameInfo_.sampleNo_ - from << " delta frames" << std::endl;
 
-        Name prefix(frameNameInfo_.getPrefix(prefix_filter::Thread));
+    Name prefix(frameNameInfo_.getPrefix(prefix_filter::Thread));
+    for (PacketNumber deltaSeqNo = from; deltaSeqNo < frameNameInfo_.sampleNo_; ++deltaSeqNo)
+    {
+        Name deltaFrameName(prefix);
+        deltaFrameName.appendSequenceNumber(deltaSeqNo);
+        decodeQueue_.push_back({ deltaFrameName, false, deltaSeqNo,
+                                 shared_ptr<FrameFetchingTask>(), shared_ptr<const BufferSlot>() });
+    }
+}
 
-        for (PacketNumber deltaSeqNo = firstGopDeltaNumber; 
-             deltaSeqNo < frameNameInfo_.sampleNo_; 
-             ++deltaSeqNo)
+void
+FrameFetcherImpl::pump()
+{
+    // fetching from local storage completes tasks synchronously, so this is
+    // re-entered from task callbacks; unwind instead of recursing over the GOP
+    if (pumping_)
+    {
+        repump_ = true;
+        return;
+    }
+
+    shared_ptr<FrameFetcherImpl> self = shared_from_this();
+    pumping_ = true;
+    do {
+        repump_ = false;
+        decodeReady();
+        if (state_ == FrameFetcher::Fetching)
+            startTasks();
+    } while (repump_ && state_ == FrameFetcher::Fetching);
+    pumping_ = false;
+}
+
+void
+FrameFetcherImpl::startTasks()
+{
+    // queue may grow and may be cleared (on failure) while tasks are started
+    unsigned int nInFlight = 0;
+    for (size_t i = 0;
+         i < decodeQueue_.size() && nInFlight < settings_.window_ && state_ == FrameFetcher::Fetching;
+         ++i)
+    {
+        if (decodeQueue_[i].slot_)
+            continue;
+
+        nInFlight++;
+        if (!decodeQueue_[i].task_)
         {
-            Name deltaFrameName(prefix);
-            deltaFrameName.appendSequenceNumber(deltaSeqNo);
-
-            LogDebugC << "will fetch " << deltaFrameName << std::endl;
-
-            shared_ptr<FrameFetcherImpl> self = shared_from_this();
-            shared_ptr<FrameFetchingTask> task = 
-                make_shared<FrameFetchingTask>(
-                    deltaFrameName,
-                    fetchMethod_,
-                    [self, this, deltaSeqNo](const boost::shared_ptr<const FetchingTask>& task, 
-                                const boost::shared_ptr<const BufferSlot>& slot)
-                    {
-                        LogDebugC << "delta " << deltaSeqNo << " fetched" << std::endl;
-                        checkReadyDecode();
-                    },
+            LogDebugC << "will fetch " << decodeQueue_[i].name_ << std::endl;
+
+            shared_ptr<FrameFetchingTask> task;
+            if (decodeQueue_[i].isKey_)
+            {
+                shared_ptr<FrameFetcherImpl> self = shared_from_this();
+                task = spawnTask(decodeQueue_[i].name_,
                     [self, this](const boost::shared_ptr<const FetchingTask>& task,
-                                 std::string reason)
+                                 const boost::shared_ptr<const SlotSegment>& segment)
                     {
-                        LogErrorC << "failed to fetch delta frame: " << reason << std::endl;
-                        halt(reason);
-                    },
-                    fetchSettings_);
-
-            deltasTasks_[deltaFrameName] = task;
-            fetchingTasks_[deltaFrameName] = task;
+                        // figure out first Delta gop number and request them all
+                        onKeyHeader(segment);
+                    });
+            }
+            else
+                task = spawnTask(decodeQueue_[i].name_);
 
-            task->setLogger(getLogger());
+            decodeQueue_[i].task_ = task;
             task->start();
         }
     }
 }
 
 void
-FrameFetcherImpl::checkReadyDecode()
+FrameFetcherImpl::decodeReady()
 {
-    if (state_ == FrameFetcher::Fetching)
+    while (state_ == FrameFetcher::Fetching && decodeQueue_.size())
     {
-        // LogInfoC << "checking " << fetchingTasks_.size() << " tasks..." << std::endl;
+        QueuedFrame& frame = decodeQueue_.front();
 
-        // check if we have all that's needed to decoding...
-        bool allFetched = true;
-        for (auto t:fetchingTasks_)
-            allFetched &= (t.second->getState() == FrameFetchingTask::Completed);
+        if (!frame.slot_ && frame.task_ &&
+            frame.task_->getState() == FrameFetchingTask::Completed)
+            frame.slot_ = frame.task_->getSlot();
 
-        if (allFetched)
-        {
-            state_ = FrameFetcher::Decoding;
-            decode();
-        }
+        if (!frame.slot_)
+            return;
+
+        QueuedFrame f = frame;
+        decodeQueue_.pop_front();
+        if (!decodeFrame(f))
+            return;
     }
+
+    if (state_ == FrameFetcher::Fetching && !targetSlot_ &&
+        targetFrameTask_ && targetFrameTask_->getState() == FrameFetchingTask::Completed)
+        targetSlot_ = targetFrameTask_->getSlot();
+
+    // target's GOP is known by the time target is fetched, hence empty queue
+    // means all preceding frames were decoded
+    if (state_ == FrameFetcher::Fetching && targetSlot_)
+        decodeTarget();
+}
+
+bool
+FrameFetcherImpl::decodeFrame(const QueuedFrame& frame)
+{
+    bool recovered = false;
+    shared_ptr<ImmutableVideoFramePacket> framePacket = frameSlot_.readPacket(*frame.slot_, recovered);
+
+    if (!framePacket.get())
+    {
+        halt("Couldn't retrieve frame from "+frame.slot_->getPrefix().toUri());
+        return false;
+    }
+
+    FrameInfo finfo = readFrameInfo(*frame.slot_);
+
+    if (frame.isKey_)
+    {
+        LogDebugC << "decoding Key " << frame.sampleNo_ << std::endl;
+
+        if (!gop_->decoder_)
+            gop_->decoder_ = boost::make_shared<VideoDecoder>(setupDecoderParams(framePacket),
+                [this](const FrameInfo& fi, const WebRtcVideoFrame& f){
+                    onFrameDecoded(fi, f);
+                });
+        gop_->decoder_->processFrame(finfo, framePacket->getFrame());
+        gop_->keySlot_ = frame.slot_;
+        gop_->nextDelta_ = gop_->firstDelta_;
+        cacheGop(gop_);
+    }
+    else
+    {
+        LogDebugC << "decoding Delta " << frame.sampleNo_ << std::endl;
+
+        gop_->decoder_->processFrame(finfo, framePacket->getFrame());
+        gop_->nextDelta_ = frame.sampleNo_+1;
+    }
+
+    return true;
 }
 
 void
-FrameFetcherImpl::decode()
+FrameFetcherImpl::decodeTarget()
 {
-    // initialize decoder here and start decoding...
-    VideoFrameSlot frameSlot;
+    state_ = FrameFetcher::Decoding;
+
     bool recovered = false;
-    shared_ptr<const BufferSlot> slot = keyFrameTask_->getSlot();
-    shared_ptr<ImmutableVideoFramePacket> framePacket =
-        frameSlot.readPacket(*slot, recovered);
-    
-    if (framePacket.get())
+    shared_ptr<ImmutableVideoFramePacket> framePacket = frameSlot_.readPacket(*targetSlot_, recovered);
+
+    if (!framePacket.get())
     {
-        VideoFrameSegmentHeader header = frameSlot.readSegmentHeader(*slot);
-        FrameInfo finfo({ (uint64_t)(slot->getHeader().publishUnixTimestamp_*1000),
-                                     header.playbackNo_,
-                                     slot->getPrefix().toUri() });
-        VideoCoderParams params = setupDecoderParams(framePacket);
-        shared_ptr<FrameFetcherImpl> self = shared_from_this();
-        int needToDecode = fetchingTasks_.size();
-        OnDecodedImage onDecoded = 
-            [&needToDecode, self, this](const FrameInfo& fi, const WebRtcVideoFrame& f){
-                --needToDecode;
-
-                if (needToDecode == 0)
-                {
-                    uint8_t* buffer = onBufferAllocate_(self, f.width(), f.height());
-                    if (buffer)
-                    {
-                        state_ = FrameFetcher::Completed;
-
-                        ConvertFromI420(f, webrtc::kBGRA, 0, buffer);
-                        onFrameFetched_(self, fi, fetchingTasks_.size(), 
-                                        f.width(), f.height(), buffer);
-                    }
-                    else
-                        LogWarnC << "received null buffer for frame" << std::endl;
-                    reset();
-                }
-            };
-        boost::shared_ptr<VideoDecoder> decoder = 
-            boost::make_shared<VideoDecoder>(params, onDecoded);
-
-        LogDebugC << "need to decode " << needToDecode << " frames. decoding Key" << std::endl;
-        assert(needToDecode > 0);
-        decoder->processFrame(finfo, framePacket->getFrame());
-
-        // decode deltas if needed
-        for (auto t:deltasTasks_)
-        {
-            LogDebugC << "decoding Delta " << needToDecode << std::endl;
+        halt("Couldn't retrieve frame from "+targetSlot_->getPrefix().toUri());
+        return;
+    }
 
-            slot = t.second->getSlot();
-            framePacket = frameSlot.readPacket(*slot, recovered);
-            if (framePacket.get())
-                decoder->processFrame(finfo, framePacket->getFrame());
-            else
-                halt("Couldn't retrieve frame from "+t.second->getSlot()->getPrefix().toUri());
-        }
+    FrameInfo finfo = readFrameInfo(*targetSlot_);
 
-        if (targetFrameTask_ != keyFrameTask_)
-        {
-            assert(needToDecode == 1);
-            LogDebugC << "decoding target frame " << needToDecode << std::endl;
+    if (!frameNameInfo_.isDelta_ && !gop_)
+    {
+        gop_ = make_shared<GopState>();
+        gop_->keyName_ = frameNameInfo_.getPrefix(prefix_filter::Sample);
+        gop_->firstDelta_ = frameSlot_.readSegmentHeader(*targetSlot_).pairedSequenceNo_;
+    }
 
-            slot = targetFrameTask_->getSlot();
-            framePacket = frameSlot.readPacket(*slot, recovered);
-            if (framePacket.get())
-            {
-                header = frameSlot.readSegmentHeader(*slot);
-                finfo.timestamp_ = (uint64_t)(slot->getHeader().publishUnixTimestamp_*1000);
-                finfo.playbackNo_ = header.playbackNo_;
-                finfo.ndnName_ = slot->getPrefix().toUri();
+    LogDebugC << "decoding target frame " << finfo.ndnName_ << std::endl;
 
-                decoder->processFrame(finfo, framePacket->getFrame());
-            }
-            else
-                halt("Couldn't retrieve frame from "+targetFrameTask_->getSlot()->getPrefix().toUri());
-        }
+    if (!gop_->decoder_)
+        gop_->decoder_ = boost::make_shared<VideoDecoder>(setupDecoderParams(framePacket),
+            [this](const FrameInfo& fi, const WebRtcVideoFrame& f){
+                onFrameDecoded(fi, f);
+            });
 
-        assert(needToDecode == 0);
+    decodingTarget_ = true;
+    gop_->decoder_->processFrame(finfo, framePacket->getFrame());
+    decodingTarget_ = false;
+
+    if (frameNameInfo_.isDelta_)
+        gop_->nextDelta_ = frameNameInfo_.sampleNo_+1;
+    else
+    {
+        gop_->keySlot_ = targetSlot_;
+        gop_->nextDelta_ = gop_->firstDelta_;
+        cacheGop(gop_);
     }
+
+    if (state_ == FrameFetcher::Decoding)
+        halt("Decoder didn't produce frame "+finfo.ndnName_);
     else
-        halt("Couldn't retrieve frame from "+keyFrameTask_->getSlot()->getPrefix().toUri());
+    {
+        reset();
+        if (rangeActive_)
+        {
+            nRangeFetched_++;
+            fetchNextInRange();
+        }
+    }
 }
 
 void
-FrameFetcherImpl::reset()
+FrameFetcherImpl::onFrameDecoded(const FrameInfo& fi, const WebRtcVideoFrame& f)
 {
-    for (auto t:fetchingTasks_)
+    if (!decodingTarget_)
+        return;
+
+    shared_ptr<FrameFetcherImpl> self = shared_from_this();
+    uint8_t* buffer = onBufferAllocate_(self, f.width(), f.height());
+    state_ = FrameFetcher::Completed;
+
+    if (buffer)
     {
-        t.second->cancel();
-        t.second.reset();
+        ConvertFromI420(f, webrtc::kBGRA, 0, buffer);
+        onFrameFetched_(self, fi, nFramesFetched_, f.width(), f.height(), buffer);
     }
+    else
+        LogWarnC << "received null buffer for frame" << std::endl;
+}
+
+shared_ptr<FrameFetcherImpl::GopState>
+FrameFetcherImpl::lookupGop(const ndn::Name& keyName)
+{
+    for (std::list<shared_ptr<GopState>>::iterator it = gops_.begin(); it != gops_.end(); ++it)
+        if ((*it)->keyName_ == keyName)
+        {
+            shared_ptr<GopState> gop = *it;
+            gops_.erase(it);
+            gops_.push_front(gop);
+            return gop;
+        }
+
+    return shared_ptr<GopState>();
+}
+
+void
+FrameFetcherImpl::cacheGop(const shared_ptr<GopState>& gop)
+{
+    if (gops_.size() && gops_.front() == gop)
+        return;
+
+    gops_.remove(gop);
+    gops_.push_front(gop);
+    while (gops_.size() > settings_.nCachedGops_)
+        gops_.pop_back();
+}
+
+FrameInfo
+FrameFetcherImpl::readFrameInfo(const BufferSlot& slot)
+{
+    VideoFrameSegmentHeader header = frameSlot_.readSegmentHeader(slot);
+    FrameInfo finfo({ (uint64_t)(slot.getHeader().publishUnixTimestamp_*1000),
+                      header.playbackNo_,
+                      slot.getPrefix().toUri() });
+    return finfo;
+}
+
+void
+FrameFetcherImpl::reset()
+{
+    if (targetFrameTask_)
+        targetFrameTask_->cancel();
+    for (auto& f:decodeQueue_)
+        if (f.task_) f.task_->cancel();
 
-    fetchingTasks_.clear();
-    deltasTasks_.clear();
-    keyFrameTask_.reset();
+    decodeQueue_.clear();
     targetFrameTask_.reset();
+    targetSlot_.reset();
+    gop_.reset();
 }
 
 void
@@ -435,6 +717,7 @@ FrameFetcherImpl::halt(std::string reason)
     if (state_ != FrameFetcher::Failed)
     {
         state_ = FrameFetcher::Failed;
+        rangeActive_ = false;
         onFetchFailure_(shared_from_this(), reason);
         reset();
     }
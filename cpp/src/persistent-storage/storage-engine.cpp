@@ -7,25 +7,32 @@
 
 #include "storage-engine.hpp"
 
-#include <unordered_map>
+#include <map>
+#include <sstream>
+#include <cstring>
 #include <ndn-cpp/name.hpp>
 #include <ndn-cpp/data.hpp>
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/util/blob.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "clock.hpp"
+#include "storage-key.hpp"
+#include "data-cache.hpp"
 
 #if HAVE_PERSISTENT_STORAGE
 
 #ifndef __ANDROID__ // use RocksDB on linux and macOS
     
     #include <rocksdb/db.h>
+    #include <rocksdb/write_batch.h>
     namespace db_namespace = rocksdb;
 
 #else // for Android - use LevelDB
 
     #include <leveldb/db.h>
+    #include <leveldb/write_batch.h>
     namespace db_namespace = leveldb;
 
 #endif
@@ -37,6 +44,24 @@ using namespace ndn;
 using namespace boost;
 
 //******************************************************************************
+#if HAVE_PERSISTENT_STORAGE
+namespace {
+const std::string IndexClean = "clean";
+
+// value bytes are copied once, into the buffer adopted by decoded packet
+shared_ptr<Data> decodeData(const char *value, size_t size)
+{
+    ptr_lib::shared_ptr<std::vector<uint8_t>> wire =
+        ptr_lib::make_shared<std::vector<uint8_t>>((const uint8_t *)value,
+                                                   (const uint8_t *)value + size);
+    shared_ptr<Data> data = make_shared<Data>();
+    data->wireDecode(Blob(wire, false));
+
+    return data;
+}
+}
+#endif
+
 namespace ndnrtc {
 
 class StorageEngineImpl : public enable_shared_from_this<StorageEngineImpl>
@@ -49,8 +74,11 @@ class StorageEngineImpl : public enable_shared_from_this<StorageEngineImpl>
     } Stats;
 
 #if HAVE_PERSISTENT_STORAGE
-    StorageEngineImpl(std::string dbPath) : dbPath_(dbPath), db_(nullptr), keysTrieBuilt_(false)
+    StorageEngineImpl(std::string dbPath) : dbPath_(dbPath), readOnly_(true), indexLoaded_(false),
+                                            binaryKeys_(true), db_(nullptr), batchStartMs_(0)
     {
+        stats_.nKeys_ = 0;
+        stats_.valueSizeBytes_ = 0;
     }
 #else
     StorageEngineImpl(std::string dbPath)
@@ -67,60 +95,82 @@ class StorageEngineImpl : public enable_shared_from_this<StorageEngineImpl>
     bool open(bool readOnly);
     void close();
 
+    void setWriteSettings(const StorageEngine::WriteSettings &settings);
+    const StorageEngine::WriteSettings &getWriteSettings() const { return writeSettings_; }
+
     bool put(const Data &data);
+    bool put(const std::vector<shared_ptr<const Data>> &segments);
+    bool flush();
     shared_ptr<Data> get(const Name &dataName);
     shared_ptr<Data> read(const Interest &interest);
 
     void getLongestPrefixes(asio::io_service &io,
                             function<void(const std::vector<Name> &)> onCompletion);
-    const Stats &getStats() const { return stats_; }
+    void scanNames(function<bool(const Name &)> onName);
+    void setCacheSize(size_t capacityBytes, unsigned int nShards);
+    shared_ptr<DataCache> getCache() const { return cache_; }
+    Stats getStats() const
+    {
+        lock_guard<mutex> scopedLock(indexMutex_);
+        return stats_;
+    }
+    bool hasBinaryKeys() const { return binaryKeys_; }
+
+    static size_t migrate(const std::string &legacyDbPath, const std::string &dbPath,
+                          function<void(size_t)> onProgress);
 
   private:
+    // Trie of key components. Nodes and their labels are kept in two flat
+    // arrays; children of a node form a singly-linked list. Keys are expected
+    // to be inserted in DB order, where keys that share a component are
+    // adjacent, so the last added child is checked first.
     class NameTrie
     {
       public:
-        struct TrieNode
-        {
-            bool isLeaf;
-            std::unordered_map<std::string, shared_ptr<TrieNode>> components;
+        typedef std::pair<const char *, size_t> Label;
+        typedef function<Name::Component(const char *, size_t)> ComponentDecoder;
 
-            TrieNode() : isLeaf(false) {}
-        };
+        NameTrie() { clear(); }
 
-        NameTrie() : head_(make_shared<TrieNode>()) {}
-
-        void insert(const std::string &n)
+        void clear()
         {
+            nodes_.clear();
+            labels_.clear();
+            nodes_.push_back(Node());
+        }
 
-            shared_ptr<TrieNode> curr = head_;
-            std::vector<std::string> components;
-            split(components, n, boost::is_any_of("/"));
+        void insert(const std::vector<Label> &components)
+        {
+            int32_t curr = 0;
 
-            for (auto c : components)
+            for (auto &c : components)
             {
-                if (c.size() == 0)
+                if (c.second == 0)
                     continue;
-                if (curr->components.find(c) == curr->components.end())
-                    curr->components[c] = make_shared<TrieNode>();
-                curr = curr->components[c];
+
+                int32_t child = findChild(curr, c);
+                curr = (child != -1 ? child : addChild(curr, c));
             }
+
+            if (curr)
+                nodes_[curr].isLeaf_ = true;
         }
 
         // gets all longest prefixes
-        const std::vector<Name> getLongestPrefixes() const
+        const std::vector<Name> getLongestPrefixes(ComponentDecoder decode) const
         {
             std::vector<Name> longestPrefixes;
 
-            for (auto cIt : head_->components)
+            for (int32_t c = nodes_[0].firstChild_; c != -1; c = nodes_[c].nextSibling_)
             {
-                Name n(cIt.first);
-                shared_ptr<TrieNode> curr = cIt.second;
+                Name n;
+                int32_t curr = c;
 
-                while (curr.get() && !curr->isLeaf && curr->components.size() == 1)
+                n.append(decode(label(curr), nodes_[curr].labelLength_));
+                while (!nodes_[curr].isLeaf_ && nodes_[curr].nChildren_ == 1)
                 {
-                    auto it = curr->components.begin();
-                    n.append(Name::fromEscapedString(it->first));
-                    curr = it->second;
+                    curr = nodes_[curr].firstChild_;
+                    n.append(decode(label(curr), nodes_[curr].labelLength_));
                 }
                 longestPrefixes.push_back(n);
             }
@@ -128,19 +178,118 @@ class StorageEngineImpl : public enable_shared_from_this<StorageEngineImpl>
             return longestPrefixes;
         }
 
+        size_t getNodesNum() const { return nodes_.size(); }
+
       private:
-        shared_ptr<TrieNode> head_;
+        struct Node
+        {
+            Node() : labelOffset_(0), labelLength_(0), firstChild_(-1), lastChild_(-1),
+                     nextSibling_(-1), nChildren_(0), isLeaf_(false) {}
+
+            size_t labelOffset_;
+            uint32_t labelLength_;
+            int32_t firstChild_, lastChild_, nextSibling_;
+            uint32_t nChildren_;
+            bool isLeaf_;
+        };
+
+        std::vector<Node> nodes_;
+        std::string labels_;
+
+        const char *label(int32_t node) const { return labels_.data() + nodes_[node].labelOffset_; }
+
+        bool hasLabel(int32_t node, const Label &l) const
+        {
+            return nodes_[node].labelLength_ == l.second &&
+                   memcmp(label(node), l.first, l.second) == 0;
+        }
+
+        int32_t findChild(int32_t parent, const Label &l) const
+        {
+            if (nodes_[parent].lastChild_ != -1 && hasLabel(nodes_[parent].lastChild_, l))
+                return nodes_[parent].lastChild_;
+
+            for (int32_t c = nodes_[parent].firstChild_; c != -1; c = nodes_[c].nextSibling_)
+                if (hasLabel(c, l))
+                    return c;
+            return -1;
+        }
+
+        int32_t addChild(int32_t parent, const Label &l)
+        {
+            Node n;
+            n.labelOffset_ = labels_.size();
+            n.labelLength_ = l.second;
+            labels_.append(l.first, l.second);
+
+            int32_t idx = nodes_.size();
+            nodes_.push_back(n);
+
+            Node &p = nodes_[parent];
+            if (p.lastChild_ != -1)
+                nodes_[p.lastChild_].nextSibling_ = idx;
+            else
+                p.firstChild_ = idx;
+            p.lastChild_ = idx;
+            p.nChildren_++;
+
+            return idx;
+        }
     };
 
     std::string dbPath_;
-    bool keysTrieBuilt_;
-    NameTrie keysTrie_;
+    bool readOnly_;
     Stats stats_;
+    // binary-keyed DBs keep longest common prefix of keys under each first
+    // component and stats in reserved keys, so startup does not need to scan
+    // the whole DB; index is marked dirty while DB is open for writing
+    bool indexLoaded_;
+    mutable mutex indexMutex_;
+    std::map<std::string, std::string> prefixes_;
+    shared_ptr<DataCache> cache_;
+    StorageEngine::WriteSettings writeSettings_;
+    // false for DBs created before keys were switched from name URIs to
+    // StorageKey encoding (see StorageEngine::migrate)
+    bool binaryKeys_;
 #if HAVE_PERSISTENT_STORAGE
     db_namespace::DB *db_;
+    db_namespace::WriteOptions writeOptions_;
+
+    mutex batchMutex_;
+    db_namespace::WriteBatch batch_;
+    // keys and value sizes of records in batch_
+    std::vector<std::pair<std::string, size_t>> batchKeys_;
+    int64_t batchStartMs_;
+
+    std::string key(const Name &name) const
+    {
+        return binaryKeys_ ? StorageKey::fromName(name) : name.toUri();
+    }
+    size_t keyComponentsNum(const db_namespace::Slice &key) const
+    {
+        return binaryKeys_ ? StorageKey::countComponents(key.data(), key.size())
+                           : Name(key.ToString()).size();
+    }
+    shared_ptr<Data> getByKey(const std::string &key);
+    shared_ptr<Data> getCached(const std::string &key) const;
+    uint64_t getCacheVersion() const;
+    shared_ptr<Data> decodeAndCache(const std::string &key, const char *value, size_t size,
+                                    uint64_t cacheVersion);
+    bool matchesSuffixComponents(const db_namespace::Slice &key, size_t prefixSize,
+                                 const Interest &interest) const;
+
+    void addToBatch(const Data &data);
+    bool isBatchDue() const;
+    bool isEmpty() const;
+
+    bool loadIndex();
+    bool saveIndex(bool clean);
+    int64_t getStoredSize(const std::string &key) const;
+    void updateIndex(const std::string &key, size_t valueSize, int64_t storedSize);
+    bool writeBatch();
 #endif
 
-    void buildKeyTrie();
+    std::vector<ndn::Name> buildKeyTrie();
 };
 
 }
@@ -174,6 +323,27 @@ void StorageEngine::put(const Data &data)
     pimpl_->put(data);
 }
 
+void StorageEngine::put(const std::vector<shared_ptr<const Data>> &segments)
+{
+    pimpl_->put(segments);
+}
+
+void StorageEngine::flush()
+{
+    pimpl_->flush();
+}
+
+void StorageEngine::setWriteSettings(const WriteSettings &settings)
+{
+    pimpl_->setWriteSettings(settings);
+}
+
+const StorageEngine::WriteSettings &
+StorageEngine::getWriteSettings() const
+{
+    return pimpl_->getWriteSettings();
+}
+
 shared_ptr<Data>
 StorageEngine::get(const Name &dataName)
 {
@@ -192,6 +362,48 @@ void StorageEngine::scanForLongestPrefixes(asio::io_service &io,
     pimpl_->getLongestPrefixes(io, onCompleted);
 }
 
+void StorageEngine::setCacheSize(size_t capacityBytes, unsigned int nShards)
+{
+    pimpl_->setCacheSize(capacityBytes, nShards);
+}
+
+StorageEngine::CacheStats
+StorageEngine::getCacheStats() const
+{
+    CacheStats stats = {0, 0, 0, 0, 0};
+    shared_ptr<DataCache> cache = pimpl_->getCache();
+
+    if (cache)
+    {
+        DataCache::Stats s = cache->getStats();
+        stats.hits_ = s.hits_;
+        stats.misses_ = s.misses_;
+        stats.evictions_ = s.evictions_;
+        stats.nEntries_ = s.nEntries_;
+        stats.sizeBytes_ = s.sizeBytes_;
+    }
+
+    return stats;
+}
+
+void StorageEngine::scanNames(function<bool(const Name &)> onName)
+{
+    pimpl_->scanNames(onName);
+}
+
+size_t
+StorageEngine::migrate(const std::string &legacyDbPath, const std::string &dbPath,
+                       function<void(size_t)> onProgress)
+{
+    return StorageEngineImpl::migrate(legacyDbPath, dbPath, onProgress);
+}
+
+bool
+StorageEngine::hasBinaryKeys() const
+{
+    return pimpl_->hasBinaryKeys();
+}
+
 const size_t
 StorageEngine::getPayloadSize() const
 {
@@ -219,6 +431,32 @@ bool StorageEngineImpl::open(bool readOnly)
     if (!status.ok())
         throw std::runtime_error(status.getState());
 
+    // new DBs are created with binary keys, existing ones keep their format
+    std::string format;
+    if (db_->Get(db_namespace::ReadOptions(), StorageKey::FormatKey, &format).ok())
+    {
+        if (format != StorageKey::FormatVersion)
+            throw std::runtime_error("unsupported key format " + format);
+        binaryKeys_ = true;
+    }
+    else
+    {
+        db_namespace::Iterator *it = db_->NewIterator(db_namespace::ReadOptions());
+        it->SeekToFirst();
+        binaryKeys_ = !it->Valid();
+        delete it;
+
+        if (binaryKeys_ && !readOnly)
+            status = db_->Put(db_namespace::WriteOptions(), StorageKey::FormatKey, StorageKey::FormatVersion);
+    }
+
+    readOnly_ = readOnly;
+    if (binaryKeys_ && !loadIndex() && !readOnly_)
+        buildKeyTrie();
+    // index will be stale if process terminates before close()
+    if (binaryKeys_ && !readOnly_)
+        saveIndex(false);
+
     return status.ok();
 #else
     return false;
@@ -230,6 +468,9 @@ void StorageEngineImpl::close()
 #if HAVE_PERSISTENT_STORAGE
     if (db_)
     {
+        flush();
+        if (binaryKeys_ && !readOnly_ && indexLoaded_)
+            saveIndex(true);
         // db_->SyncWAL();
         // db_->Close();
         delete db_;
@@ -238,43 +479,216 @@ void StorageEngineImpl::close()
 #endif
 }
 
+void StorageEngineImpl::setWriteSettings(const StorageEngine::WriteSettings &settings)
+{
+#if HAVE_PERSISTENT_STORAGE
+    // commit whatever was accumulated under previous settings
+    flush();
+
+    lock_guard<mutex> scopedLock(batchMutex_);
+    writeSettings_ = settings;
+    writeOptions_ = db_namespace::WriteOptions();
+    writeOptions_.sync = settings.sync_;
+#ifndef __ANDROID__
+    writeOptions_.disableWAL = settings.disableWal_;
+#endif
+#else
+    writeSettings_ = settings;
+#endif
+}
+
 bool StorageEngineImpl::put(const Data &data)
 {
 #if HAVE_PERSISTENT_STORAGE
     if (!db_)
         throw std::runtime_error("DB is not open");
 
+    if (writeSettings_.batch_)
+    {
+        lock_guard<mutex> scopedLock(batchMutex_);
+        addToBatch(data);
+        if (isBatchDue())
+            return writeBatch();
+        return true;
+    }
+
+    std::string k = key(data.getName());
+    int64_t storedSize = (binaryKeys_ && indexLoaded_ ? getStoredSize(k) : -1);
     db_namespace::Status s =
-        db_->Put(db_namespace::WriteOptions(),
-                 data.getName().toUri(),
+        db_->Put(writeOptions_, k,
                  db_namespace::Slice((const char *)data.wireEncode().buf(),
                                      data.wireEncode().size()));
+    if (s.ok())
+        updateIndex(k, data.wireEncode().size(), storedSize);
+    // invalidated after the write: the old record cached by a read that
+    // started earlier is either erased here or rejected by DataCache::put
+    shared_ptr<DataCache> cache = cache_;
+    if (cache)
+        cache->erase(k);
     return s.ok();
 #else
     return false;
 #endif
 }
 
+bool StorageEngineImpl::put(const std::vector<shared_ptr<const Data>> &segments)
+{
+#if HAVE_PERSISTENT_STORAGE
+    if (!db_)
+        throw std::runtime_error("DB is not open");
+
+    lock_guard<mutex> scopedLock(batchMutex_);
+    for (auto &d : segments)
+        addToBatch(*d);
+
+    // without batch mode, a frame is still written with one call
+    if (!writeSettings_.batch_ || writeSettings_.flushOnFrame_ || isBatchDue())
+        return writeBatch();
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool StorageEngineImpl::flush()
+{
+#if HAVE_PERSISTENT_STORAGE
+    if (!db_)
+        return false;
+
+    lock_guard<mutex> scopedLock(batchMutex_);
+    return writeBatch();
+#else
+    return false;
+#endif
+}
+
+#if HAVE_PERSISTENT_STORAGE
+void StorageEngineImpl::addToBatch(const Data &data)
+{
+    if (batchKeys_.empty())
+        batchStartMs_ = clock::millisecondTimestamp();
+
+    std::string k = key(data.getName());
+    batch_.Put(k, db_namespace::Slice((const char *)data.wireEncode().buf(),
+                                      data.wireEncode().size()));
+    batchKeys_.push_back(std::make_pair(k, data.wireEncode().size()));
+}
+
+bool StorageEngineImpl::isBatchDue() const
+{
+    return (writeSettings_.batchSize_ && batchKeys_.size() >= writeSettings_.batchSize_) ||
+           (writeSettings_.batchBudgetMs_ &&
+            clock::millisecondTimestamp() - batchStartMs_ >= writeSettings_.batchBudgetMs_);
+}
+
+bool StorageEngineImpl::writeBatch()
+{
+    if (batchKeys_.empty())
+        return true;
+
+    // sizes of values overwritten by the batch, including records written
+    // earlier in the same batch, so that index stats count each key once
+    std::vector<int64_t> storedSizes;
+    if (binaryKeys_ && indexLoaded_)
+    {
+        std::map<std::string, size_t> batched;
+        storedSizes.reserve(batchKeys_.size());
+        for (auto &k : batchKeys_)
+        {
+            auto it = batched.find(k.first);
+            storedSizes.push_back(it != batched.end() ? (int64_t)it->second : getStoredSize(k.first));
+            batched[k.first] = k.second;
+        }
+    }
+
+    db_namespace::Status s = db_->Write(writeOptions_, &batch_);
+    // index and cache change only once records are visible to readers
+    shared_ptr<DataCache> cache = cache_;
+    for (size_t i = 0; i < batchKeys_.size(); ++i)
+    {
+        const std::string &k = batchKeys_[i].first;
+        if (s.ok())
+            updateIndex(k, batchKeys_[i].second, storedSizes.empty() ? -1 : storedSizes[i]);
+        if (cache)
+            cache->erase(k);
+    }
+    batch_.Clear();
+    batchKeys_.clear();
+
+    return s.ok();
+}
+#endif
+
 shared_ptr<Data> StorageEngineImpl::get(const Name &dataName)
+{
+    return getByKey(key(dataName));
+}
+
+shared_ptr<Data> StorageEngineImpl::getByKey(const std::string &key)
 {
 #if HAVE_PERSISTENT_STORAGE
     if (!db_)
         throw std::runtime_error("DB is not open");
 
-    static std::string dataString;
+    shared_ptr<Data> data = getCached(key);
+    if (data)
+        return data;
+
+    uint64_t cacheVersion = getCacheVersion();
+
+#ifndef __ANDROID__
+    // value stays pinned in the block cache, no intermediate copy is made
+    db_namespace::PinnableSlice value;
     db_namespace::Status s = db_->Get(db_namespace::ReadOptions(),
-                                      dataName.toUri(),
-                                      &dataString);
+                                      db_->DefaultColumnFamily(),
+                                      key, &value);
+#else
+    static thread_local std::string value;
+    db_namespace::Status s = db_->Get(db_namespace::ReadOptions(), key, &value);
+#endif
     if (s.ok())
+        return decodeAndCache(key, value.data(), value.size(), cacheVersion);
+#endif
+    return shared_ptr<Data>(nullptr);
+}
+
+#if HAVE_PERSISTENT_STORAGE
+// cached packets are copied (content and name components are shared), so
+// that callers can not modify cached ones
+shared_ptr<Data> StorageEngineImpl::getCached(const std::string &key) const
+{
+    shared_ptr<DataCache> cache = cache_;
+    if (cache)
     {
-        shared_ptr<Data> data = make_shared<Data>();
-        data->wireDecode((const uint8_t *)dataString.data(), dataString.size());
+        shared_ptr<const Data> d = cache->get(key);
+        if (d)
+            return make_shared<Data>(*d);
+    }
+    return shared_ptr<Data>();
+}
 
-        return data;
+// must be taken before reading the DB, see DataCache
+uint64_t StorageEngineImpl::getCacheVersion() const
+{
+    shared_ptr<DataCache> cache = cache_;
+    return cache ? cache->getVersion() : 0;
+}
+
+shared_ptr<Data> StorageEngineImpl::decodeAndCache(const std::string &key, const char *value, size_t size,
+                                                   uint64_t cacheVersion)
+{
+    shared_ptr<Data> data = decodeData(value, size);
+    shared_ptr<DataCache> cache = cache_;
+
+    if (cache)
+    {
+        cache->put(key, data, cacheVersion);
+        return make_shared<Data>(*data);
     }
-#endif
-    return shared_ptr<Data>(nullptr);
+    return data;
 }
+#endif
 
 shared_ptr<Data> StorageEngineImpl::read(const Interest &interest)
 {
@@ -284,39 +698,42 @@ shared_ptr<Data> StorageEngineImpl::read(const Interest &interest)
 
     if (canBePrefix)
     {
-        // extract by prefix match
-        Name prefix = interest.getName(), keyName;
+        // extract by prefix match: leftmost child is the first key under the
+        // prefix, rightmost (default) is found by seeking to the prefix upper
+        // bound and stepping back, so neither scans all keys under the prefix
+        std::string prefixKey = key(interest.getName());
+        size_t prefixSize = interest.getName().size();
+        bool leftmost = (interest.getChildSelector() == 0);
+        uint64_t cacheVersion = getCacheVersion();
         auto it = db_->NewIterator(db_namespace::ReadOptions());
-        std::string key = "";
-        bool checkMaxSuffixComponents = interest.getMaxSuffixComponents() != -1;
-        bool checkMinSuffixComponents = interest.getMinSuffixComponents() != -1;
 
-        for (it->Seek(prefix.toUri());
-             it->Valid() && it->key().starts_with(prefix.toUri());
-             it->Next())
+        if (leftmost)
+            it->Seek(prefixKey);
+        else
         {
-            if (checkMaxSuffixComponents || checkMinSuffixComponents)
-            {
-                keyName = Name(it->key().ToString());
-                int nSuffixComponents = keyName.size() - prefix.size();
-                bool passCheck = false;
-
-                if (checkMaxSuffixComponents && 
-                    nSuffixComponents <= interest.getMaxSuffixComponents())
-                    passCheck = true;
-                if (checkMinSuffixComponents &&
-                    nSuffixComponents >= interest.getMinSuffixComponents())
-                    passCheck = true;
-                
-                if (passCheck)
-                    key = it->key().ToString();
-            }
+            // keys never contain 0xFF right after a complete prefix key:
+            // binary components start with class byte, URIs are escaped
+            it->Seek(prefixKey + '\xFF');
+            if (it->Valid())
+                it->Prev();
             else
-                key = it->key().ToString();
+                it->SeekToLast();
         }
 
-        if (key != "")
-            data = get(Name(key));
+        for (; it->Valid() && it->key().starts_with(prefixKey);
+             leftmost ? it->Next() : it->Prev())
+        {
+            if (binaryKeys_ && StorageKey::isReserved(it->key().data(), it->key().size()))
+                continue;
+
+            if (matchesSuffixComponents(it->key(), prefixSize, interest))
+            {
+                std::string k = it->key().ToString();
+                if (!(data = getCached(k)))
+                    data = decodeAndCache(k, it->value().data(), it->value().size(), cacheVersion);
+                break;
+            }
+        }
 
         delete it;
     }
@@ -326,38 +743,310 @@ shared_ptr<Data> StorageEngineImpl::read(const Interest &interest)
     return data;
 }
 
+#if HAVE_PERSISTENT_STORAGE
+bool StorageEngineImpl::matchesSuffixComponents(const db_namespace::Slice &key, size_t prefixSize,
+                                                const Interest &interest) const
+{
+    int minSuffixComponents = interest.getMinSuffixComponents();
+    int maxSuffixComponents = interest.getMaxSuffixComponents();
+
+    if (minSuffixComponents == -1 && maxSuffixComponents == -1)
+        return true;
+
+    int nSuffixComponents = keyComponentsNum(key) - prefixSize;
+    return (minSuffixComponents == -1 || nSuffixComponents >= minSuffixComponents) &&
+           (maxSuffixComponents == -1 || nSuffixComponents <= maxSuffixComponents);
+}
+#endif
+
 void StorageEngineImpl::getLongestPrefixes(asio::io_service &io,
                                            function<void(const std::vector<Name> &)> onCompletion)
 {
-    // if (!keysTrieBuilt_)
-    //     onCompletion(keysTrie_.getLongestPrefixes());
-    // else
-    // {
     shared_ptr<StorageEngineImpl> me = shared_from_this();
     io.dispatch([me, this, onCompletion]() {
-        buildKeyTrie();
-        keysTrieBuilt_ = true;
-        onCompletion(keysTrie_.getLongestPrefixes());
+        if (!indexLoaded_)
+        {
+            onCompletion(buildKeyTrie());
+            return;
+        }
+
+        std::vector<Name> longestPrefixes;
+        {
+            lock_guard<mutex> scopedLock(indexMutex_);
+            for (auto &p : prefixes_)
+                longestPrefixes.push_back(StorageKey::toName(p.second.data(), p.second.size()));
+        }
+        onCompletion(longestPrefixes);
     });
-    // }
 }
 
-void StorageEngineImpl::buildKeyTrie()
+void StorageEngineImpl::setCacheSize(size_t capacityBytes, unsigned int nShards)
+{
+    if (capacityBytes)
+        cache_ = make_shared<DataCache>(capacityBytes, nShards);
+    else
+        cache_.reset();
+}
+
+void StorageEngineImpl::scanNames(function<bool(const Name &)> onName)
+{
+#if HAVE_PERSISTENT_STORAGE
+    if (!db_)
+        throw std::runtime_error("DB is not open");
+
+    db_namespace::Iterator *it = db_->NewIterator(db_namespace::ReadOptions());
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        db_namespace::Slice k = it->key();
+        if (binaryKeys_ && StorageKey::isReserved(k.data(), k.size()))
+            continue;
+
+        Name n = (binaryKeys_ ? StorageKey::toName(k.data(), k.size()) : Name(k.ToString()));
+        if (!onName(n))
+            break;
+    }
+    delete it;
+#endif
+}
+
+std::vector<Name> StorageEngineImpl::buildKeyTrie()
 {
-    stats_.nKeys_ = 0;
-    stats_.valueSizeBytes_ = 0;
+    std::vector<Name> longestPrefixes;
 #if HAVE_PERSISTENT_STORAGE
+    NameTrie keysTrie;
+    Stats stats;
+    stats.nKeys_ = 0;
+    stats.valueSizeBytes_ = 0;
 
-    db_namespace::Iterator *it = db_->NewIterator(rocksdb::ReadOptions());
+    db_namespace::Iterator *it = db_->NewIterator(db_namespace::ReadOptions());
 
+    std::vector<std::string> uriComponents;
+    std::vector<NameTrie::Label> components;
     for (it->SeekToFirst(); it->Valid(); it->Next())
     {
-        keysTrie_.insert(it->key().ToString());
-        stats_.nKeys_++;
-        stats_.valueSizeBytes_ += it->value().size();
+        db_namespace::Slice k = it->key();
+        components.clear();
+
+        if (binaryKeys_)
+        {
+            if (StorageKey::isReserved(k.data(), k.size()))
+                continue;
+
+            for (size_t pos = 0, next; pos < k.size(); pos = next)
+            {
+                next = StorageKey::nextComponent(k.data(), k.size(), pos);
+                components.push_back(NameTrie::Label(k.data()+pos, next-pos));
+            }
+        }
+        else
+        {
+            split(uriComponents, k.ToString(), boost::is_any_of("/"));
+            for (auto &c : uriComponents)
+                components.push_back(NameTrie::Label(c.data(), c.size()));
+        }
+
+        keysTrie.insert(components);
+        stats.nKeys_++;
+        stats.valueSizeBytes_ += it->value().size();
     }
     assert(it->status().ok()); // Check for any errors found during the scan
 
     delete it;
+
+    if (binaryKeys_)
+        longestPrefixes = keysTrie.getLongestPrefixes([](const char *c, size_t len) {
+            return StorageKey::toComponent(c, len);
+        });
+    else
+        longestPrefixes = keysTrie.getLongestPrefixes([](const char *c, size_t len) {
+            return Name::Component(Name::fromEscapedString(std::string(c, len)));
+        });
+
+    lock_guard<mutex> scopedLock(indexMutex_);
+    stats_ = stats;
+    if (binaryKeys_)
+    {
+        prefixes_.clear();
+        for (auto &n : longestPrefixes)
+        {
+            std::string k = StorageKey::fromName(n);
+            prefixes_[k.substr(0, StorageKey::nextComponent(k.data(), k.size(), 0))] = k;
+        }
+        indexLoaded_ = true;
+    }
+#endif
+    return longestPrefixes;
+}
+
+#if HAVE_PERSISTENT_STORAGE
+bool StorageEngineImpl::isEmpty() const
+{
+    // reserved keys sort first and are not data
+    db_namespace::Iterator *it = db_->NewIterator(db_namespace::ReadOptions());
+    for (it->SeekToFirst();
+         it->Valid() && binaryKeys_ && StorageKey::isReserved(it->key().data(), it->key().size());
+         it->Next());
+
+    bool empty = !it->Valid();
+    delete it;
+
+    return empty;
+}
+
+bool StorageEngineImpl::loadIndex()
+{
+    std::string state;
+    if (!db_->Get(db_namespace::ReadOptions(), StorageKey::IndexStateKey, &state).ok())
+        return false;
+
+    std::istringstream ss(state);
+    std::string clean;
+    Stats stats;
+    if (!(ss >> clean >> stats.nKeys_ >> stats.valueSizeBytes_) || clean != IndexClean)
+        return false;
+
+    lock_guard<mutex> scopedLock(indexMutex_);
+    db_namespace::Iterator *it = db_->NewIterator(db_namespace::ReadOptions());
+
+    prefixes_.clear();
+    for (it->Seek(StorageKey::IndexPrefixKey);
+         it->Valid() && it->key().starts_with(StorageKey::IndexPrefixKey); it->Next())
+        prefixes_[it->key().ToString().substr(StorageKey::IndexPrefixKey.size())] = it->value().ToString();
+
+    indexLoaded_ = it->status().ok();
+    delete it;
+
+    if (indexLoaded_)
+        stats_ = stats;
+    return indexLoaded_;
+}
+
+bool StorageEngineImpl::saveIndex(bool clean)
+{
+    db_namespace::WriteBatch batch;
+    db_namespace::WriteOptions options;
+    options.sync = true;
+
+    lock_guard<mutex> scopedLock(indexMutex_);
+    if (clean)
+    {
+        for (auto &p : prefixes_)
+            batch.Put(StorageKey::IndexPrefixKey + p.first, p.second);
+        batch.Put(StorageKey::IndexStateKey, IndexClean + " " + std::to_string(stats_.nKeys_) +
+                                     " " + std::to_string(stats_.valueSizeBytes_));
+    }
+    else
+        batch.Put(StorageKey::IndexStateKey, "dirty");
+
+    return db_->Write(options, &batch).ok();
+}
+
+// size of the value stored under the key or -1 if there is none
+int64_t StorageEngineImpl::getStoredSize(const std::string &key) const
+{
+#ifndef __ANDROID__
+    // bloom filters answer for most new keys without reading the value
+    std::string unused;
+    if (!db_->KeyMayExist(db_namespace::ReadOptions(), key, &unused))
+        return -1;
+
+    db_namespace::PinnableSlice value;
+    db_namespace::Status s = db_->Get(db_namespace::ReadOptions(),
+                                      db_->DefaultColumnFamily(),
+                                      key, &value);
+#else
+    std::string value;
+    db_namespace::Status s = db_->Get(db_namespace::ReadOptions(), key, &value);
 #endif
-}
\ No newline at end of file
+    return s.ok() ? (int64_t)value.size() : -1;
+}
+
+// storedSize is the size of the value that was overwritten, -1 for new keys
+void StorageEngineImpl::updateIndex(const std::string &key, size_t valueSize, int64_t storedSize)
+{
+    if (!binaryKeys_ || !indexLoaded_)
+        return;
+
+    lock_guard<mutex> scopedLock(indexMutex_);
+    stats_.valueSizeBytes_ += valueSize;
+    if (storedSize >= 0)
+    {
+        // existing key is already covered by the index
+        stats_.valueSizeBytes_ -= storedSize;
+        return;
+    }
+    stats_.nKeys_++;
+
+    std::string first = key.substr(0, StorageKey::nextComponent(key.data(), key.size(), 0));
+    auto it = prefixes_.find(first);
+
+    if (it == prefixes_.end())
+        prefixes_[first] = key;
+    else
+    {
+        // longest common prefix, up to the last complete component
+        std::string &prefix = it->second;
+        size_t common = 0;
+        for (size_t pos = 0, next; pos < prefix.size(); pos = next)
+        {
+            next = StorageKey::nextComponent(prefix.data(), prefix.size(), pos);
+            if (next > key.size() || prefix.compare(pos, next-pos, key, pos, next-pos) != 0)
+                break;
+            common = next;
+        }
+        prefix.resize(common);
+    }
+}
+#endif
+
+size_t StorageEngineImpl::migrate(const std::string &legacyDbPath, const std::string &dbPath,
+                                  function<void(size_t)> onProgress)
+{
+    size_t nKeys = 0;
+#if HAVE_PERSISTENT_STORAGE
+    shared_ptr<StorageEngineImpl> src = make_shared<StorageEngineImpl>(legacyDbPath);
+    shared_ptr<StorageEngineImpl> dst = make_shared<StorageEngineImpl>(dbPath);
+
+    src->open(true);
+    if (src->binaryKeys_)
+        throw std::runtime_error(legacyDbPath + " already uses binary keys");
+
+    dst->open(false);
+    if (!dst->binaryKeys_ || !dst->isEmpty())
+        throw std::runtime_error(dbPath + " is not empty");
+
+    static const size_t BatchSize = 1000;
+    bool ok = true;
+    db_namespace::WriteBatch batch;
+    db_namespace::Iterator *it = src->db_->NewIterator(db_namespace::ReadOptions());
+
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        batch.Put(StorageKey::fromName(Name(it->key().ToString())), it->value());
+
+        if (++nKeys % BatchSize == 0)
+        {
+            if (!(ok = dst->db_->Write(db_namespace::WriteOptions(), &batch).ok()))
+                break;
+            batch.Clear();
+
+            if (onProgress)
+                onProgress(nKeys);
+        }
+    }
+
+    ok = ok && it->status().ok() &&
+         dst->db_->Write(db_namespace::WriteOptions(), &batch).ok();
+    delete it;
+
+    if (!ok)
+        throw std::runtime_error("failed to migrate " + legacyDbPath);
+
+    // records were written bypassing the index
+    dst->buildKeyTrie();
+
+    if (onProgress)
+        onProgress(nKeys);
+#endif
+    return nKeys;
+}
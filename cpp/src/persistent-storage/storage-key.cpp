@@ -0,0 +1,186 @@
+//
+// storage-key.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include "storage-key.hpp"
+
+#include <vector>
+
+using namespace ndnrtc;
+using namespace ndn;
+
+namespace {
+    const char GenericClass = 0x01;
+    const char NumericClass = 0x02;
+    const char Escape = 0x00;
+    const char EscapedZero = (char)0xFF;
+    const char Terminator = 0x01;
+
+    bool isMarker(uint8_t b)
+    {
+        // segment, segment offset, timestamp, version, sequence number
+        return b == 0x00 || b == 0xFB || b == 0xFC || b == 0xFD || b == 0xFE;
+    }
+
+    size_t nonNegativeIntegerWidth(uint64_t n)
+    {
+        if (n <= 0xFF) return 1;
+        if (n <= 0xFFFF) return 2;
+        if (n <= 0xFFFFFFFFull) return 4;
+        return 8;
+    }
+
+    // returns true if component is a marker followed by canonically encoded
+    // number, i.e. it can be restored exactly from (marker, number)
+    bool toNumber(const uint8_t *value, size_t size, uint8_t &marker, uint64_t &n)
+    {
+        if (size != 2 && size != 3 && size != 5 && size != 9)
+            return false;
+        if (!isMarker(value[0]))
+            return false;
+
+        n = 0;
+        for (size_t i = 1; i < size; ++i)
+            n = (n << 8) | value[i];
+        marker = value[0];
+
+        return nonNegativeIntegerWidth(n) == size-1;
+    }
+
+    void appendEscaped(std::string &key, const uint8_t *value, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            key.push_back((char)value[i]);
+            if (value[i] == 0)
+                key.push_back(EscapedZero);
+        }
+    }
+}
+
+const std::string StorageKey::FormatKey = std::string("\x00\x00", 2) + "format";
+const std::string StorageKey::FormatVersion = "binary-name-keys-1";
+const std::string StorageKey::IndexStateKey = std::string("\x00\x00", 2) + "index";
+const std::string StorageKey::IndexPrefixKey = std::string("\x00\x01", 2);
+
+std::string
+StorageKey::fromName(const Name &name)
+{
+    std::string key;
+    key.reserve(name.size()*12);
+
+    for (size_t i = 0; i < name.size(); ++i)
+        appendComponent(key, name[i]);
+
+    return key;
+}
+
+void
+StorageKey::appendComponent(std::string &key, const Name::Component &c)
+{
+    const uint8_t *value = c.getValue().buf();
+    size_t size = c.getValue().size();
+    uint8_t marker;
+    uint64_t n;
+
+    if (toNumber(value, size, marker, n))
+    {
+        uint8_t fixed[9];
+        fixed[0] = marker;
+        for (int i = 8; i > 0; --i, n >>= 8)
+            fixed[i] = (uint8_t)(n & 0xFF);
+
+        key.push_back(NumericClass);
+        appendEscaped(key, fixed, sizeof(fixed));
+    }
+    else
+    {
+        key.push_back(GenericClass);
+        appendEscaped(key, value, size);
+    }
+
+    key.push_back(Escape);
+    key.push_back(Terminator);
+}
+
+Name
+StorageKey::toName(const char *key, size_t keyLength)
+{
+    Name name;
+    size_t pos = 0;
+
+    while (pos < keyLength)
+    {
+        size_t next = nextComponent(key, keyLength, pos);
+        name.append(toComponent(key+pos, next-pos));
+        pos = next;
+    }
+
+    return name;
+}
+
+Name::Component
+StorageKey::toComponent(const char *encoded, size_t length)
+{
+    std::vector<uint8_t> value;
+    value.reserve(length);
+
+    // skip class byte, stop at terminator
+    for (size_t i = 1; i < length; ++i)
+    {
+        if (encoded[i] == Escape)
+        {
+            if (i+1 < length && encoded[i+1] == EscapedZero)
+            {
+                value.push_back(0);
+                ++i;
+                continue;
+            }
+            break;
+        }
+        value.push_back((uint8_t)encoded[i]);
+    }
+
+    if (length && encoded[0] == NumericClass && value.size() == 9)
+    {
+        uint64_t n = 0;
+        for (size_t i = 1; i < 9; ++i)
+            n = (n << 8) | value[i];
+
+        size_t width = nonNegativeIntegerWidth(n);
+        std::vector<uint8_t> canonical(width+1);
+        canonical[0] = value[0];
+        for (size_t i = width; i > 0; --i, n >>= 8)
+            canonical[i] = (uint8_t)(n & 0xFF);
+
+        return Name::Component(canonical);
+    }
+
+    return Name::Component(value);
+}
+
+size_t
+StorageKey::nextComponent(const char *key, size_t keyLength, size_t pos)
+{
+    for (size_t i = pos+1; i+1 < keyLength; ++i)
+        if (key[i] == Escape)
+        {
+            if (key[i+1] == Terminator)
+                return i+2;
+            ++i; // escaped zero
+        }
+
+    return keyLength;
+}
+
+size_t
+StorageKey::countComponents(const char *key, size_t keyLength)
+{
+    size_t n = 0;
+    for (size_t pos = 0; pos < keyLength; pos = nextComponent(key, keyLength, pos))
+        n++;
+    return n;
+}
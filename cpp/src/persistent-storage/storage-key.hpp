@@ -0,0 +1,71 @@
+//
+// storage-key.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __storage_key_hpp__
+#define __storage_key_hpp__
+
+#include <string>
+#include <ndn-cpp/name.hpp>
+
+namespace ndnrtc {
+
+    /**
+     * Binary encoding of data names used as persistent storage keys.
+     * Unlike name URIs, keys are ordered component-wise: key of a name is a
+     * byte prefix of keys of all names under it and shorter components sort
+     * before longer ones with the same prefix. Numeric components (segment,
+     * segment offset, timestamp, version and sequence number markers) are
+     * stored with fixed-width big-endian values, so frames and segments sort
+     * numerically.
+     *
+     * Each component is encoded as:
+     *  - class byte: 0x01 for generic components, 0x02 for numeric ones;
+     *  - component value (numeric: marker + 8 bytes value) where 0x00 bytes
+     *    are escaped as 0x00 0xFF;
+     *  - terminator 0x00 0x01.
+     */
+    class StorageKey {
+    public:
+        /**
+         * Reserved key that marks DBs using binary keys. Sorts before any
+         * data key.
+         */
+        static const std::string FormatKey;
+        static const std::string FormatVersion;
+        /**
+         * Reserved keys of the persisted key index of StorageEngine: index
+         * state (stats, clean/dirty flag) and prefix of per-prefix records.
+         */
+        static const std::string IndexStateKey;
+        static const std::string IndexPrefixKey;
+
+        /**
+         * Keys starting with 0x00 are reserved for storage metadata; data
+         * keys always start with a class byte.
+         */
+        static bool isReserved(const char* key, size_t keyLength)
+        { return keyLength && key[0] == 0x00; }
+
+        static std::string fromName(const ndn::Name& name);
+        static void appendComponent(std::string& key, const ndn::Name::Component& c);
+
+        static ndn::Name toName(const char* key, size_t keyLength);
+        /**
+         * Decodes one encoded component (including terminator).
+         */
+        static ndn::Name::Component toComponent(const char* encoded, size_t length);
+
+        /**
+         * Returns position right after the component that starts at pos
+         * or keyLength if key is malformed.
+         */
+        static size_t nextComponent(const char* key, size_t keyLength, size_t pos);
+        static size_t countComponents(const char* key, size_t keyLength);
+    };
+}
+
+#endif
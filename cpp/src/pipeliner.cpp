@@ -206,7 +206,7 @@ void Pipeliner::onNewData(const BufferReceipt& receipt)
 {
     // check for missing segments
     std::vector<boost::shared_ptr<const Interest>> interests;
-    for (auto& n:receipt.slot_->getMissingSegments())
+    for (auto& n:receipt.missingSegments_)
     {
         boost::shared_ptr<Interest> i = boost::make_shared<Interest>(n, interestLifetime_);
         i->setMustBeFresh(false);
@@ -216,10 +216,10 @@ void Pipeliner::onNewData(const BufferReceipt& receipt)
     if (interests.size())
     {
         LogTraceC << interests.size() << " missing segments for "
-            << receipt.slot_->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+            << receipt.segment_->getInfo().getSuffix(suffix_filter::Thread) << std::endl;
         express(interests, true);
         (*sstorage_)[Indicator::DoubleRtFrames]++;
-        if (!receipt.slot_->getNameInfo().isDelta_)
+        if (!receipt.segment_->getInfo().isDelta_)
             (*sstorage_)[Indicator::DoubleRtFramesKey]++;
     }
 }
@@ -0,0 +1,88 @@
+//
+// publish-stage.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <boost/bind.hpp>
+
+#include "publish-stage.hpp"
+
+using namespace ndnrtc;
+
+PublishStage::PublishStage(const std::string &name)
+    : stopped_(false)
+{
+    description_ = "stage-" + name;
+    worker_ = boost::thread(boost::bind(&PublishStage::work, this));
+}
+
+PublishStage::~PublishStage()
+{
+    stop();
+}
+
+bool PublishStage::push(Job job)
+{
+    boost::lock_guard<boost::mutex> scopedLock(queueMutex_);
+
+    if (stopped_)
+        return false;
+
+    queue_.push_back(job);
+    queueCv_.notify_one();
+    return true;
+}
+
+void PublishStage::stop()
+{
+    std::deque<Job> dropped;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(queueMutex_);
+        if (stopped_)
+            return;
+
+        stopped_ = true;
+        dropped.swap(queue_);
+        queueCv_.notify_one();
+    }
+
+    if (worker_.joinable())
+        worker_.join();
+
+    if (dropped.size())
+        LogDebugC << "discarded " << dropped.size() << " queued jobs" << std::endl;
+    // jobs' captures are released here, outside of the queue lock
+}
+
+size_t PublishStage::getQueueSize() const
+{
+    boost::lock_guard<boost::mutex> scopedLock(queueMutex_);
+    return queue_.size();
+}
+
+void PublishStage::work()
+{
+    while (true)
+    {
+        boost::unique_lock<boost::mutex> lock(queueMutex_);
+        queueCv_.wait(lock, [this]() { return stopped_ || queue_.size(); });
+
+        if (stopped_)
+            break;
+
+        Job job(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        try
+        {
+            job();
+        }
+        catch (std::exception &e)
+        {
+            LogErrorC << "publishing job failed: " << e.what() << std::endl;
+        }
+    }
+}
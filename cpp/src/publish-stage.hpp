@@ -0,0 +1,62 @@
+//
+// publish-stage.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __publish_stage_h__
+#define __publish_stage_h__
+
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "ndnrtc-object.hpp"
+
+namespace ndnrtc
+{
+
+/**
+ * Worker thread of one stage of the frame publishing pipeline. Jobs are
+ * run one at a time, in the order they were pushed, so consecutive frames
+ * leave the stage in capture order while the next stage works on the
+ * previous ones. The queue is not bounded by the stage itself: pipeline
+ * owner limits the number of frames in flight across all stages.
+ */
+class PublishStage : public NdnRtcComponent
+{
+  public:
+    typedef boost::function<void(void)> Job;
+
+    PublishStage(const std::string &name);
+    ~PublishStage();
+
+    /**
+     * Queues job for the stage's thread. Never blocks.
+     * @return false if stage has been stopped and job was discarded
+     */
+    bool push(Job job);
+
+    /**
+     * Discards queued jobs and joins stage's thread. Job that is running
+     * is let to complete. Must not be called from the stage's thread.
+     */
+    void stop();
+
+    size_t getQueueSize() const;
+
+  private:
+    PublishStage(const PublishStage &) = delete;
+
+    mutable boost::mutex queueMutex_;
+    boost::condition_variable queueCv_;
+    std::deque<Job> queue_;
+    bool stopped_;
+    boost::thread worker_;
+
+    void work();
+};
+}
+
+#endif
@@ -26,6 +26,9 @@ using namespace ndnrtc;
 using namespace ndn;
 using namespace boost;
 
+// number of threads checking segments' digests against frame manifests
+static const unsigned int MANIFEST_DIGEST_THREADS = 1;
+
 class BufferObserver : public IBufferObserver {
     public:
     BufferObserver(boost::shared_ptr<IPipeliner> pipeliner,
@@ -41,7 +44,7 @@ class BufferObserver : public IBufferObserver {
         {
             interestControl_->decrement();
 
-            if (receipt.slot_->getNameInfo().class_ == SampleClass::Key)
+            if (receipt.segment_->getInfo().class_ == SampleClass::Key)
                 pipeliner_->setNeedSample(SampleClass::Key);
         }
     }
@@ -127,7 +130,8 @@ void RemoteVideoStreamImpl::construct()
     latencyControl_->setPlayoutControl(playoutControl_);
     drdEstimator_->attach(playoutControl_.get());
 
-    validator_ = boost::make_shared<ManifestValidator>(face_, keyChain_, sstorage_);
+    validator_ = boost::make_shared<ManifestValidator>(io_, face_, keyChain_, sstorage_,
+                                                       MANIFEST_DIGEST_THREADS);
     buffer_->attach(validator_.get());
 }
 
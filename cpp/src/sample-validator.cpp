@@ -6,10 +6,13 @@
 //
 
 #include "sample-validator.hpp"
+#include <ndn-cpp/c/common.h>
 #include <ndn-cpp/data.hpp>
 #include <ndn-cpp/name.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
 
+#include "clock.hpp"
 #include "frame-data.hpp"
 #include "name-components.hpp"
 #include "meta-fetcher.hpp"
@@ -19,6 +22,7 @@ static const unsigned int META_FETCHER_POOL_SIZE = 100;
 using namespace ndnrtc;
 using namespace ndn;
 using namespace ndnrtc::statistics;
+using namespace estimators;
 
 void SampleValidator::onNewRequest(const boost::shared_ptr<BufferSlot> &slot)
 {
@@ -30,11 +34,14 @@ void SampleValidator::onNewData(const BufferReceipt &receipt)
     boost::shared_ptr<SampleValidator> me = boost::dynamic_pointer_cast<SampleValidator>(shared_from_this());
     boost::shared_ptr<int> nVerifiedSegments(boost::make_shared<int>(0));
     boost::shared_ptr<const BufferSlot> slot = receipt.slot_;
+    // slot may be reused for another sample by the time data is verified
+    uint64_t generation = receipt.generation_;
     keyChain_->verifyData(receipt.segment_->getData()->getData(),
-                          [me, this, slot, nVerifiedSegments](const boost::shared_ptr<ndn::Data> &data) {
+                          [me, this, slot, generation, nVerifiedSegments](const boost::shared_ptr<ndn::Data> &data) {
                               // success
                               (*nVerifiedSegments)++;
-                              if (slot->getState() >= BufferSlot::State::Ready &&
+                              if (slot->getGeneration() == generation &&
+                                  slot->getState() >= BufferSlot::State::Ready &&
                                   *nVerifiedSegments == slot->getFetchedNum() &&
                                   slot->verified_ == BufferSlot::Verification::Unknown)
                                   slot->verified_ = BufferSlot::Verification::Verified;
@@ -42,9 +49,10 @@ void SampleValidator::onNewData(const BufferReceipt &receipt)
                               LogDebugC << "sample verified " << slot->dump() << std::endl;
                               (*statStorage_)[Indicator::VerifySuccess]++;
                           },
-                          (const OnDataValidationFailed)([me, this, slot](const boost::shared_ptr<ndn::Data> &data, const std::string &reason) {
+                          (const OnDataValidationFailed)([me, this, slot, generation](const boost::shared_ptr<ndn::Data> &data, const std::string &reason) {
                               // failure
-                              if (slot->getState() >= BufferSlot::State::Assembling)
+                              if (slot->getGeneration() == generation &&
+                                  slot->getState() >= BufferSlot::State::Assembling)
                                   slot->verified_ = BufferSlot::Verification::Failed;
 
                               LogDebugC << "sample verification failure "
@@ -56,12 +64,42 @@ void SampleValidator::onNewData(const BufferReceipt &receipt)
 ManifestValidator::ManifestValidator(boost::shared_ptr<ndn::Face> face,
                                      boost::shared_ptr<ndn::KeyChain> keyChain,
                                      const boost::shared_ptr<StatisticsStorage> &statStorage) 
-    : StatObject(statStorage), face_(face), keyChain_(keyChain),
-    metaFetcherPool_(META_FETCHER_POOL_SIZE)
+    : StatObject(statStorage), faceIo_(nullptr), face_(face), keyChain_(keyChain),
+    metaFetcherPool_(META_FETCHER_POOL_SIZE),
+    verifyLatency_(Average(boost::make_shared<SampleWindow>(30)))
 {
     description_ = "sample-validator";
 }
 
+ManifestValidator::ManifestValidator(boost::asio::io_service &faceIo,
+                                     boost::shared_ptr<ndn::Face> face,
+                                     boost::shared_ptr<ndn::KeyChain> keyChain,
+                                     const boost::shared_ptr<StatisticsStorage> &statStorage,
+                                     unsigned int nDigestThreads)
+    : StatObject(statStorage), faceIo_(&faceIo), face_(face), keyChain_(keyChain),
+    metaFetcherPool_(META_FETCHER_POOL_SIZE),
+    verifyLatency_(Average(boost::make_shared<SampleWindow>(30)))
+{
+    description_ = "sample-validator";
+
+    if (nDigestThreads)
+        digestWork_ = boost::make_shared<boost::asio::io_service::work>(digestIo_);
+
+    for (unsigned int i = 0; i < nDigestThreads; ++i)
+        digestThreads_.push_back(boost::make_shared<boost::thread>([this]() {
+            digestIo_.run();
+        }));
+}
+
+ManifestValidator::~ManifestValidator()
+{
+    digestWork_.reset();
+    digestIo_.stop();
+
+    for (auto &t : digestThreads_)
+        t->join();
+}
+
 void ManifestValidator::onNewRequest(const boost::shared_ptr<BufferSlot> &slot)
 {
     if (slot->getState() == BufferSlot::State::New)
@@ -94,15 +132,7 @@ void ManifestValidator::onNewRequest(const boost::shared_ptr<BufferSlot> &slot)
                                 LogTraceC << "received manifest for "
                                           << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
 
-                                if (slot->getState() >= BufferSlot::State::New)
-                                {
-                                    slot->manifest_ = boost::make_shared<Manifest>(boost::move(nd));
-                                    if (slot->getState() >= BufferSlot::State::Ready)
-                                        verifySlot(slot);
-                                }
-                                else
-                                    LogWarnC << "late manifest arrival "
-                                             << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+                                setManifest(slot, boost::make_shared<Manifest>(boost::move(nd)));
                             }
                             metaFetcherPool_.push(mfetcher);
                         },
@@ -119,23 +149,104 @@ void ManifestValidator::onNewRequest(const boost::shared_ptr<BufferSlot> &slot)
     }
 }
 
+void ManifestValidator::setManifest(const boost::shared_ptr<const BufferSlot> &slot,
+                                    const boost::shared_ptr<Manifest> &manifest)
+{
+    if (slot->getState() >= BufferSlot::State::New)
+    {
+        slot->manifest_ = manifest;
+        if (slot->getState() >= BufferSlot::State::Ready)
+            verifySlot(slot);
+    }
+    else
+        LogWarnC << "late manifest arrival "
+                 << slot->getNameInfo().getSuffix(suffix_filter::Thread) << std::endl;
+}
+
 void ManifestValidator::onNewData(const BufferReceipt &receipt)
 {
-    if (receipt.slot_->getVerificationStatus() == BufferSlot::Verification::Unknown)
-        if ((receipt.slot_->getState() & BufferSlot::State::Ready ||
-             receipt.slot_->getState() & BufferSlot::State::Locked) &&
-            receipt.slot_->manifest_.get())
-            verifySlot(receipt.slot_);
+    // slot could have been locked for playback (or dropped) since receipt
+    // was issued, hence state is taken from receipt's snapshot
+    if (receipt.newState_ == BufferSlot::State::Ready && receipt.isCurrent() &&
+        receipt.slot_->getVerificationStatus() == BufferSlot::Verification::Unknown &&
+        receipt.slot_->manifest_.get())
+        verifySlot(receipt.slot_);
 }
 
 void ManifestValidator::verifySlot(const boost::shared_ptr<const BufferSlot> slot)
 {
     assert(slot->getState() >= BufferSlot::State::Ready);
 
+    if (digestThreads_.size())
+    {
+        verifySlotAsync(slot);
+        return;
+    }
+
+    int64_t startUsec = clock::microsecondTimestamp();
     bool verified = true;
-    for (auto &it : slot->fetched_)
-        verified &= slot->manifest_->hasData(*(it.second->getData()->getData()));
+    for (auto &segment : slot->getFetchedSegments())
+        verified &= slot->manifest_->hasData(*(segment->getData()->getData()));
+
+    onSlotVerified(slot, slot->getPrefix(), verified, startUsec);
+}
+
+void ManifestValidator::verifySlotAsync(const boost::shared_ptr<const BufferSlot> slot)
+{
+    if (pendingSlots_.find(slot.get()) != pendingSlots_.end())
+        return;
+
+    // slot may be cleared and reused on this thread while digests are being
+    // computed, so hand over only the wire encodings and the manifest;
+    // encodings are taken here as Data is not safe to use from other threads
+    std::vector<ndn::SignedBlob> encodings;
+    for (auto &segment : slot->getFetchedSegments())
+        encodings.push_back(segment->getData()->getData()->getDefaultWireEncoding());
+
+    boost::shared_ptr<const Manifest> manifest = slot->manifest_;
+    ndn::Name samplePrefix = slot->getPrefix();
+    int64_t startUsec = clock::microsecondTimestamp();
+    boost::weak_ptr<ManifestValidator> weakMe = boost::dynamic_pointer_cast<ManifestValidator>(shared_from_this());
+
+    pendingSlots_.insert(slot.get());
+    digestIo_.post([this, weakMe, slot, encodings, manifest, samplePrefix, startUsec]() {
+        uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+        bool verified = true;
+
+        for (auto &encoding : encodings)
+        {
+            // implicit digest is computed over the whole wire encoding
+            CryptoLite::digestSha256(encoding.buf(), encoding.size(), digest);
+            if (!(verified = manifest->hasDigest(digest, sizeof(digest))))
+                break;
+        }
+
+        faceIo_->post([weakMe, slot, samplePrefix, verified, startUsec]() {
+            boost::shared_ptr<ManifestValidator> me = weakMe.lock();
+            if (me)
+                me->onSlotVerified(slot, samplePrefix, verified, startUsec);
+        });
+    });
+}
+
+void ManifestValidator::onSlotVerified(const boost::shared_ptr<const BufferSlot> &slot,
+                                       const ndn::Name &samplePrefix, bool verified, int64_t startUsec)
+{
+    pendingSlots_.erase(slot.get());
+
+    if (slot->getPrefix() != samplePrefix || slot->getState() < BufferSlot::State::Ready)
+    {
+        LogDebugC << "slot was reused while verifying " << samplePrefix << std::endl;
+
+        if (slot->getState() >= BufferSlot::State::Ready && slot->manifest_.get() &&
+            slot->getVerificationStatus() == BufferSlot::Verification::Unknown)
+            verifySlot(slot);
+        return;
+    }
+
     slot->verified_ = (verified ? BufferSlot::Verification::Verified : BufferSlot::Verification::Failed);
+    verifyLatency_.newValue((double)(clock::microsecondTimestamp() - startUsec) / 1000.);
+    (*statStorage_)[Indicator::VerifyLatency] = verifyLatency_.value();
 
     if (slot->getVerificationStatus() == BufferSlot::Verification::Failed)
     {
@@ -8,9 +8,14 @@
 #ifndef __sample_validator_h__
 #define __sample_validator_h__
 
+#include <set>
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
 #include "ndnrtc-object.hpp"
 #include "frame-buffer.hpp"
 #include "statistics.hpp"
+#include "estimators.hpp"
 
 namespace ndn
 {
@@ -47,6 +52,11 @@ class SampleValidator : public NdnRtcComponent, public IBufferObserver, statisti
 
 /**
  * Used for validating multi-segment unsigned data, where signed manifest is published. 
+ * Only manifest signature is verified; segments are checked by comparing
+ * their implicit SHA-256 digests against the manifest. If digest threads
+ * are requested, digests are computed in background and verification
+ * result is delivered on faceIo thread; otherwise segments are checked
+ * synchronously once sample is assembled.
  */
 class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statistics::StatObject
 {
@@ -54,6 +64,19 @@ class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statis
     ManifestValidator(boost::shared_ptr<ndn::Face> face,
                       boost::shared_ptr<ndn::KeyChain> keyChain,
                       const boost::shared_ptr<statistics::StatisticsStorage> &statStorage);
+    ManifestValidator(boost::asio::io_service &faceIo,
+                      boost::shared_ptr<ndn::Face> face,
+                      boost::shared_ptr<ndn::KeyChain> keyChain,
+                      const boost::shared_ptr<statistics::StatisticsStorage> &statStorage,
+                      unsigned int nDigestThreads);
+    ~ManifestValidator();
+
+    /**
+     * Attaches fetched manifest to the slot and verifies the slot, if it is
+     * already assembled. Must be called on the face thread.
+     */
+    void setManifest(const boost::shared_ptr<const BufferSlot> &slot,
+                     const boost::shared_ptr<Manifest> &manifest);
 
   private:
     template <typename T>
@@ -100,14 +123,25 @@ class ManifestValidator : public NdnRtcComponent, public IBufferObserver, statis
         std::vector<boost::shared_ptr<T>> pool_;
     };
 
+    boost::asio::io_service *faceIo_;
     boost::shared_ptr<ndn::Face> face_;
     boost::shared_ptr<ndn::KeyChain> keyChain_;
     Pool<MetaFetcher> metaFetcherPool_;
+    estimators::Average verifyLatency_;
+
+    boost::asio::io_service digestIo_;
+    boost::shared_ptr<boost::asio::io_service::work> digestWork_;
+    std::vector<boost::shared_ptr<boost::thread>> digestThreads_;
+    // slots which digests are being checked in background
+    std::set<const BufferSlot *> pendingSlots_;
 
     void onNewRequest(const boost::shared_ptr<BufferSlot> &);
     void onNewData(const BufferReceipt &receipt);
     void onReset() {}
     void verifySlot(const boost::shared_ptr<const BufferSlot> slot);
+    void verifySlotAsync(const boost::shared_ptr<const BufferSlot> slot);
+    void onSlotVerified(const boost::shared_ptr<const BufferSlot> &slot,
+                        const ndn::Name &samplePrefix, bool verified, int64_t startUsec);
 };
 }
 
@@ -0,0 +1,141 @@
+//
+// signing-pool.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <ndn-cpp/c/common.h>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+
+#include "signing-pool.hpp"
+
+using namespace ndnrtc;
+using namespace ndn;
+
+namespace
+{
+// state of one sign() call, shared with the tasks posted to workers
+struct BatchState
+{
+    BatchState(size_t nSegments) : done_(nSegments, false), failed_(nSegments, false), nFailed_(0) {}
+
+    bool allDone() const
+    {
+        return std::find(done_.begin(), done_.end(), false) == done_.end();
+    }
+
+    boost::mutex mutex_;
+    boost::condition_variable signed_;
+    std::vector<bool> done_, failed_;
+    size_t nFailed_;
+};
+}
+
+SigningPool::SigningPool(unsigned int nThreads)
+    : work_(boost::make_shared<boost::asio::io_service::work>(io_))
+{
+    description_ = "signing-pool";
+
+    for (unsigned int i = 0; i < nThreads; ++i)
+        threads_.push_back(boost::make_shared<boost::thread>([this]() {
+            io_.run();
+        }));
+}
+
+SigningPool::~SigningPool()
+{
+    work_.reset();
+    io_.stop();
+
+    for (auto &t : threads_)
+        t->join();
+}
+
+void SigningPool::sign(size_t nSegments, SegmentCallback signFn, SegmentCallback onSigned)
+{
+    if (threads_.size() == 0 || nSegments < 2)
+    {
+        for (size_t i = 0; i < nSegments; ++i)
+        {
+            signFn(i);
+            onSigned(i);
+        }
+        return;
+    }
+
+    boost::shared_ptr<BatchState> state = boost::make_shared<BatchState>(nSegments);
+
+    for (size_t i = 0; i < nSegments; ++i)
+        io_.post([state, signFn, i, this]() {
+            bool failed = false;
+            try
+            {
+                signFn(i);
+            }
+            catch (std::exception &e)
+            {
+                LogErrorC << "failed to sign segment " << i << ": " << e.what() << std::endl;
+                failed = true;
+            }
+            catch (...)
+            {
+                LogErrorC << "failed to sign segment " << i << ": unknown error" << std::endl;
+                failed = true;
+            }
+
+            boost::lock_guard<boost::mutex> scopedLock(state->mutex_);
+            state->done_[i] = true;
+            state->failed_[i] = failed;
+            state->nFailed_ += failed;
+            state->signed_.notify_one();
+        });
+
+    // hand segments over in order, up to the first one that failed to be
+    // signed; tasks reference signFn's captures, so all of them must
+    // complete before returning, even if onSigned throws
+    try
+    {
+        for (size_t next = 0; next < nSegments; ++next)
+        {
+            {
+                boost::unique_lock<boost::mutex> lock(state->mutex_);
+                state->signed_.wait(lock, [state, next]() { return state->done_[next]; });
+                if (state->failed_[next])
+                    break;
+            }
+            onSigned(next);
+        }
+    }
+    catch (...)
+    {
+        boost::unique_lock<boost::mutex> lock(state->mutex_);
+        state->signed_.wait(lock, [state]() { return state->allDone(); });
+        throw;
+    }
+
+    boost::unique_lock<boost::mutex> lock(state->mutex_);
+    state->signed_.wait(lock, [state]() { return state->allDone(); });
+
+    if (state->nFailed_)
+    {
+        std::stringstream ss;
+        ss << state->nFailed_ << " out of " << nSegments << " segments were not signed";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void SigningPool::digestSign(Data &data)
+{
+    uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+
+    data.setSignature(DigestSha256Signature());
+    SignedBlob encoding = data.wireEncode();
+    CryptoLite::digestSha256(encoding.signedBuf(), encoding.signedSize(), digest);
+    data.getSignature()->setSignature(Blob(digest, sizeof(digest)));
+}
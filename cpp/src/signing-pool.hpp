@@ -0,0 +1,71 @@
+//
+// signing-pool.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __signing_pool_h__
+#define __signing_pool_h__
+
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "ndnrtc-object.hpp"
+
+namespace ndn
+{
+class Data;
+}
+
+namespace ndnrtc
+{
+
+/**
+ * Pool of worker threads that sign segments of a sample in parallel.
+ * Signed segments are handed back to the calling thread in the order
+ * they were submitted, so they can be added to the memory cache (which
+ * is not thread-safe) as soon as all preceding segments are signed.
+ * ndn::KeyChain is not thread-safe either, therefore calls to it must be
+ * guarded by keyChainMutex(); digest signatures are computed in parallel.
+ */
+class SigningPool : public NdnRtcComponent
+{
+  public:
+    typedef boost::function<void(size_t)> SegmentCallback;
+
+    SigningPool(unsigned int nThreads);
+    ~SigningPool();
+
+    unsigned int getThreadsNum() const { return threads_.size(); }
+
+    /**
+     * Calls signFn for segments [0, nSegments) on worker threads and
+     * onSigned for the same segments, in order, on the calling thread.
+     * Returns once onSigned was called for every segment. If signFn fails
+     * for any segment, onSigned is not called for it nor for the segments
+     * that follow, and an exception is thrown once all workers are done,
+     * so the caller can drop the sample instead of publishing it.
+     */
+    void sign(size_t nSegments, SegmentCallback signFn, SegmentCallback onSigned);
+
+    boost::mutex &keyChainMutex() { return keyChainMutex_; }
+
+    /**
+     * Sets DigestSha256 signature computed over the data packet.
+     * Thread-safe as long as data object is not shared.
+     */
+    static void digestSign(ndn::Data &data);
+
+  private:
+    SigningPool(const SigningPool &) = delete;
+
+    boost::asio::io_service io_;
+    boost::shared_ptr<boost::asio::io_service::work> work_;
+    std::vector<boost::shared_ptr<boost::thread>> threads_;
+    boost::mutex keyChainMutex_;
+};
+}
+
+#endif
@@ -40,6 +40,7 @@ map_list_of
 ( Indicator::CurrentProducerFramerate, "Producer rate" )
 ( Indicator::VerifySuccess, "Verified samples" )
 ( Indicator::VerifyFailure, "Verify failure samples" )
+( Indicator::VerifyLatency, "Average sample verification latency (ms)" )
 ( Indicator::LatencyControlStable, "Latency control stable state" )
 ( Indicator::LatencyControlCommand, "Latency control command" )
 ( Indicator::FrameFetchAvgDelta, "Average time for fetching delta frames" )
@@ -90,6 +91,20 @@ map_list_of
 ( Indicator::PublishedKeyNum, "Published key frames" )
 ( Indicator::InterestsReceivedNum, "Interests received" )
 ( Indicator::SignNum, "Sign operations")
+( Indicator::FecCoderCacheHitNum, "FEC coder cache hits" )
+( Indicator::FecCoderCacheMissNum, "FEC coder cache misses" )
+( Indicator::ParityPoolHitNum, "Parity buffer pool hits" )
+( Indicator::ParityPoolMissNum, "Parity buffer pool misses" )
+( Indicator::PublishLatency, "Average frame publishing latency (ms)" )
+( Indicator::CaptureLatency, "Average capture-to-publish latency (ms)" )
+( Indicator::EncodeLatency, "Average encode stage latency (ms)" )
+( Indicator::EncodeLatencyP95, "95th percentile of encode stage latency (ms)" )
+( Indicator::FecLatency, "Average FEC stage latency (ms)" )
+( Indicator::FecLatencyP95, "95th percentile of FEC stage latency (ms)" )
+( Indicator::SignLatency, "Average segment and sign stage latency (ms)" )
+( Indicator::SignLatencyP95, "95th percentile of segment and sign stage latency (ms)" )
+( Indicator::CacheLatency, "Average cache insert stage latency (ms)" )
+( Indicator::CacheLatencyP95, "95th percentile of cache insert stage latency (ms)" )
 
 // encoder
 ( Indicator::EncodedNum, "Encoded frames" )
@@ -121,6 +136,7 @@ map_list_of
 ( Indicator::CurrentProducerFramerate, 0. )
 ( Indicator::VerifySuccess, 0. )
 ( Indicator::VerifyFailure, 0. )
+( Indicator::VerifyLatency, 0. )
 ( Indicator::LatencyControlStable, 0. )
 ( Indicator::LatencyControlCommand, 0. )
 ( Indicator::FrameFetchAvgDelta, 0. )
@@ -173,6 +189,20 @@ map_list_of ( Indicator::Timestamp, 0. )
 ( Indicator::PublishedKeyNum, 0. )
 ( Indicator::InterestsReceivedNum, 0. )
 ( Indicator::SignNum, 0. )
+( Indicator::FecCoderCacheHitNum, 0. )
+( Indicator::FecCoderCacheMissNum, 0. )
+( Indicator::ParityPoolHitNum, 0. )
+( Indicator::ParityPoolMissNum, 0. )
+( Indicator::PublishLatency, 0. )
+( Indicator::CaptureLatency, 0. )
+( Indicator::EncodeLatency, 0. )
+( Indicator::EncodeLatencyP95, 0. )
+( Indicator::FecLatency, 0. )
+( Indicator::FecLatencyP95, 0. )
+( Indicator::SignLatency, 0. )
+( Indicator::SignLatencyP95, 0. )
+( Indicator::CacheLatency, 0. )
+( Indicator::CacheLatencyP95, 0. )
 ( Indicator::CurrentProducerFramerate, 0. )
 // encoder
 ( Indicator::DroppedNum, 0. )
@@ -205,6 +235,7 @@ boost::assign::map_list_of
 (Indicator::CurrentProducerFramerate, "prodRate")
 (Indicator::VerifySuccess, "verifySuccess")
 (Indicator::VerifyFailure, "verifyFailure")
+(Indicator::VerifyLatency, "verifyLatency")
 (Indicator::LatencyControlStable, "latCtrlStable" )
 (Indicator::LatencyControlCommand, "latCtrlCmd" )
 ( Indicator::FrameFetchAvgDelta, "fetchDeltaAvg" )
@@ -253,6 +284,20 @@ boost::assign::map_list_of
 (Indicator::PublishedKeyNum, "framesPubKey")
 (Indicator::InterestsReceivedNum, "irecvd")
 (Indicator::SignNum, "signNum")
+(Indicator::FecCoderCacheHitNum, "fecCacheHit")
+(Indicator::FecCoderCacheMissNum, "fecCacheMiss")
+(Indicator::ParityPoolHitNum, "parityPoolHit")
+(Indicator::ParityPoolMissNum, "parityPoolMiss")
+(Indicator::PublishLatency, "pubLatency")
+(Indicator::CaptureLatency, "capLatency")
+(Indicator::EncodeLatency, "encLatency")
+(Indicator::EncodeLatencyP95, "encLatency95")
+(Indicator::FecLatency, "fecLatency")
+(Indicator::FecLatencyP95, "fecLatency95")
+(Indicator::SignLatency, "signLatency")
+(Indicator::SignLatencyP95, "signLatency95")
+(Indicator::CacheLatency, "cacheLatency")
+(Indicator::CacheLatencyP95, "cacheLatency95")
 // encoder
 (Indicator::EncodedNum, "framesEncoded")
 // capturer
@@ -19,36 +19,12 @@
 #include <webrtc/modules/video_coding/codec_database.h>
 
 #include "video-coder.hpp"
-#include "threading-capability.hpp"
 
 using namespace std;
 using namespace ndnlog;
 using namespace ndnrtc;
 using namespace webrtc;
 
-// this class is needed to synchronously dispatch all
-// frame scaling (see - FrameScaler) calls on the same thread.
-// this is WebRTC requirement - all frame scaling calls must be
-// executed on the same thread throughout lifecycle
-class ScalerThread : public ThreadingCapability
-{
-  public:
-    static ScalerThread *getSharedInstance()
-    {
-        static ScalerThread scalerThread;
-        return &scalerThread;
-    }
-
-    void perform(boost::function<void(void)> block)
-    {
-        performOnMyThread(block);
-    }
-
-  private:
-    ScalerThread() { startMyThread(); }
-    ~ScalerThread() { stopMyThread(); }
-};
-
 //********************************************************************************
 char *plotCodec(webrtc::VideoCodec codec)
 {
@@ -109,40 +85,23 @@ webrtc::VideoCodec VideoCoder::codecFromSettings(const VideoCoderParams &setting
 }
 
 //******************************************************************************
-FrameScaler::FrameScaler(unsigned int dstWidth, unsigned int dstHeight)
-    : srcWidth_(0), srcHeight_(0),
-      dstWidth_(dstWidth), dstHeight_(dstHeight)
+FrameScaler::FrameScaler(unsigned int dstWidth, unsigned int dstHeight, size_t maxPoolSize)
+    : dstWidth_(dstWidth), dstHeight_(dstHeight),
+      pool_(maxPoolSize)
 {
-    initScaledFrame();
+    pool_.getBuffer(dstWidth_, dstHeight_); // allocate first buffer up front
 }
 
 const WebRtcVideoFrame
 FrameScaler::operator()(const WebRtcVideoFrame &frame)
 {
-    // try do scaling on this thread. if throws, do it old-fashioned way
-    // ScalerThread::getSharedInstance()->perform([&res, &frame, this](){
-    //     scaledFrameBuffer_->ScaleFrom(frame);
-    // });
+    if (frame.width() == (int)dstWidth_ && frame.height() == (int)dstHeight_)
+        return frame;
 
-    scaledFrameBuffer_->ScaleFrom(*(frame.video_frame_buffer()));
+    WebRtcSmartPtr<WebRtcVideoFrameBuffer> buffer = pool_.getBuffer(dstWidth_, dstHeight_);
+    buffer->ScaleFrom(*(frame.video_frame_buffer()));
 
-    return WebRtcVideoFrame(scaledFrameBuffer_, frame.rotation(), frame.timestamp_us());
-}
-
-void FrameScaler::initScaledFrame()
-{
-    int stride_y = dstWidth_;
-    int stride_uv = (dstWidth_ + 1) / 2;
-    int target_width = dstWidth_;
-    int target_height = dstHeight_;
-
-    scaledFrameBuffer_ = I420Buffer::Create(target_width,
-                                            abs(target_height),
-                                            stride_y,
-                                            stride_uv, stride_uv);
-
-    if (!scaledFrameBuffer_)
-        throw std::runtime_error("failed to allocate scaled frame");
+    return WebRtcVideoFrame(buffer, frame.rotation(), frame.timestamp_us());
 }
 
 //********************************************************************************
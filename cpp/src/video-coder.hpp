@@ -18,6 +18,7 @@
 #include "ndnrtc-common.hpp"
 #include "statistics.hpp"
 #include "ndnrtc-object.hpp"
+#include "frame-buffer-pool.hpp"
 
 #define USE_VP9
 
@@ -43,31 +44,31 @@ class IEncoderDelegate
 };
 
 /**
-     * This class performs scaling of raw frames. WebRTC uses frame buffers
-     * pool for allocating frames memory. All frame operations that involve 
-     * memory manipulations must use buffer pool. According to WebRTC design,
-     * access to buffer pool is restricted to only one thread - the one that
-     * was the first to access pool. As frame scaling involves pool access,
-     * one has to ensure that scaling is always performed on the same thread.
-     * This rule affects applies to all FrameScaler instances.
+     * This class performs scaling of raw frames. Scaled frames are written
+     * into buffers of scaler's own pool (see FrameBufferPool), so frames
+     * returned by the scaler stay valid while they are queued for encoding.
+     * One scaler must be used by one thread at a time, but different scalers
+     * can run in parallel. Frames that already have target resolution are
+     * passed through without copying.
      */
 class FrameScaler
 {
   public:
-    FrameScaler(unsigned int dstWidth, unsigned int dstHeight);
+    FrameScaler(unsigned int dstWidth, unsigned int dstHeight, size_t maxPoolSize = 4);
     const WebRtcVideoFrame operator()(const WebRtcVideoFrame &frame);
 
+    unsigned int getWidth() const { return dstWidth_; }
+    unsigned int getHeight() const { return dstHeight_; }
+
+    // number of buffers allocated so far, including those that did not
+    // fit into the pool
+    unsigned int getAllocatedNum() const { return pool_.getAllocatedNum(); }
+
   private:
     FrameScaler(const FrameScaler &) = delete;
 
-    unsigned int srcWidth_, srcHeight_;
     unsigned int dstWidth_, dstHeight_;
-    // webrtc::Scaler scaler_;
-    // WebRtcVideoFrame scaledFrame_;
-    WebRtcSmartPtr<WebRtcVideoFrameBuffer> scaledFrameBuffer_;
-
-    void
-    initScaledFrame();
+    FrameBufferPool pool_;
 };
 
 /**
@@ -5,10 +5,10 @@
 //  Copyright 2013-2016 Regents of the University of California
 //
 
-#define BOOST_THREAD_PROVIDES_FUTURE
-#include <boost/thread/future.hpp>
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/smart_ptr/weak_ptr.hpp>
 #include <ndn-cpp/c/common.h>
 #include <ndn-cpp/face.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
@@ -36,15 +36,137 @@ using namespace ndn;
 using namespace estimators;
 
 typedef boost::shared_ptr<VideoFramePacket> FramePacketPtr;
-typedef boost::future<FramePacketPtr> FutureFrame;
-typedef boost::shared_ptr<boost::future<FramePacketPtr>> FutureFramePtr;
+
+// number of captured frames in the publishing pipeline (all encoded
+// threads of one captured frame take one slot); encoders wait for it once
+// the limit is reached
+struct VideoStreamImpl::PublishSlots
+{
+    PublishSlots() : nInFlight_(0), stopped_(false) {}
+
+    void acquire()
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        nInFlight_++;
+    }
+
+    void release()
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        nInFlight_--;
+        released_.notify_all();
+    }
+
+    void wait(size_t limit)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        released_.wait(lock, [this, limit]() { return stopped_ || nInFlight_ < limit; });
+    }
+
+    void stop()
+    {
+        boost::lock_guard<boost::mutex> scopedLock(mutex_);
+        stopped_ = true;
+        released_.notify_all();
+    }
+
+    boost::mutex mutex_;
+    boost::condition_variable released_;
+    size_t nInFlight_;
+    bool stopped_;
+};
+
+// slot of one captured frame in the pipeline; shared by jobs of all its
+// encoded threads and released once the last of them is gone
+struct VideoStreamImpl::PublishSlot
+{
+    PublishSlot(const boost::shared_ptr<PublishSlots> &slots)
+        : slots_(slots)
+    {
+        slots_->acquire();
+    }
+
+    ~PublishSlot()
+    {
+        slots_->release();
+    }
+
+    boost::shared_ptr<PublishSlots> slots_;
+};
+
+// encoded frame passed along publishing stages; frame leaves the pipeline
+// once it is cached or discarded by a stopped stage
+struct VideoStreamImpl::PublishJob
+{
+    PublishJob(const boost::shared_ptr<PublishSlot> &slot)
+        : slot_(slot), nDataSeg_(0), nParitySeg_(0), signFailed_(false), fecMs_(0), signMs_(-1),
+          fecCoderHits_(0), fecCoderMisses_(0), parityPoolHits_(0), parityPoolMisses_(0) {}
+
+    // returns latency of the stage that has just completed (ms)
+    double stageDone()
+    {
+        int64_t now = clock::microsecondTimestamp();
+        double latencyMs = (double)(now - stageUsec_) / 1000.;
+        stageUsec_ = now;
+        return latencyMs;
+    }
+
+    // updates latency of the stage that has just completed; statistics
+    // storage is not thread-safe, so this is called on the face thread only
+    void stageDone(StageLatency &latency, StatisticsStorage &storage)
+    {
+        latency.newValue(stageDone(), storage);
+    }
+
+    boost::shared_ptr<PublishSlot> slot_;
+    FramePacketPtr fp_;
+    boost::shared_ptr<NetworkData> parityData_;
+    boost::shared_ptr<MetaKeeper> keeper_;
+    boost::shared_ptr<EncodeBatch> batch_;
+    bool isKey_;
+    PacketNumber seqNo_, pairedSeq_, playbackNo_;
+    unsigned char gopPos_;
+    Name dataName_;
+    size_t nDataSeg_, nParitySeg_;
+    VideoFrameSegmentHeader segmentHdr_;
+    VideoPacketPublisher::SlicedSample data_, parity_;
+    int64_t publishStartUsec_, stageUsec_;
+    // set if frame could not be signed; such frame is dropped, not cached
+    bool signFailed_;
+    // measured on stage threads and reported on the face thread;
+    // signMs_ is negative if frame was not signed on the signing stage
+    double fecMs_, signMs_;
+    size_t fecCoderHits_, fecCoderMisses_, parityPoolHits_, parityPoolMisses_;
+};
+
+struct VideoStreamImpl::EncodeBatch
+{
+    EncodeBatch(size_t nThreads, int64_t captureUsec)
+        : nPending_(nThreads), nPublishing_(0), captureUsec_(captureUsec),
+          encodeMs_(0), encodeReported_(false) {}
+
+    size_t nPending_; // guarded by internalMutex_
+    boost::atomic<size_t> nPublishing_;
+    int64_t captureUsec_;
+    // measured on encoder worker, reported on the face thread
+    double encodeMs_;
+    bool encodeReported_; // accessed on the face thread only
+    map<string, FramePacketPtr> frames_;
+    map<string, unsigned char> gopPos_;
+};
 
 VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
                                  const MediaStreamSettings &settings, bool useFec)
     : MediaStreamBase(streamPrefix, settings),
       playbackCounter_(0),
       fecEnabled_(useFec),
-      busyPublishing_(0)
+      publishLatency_(Average(boost::make_shared<SampleWindow>(30))),
+      captureLatency_(Average(boost::make_shared<SampleWindow>(30))),
+      encodeLatency_(Indicator::EncodeLatency, Indicator::EncodeLatencyP95),
+      fecLatency_(Indicator::FecLatency, Indicator::FecLatencyP95),
+      signLatency_(Indicator::SignLatency, Indicator::SignLatencyP95),
+      cacheLatency_(Indicator::CacheLatency, Indicator::CacheLatencyP95),
+      publishSlots_(boost::make_shared<PublishSlots>())
 {
     if (settings_.params_.type_ == MediaStreamParams::MediaStreamType::MediaStreamTypeAudio)
         throw runtime_error("Wrong media stream parameters type supplied (audio instead of video)");
@@ -56,7 +178,10 @@ VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
             add(settings_.params_.getVideoThread(i));
 
     PublisherSettings ps;
-    ps.sign_ = false; // stream samples are not signed - we use manifests for verification
+    // by default, stream samples are not signed - we use manifests for verification
+    ps.sign_ = (settings_.sign_ && !settings_.signManifestsOnly_);
+    ps.batchPit_ = true; // frames have many segments, match them against PIT at once
+    ps.signingPool_ = signingPool_.get();
     ps.keyChain_ = settings_.keyChain_;
     ps.memoryCache_ = cache_.get();
     ps.segmentWireLength_ = settings_.params_.producerParams_.segmentSize_;
@@ -70,11 +195,14 @@ VideoStreamImpl::VideoStreamImpl(const std::string &streamPrefix,
 
     framePublisher_ = boost::make_shared<VideoPacketPublisher>(ps);
     framePublisher_->setDescription("seg-publisher-" + settings_.params_.streamName_);
+
+    fecStage_ = boost::make_shared<PublishStage>("fec-" + settings_.params_.streamName_);
+    signStage_ = boost::make_shared<PublishStage>("sign-" + settings_.params_.streamName_);
 }
 
 VideoStreamImpl::~VideoStreamImpl()
 {
-    // cleanup
+    stop();
 }
 
 vector<string> VideoStreamImpl::getThreads() const
@@ -104,6 +232,14 @@ int VideoStreamImpl::incomingFrame(const I420RawFrameWrapper &w)
     return -1;
 }
 
+int VideoStreamImpl::incomingFrame(const I420RawFrameWrapper &w, boost::function<void(void)> onReleased)
+{
+    LogDebugC << "⤹ incoming I420 frame (no copy) " << w.width_ << "x" << w.height_ << std::endl;
+    if (feedFrame(RawFrameConverter::wrap(w, onReleased)))
+        return (playbackCounter_ - 1);
+    return -1;
+}
+
 int VideoStreamImpl::incomingFrame(const YUV_NV21FrameWrapper &w)
 {
     LogDebugC << "⤹ incoming NV21 frame " << w.width_ << "x" << w.height_ << std::endl;
@@ -120,6 +256,8 @@ void VideoStreamImpl::setLogger(boost::shared_ptr<ndnlog::new_api::Logger> logge
     for (auto t : threads_)
         t.second->setLogger(logger);
     framePublisher_->setLogger(logger);
+    fecStage_->setLogger(logger);
+    signStage_->setLogger(logger);
     metadataPublisher_->setLogger(logger);
     ILoggingObject::setLogger(logger);
 }
@@ -140,8 +278,6 @@ void VideoStreamImpl::add(const MediaThreadParams *mp)
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
 
         threads_[params->threadName_] = boost::make_shared<VideoThread>(params->coderParams_);
-        scalers_[params->threadName_] = boost::make_shared<FrameScaler>(params->coderParams_.encodeWidth_,
-                                                                        params->coderParams_.encodeHeight_);
         seqCounters_[params->threadName_].first = -1;
         seqCounters_[params->threadName_].second = -1;
         metaKeepers_[params->threadName_] = boost::make_shared<MetaKeeper>(params);
@@ -154,64 +290,69 @@ void VideoStreamImpl::add(const MediaThreadParams *mp)
 
 void VideoStreamImpl::remove(const string &threadName)
 {
-    if (threads_.find(threadName) != threads_.end())
+    boost::shared_ptr<VideoThread> thread;
     {
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
 
+        if (threads_.find(threadName) == threads_.end())
+            return;
+
+        thread = threads_[threadName];
         threads_.erase(threadName);
-        scalers_.erase(threadName);
         seqCounters_.erase(threadName);
         metaKeepers_.erase(threadName);
-
-        LogTraceC << "remove thread " << threadName << std::endl;
     }
+
+    // worker reports queued frames via onFrameEncoded which takes
+    // internalMutex_, so it is stopped outside of the lock
+    thread->stop();
+
+    LogTraceC << "remove thread " << threadName << std::endl;
 }
 
-bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
+void VideoStreamImpl::stop()
 {
-    (*statStorage_)[Indicator::CapturedNum]++;
-
-    if (busyPublishing_ > 0)
+    map<string, boost::shared_ptr<VideoThread>> threads;
     {
-        LogWarnC << "⨂ busy publishing (capture rate may be too high)" << std::endl;
-        return false;
+        boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+        threads.swap(threads_);
     }
 
-    if (threads_.size())
+    // workers may wait for the publishing pipeline which won't drain if
+    // face thread is not running anymore
+    publishSlots_->stop();
+
+    // once workers and stages are stopped, none of them holds a reference
+    // to the stream
+    for (auto it : threads)
+        it.second->stop();
+    fecStage_->stop();
+    signStage_->stop();
+
+    boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+    encodeBatches_.clear();
+}
+
+bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
+{
+    countFrame(Indicator::CapturedNum);
+
+    boost::shared_ptr<VideoThreadList> threads = boost::make_shared<VideoThreadList>();
+    boost::shared_ptr<EncodeBatch> batch;
     {
         boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
-        LogDebugC << "↓ feeding " << playbackCounter_ << "p into encoders..." << std::endl;
 
-        map<string, FutureFramePtr> futureFrames;
-        for (auto it : threads_)
+        if (!threads_.size())
         {
-            FutureFramePtr ff =
-                boost::make_shared<FutureFrame>(boost::move(boost::async(boost::launch::async,
-                                                                         boost::bind(&VideoThread::encode, it.second.get(),
-                                                                         (*scalers_[it.first])(frame)))));
-            futureFrames[it.first] = ff;
+            LogWarnC << "incoming frame was given, but there are no threads" << std::endl;
+            return false;
         }
 
-        map<string, FramePacketPtr> frames;
-        for (auto it : futureFrames)
-        {
-            FramePacketPtr f(it.second->get());
-            if (f.get())
-            {
-                (*statStorage_)[Indicator::EncodedNum]++;
-                frames[it.first] = f;
-            }
-        }
-
-        (*statStorage_)[Indicator::DroppedNum] += (threads_.size() - frames.size());
-        bool result = false;
+        batch = boost::make_shared<EncodeBatch>(threads_.size(), clock::microsecondTimestamp());
+        encodeBatches_.push_back(batch);
 
-        if (frames.size())
-        {
-            publish(frames);
-            playbackCounter_++;
-            result = true;
-        }
+        for (auto it : threads_)
+            threads->push_back(it);
 
         if (!isPeriodicInvocationSet())
         {
@@ -219,20 +360,120 @@ bool VideoStreamImpl::feedFrame(const WebRtcVideoFrame &frame)
             setupInvocation(MediaStreamBase::MetaCheckIntervalMs,
                             boost::bind(&VideoStreamImpl::periodicInvocation, me));
         }
+    }
 
-        return result;
+    LogDebugC << "↓ feeding frame into encoders..." << std::endl;
+
+    // frames are queued outside of the lock: workers take it to report
+    // encoded frames and frames dropped from the queue are reported
+    // synchronously
+    if (settings_.cascadedScaling_)
+    {
+        std::sort(threads->begin(), threads->end(),
+                  [](const VideoThreadList::value_type &a, const VideoThreadList::value_type &b) {
+                      return a.second->getScaler().getWidth() * a.second->getScaler().getHeight() >
+                             b.second->getScaler().getWidth() * b.second->getScaler().getHeight();
+                  });
+        encodeCascade(batch, threads, 0, frame);
     }
     else
-        LogWarnC << "incoming frame was given, but there are no threads" << std::endl;
+        for (auto it : *threads)
+            it.second->encodeAsync(frame, boost::bind(&VideoStreamImpl::onFrameEncoded, this,
+                                                      batch, it.first, _1, _2));
 
-    return false;
+    return true;
 }
 
-void VideoStreamImpl::publish(map<string, FramePacketPtr> &frames)
+void VideoStreamImpl::encodeCascade(boost::shared_ptr<EncodeBatch> batch,
+                                    boost::shared_ptr<VideoThreadList> cascade,
+                                    size_t level, const WebRtcVideoFrame &frame)
 {
-    LogTraceC << "will publish " << frames.size() << " frames" << std::endl;
+    const VideoThreadList::value_type &thread = (*cascade)[level];
 
-    for (auto it : frames)
+    if (level + 1 == cascade->size())
+    {
+        thread.second->encodeAsync(frame, boost::bind(&VideoStreamImpl::onFrameEncoded, this,
+                                                      batch, thread.first, _1, _2));
+        return;
+    }
+
+    // scaled frame of this level is the source for the next one; both
+    // callbacks run on the same worker, unless frame is dropped from the
+    // queue, in which case it is never scaled
+    boost::shared_ptr<bool> forwarded = boost::make_shared<bool>(false);
+    thread.second->encodeAsync(frame,
+                               [this, batch, cascade, level, forwarded](const FramePacketPtr &fp, unsigned char gopPos) {
+                                   if (!*forwarded)
+                                       for (size_t i = level + 1; i < cascade->size(); ++i)
+                                           onFrameEncoded(batch, (*cascade)[i].first, FramePacketPtr(), 0);
+                                   onFrameEncoded(batch, (*cascade)[level].first, fp, gopPos);
+                               },
+                               [this, batch, cascade, level, forwarded](const WebRtcVideoFrame &scaled) {
+                                   *forwarded = true;
+                                   encodeCascade(batch, cascade, level + 1, scaled);
+                               });
+}
+
+void VideoStreamImpl::onFrameEncoded(boost::shared_ptr<EncodeBatch> batch, string thread,
+                                     const FramePacketPtr &fp, unsigned char gopPos)
+{
+    publishEncoded(batch, thread, fp, gopPos);
+
+    // encoder takes next frame once there is room in the publishing pipeline;
+    // frames captured meanwhile are dropped from its queue. Dropped frames
+    // are also reported on capturing thread, which must not wait
+    if (fp.get())
+        publishSlots_->wait(std::max<size_t>(1, settings_.publishQueueSize_));
+}
+
+void VideoStreamImpl::publishEncoded(const boost::shared_ptr<EncodeBatch> &batch, const string &thread,
+                                     const FramePacketPtr &fp, unsigned char gopPos)
+{
+    boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+
+    if (fp.get())
+    {
+        countFrame(Indicator::EncodedNum);
+        batch->frames_[thread] = fp;
+        batch->gopPos_[thread] = gopPos;
+    }
+    else
+        countFrame(Indicator::DroppedNum);
+
+    batch->nPending_--;
+
+    // threads encode at different pace, so batches are published in capture
+    // order starting from the oldest one
+    while (encodeBatches_.size() && encodeBatches_.front()->nPending_ == 0)
+    {
+        boost::shared_ptr<EncodeBatch> b = encodeBatches_.front();
+        encodeBatches_.pop_front();
+
+        // thread might have been removed while other threads were encoding
+        for (auto it = b->frames_.begin(); it != b->frames_.end();)
+            if (threads_.find(it->first) == threads_.end())
+                it = b->frames_.erase(it);
+            else
+                ++it;
+
+        if (b->frames_.size())
+        {
+            publish(b);
+            playbackCounter_++;
+        }
+    }
+}
+
+void VideoStreamImpl::publish(const boost::shared_ptr<EncodeBatch> &batch)
+{
+    LogTraceC << "will publish " << batch->frames_.size() << " frames" << std::endl;
+
+    int64_t encodedUsec = clock::microsecondTimestamp();
+    batch->encodeMs_ = (double)(encodedUsec - batch->captureUsec_) / 1000.;
+
+    boost::shared_ptr<PublishSlot> slot = boost::make_shared<PublishSlot>(publishSlots_);
+    batch->nPublishing_ = batch->frames_.size();
+    for (auto it : batch->frames_)
     {
         // prepare packet header
         bool isKey = (it.second->getFrame()._frameType == webrtc::kVideoFrameKey);
@@ -255,95 +496,209 @@ void VideoStreamImpl::publish(map<string, FramePacketPtr> &frames)
 
         lastPublished_[it.first].timestamp_ = (uint64_t)(packetHdr.publishUnixTimestamp_*1000);
         lastPublished_[it.first].playbackNo_ = playbackCounter_;
-        lastPublished_[it.first].ndnName_ = publish(it.first, it.second);
+        lastPublished_[it.first].ndnName_ = publish(it.first, it.second, batch->gopPos_[it.first], batch, slot);
     }
 }
 
-std::string VideoStreamImpl::publish(const string &thread, FramePacketPtr &fp)
-{
-    boost::shared_ptr<NetworkData> parityData = fp->getParityData(
-        VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_),
-        PARITY_RATIO);
-
-    bool isKey = (fp->getFrame()._frameType == webrtc::kVideoFrameKey);
-    PacketNumber seqNo = (isKey ? seqCounters_[thread].first : seqCounters_[thread].second);
-    PacketNumber pairedSeq = (isKey ? seqCounters_[thread].second + 1 : seqCounters_[thread].first);
-    PacketNumber playbackNo = playbackCounter_;
-    unsigned char gopPos = (char)threads_[thread]->getCoder().getGopCounter();
-    Name dataName(streamPrefix_);
-    dataName.append(thread)
-        .append((isKey ? NameComponents::NameComponentKey : NameComponents::NameComponentDelta))
-        .appendSequenceNumber(seqNo);
-
-    size_t nDataSeg = VideoFrameSegment::numSlices(*fp,
-                                                   settings_.params_.producerParams_.segmentSize_);
-    size_t nParitySeg = fecEnabled_ && VideoFrameSegment::numSlices(*parityData,
-                                                     settings_.params_.producerParams_.segmentSize_);
-    boost::shared_ptr<VideoStreamImpl> me = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
-    boost::shared_ptr<MetaKeeper> keeper = metaKeepers_[thread];
+std::string VideoStreamImpl::publish(const string &thread, FramePacketPtr &fp,
+                                     unsigned char gopPos, const boost::shared_ptr<EncodeBatch> &batch,
+                                     const boost::shared_ptr<PublishSlot> &slot)
+{
+    boost::shared_ptr<PublishJob> job = boost::make_shared<PublishJob>(slot);
+
+    job->fp_ = fp;
+    job->gopPos_ = gopPos;
+    job->batch_ = batch;
+    job->keeper_ = metaKeepers_[thread];
+    job->isKey_ = (fp->getFrame()._frameType == webrtc::kVideoFrameKey);
+    job->seqNo_ = (job->isKey_ ? seqCounters_[thread].first : seqCounters_[thread].second);
+    job->pairedSeq_ = (job->isKey_ ? seqCounters_[thread].second + 1 : seqCounters_[thread].first);
+    job->playbackNo_ = playbackCounter_;
+    job->dataName_ = Name(streamPrefix_);
+    job->dataName_.append(thread)
+        .append((job->isKey_ ? NameComponents::NameComponentKey : NameComponents::NameComponentDelta))
+        .appendSequenceNumber(job->seqNo_);
+    job->nDataSeg_ = VideoFrameSegment::numSlices(*fp, settings_.params_.producerParams_.segmentSize_);
+    job->publishStartUsec_ = job->stageUsec_ = clock::microsecondTimestamp();
 
     LogTraceC << "spawned publish task for "
-              << seqNo
-              << (isKey ? "k " : "d ")
-              << playbackNo << "p "
-              << "(" << SAMPLE_SUFFIX(dataName) << ")" << std::endl;
-
-    busyPublishing_++;
-    async::dispatchAsync(settings_.faceIo_, [me, nParitySeg, nDataSeg, seqNo, pairedSeq, keeper, isKey,
-                                             thread, fp, parityData, dataName, playbackNo, gopPos, this] {
-        VideoFrameSegmentHeader segmentHdr;
-        segmentHdr.totalSegmentsNum_ = nDataSeg;
-        segmentHdr.paritySegmentsNum_ = nParitySeg;
-        segmentHdr.playbackNo_ = playbackNo;
-        segmentHdr.pairedSequenceNo_ = pairedSeq;
-
-        PublishedDataPtrVector segments =
-            me->framePublisher_->publish(dataName, *fp, segmentHdr,
-                                         (isKey ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
-                                         isKey, true);
-        assert(segments.size());
-        keeper->updateMeta(isKey, nDataSeg, nParitySeg, seqNo, pairedSeq, gopPos);
+              << job->seqNo_
+              << (job->isKey_ ? "k " : "d ")
+              << job->playbackNo_ << "p "
+              << "(" << SAMPLE_SUFFIX(job->dataName_) << ")" << std::endl;
+
+    // stages hold weak reference to the stream: they are stopped before
+    // it is destroyed and must not be the ones destroying it
+    boost::weak_ptr<VideoStreamImpl> me = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+    fecStage_->push([this, me, job]() {
+        computeParity(*job);
+        async::dispatchAsync(settings_.faceIo_, [me, job]() {
+            if (boost::shared_ptr<VideoStreamImpl> stream = me.lock())
+                stream->sliceFrame(job);
+        });
+    });
 
-        LogDebugC << "↓ published "
-                  << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                  << "(" << SAMPLE_SUFFIX(dataName) << ")x" << segments.size()
-                  << " Dgen " << segmentHdr.generationDelayMs_ << "ms" << std::endl;
+    return job->dataName_.toUri();
+}
 
-        PublishedDataPtrVector paritySegments;
-        if (nParitySeg)
-        {
-            Name parityName(dataName);
-            parityName.append(NameComponents::NameComponentParity);
-
-            paritySegments =
-                me->framePublisher_->publish(parityName, *parityData, segmentHdr,
-                                             (isKey ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1),
-                                             isKey);
-            assert(paritySegments.size());
-            std::copy(paritySegments.begin(), paritySegments.end(), std::back_inserter(segments));
-
-            LogDebugC << "↓ published "
-                      << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                      << "(" << PARITY_SUFFIX(parityName) << ")x" << paritySegments.size()
-                      << std::endl;
-        }
-        publishManifest(dataName, segments);
-        busyPublishing_--;
+void VideoStreamImpl::computeParity(PublishJob &job)
+{
+    if (fecEnabled_)
+    {
+        job.parityData_ = job.fp_->getParityData(
+            VideoFrameSegment::payloadLength(settings_.params_.producerParams_.segmentSize_),
+            PARITY_RATIO, parityPool_);
+        job.nParitySeg_ = VideoFrameSegment::numSlices(*job.parityData_,
+                                                       settings_.params_.producerParams_.segmentSize_);
+
+        const fec::Rs28CoderCache &coderCache = fec::Rs28CoderCache::getThreadInstance();
+
+        job.fecCoderHits_ = coderCache.getHitsNum();
+        job.fecCoderMisses_ = coderCache.getMissesNum();
+        job.parityPoolHits_ = parityPool_.getHitsNum();
+        job.parityPoolMisses_ = parityPool_.getMissesNum();
+    }
 
-        LogInfoC << "▻ published frame "
-                 << seqNo << (isKey ? "k " : "d ") << playbackNo << "p "
-                 << " data segments x" << segments.size()
-                 << " parity segments x" << paritySegments.size()
-                 << std::endl;
+    job.fecMs_ = job.stageDone();
+}
 
-        (*statStorage_)[Indicator::PublishedNum]++;
-        if (isKey)
-            (*statStorage_)[Indicator::PublishedKeyNum]++;
-        if (busyPublishing_ == 0)
-            (*statStorage_)[Indicator::ProcessedNum]++;
+void VideoStreamImpl::sliceFrame(const boost::shared_ptr<PublishJob> &job)
+{
+    if (!job->batch_->encodeReported_)
+    {
+        encodeLatency_.newValue(job->batch_->encodeMs_, *statStorage_);
+        job->batch_->encodeReported_ = true;
+    }
+    fecLatency_.newValue(job->fecMs_, *statStorage_);
+    if (fecEnabled_)
+    {
+        (*statStorage_)[Indicator::FecCoderCacheHitNum] = job->fecCoderHits_;
+        (*statStorage_)[Indicator::FecCoderCacheMissNum] = job->fecCoderMisses_;
+        (*statStorage_)[Indicator::ParityPoolHitNum] = job->parityPoolHits_;
+        (*statStorage_)[Indicator::ParityPoolMissNum] = job->parityPoolMisses_;
+    }
+
+    job->segmentHdr_.totalSegmentsNum_ = job->nDataSeg_;
+    job->segmentHdr_.paritySegmentsNum_ = job->nParitySeg_;
+    job->segmentHdr_.playbackNo_ = job->playbackNo_;
+    job->segmentHdr_.pairedSequenceNo_ = job->pairedSeq_;
+
+    int freshnessMs = (job->isKey_ ? settings_.params_.producerParams_.freshness_.sampleKeyMs_ : -1);
+
+    job->data_ = framePublisher_->slice(job->dataName_, *job->fp_, job->segmentHdr_, freshnessMs);
+    if (job->nParitySeg_)
+    {
+        Name parityName(job->dataName_);
+        parityName.append(NameComponents::NameComponentParity);
+        job->parity_ = framePublisher_->slice(parityName, *job->parityData_, job->segmentHdr_, freshnessMs);
+    }
+
+    // key chain is shared with other streams and the face, so segments
+    // signed with it are signed here, on the face thread; only digest
+    // signing is done on the signing stage
+    if (framePublisher_->signsWithKeyChain())
+    {
+        signFrame(*job);
+        job->stageDone(signLatency_, *statStorage_);
+        cacheFrame(job);
+        return;
+    }
+
+    boost::weak_ptr<VideoStreamImpl> me = boost::static_pointer_cast<VideoStreamImpl>(shared_from_this());
+    signStage_->push([this, me, job]() {
+        signFrame(*job);
+        job->signMs_ = job->stageDone();
+
+        async::dispatchAsync(settings_.faceIo_, [me, job]() {
+            if (boost::shared_ptr<VideoStreamImpl> stream = me.lock())
+                stream->cacheFrame(job);
+        });
     });
+}
+
+void VideoStreamImpl::signFrame(PublishJob &job)
+{
+    try
+    {
+        framePublisher_->sign(job.data_);
+        framePublisher_->sign(job.parity_);
+    }
+    catch (std::exception &e)
+    {
+        LogErrorC << "failed to sign frame " << job.dataName_ << ": " << e.what() << std::endl;
+        job.signFailed_ = true;
+    }
+}
 
-    return dataName.toUri();
+void VideoStreamImpl::cacheFrame(const boost::shared_ptr<PublishJob> &job)
+{
+    if (job->signMs_ >= 0)
+        signLatency_.newValue(job->signMs_, *statStorage_);
+
+    if (job->signFailed_)
+    {
+        LogWarnC << "dropped frame " << job->seqNo_ << (job->isKey_ ? "k " : "d ")
+                 << job->playbackNo_ << "p: not signed" << std::endl;
+        (*statStorage_)[Indicator::DroppedNum]++;
+        --job->batch_->nPublishing_;
+        return;
+    }
+
+    PublishedDataPtrVector segments = framePublisher_->cache(job->data_, job->isKey_, true);
+    assert(segments.size());
+    job->keeper_->updateMeta(job->isKey_, job->nDataSeg_, job->nParitySeg_,
+                             job->seqNo_, job->pairedSeq_, job->gopPos_);
+
+    LogDebugC << "↓ published "
+              << job->seqNo_ << (job->isKey_ ? "k " : "d ") << job->playbackNo_ << "p "
+              << "(" << SAMPLE_SUFFIX(job->dataName_) << ")x" << segments.size()
+              << " Dgen " << job->segmentHdr_.generationDelayMs_ << "ms" << std::endl;
+
+    PublishedDataPtrVector paritySegments;
+    if (job->nParitySeg_)
+    {
+        paritySegments = framePublisher_->cache(job->parity_, job->isKey_);
+        assert(paritySegments.size());
+        std::copy(paritySegments.begin(), paritySegments.end(), std::back_inserter(segments));
+
+        LogDebugC << "↓ published "
+                  << job->seqNo_ << (job->isKey_ ? "k " : "d ") << job->playbackNo_ << "p "
+                  << "(" << PARITY_SUFFIX(job->parity_.name_) << ")x" << paritySegments.size()
+                  << std::endl;
+    }
+    publishManifest(job->dataName_, segments);
+    job->stageDone(cacheLatency_, *statStorage_);
+
+    double latencyMs = (double)(clock::microsecondTimestamp() - job->publishStartUsec_) / 1000.;
+    publishLatency_.newValue(latencyMs);
+    (*statStorage_)[Indicator::PublishLatency] = publishLatency_.value();
+
+    LogInfoC << "▻ published frame "
+             << job->seqNo_ << (job->isKey_ ? "k " : "d ") << job->playbackNo_ << "p "
+             << " data segments x" << segments.size()
+             << " parity segments x" << paritySegments.size()
+             << " in " << latencyMs << "ms"
+             << std::endl;
+
+    (*statStorage_)[Indicator::PublishedNum]++;
+    if (job->isKey_)
+        (*statStorage_)[Indicator::PublishedKeyNum]++;
+    if (--job->batch_->nPublishing_ == 0)
+    {
+        captureLatency_.newValue((double)(clock::microsecondTimestamp() - job->batch_->captureUsec_) / 1000.);
+        (*statStorage_)[Indicator::CaptureLatency] = captureLatency_.value();
+        (*statStorage_)[Indicator::ProcessedNum]++;
+    }
+}
+
+void VideoStreamImpl::countFrame(Indicator indicator)
+{
+    // statistics storage is not thread-safe; capture and encoder threads
+    // update it on the face thread
+    boost::shared_ptr<StatisticsStorage> storage = statStorage_;
+    async::dispatchAsync(settings_.faceIo_, [storage, indicator]() {
+        (*storage)[indicator]++;
+    });
 }
 
 void VideoStreamImpl::publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments)
@@ -352,8 +707,7 @@ void VideoStreamImpl::publishManifest(ndn::Name dataName, PublishedDataPtrVector
     dataName.append(NameComponents::NameComponentManifest).appendVersion(0);
     PublishedDataPtrVector ss = metadataPublisher_->publish(dataName, m);
 
-    LogDebugC << (busyPublishing_ == 1 ? "⤷" : "↓")
-              << " published manifest ☆ (" << dataName.getSubName(-5, 5) << ")x"
+    LogDebugC << "↓ published manifest ☆ (" << dataName.getSubName(-5, 5) << ")x"
               << ss.size() << std::endl;
 }
 
@@ -8,10 +8,12 @@
 #ifndef __video_stream_impl_h__
 #define __video_stream_impl_h__
 
+#include <deque>
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/atomic.hpp>
+#include <boost/make_shared.hpp>
 
 #include "interfaces.hpp"
 #include "media-stream-base.hpp"
@@ -19,6 +21,7 @@
 #include "packet-publisher.hpp"
 #include "frame-converter.hpp"
 #include "estimators.hpp"
+#include "publish-stage.hpp"
 
 namespace ndn
 {
@@ -36,7 +39,6 @@ class Logger;
 namespace ndnrtc
 {
 class VideoThread;
-class FrameScaler;
 class VideoThreadParams;
 struct Mutable;
 template <typename T>
@@ -54,9 +56,14 @@ class VideoStreamImpl : public MediaStreamBase
 
     int incomingFrame(const ArgbRawFrameWrapper &);
     int incomingFrame(const I420RawFrameWrapper &);
+    int incomingFrame(const I420RawFrameWrapper &, boost::function<void(void)> onReleased);
     int incomingFrame(const YUV_NV21FrameWrapper &);
     
-    const std::map<std::string, FrameInfo>& getLastPublished() { return lastPublished_; }
+    std::map<std::string, FrameInfo> getLastPublished() const
+    {
+        boost::lock_guard<boost::mutex> scopedLock(internalMutex_);
+        return lastPublished_;
+    }
     void setLogger(boost::shared_ptr<ndnlog::new_api::Logger>) override;
 
   private:
@@ -65,6 +72,17 @@ class VideoStreamImpl : public MediaStreamBase
 
     VideoStreamImpl(const VideoStreamImpl &stream) = delete;
 
+    // frame captured at the same time for all threads; batches are published
+    // in capture order, once every thread has encoded or dropped its frame
+    struct EncodeBatch;
+    // encoded frames are published by a pipeline of stages: FEC (fecStage_),
+    // segmenting (face thread), signing (signStage_) and cache insert (face
+    // thread); stages of consecutive frames overlap
+    struct PublishJob;
+    struct PublishSlot;
+    struct PublishSlots;
+    typedef std::vector<std::pair<std::string, boost::shared_ptr<VideoThread>>> VideoThreadList;
+
     class MetaKeeper : public MediaStreamBase::BaseMetaKeeper<VideoThreadMeta>
     {
       public:
@@ -90,24 +108,66 @@ class VideoStreamImpl : public MediaStreamBase
         uint32_t versionNumber_;
     };
 
+    // latency of one publishing stage: average and 95th percentile
+    class StageLatency
+    {
+      public:
+        StageLatency(statistics::Indicator average, statistics::Indicator percentile)
+            : averageIndicator_(average), percentileIndicator_(percentile),
+              average_(boost::make_shared<estimators::SampleWindow>(30)),
+              percentile_(boost::make_shared<estimators::SampleWindow>(100), 0.95) {}
+
+        void newValue(double latencyMs, statistics::StatisticsStorage &storage)
+        {
+            average_.newValue(latencyMs);
+            percentile_.newValue(latencyMs);
+            storage[averageIndicator_] = average_.value();
+            storage[percentileIndicator_] = percentile_.value();
+        }
+
+      private:
+        statistics::Indicator averageIndicator_, percentileIndicator_;
+        estimators::Average average_;
+        estimators::Percentile percentile_;
+    };
+
     bool fecEnabled_;
-    boost::atomic<int> busyPublishing_;
     RawFrameConverter conv_;
     std::map<std::string, boost::shared_ptr<VideoThread>> threads_;
-    std::map<std::string, boost::shared_ptr<FrameScaler>> scalers_;
     std::map<std::string, boost::shared_ptr<MetaKeeper>> metaKeepers_;
     std::map<std::string, std::pair<uint64_t, uint64_t>> seqCounters_;
-    uint64_t playbackCounter_;
+    boost::atomic<uint64_t> playbackCounter_;
     boost::shared_ptr<VideoPacketPublisher> framePublisher_;
+    ParityBufferPool parityPool_;
+    estimators::Average publishLatency_, captureLatency_;
+    StageLatency encodeLatency_, fecLatency_, signLatency_, cacheLatency_;
+    boost::shared_ptr<PublishSlots> publishSlots_;
+    boost::shared_ptr<PublishStage> fecStage_, signStage_;
+    std::deque<boost::shared_ptr<EncodeBatch>> encodeBatches_;
     std::map<std::string, FrameInfo> lastPublished_;
 
     void add(const MediaThreadParams *params) override;
     void remove(const std::string &threadName) override;
     bool updateMeta() override;
 
+    void stop();
+
     bool feedFrame(const WebRtcVideoFrame &frame);
-    void publish(std::map<std::string, boost::shared_ptr<VideoFramePacketAlias>> &frames);
-    std::string publish(const std::string &thread, boost::shared_ptr<VideoFramePacketAlias> &fp);
+    void encodeCascade(boost::shared_ptr<EncodeBatch> batch, boost::shared_ptr<VideoThreadList> cascade,
+                       size_t level, const WebRtcVideoFrame &frame);
+    void onFrameEncoded(boost::shared_ptr<EncodeBatch> batch, std::string thread,
+                        const boost::shared_ptr<VideoFramePacketAlias> &fp, unsigned char gopPos);
+    void publishEncoded(const boost::shared_ptr<EncodeBatch> &batch, const std::string &thread,
+                        const boost::shared_ptr<VideoFramePacketAlias> &fp, unsigned char gopPos);
+    void publish(const boost::shared_ptr<EncodeBatch> &batch);
+    std::string publish(const std::string &thread, boost::shared_ptr<VideoFramePacketAlias> &fp,
+                        unsigned char gopPos, const boost::shared_ptr<EncodeBatch> &batch,
+                        const boost::shared_ptr<PublishSlot> &slot);
+    void computeParity(PublishJob &job);
+    void sliceFrame(const boost::shared_ptr<PublishJob> &job);
+    void signFrame(PublishJob &job);
+    void cacheFrame(const boost::shared_ptr<PublishJob> &job);
+    void countFrame(statistics::Indicator indicator);
     void publishManifest(ndn::Name dataName, PublishedDataPtrVector &segments);
     std::map<std::string, PacketNumber> getCurrentSyncList(bool forKey = false);
 };
@@ -8,7 +8,9 @@
 //  Author:  Peter Gusev
 //
 
+#include <algorithm>
 #include <boost/make_shared.hpp>
+#include <boost/bind.hpp>
 #include <ndn-cpp/data.hpp>
 
 #include "video-thread.hpp"
@@ -20,15 +22,21 @@ using namespace ndnrtc;
 using namespace webrtc;
 
 //******************************************************************************
-VideoThread::VideoThread(const VideoCoderParams &coderParams)
+VideoThread::VideoThread(const VideoCoderParams &coderParams, size_t maxQueueSize)
     : coder_(coderParams, this, VideoCoder::KeyEnforcement::Gop),
-      nEncoded_(0), nDropped_(0)
+      scaler_(coderParams.encodeWidth_, coderParams.encodeHeight_),
+      nEncoded_(0), nDropped_(0), nQueueDropped_(0),
+      packetPool_(boost::make_shared<VideoFramePacketPool>()),
+      maxQueueSize_(std::max<size_t>(1, maxQueueSize)),
+      stopped_(false)
 {
     description_ = "vthread";
+    worker_ = boost::thread(boost::bind(&VideoThread::work, this));
 }
 
 VideoThread::~VideoThread()
 {
+    stop();
 }
 
 //******************************************************************************
@@ -39,8 +47,89 @@ VideoThread::encode(const WebRtcVideoFrame &frame)
     coder_.onRawFrame(frame);
     // result should be delivered using onEncodedFrame or onDroppedFrame
     // callbacks which prepare videoFramePacket_ accordingly
-    // here, we just need to return this packet back to a caller
-    return boost::move(videoFramePacket_);
+    // here, we just need to return this packet back to a caller; thread must
+    // not keep a reference to it, otherwise packet never returns to the pool
+    boost::shared_ptr<VideoFramePacket> packet;
+    packet.swap(videoFramePacket_);
+    return packet;
+}
+
+bool VideoThread::encodeAsync(const WebRtcVideoFrame &frame, OnFrameEncoded onEncoded,
+                              OnFrameScaled onScaled)
+{
+    std::vector<OnFrameEncoded> dropped;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(queueMutex_);
+
+        if (stopped_)
+            dropped.push_back(onEncoded);
+        else
+        {
+            while (queue_.size() >= maxQueueSize_)
+            {
+                dropped.push_back(queue_.front().onEncoded_);
+                queue_.pop_front();
+            }
+            queue_.push_back(QueuedFrame(frame, onEncoded, onScaled));
+            queueCv_.notify_one();
+        }
+    }
+
+    // callbacks are not called under queue lock, as they may queue new frames
+    for (auto &cb : dropped)
+    {
+        nQueueDropped_++;
+        LogWarnC << "⨂ encoder is busy, dropped queued frame" << std::endl;
+        cb(boost::shared_ptr<VideoFramePacket>(), 0);
+    }
+
+    return (dropped.size() == 0);
+}
+
+void VideoThread::stop()
+{
+    std::deque<QueuedFrame> dropped;
+    {
+        boost::lock_guard<boost::mutex> scopedLock(queueMutex_);
+        if (stopped_)
+            return;
+
+        stopped_ = true;
+        dropped.swap(queue_);
+        queueCv_.notify_one();
+    }
+
+    if (worker_.joinable())
+        worker_.join();
+
+    for (auto &qf : dropped)
+    {
+        nQueueDropped_++;
+        qf.onEncoded_(boost::shared_ptr<VideoFramePacket>(), 0);
+    }
+}
+
+void VideoThread::work()
+{
+    while (true)
+    {
+        boost::unique_lock<boost::mutex> lock(queueMutex_);
+        queueCv_.wait(lock, [this]() { return stopped_ || queue_.size(); });
+
+        if (stopped_)
+            break;
+
+        QueuedFrame qf(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        WebRtcVideoFrame scaled = scaler_(qf.frame_);
+        if (qf.onScaled_)
+            qf.onScaled_(scaled);
+
+        boost::shared_ptr<VideoFramePacket> packet = encode(scaled);
+        qf.onEncoded_(packet, (unsigned char)coder_.getGopCounter());
+    }
 }
 
 void VideoThread::setDescription(const std::string &desc)
@@ -58,7 +147,7 @@ void VideoThread::onEncodingStarted()
 void VideoThread::onEncodedFrame(const webrtc::EncodedImage &encodedImage)
 {
     nEncoded_++;
-    videoFramePacket_ = boost::make_shared<VideoFramePacket>(encodedImage);
+    videoFramePacket_ = packetPool_->acquire(encodedImage);
 }
 
 void VideoThread::onDroppedFrame()
@@ -11,7 +11,11 @@
 #ifndef __ndnrtc__video_thread__
 #define __ndnrtc__video_thread__
 
+#include <deque>
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 #include "video-coder.hpp"
 
@@ -20,16 +24,61 @@ namespace ndnrtc
 struct Mutable;
 template <typename T>
 class VideoFramePacketT;
-
+class VideoFramePacketPool;
+
+/**
+ * Video thread encodes raw frames into video frame packets. Frames can be
+ * encoded synchronously (encode()) or handed over to thread's worker
+ * (encodeAsync()). These two must not be mixed for the same thread.
+ * Worker scales frames to encoding resolution using thread's own scaler,
+ * so threads scale in parallel. Encoded frames are copied into packets from
+ * thread's pool; packet is reused once all references to it are released.
+ */
 class VideoThread : public NdnRtcComponent,
                     public IEncoderDelegate
 {
   public:
-    VideoThread(const VideoCoderParams &coderParams);
+    /**
+     * Called with encoded packet and its position in GOP, or with null
+     * packet if frame was dropped by encoder or was dropped from the queue.
+     */
+    typedef boost::function<void(const boost::shared_ptr<VideoFramePacketT<Mutable>> &,
+                                 unsigned char gopPos)>
+        OnFrameEncoded;
+    /**
+     * Called on the worker with frame scaled to encoding resolution, before
+     * it is encoded.
+     */
+    typedef boost::function<void(const WebRtcVideoFrame &)> OnFrameScaled;
+
+    /**
+     * @param coderParams Encoder parameters
+     * @param maxQueueSize Maximum number of frames waiting for the worker;
+     *                     when queue is full, the oldest frame is dropped
+     */
+    VideoThread(const VideoCoderParams &coderParams, size_t maxQueueSize = 1);
     ~VideoThread();
 
     boost::shared_ptr<VideoFramePacketT<Mutable>> encode(const WebRtcVideoFrame &frame);
 
+    /**
+     * Queues frame for scaling and encoding on the worker. Frame pixel buffer
+     * is reference-counted and is not copied. onEncoded is called on the
+     * worker once frame is encoded or dropped by encoder. If frame is pushed
+     * out of the queue by newer frames or by stop(), onEncoded is called
+     * with null packet on the thread that dropped it and onScaled is not
+     * called.
+     * @return false if an older frame was dropped to make room for this one
+     */
+    bool encodeAsync(const WebRtcVideoFrame &frame, OnFrameEncoded onEncoded,
+                     OnFrameScaled onScaled = OnFrameScaled());
+
+    /**
+     * Drops queued frames, waits for the frame being encoded and stops the
+     * worker. Frames passed to encodeAsync() afterwards are dropped.
+     */
+    void stop();
+
     void
         setLogger(boost::shared_ptr<ndnlog::new_api::Logger>);
 
@@ -39,20 +88,53 @@ class VideoThread : public NdnRtcComponent,
     unsigned int
     getDroppedNum() { return nDropped_; }
 
+    unsigned int
+    getQueueDroppedNum() { return nQueueDropped_; }
+
     void
     setDescription(const std::string &desc);
 
     const VideoCoder &
     getCoder() const { return coder_; }
 
+    const FrameScaler &
+    getScaler() const { return scaler_; }
+
+    const VideoFramePacketPool &
+    getPacketPool() const { return *packetPool_; }
+
   private:
+    struct QueuedFrame
+    {
+        QueuedFrame(const WebRtcVideoFrame &frame, OnFrameEncoded onEncoded, OnFrameScaled onScaled)
+            : frame_(frame), onEncoded_(onEncoded), onScaled_(onScaled) {}
+
+        WebRtcVideoFrame frame_;
+        OnFrameEncoded onEncoded_;
+        OnFrameScaled onScaled_;
+    };
+
     VideoThread(const VideoThread &) = delete;
     VideoCoder coder_;
+    FrameScaler scaler_;
     unsigned int nEncoded_, nDropped_;
+    boost::atomic<unsigned int> nQueueDropped_;
 
 #warning using shared pointer here as libstdc++ on OSX does not support std::move
     // TODO: update code to use std::move on Ubuntu
     boost::shared_ptr<VideoFramePacketT<Mutable>> videoFramePacket_;
+    // encoded frames are copied into recycled packets
+    boost::shared_ptr<VideoFramePacketPool> packetPool_;
+
+    size_t maxQueueSize_;
+    bool stopped_;
+    std::deque<QueuedFrame> queue_;
+    boost::mutex queueMutex_;
+    boost::condition_variable queueCv_;
+    boost::thread worker_;
+
+    void
+    work();
 
     void
     onEncodingStarted();
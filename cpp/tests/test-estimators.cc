@@ -174,6 +174,46 @@ TEST(TestFilter, TestSmoothing)
 }
 
 
+TEST(TestPercentile, TestSampleWindow)
+{
+	Percentile median(boost::make_shared<SampleWindow>(10), 0.5);
+	Percentile p90(boost::make_shared<SampleWindow>(10), 0.9);
+
+	for (int i = 1; i <= 10; ++i)
+	{
+		median.newValue(i);
+		p90.newValue(i);
+	}
+	EXPECT_EQ(5, median.value());
+	EXPECT_EQ(9, p90.value());
+	EXPECT_EQ(10, median.count());
+
+	// older samples leave the window
+	for (int i = 0; i < 10; ++i)
+	{
+		median.newValue(100+i);
+		p90.newValue(100+i);
+	}
+	EXPECT_EQ(104, median.value());
+	EXPECT_EQ(108, p90.value());
+}
+
+TEST(TestPercentile, TestEdgeValues)
+{
+	Percentile min(boost::make_shared<SampleWindow>(5), 0.);
+	Percentile max(boost::make_shared<SampleWindow>(5), 1.);
+	std::vector<double> values = boost::assign::list_of (5.) (3.) (7.) (1.) (4.);
+
+	EXPECT_EQ(0, min.value());
+	for (auto v:values)
+	{
+		min.newValue(v);
+		max.newValue(v);
+	}
+	EXPECT_EQ(1, min.value());
+	EXPECT_EQ(7, max.value());
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
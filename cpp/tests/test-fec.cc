@@ -0,0 +1,290 @@
+//
+// test-fec.cc
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <boost/chrono.hpp>
+
+#include "gtest/gtest.h"
+#include "tests-helpers.hpp"
+#include "fec.hpp"
+#include "fec-rs28.hpp"
+
+using namespace fec;
+
+namespace {
+    std::vector<uint8_t> randomData(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &b:data) b = rand()%256;
+        return data;
+    }
+
+    std::vector<uint8_t> encodeWith(Backend b, std::vector<uint8_t> &data,
+        unsigned int nData, unsigned int nParity, unsigned int symLen)
+    {
+        std::vector<uint8_t> parity(nParity*symLen, 0);
+        setBackend(b);
+        Rs28Encoder enc(nData, nParity, symLen);
+        EXPECT_EQ(0, enc.encode(data.data(), parity.data()));
+        setBackend(Backend::Native);
+        return parity;
+    }
+}
+
+TEST(TestFec, TestNativeParityMatchesOpenFec)
+{
+    unsigned int symLen = 1000;
+    std::vector<std::pair<unsigned int, unsigned int>> configs = {{1,1}, {5,3}, {10,2}, {30,15}, {100,50}};
+
+    for (auto c:configs)
+    {
+        std::vector<uint8_t> data = randomData(c.first*symLen);
+        std::vector<uint8_t> openFecParity = encodeWith(Backend::OpenFec, data, c.first, c.second, symLen);
+        std::vector<uint8_t> nativeParity = encodeWith(Backend::Native, data, c.first, c.second, symLen);
+
+        EXPECT_EQ(openFecParity, nativeParity);
+    }
+}
+
+TEST(TestFec, TestEncodeShortData)
+{
+    unsigned int nData = 10, nParity = 5, symLen = 100;
+    // data ends in the middle of a symbol, several symbols before the last one
+    std::vector<size_t> lengths = {1, 50, 250, 500, 999};
+
+    for (int b = 0; b < 2; ++b)
+        for (auto dataLength:lengths)
+        {
+            Backend backend = (b ? Backend::Native : Backend::OpenFec);
+            std::vector<uint8_t> data = randomData(dataLength);
+            std::vector<uint8_t> padded(data);
+            padded.resize(nData*symLen, 0);
+
+            std::vector<uint8_t> expectedParity = encodeWith(backend, padded, nData, nParity, symLen);
+            std::vector<uint8_t> parity(nParity*symLen, 0);
+
+            setBackend(backend);
+            Rs28Encoder enc(nData, nParity, symLen);
+            EXPECT_EQ(0, enc.encode(data.data(), data.size(), parity.data()));
+            setBackend(Backend::Native);
+
+            EXPECT_EQ(expectedParity, parity);
+        }
+}
+
+TEST(TestFec, TestCrossDecode)
+{
+    unsigned int nData = 20, nParity = 10, symLen = 500;
+
+    for (int encBackend = 0; encBackend < 2; ++encBackend)
+    {
+        Backend encB = (encBackend ? Backend::Native : Backend::OpenFec);
+        Backend decB = (encBackend ? Backend::OpenFec : Backend::Native);
+        std::vector<uint8_t> data = randomData(nData*symLen);
+        std::vector<uint8_t> parity = encodeWith(encB, data, nData, nParity, symLen);
+        std::vector<uint8_t> received(data);
+        std::vector<uint8_t> rList(nData+nParity, FEC_RLIST_SYMREADY);
+
+        for (int i = 0; i < nParity; i += 2)
+        {
+            memset(&received[(i*3%nData)*symLen], 0, symLen);
+            rList[i*3%nData] = FEC_RLIST_SYMEMPTY;
+        }
+
+        setBackend(decB);
+        Rs28Decoder dec(nData, nParity, symLen);
+        EXPECT_LE(0, dec.decode(received.data(), parity.data(), rList.data()));
+        setBackend(Backend::Native);
+
+        EXPECT_EQ(data, received);
+        for (int i = 0; i < nData; ++i)
+            EXPECT_NE(FEC_RLIST_SYMEMPTY, rList[i]);
+    }
+}
+
+TEST(TestFec, TestDecodeWithLoss)
+{
+    unsigned int nData = 10, nParity = 5, symLen = 100;
+    std::vector<uint8_t> data = randomData(nData*symLen);
+    std::vector<uint8_t> parity = encodeWith(Backend::Native, data, nData, nParity, symLen);
+
+    { // as many losses as there are parity segments
+        std::vector<uint8_t> received(data);
+        std::vector<uint8_t> rList(nData+nParity, FEC_RLIST_SYMREADY);
+        for (int i = 0; i < nParity; ++i)
+        {
+            memset(&received[(2*i)*symLen], 0, symLen);
+            rList[2*i] = FEC_RLIST_SYMEMPTY;
+        }
+
+        Rs28Codec codec(nData, nParity, symLen);
+        EXPECT_EQ(nParity, codec.decode(received.data(), parity.data(), rList.data()));
+        EXPECT_EQ(data, received);
+        for (int i = 0; i < nParity; ++i)
+            EXPECT_EQ(FEC_RLIST_SYMREPAIRED, rList[2*i]);
+    }
+    { // data and parity losses
+        std::vector<uint8_t> received(data);
+        std::vector<uint8_t> rList(nData+nParity, FEC_RLIST_SYMREADY);
+        memset(&received[3*symLen], 0, symLen);
+        memset(&received[7*symLen], 0, symLen);
+        rList[3] = rList[7] = rList[nData] = rList[nData+4] = FEC_RLIST_SYMEMPTY;
+
+        Rs28Decoder dec(nData, nParity, symLen);
+        EXPECT_EQ(4, dec.decode(received.data(), parity.data(), rList.data()));
+        EXPECT_EQ(data, received);
+    }
+    { // not enough parity
+        std::vector<uint8_t> received(data);
+        std::vector<uint8_t> rList(nData+nParity, FEC_RLIST_SYMREADY);
+        for (int i = 0; i <= nParity; ++i)
+            rList[i] = FEC_RLIST_SYMEMPTY;
+
+        Rs28Codec codec(nData, nParity, symLen);
+        EXPECT_EQ(-1, codec.decode(received.data(), parity.data(), rList.data()));
+    }
+}
+
+TEST(TestFec, TestSimdLevelsAgree)
+{
+    // odd symbol length to exercise scalar tails of vector loops
+    unsigned int nData = 17, nParity = 9, symLen = 1037;
+    std::vector<uint8_t> data = randomData(nData*symLen);
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar, SimdLevel::Ssse3, SimdLevel::Avx2};
+    std::vector<uint8_t> reference;
+
+    for (auto l:levels)
+    {
+        setSimdLevel(l);
+
+        std::vector<uint8_t> parity(nParity*symLen, 0);
+        Rs28Codec codec(nData, nParity, symLen);
+        EXPECT_EQ(0, codec.encode(data.data(), parity.data()));
+
+        if (reference.empty()) reference = parity;
+        EXPECT_EQ(reference, parity);
+    }
+
+    setSimdLevel(SimdLevel::Auto);
+
+    for (int c = 0; c < 256; ++c)
+        for (int x = 0; x < 256; ++x)
+        {
+            uint8_t dst = 0, src = x;
+            gf256::addmul(&dst, &src, c, 1);
+            ASSERT_EQ(gf256::mul(c, x), dst);
+            if (c) ASSERT_EQ(1, gf256::mul(c, gf256::inv(c)));
+        }
+}
+
+TEST(TestFec, TestCoderCache)
+{
+    unsigned int nData = 12, nParity = 3, symLen = 1000;
+    size_t dataLength = nData*symLen - 333;
+    std::vector<uint8_t> data = randomData(nData*symLen);
+    Rs28CoderCache cache;
+
+    memset(&data[dataLength], 0, nData*symLen - dataLength);
+    std::vector<uint8_t> parity = encodeWith(Backend::OpenFec, data, nData, nParity, symLen);
+
+    for (int b = 0; b < 2; ++b)
+    {
+        setBackend(b ? Backend::Native : Backend::OpenFec);
+        for (int i = 0; i < 3; ++i)
+        {
+            // encoder session is reused and data is not padded by caller
+            std::vector<uint8_t> p(nParity*symLen, 0);
+            EXPECT_EQ(0, cache.getEncoder(nData, nParity, symLen).encode(data.data(), dataLength, p.data()));
+            EXPECT_EQ(parity, p);
+        }
+    }
+    setBackend(Backend::Native);
+
+    EXPECT_EQ(&cache.getEncoder(nData, nParity, symLen), &cache.getEncoder(nData, nParity, symLen));
+    EXPECT_NE(&cache.getEncoder(nData, nParity, symLen), &cache.getEncoder(nData, nParity+1, symLen));
+    EXPECT_EQ(2, cache.getMissesNum());
+    EXPECT_EQ(8, cache.getHitsNum());
+
+    for (int b = 0; b < 2; ++b)
+    {
+        setBackend(b ? Backend::Native : Backend::OpenFec);
+        for (int i = 0; i < 3; ++i)
+        {
+            std::vector<uint8_t> received(data);
+            std::vector<uint8_t> rList(nData+nParity, FEC_RLIST_SYMREADY);
+            rList[i] = rList[i+5] = FEC_RLIST_SYMEMPTY;
+            memset(&received[i*symLen], 0, symLen);
+            memset(&received[(i+5)*symLen], 0, symLen);
+
+            EXPECT_LE(0, cache.getDecoder(nData, nParity, symLen).decode(received.data(), parity.data(), rList.data()));
+            EXPECT_EQ(data, received);
+        }
+    }
+    setBackend(Backend::Native);
+
+    EXPECT_EQ(3, cache.size());
+    cache.clear();
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST(TestFec, TestBenchmarkEncode)
+{
+    typedef boost::chrono::high_resolution_clock Clock;
+    unsigned int nData = 30, nParity = 15, symLen = 1000, nRuns = 200;
+    std::vector<uint8_t> data = randomData(nData*symLen);
+    std::vector<uint8_t> parity(nParity*symLen, 0);
+
+    std::vector<std::pair<std::string, SimdLevel>> levels = {
+        {"native scalar", SimdLevel::Scalar},
+        {"native ssse3", SimdLevel::Ssse3},
+        {"native avx2", SimdLevel::Avx2}};
+
+    GT_PRINTF("encoding %d data segments of %d bytes into %d parity segments:\n",
+        nData, symLen, nParity);
+
+    {
+        setBackend(Backend::OpenFec);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < nRuns; ++i)
+        {
+            Rs28Encoder enc(nData, nParity, symLen);
+            enc.encode(data.data(), parity.data());
+        }
+        double us = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/nRuns;
+        GT_PRINTF("openfec: %.2f us/frame (%.1f MB/s)\n", us, (double)(nData*symLen)/us);
+        setBackend(Backend::Native);
+    }
+
+    for (auto l:levels)
+    {
+        setSimdLevel(l.second);
+        if (getSimdLevel() != l.second)
+        {
+            GT_PRINTF("%s: not supported by CPU\n", l.first.c_str());
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < nRuns; ++i)
+        {
+            Rs28Encoder enc(nData, nParity, symLen);
+            enc.encode(data.data(), parity.data());
+        }
+        double us = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/nRuns;
+        GT_PRINTF("%s: %.2f us/frame (%.1f MB/s)\n", l.first.c_str(), us, (double)(nData*symLen)/us);
+    }
+
+    setSimdLevel(SimdLevel::Auto);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <algorithm>
 #include <ctime>
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/name.hpp>
@@ -511,6 +513,43 @@ TEST(TestBufferSlot, TestReuseSlot)
 	}
 }
 
+TEST(TestBufferSlot, TestBenchmarkSegmentReceived)
+{
+	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d/%FE%07";
+	std::vector<int> segmentNums = {10, 50, 100, 200};
+	int nRuns = 200;
+
+	for (auto nSeg:segmentNums)
+	{
+		VideoFramePacket vp = getVideoFramePacket(nSeg*VideoFrameSegment::payloadLength(1000)-100);
+		std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+		std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(frameName, segments);
+		std::vector<boost::shared_ptr<Interest>> interests = getInterests(frameName, 0, dataObjects.size());
+		std::vector<boost::shared_ptr<const Interest>> constInterests = makeInterestsConst(interests);
+		std::vector<boost::shared_ptr<WireSegment>> wireSegments;
+
+		for (int i = 0; i < dataObjects.size(); ++i)
+			wireSegments.push_back(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+
+		BufferSlot slot;
+		TPoint t1 = Clock::now();
+		for (int r = 0; r < nRuns; ++r)
+		{
+			slot.clear();
+			slot.segmentsRequested(constInterests);
+			for (auto& s:wireSegments)
+				slot.segmentReceived(s);
+		}
+		TPoint t2 = Clock::now();
+		EXPECT_EQ(BufferSlot::Ready, slot.getState());
+		EXPECT_EQ(wireSegments.size(), slot.getFetchedNum());
+
+		double usec = (double)lib_chrono::duration_cast<lib_chrono::microseconds>(t2-t1).count()/(double)nRuns;
+		GT_PRINTF("%lu segments: BufferSlot (request+receive) %.2fus per frame, %.3fus per segment\n",
+			wireSegments.size(), usec, usec/(double)wireSegments.size());
+	}
+}
+
 TEST(TestVideoFrameSlot, TestAsembleVideoFrame)
 {
 	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d/%FE%07";
@@ -692,6 +731,67 @@ TEST(TestVideoFrameSlot, TestAssembleVideoFrameRecover2)
 	EXPECT_TRUE(videoPacket.get());
 }
 
+TEST(TestVideoFrameSlot, TestBenchmarkReadPacket)
+{
+	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d/%FE%07";
+	std::vector<int> segmentNums = {10, 50, 100, 200};
+	int nRuns = 200;
+
+	for (auto nSeg:segmentNums)
+	{
+		VideoFramePacket vp = getVideoFramePacket(nSeg*VideoFrameSegment::payloadLength(1000)-100);
+
+		boost::shared_ptr<NetworkData> parity;
+		std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+		std::vector<VideoFrameSegment> paritySegments = sliceParity(vp, parity);
+		std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(frameName, segments);
+		std::vector<boost::shared_ptr<ndn::Data>> parityObjects = dataFromParitySegments(frameName, paritySegments);
+		std::vector<boost::shared_ptr<Interest>> interests = getInterests(frameName, 0, dataObjects.size());
+		std::vector<boost::shared_ptr<Interest>> parityInterests = getInterests(frameName+"/_parity", 0, parityObjects.size());
+
+		// 10% of data segments are lost, all parity segments have arrived
+		size_t nLost = std::max(1, (int)dataObjects.size()/10);
+		ASSERT_LE(nLost, parityObjects.size());
+
+		BufferSlot fullSlot, lossySlot;
+		fullSlot.segmentsRequested(makeInterestsConst(interests));
+		lossySlot.segmentsRequested(makeInterestsConst(interests));
+		lossySlot.segmentsRequested(makeInterestsConst(parityInterests));
+
+		for (int i = 0; i < dataObjects.size(); ++i)
+		{
+			fullSlot.segmentReceived(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+			if (i % (dataObjects.size()/nLost) != 0 || i/(dataObjects.size()/nLost) >= nLost)
+				lossySlot.segmentReceived(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+		}
+		for (int i = 0; i < parityObjects.size(); ++i)
+			lossySlot.segmentReceived(boost::make_shared<WireData<VideoFrameSegmentHeader>>(parityObjects[i], parityInterests[i]));
+
+		VideoFrameSlot videoSlot;
+		bool recovered = false;
+		TPoint t1 = Clock::now();
+		for (int i = 0; i < nRuns; ++i)
+		{
+			ASSERT_TRUE(videoSlot.readPacket(fullSlot, recovered).get());
+			EXPECT_FALSE(recovered);
+		}
+		TPoint t2 = Clock::now();
+		for (int i = 0; i < nRuns; ++i)
+		{
+			ASSERT_TRUE(videoSlot.readPacket(lossySlot, recovered).get());
+			EXPECT_TRUE(recovered);
+		}
+		TPoint t3 = Clock::now();
+
+		EXPECT_TRUE(checkVideoFrame(videoSlot.readPacket(lossySlot, recovered)->getFrame()));
+
+		GT_PRINTF("%lu data segments (%lu parity): no loss %.2fus per frame, %lu lost %.2fus per frame\n",
+			dataObjects.size(), parityObjects.size(),
+			(double)lib_chrono::duration_cast<lib_chrono::microseconds>(t2-t1).count()/(double)nRuns, nLost,
+			(double)lib_chrono::duration_cast<lib_chrono::microseconds>(t3-t2).count()/(double)nRuns);
+	}
+}
+
 TEST(TestAudioBundleSlot, TestAssembleAudioBundle)
 {
     int data_len = 247;
@@ -860,6 +960,252 @@ TEST(TestBuffer, TestRequestAndReceive)
     EXPECT_EQ(poolSize, (*storage)[Indicator::AssembledNum]);
 }
 
+TEST(TestBuffer, TestReceiptSnapshot)
+{
+	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d";
+	boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	Buffer buffer(storage, boost::make_shared<SlotPool>(10));
+
+	VideoFramePacket vp = getVideoFramePacket();
+	std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+	Name n(frameName);
+	n.appendSequenceNumber(0);
+	std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(n.toUri(), segments);
+	std::vector<boost::shared_ptr<const Interest>> interests;
+	for (auto d:dataObjects)
+		interests.push_back(boost::make_shared<const Interest>(d->getName(), 1000));
+	EXPECT_TRUE(buffer.requested(interests));
+
+	BufferReceipt rcpt;
+	for (auto d:dataObjects)
+	{
+		boost::shared_ptr<ndn::Interest> interest(boost::make_shared<ndn::Interest>(n,1000));
+		rcpt = buffer.received(boost::make_shared<WireData<VideoFrameSegmentHeader>>(d, interest));
+		if (rcpt.newState_ != BufferSlot::Ready)
+		{
+			EXPECT_FALSE(rcpt.header_.get());
+			EXPECT_EQ(0, rcpt.missingSegments_.size());
+		}
+	}
+
+	ASSERT_EQ(BufferSlot::Ready, rcpt.newState_);
+	ASSERT_TRUE(rcpt.header_.get());
+	EXPECT_DOUBLE_EQ(24.7, rcpt.header_->sampleRate_);
+	EXPECT_TRUE(rcpt.isCurrent());
+
+	// slot goes back to the pool and is cleared, receipt keeps its snapshot
+	buffer.reset();
+	EXPECT_FALSE(rcpt.isCurrent());
+	EXPECT_EQ(BufferSlot::Ready, rcpt.newState_);
+	EXPECT_DOUBLE_EQ(24.7, rcpt.header_->sampleRate_);
+}
+
+TEST(TestBuffer, TestRingOverflow)
+{
+	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d";
+	boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	size_t ringSize = 32;
+	Buffer buffer(storage, boost::make_shared<SlotPool>(100), ringSize);
+
+	for (int i = 0; i < ringSize+1; ++i)
+	{
+		Name n(frameName);
+		n.appendSequenceNumber(i);
+		EXPECT_TRUE(buffer.requested(makeInterestsConst(getInterests(n.toUri(), 0, 5))));
+	}
+
+	// sample 0 was dropped in favor of sample ringSize
+	EXPECT_EQ(ringSize, buffer.getSlotsNum(Name(frameName), BufferSlot::New));
+	EXPECT_EQ(1, (*storage)[Indicator::DroppedNum]);
+	EXPECT_EQ(100-ringSize, buffer.getPool()->size());
+
+	{
+		Name n(frameName);
+		n.appendSequenceNumber(1);
+		EXPECT_EQ(1, buffer.getSlotsNum(n, BufferSlot::New));
+		n = Name(frameName);
+		n.appendSequenceNumber(0);
+		EXPECT_EQ(0, buffer.getSlotsNum(n, BufferSlot::New));
+	}
+
+	buffer.reset();
+	EXPECT_EQ(0, buffer.getSlotsNum(Name(frameName), BufferSlot::New));
+	EXPECT_EQ(100, buffer.getPool()->size());
+}
+
+TEST(TestBuffer, TestSmallRing)
+{
+	std::string frameName = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6/hi/d";
+	boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	// ring can't be smaller than the number of lock shards (16)
+	Buffer buffer(storage, boost::make_shared<SlotPool>(100), 0);
+
+	for (int i = 0; i < 17; ++i)
+	{
+		Name n(frameName);
+		n.appendSequenceNumber(i);
+		EXPECT_TRUE(buffer.requested(makeInterestsConst(getInterests(n.toUri(), 0, 5))));
+	}
+
+	EXPECT_EQ(16, buffer.getSlotsNum(Name(frameName), BufferSlot::New));
+	EXPECT_EQ(1, (*storage)[Indicator::DroppedNum]);
+}
+
+TEST(TestBuffer, TestBenchmarkContention)
+{
+	// each consumer thread requests and receives frames of its own media 
+	// thread in the shared buffer, while playout thread keeps polling it
+	std::string streamPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera/%FC%00%00%01c_%27%DE%D6";
+	std::vector<int> consumerNums = {1, 2, 4, 8};
+	size_t nFrames = 200;
+	VideoFramePacket vp = getVideoFramePacket(20*VideoFrameSegment::payloadLength(1000));
+	std::vector<VideoFrameSegment> frameSegments = sliceFrame(vp);
+
+	for (auto nConsumers:consumerNums)
+	{
+		typedef std::vector<boost::shared_ptr<const Interest>> InterestBatch;
+		typedef std::vector<boost::shared_ptr<WireSegment>> SegmentBatch;
+		std::vector<std::vector<std::pair<InterestBatch, SegmentBatch>>> frames(nConsumers);
+
+		for (int c = 0; c < nConsumers; ++c)
+			for (int f = 0; f < nFrames; ++f)
+			{
+				Name n(streamPrefix);
+				n.append("t"+boost::lexical_cast<std::string>(c)).append(NameComponents::NameComponentDelta).appendSequenceNumber(f);
+				std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(n.toUri(), frameSegments);
+				std::vector<boost::shared_ptr<Interest>> interests = getInterests(n.toUri(), 0, dataObjects.size());
+				SegmentBatch segments;
+
+				for (int i = 0; i < dataObjects.size(); ++i)
+					segments.push_back(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+				frames[c].push_back(std::make_pair(makeInterestsConst(interests), segments));
+			}
+
+		boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+		Buffer buffer(storage, boost::make_shared<SlotPool>(nConsumers*nFrames));
+		boost::atomic<bool> done(false);
+		boost::atomic<int> nPolls(0);
+		// buffer statistics are not synchronized, so assembled frames are
+		// counted here
+		boost::atomic<int> nAssembled(0);
+		std::vector<boost::shared_ptr<boost::thread>> consumers;
+
+		boost::thread playout([&buffer, &done, &nPolls, streamPrefix](){
+			while (!done)
+			{
+				buffer.getSlotsNum(Name(streamPrefix), BufferSlot::New|BufferSlot::Assembling);
+				nPolls++;
+			}
+		});
+
+		TPoint t1 = Clock::now();
+		for (int c = 0; c < nConsumers; ++c)
+			consumers.push_back(boost::make_shared<boost::thread>([&buffer, &frames, &nAssembled, c](){
+				for (auto& f:frames[c])
+				{
+					buffer.requested(f.first);
+					for (auto& s:f.second)
+						if (buffer.isRequested(s))
+						{
+							BufferReceipt r = buffer.received(s);
+							if (r.newState_ == BufferSlot::Ready && r.oldState_ != BufferSlot::Ready)
+								nAssembled++;
+						}
+				}
+			}));
+		for (auto& t:consumers) t->join();
+		TPoint t2 = Clock::now();
+
+		done = true;
+		playout.join();
+
+		EXPECT_EQ(nConsumers*nFrames, nAssembled.load());
+
+		size_t nSegments = nConsumers*nFrames*frameSegments.size();
+		double usec = (double)lib_chrono::duration_cast<lib_chrono::microseconds>(t2-t1).count();
+		GT_PRINTF("%d consumer(s): %lu segments in %.2fms (%.2f segments/ms), %d playout polls\n",
+			nConsumers, nSegments, usec/1000., (double)nSegments/usec*1000., (int)nPolls);
+	}
+}
+
+TEST(TestPlaybackQueue, TestReceiveWhileDropping)
+{
+	// slots are dropped by ring overflow while their last segments are 
+	// being received; playback queue must only get slots that are still 
+	// assembled when they are reserved
+	std::string streamPrefix = "/ndn/edu/ucla/remap/peter/ndncon/instance1/ndnrtc/%FD%03/video/camera";
+	std::string frameName = streamPrefix+"/%FC%00%00%01c_%27%DE%D6/hi/d";
+	size_t ringSize = 16, nFrames = 300;
+	typedef std::vector<boost::shared_ptr<const Interest>> InterestBatch;
+	typedef std::vector<boost::shared_ptr<WireSegment>> SegmentBatch;
+	std::vector<std::pair<InterestBatch, SegmentBatch>> frames;
+
+	for (int f = 0; f < nFrames+ringSize; ++f)
+	{
+		// frames are ordered in playback queue by publish timestamp
+		VideoFramePacket vp = getVideoFramePacket(3*VideoFrameSegment::payloadLength(1000), 30, 488589553+f*33);
+		std::vector<VideoFrameSegment> frameSegments = sliceFrame(vp);
+		Name n(frameName);
+		n.appendSequenceNumber(f);
+		std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(n.toUri(), frameSegments);
+		std::vector<boost::shared_ptr<Interest>> interests = getInterests(n.toUri(), 0, dataObjects.size());
+		SegmentBatch segments;
+
+		for (int i = 0; i < dataObjects.size(); ++i)
+			segments.push_back(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+		frames.push_back(std::make_pair(makeInterestsConst(interests), segments));
+	}
+
+	boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+	boost::shared_ptr<Buffer> buffer(boost::make_shared<Buffer>(storage, 
+		boost::make_shared<SlotPool>(nFrames+2*ringSize), ringSize));
+	boost::shared_ptr<PlaybackQueue> pqueue(boost::make_shared<PlaybackQueue>(Name(streamPrefix), buffer));
+	boost::atomic<int> lastRequested(-1), lastReceived(-1), nFailures(0);
+
+	// requesting frame f drops frame f-ringSize, which is being received
+	boost::thread requester([&](){
+		for (int f = 0; f < frames.size(); ++f)
+		{
+			while (lastReceived < f-(int)ringSize-1) boost::this_thread::yield();
+			buffer->requested(frames[f].first);
+			lastRequested = f;
+		}
+	});
+	boost::thread receiver([&](){
+		for (int f = 0; f < nFrames; ++f)
+		{
+			while (lastRequested < f) boost::this_thread::yield();
+			for (auto& s:frames[f].second)
+				try
+				{
+					buffer->received(s);
+				}
+				catch (std::runtime_error& e)
+				{
+					// frame was dropped before segment arrived
+					if (std::string(e.what()).find("not previously requested") == std::string::npos)
+						nFailures++;
+				}
+			lastReceived = f;
+		}
+	});
+	requester.join();
+	receiver.join();
+
+	EXPECT_EQ(0, nFailures);
+
+	int nQueued = 0;
+	while (pqueue->size())
+		pqueue->pop([&nQueued](const boost::shared_ptr<const BufferSlot>& slot, double){
+			EXPECT_EQ(BufferSlot::Locked, slot->getState());
+			EXPECT_NO_THROW(slot->getHeader());
+			nQueued++;
+		});
+
+	GT_PRINTF("%d frames queued, %d dropped\n", nQueued, (int)(*storage)[Indicator::DroppedNum]);
+	EXPECT_LT(0, nQueued);
+}
+
 //******************************************************************************
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
@@ -9,6 +9,7 @@
 
 #include "gtest/gtest.h"
 #include "frame-converter.hpp"
+#include "tests-helpers.hpp"
 
 using namespace ndnrtc;
 
@@ -42,6 +43,132 @@ TEST(TestFrameConverter, TestI420Frame)
 	EXPECT_EQ(h, frame.height());
 }
 
+TEST(TestFrameConverter, TestI420FrameStrides)
+{
+	// caller's planes are padded, converted frame has default strides
+	unsigned int w = 6, h = 4, strideY = 8, strideUV = 4;
+	std::vector<uint8_t> ybuf(strideY*h), ubuf(strideUV*h/2), vbuf(strideUV*h/2);
+	for (int i = 0; i < ybuf.size(); ++i) ybuf[i] = i;
+	for (int i = 0; i < ubuf.size(); ++i) ubuf[i] = 100+i;
+	for (int i = 0; i < vbuf.size(); ++i) vbuf[i] = 200+i;
+
+	RawFrameConverter conv;
+	WebRtcVideoFrame frame = conv << I420RawFrameWrapper({w,h,strideY, strideUV, strideUV, 
+		ybuf.data(), ubuf.data(), vbuf.data()});
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = frame.video_frame_buffer();
+
+	ASSERT_EQ(w, buffer->StrideY());
+	for (int row = 0; row < h; ++row)
+		for (int col = 0; col < w; ++col)
+			EXPECT_EQ(ybuf[row*strideY+col], buffer->DataY()[row*buffer->StrideY()+col]);
+	for (int row = 0; row < h/2; ++row)
+		for (int col = 0; col < w/2; ++col)
+		{
+			EXPECT_EQ(ubuf[row*strideUV+col], buffer->DataU()[row*buffer->StrideU()+col]);
+			EXPECT_EQ(vbuf[row*strideUV+col], buffer->DataV()[row*buffer->StrideV()+col]);
+		}
+}
+
+TEST(TestFrameConverter, TestWrapI420Frame)
+{
+	unsigned int w = 640, h = 480, strideY = 640, strideUV = 320;
+	std::vector<uint8_t> ybuf(strideY*h), ubuf(strideUV*h/2), vbuf(strideUV*h/2);
+	int nReleased = 0;
+
+	{
+		WebRtcVideoFrame frame = RawFrameConverter::wrap(I420RawFrameWrapper({w,h,strideY, strideUV, strideUV, 
+			ybuf.data(), ubuf.data(), vbuf.data()}), [&nReleased](){ nReleased++; });
+
+		EXPECT_EQ(w, frame.width());
+		EXPECT_EQ(h, frame.height());
+		EXPECT_EQ(ybuf.data(), frame.video_frame_buffer()->DataY());
+		EXPECT_EQ(ubuf.data(), frame.video_frame_buffer()->DataU());
+		EXPECT_EQ(vbuf.data(), frame.video_frame_buffer()->DataV());
+
+		{
+			WebRtcVideoFrame copy(frame);
+			EXPECT_EQ(ybuf.data(), copy.video_frame_buffer()->DataY());
+		}
+		// caller's planes are still in use
+		EXPECT_EQ(0, nReleased);
+	}
+
+	EXPECT_EQ(1, nReleased);
+}
+
+TEST(TestFrameConverter, TestPooledBuffers)
+{
+	unsigned int w = 640, h = 480, size = w*h*4;
+	std::vector<uint8_t> data(size);
+	RawFrameConverter conv;
+
+	{ // frames that are released give buffers back
+		for (int i = 0; i < 10; ++i)
+			WebRtcVideoFrame frame = conv << ArgbRawFrameWrapper({w,h,data.data(),size,true});
+		EXPECT_EQ(1, conv.getAllocatedNum());
+	}
+	{ // frames that are held keep their buffers
+		std::vector<WebRtcVideoFrame> frames;
+		for (int i = 0; i < 3; ++i)
+			frames.push_back(conv << ArgbRawFrameWrapper({w,h,data.data(),size,true}));
+		EXPECT_EQ(3, conv.getAllocatedNum());
+		EXPECT_NE(frames[0].video_frame_buffer().get(), frames[1].video_frame_buffer().get());
+		EXPECT_NE(frames[1].video_frame_buffer().get(), frames[2].video_frame_buffer().get());
+	}
+	{ // frame size changes
+		WebRtcVideoFrame frame = conv << ArgbRawFrameWrapper({w/2,h/2,data.data(),size/4,true});
+		EXPECT_EQ(w/2, frame.width());
+		EXPECT_EQ(4, conv.getAllocatedNum());
+	}
+}
+
+TEST(TestFrameConverter, TestAllocationsPerFrame)
+{
+	int nFrames = 100;
+	unsigned int w = 1280, h = 720;
+	unsigned int strideY = w, strideUV = w/2;
+	std::vector<uint8_t> argb(w*h*4), ybuf(strideY*h), ubuf(strideUV*h/2), vbuf(strideUV*h/2);
+	std::vector<uint8_t> nv21(strideY*h + strideY*h/2);
+	RawFrameConverter conv;
+	int nReleased = 0;
+
+	// warm up pool
+	{
+		WebRtcVideoFrame f = conv << ArgbRawFrameWrapper({w,h,argb.data(),(unsigned int)argb.size(),true});
+	}
+
+	std::vector<std::pair<std::string, boost::function<WebRtcVideoFrame(void)>>> paths = {
+		{ "ARGB", [&](){ 
+			return conv << ArgbRawFrameWrapper({w,h,argb.data(),(unsigned int)argb.size(),true}); }},
+		{ "NV21", [&](){ 
+			return conv << YUV_NV21FrameWrapper({w,h,strideY,strideY,nv21.data(),nv21.data()+strideY*h}); }},
+		{ "I420 copy", [&](){ 
+			return conv << I420RawFrameWrapper({w,h,strideY,strideUV,strideUV,ybuf.data(),ubuf.data(),vbuf.data()}); }},
+		{ "I420 no copy", [&](){ 
+			return RawFrameConverter::wrap(I420RawFrameWrapper({w,h,strideY,strideUV,strideUV,
+				ybuf.data(),ubuf.data(),vbuf.data()}), [&nReleased](){ nReleased++; }); }}
+	};
+
+	for (auto &p : paths)
+	{
+		unsigned int poolAllocated = conv.getAllocatedNum();
+		allocationsNum = 0;
+		countAllocations = true;
+		for (int i = 0; i < nFrames; ++i)
+			WebRtcVideoFrame frame = p.second();
+		countAllocations = false;
+
+		GT_PRINTF("%s: %.2f heap allocations per frame, %d frame buffers allocated\n",
+			p.first.c_str(), (double)allocationsNum/(double)nFrames,
+			conv.getAllocatedNum()-poolAllocated);
+
+		// frame buffers come from the pool or from the caller
+		EXPECT_EQ(poolAllocated, conv.getAllocatedNum());
+	}
+
+	EXPECT_EQ(nFrames, nReleased);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -517,6 +517,99 @@ TEST(TestVideoStream, TestRemoveThreadWhilePublishing)
     }
     t.join();
 }
+
+TEST(TestVideoStream, TestBenchmarkCaptureLatency)
+{
+#ifdef ENABLE_LOGGING
+    ndnlog::new_api::Logger::initAsyncLogging();
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(ndnlog::NdnLoggerDetailLevelAll);
+#endif
+
+    int nFrames = 30 * 10;
+    int width = 1280, height = 720;
+    std::srand(std::time(0));
+    int frameSize = width * height * 4 * sizeof(uint8_t);
+    std::vector<boost::shared_ptr<uint8_t>> frames;
+
+    for (int f = 0; f < 30; ++f)
+    {
+        uint8_t *buf = new uint8_t[frameSize];
+        for (int i = 0; i < frameSize; ++i)
+            buf[i] = std::rand() % 256; // random noise
+        frames.push_back(boost::shared_ptr<uint8_t>(buf));
+    }
+
+    boost::asio::io_service io;
+    boost::asio::deadline_timer runTimer(io);
+    boost::shared_ptr<boost::asio::io_service::work> work(boost::make_shared<boost::asio::io_service::work>(io));
+    boost::thread t([&io]() {
+        io.run();
+    });
+
+    ndn::Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+
+    MediaStreamParams msp = getSampleVideoParams();
+    VideoThreadParams tp("hi", sampleVideoCoderParams());
+    tp.coderParams_.encodeWidth_ = 1280;
+    tp.coderParams_.encodeHeight_ = 720;
+    tp.coderParams_.startBitrate_ = 2000;
+    msp.addMediaThread(tp);
+
+    {
+        MediaStreamSettings settings(io, msp);
+        settings.face_ = &face;
+        settings.keyChain_ = keyChain.get();
+        LocalVideoStream s(appPrefix, settings);
+
+#ifdef ENABLE_LOGGING
+        s.setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+#endif
+        lib_chrono::duration<int, std::nano> captureDuration(0);
+        for (int i = 0; i < nFrames; ++i)
+        {
+            runTimer.expires_from_now(boost::posix_time::milliseconds(1000 / 30));
+            high_resolution_clock::time_point captureStart = high_resolution_clock::now();
+            EXPECT_NO_THROW(s.incomingArgbFrame(width, height, frames[i % frames.size()].get(), frameSize));
+            captureDuration += (high_resolution_clock::now() - captureStart);
+            runTimer.wait();
+        }
+
+        // let the last frames through
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+
+        statistics::StatisticsStorage stats = s.getStatistics();
+        double avgCaptureCallUs = (double)duration_cast<microseconds>(captureDuration).count() / (double)nFrames;
+
+        GT_PRINTF("Captured %.0f frames (%d threads). Encoded %.0f, dropped %.0f, processed %.0f.\n",
+                  stats[statistics::Indicator::CapturedNum], msp.getThreadNum(),
+                  stats[statistics::Indicator::EncodedNum], stats[statistics::Indicator::DroppedNum],
+                  stats[statistics::Indicator::ProcessedNum]);
+        GT_PRINTF("Capture call %.2fus, capture-to-publish latency %.2fms, publish latency %.2fms\n",
+                  avgCaptureCallUs, stats[statistics::Indicator::CaptureLatency],
+                  stats[statistics::Indicator::PublishLatency]);
+        GT_PRINTF("Stage latency avg/p95 (ms): encode %.2f/%.2f, FEC %.2f/%.2f, "
+                  "segment+sign %.2f/%.2f, cache %.2f/%.2f\n",
+                  stats[statistics::Indicator::EncodeLatency], stats[statistics::Indicator::EncodeLatencyP95],
+                  stats[statistics::Indicator::FecLatency], stats[statistics::Indicator::FecLatencyP95],
+                  stats[statistics::Indicator::SignLatency], stats[statistics::Indicator::SignLatencyP95],
+                  stats[statistics::Indicator::CacheLatency], stats[statistics::Indicator::CacheLatencyP95]);
+
+        EXPECT_EQ(nFrames, stats[statistics::Indicator::CapturedNum]);
+        EXPECT_LT(0, stats[statistics::Indicator::ProcessedNum]);
+        EXPECT_LT(0, stats[statistics::Indicator::CaptureLatency]);
+        EXPECT_LT(0, stats[statistics::Indicator::EncodeLatency]);
+        EXPECT_LT(0, stats[statistics::Indicator::FecLatency]);
+        EXPECT_LT(0, stats[statistics::Indicator::SignLatency]);
+        EXPECT_LE(stats[statistics::Indicator::SignLatency], stats[statistics::Indicator::CaptureLatency]);
+        // capturing thread only scales frames and hands them over to workers
+        EXPECT_GE(1000 / 30 * 1000, avgCaptureCallUs);
+
+        work.reset();
+    }
+    t.join();
+}
 #endif
 
 #if 1
@@ -198,6 +198,95 @@ TEST(TestVideoThread, TestEncodeMultipleThreads)
 			seqCounters[i].first, seqCounters[i].second);
 	}
 }
+
+TEST(TestVideoThread, TestEncodeQueue)
+{
+	int nFrames = 60;
+	int width = 1280, height = 720;
+	std::vector<WebRtcVideoFrame> frames = getFrameSequence(width, height, nFrames);
+
+	VideoCoderParams vcp(sampleVideoCoderParams());
+	vcp.startBitrate_ = 1000;
+	vcp.maxBitrate_ = 1000;
+	vcp.encodeWidth_ = width;
+	vcp.encodeHeight_ = height;
+
+	boost::mutex m;
+	boost::condition_variable cv;
+	int nCallbacks = 0, nEncoded = 0, nNull = 0;
+	std::vector<int> order;
+
+	{
+		VideoThread vt(vcp, 2);
+		boost::thread::id callerId = boost::this_thread::get_id();
+		int nRejected = 0;
+
+		// frames come faster than encoder can handle, older ones are dropped
+		for (int i = 0; i < nFrames; ++i)
+		{
+			bool queued = vt.encodeAsync(frames[i], 
+				[i, &m, &cv, &nCallbacks, &nEncoded, &nNull, &order, callerId]
+				(const boost::shared_ptr<VideoFramePacket>& fp, unsigned char gopPos){
+					boost::lock_guard<boost::mutex> lock(m);
+					nCallbacks++;
+					if (fp.get())
+					{
+						EXPECT_NE(callerId, boost::this_thread::get_id());
+						nEncoded++;
+						order.push_back(i);
+					}
+					else
+						nNull++;
+					cv.notify_one();
+				});
+			if (!queued) nRejected++;
+		}
+
+		{
+			boost::unique_lock<boost::mutex> lock(m);
+			cv.wait_for(lock, boost::chrono::seconds(10), [&nCallbacks, nFrames](){ return nCallbacks == nFrames; });
+		}
+
+		EXPECT_EQ(nRejected, vt.getQueueDroppedNum());
+		EXPECT_LT(0, nRejected);
+		EXPECT_EQ(nEncoded, vt.getEncodedNum());
+		EXPECT_LT(0, order.size());
+	}
+
+	EXPECT_EQ(nFrames, nCallbacks);
+	EXPECT_EQ(nFrames, nEncoded + nNull);
+	for (int i = 1; i < order.size(); ++i)
+		EXPECT_LT(order[i-1], order[i]);
+
+	GT_PRINTF("Queued %d frames: %d encoded, %d dropped\n", nFrames, nEncoded, nNull);
+}
+
+TEST(TestVideoThread, TestStopDropsQueued)
+{
+	int width = 640, height = 480;
+	std::vector<WebRtcVideoFrame> frames = getFrameSequence(width, height, 5);
+
+	VideoCoderParams vcp(sampleVideoCoderParams());
+	vcp.encodeWidth_ = width;
+	vcp.encodeHeight_ = height;
+
+	boost::atomic<int> nCallbacks(0);
+	VideoThread vt(vcp, 5);
+	for (auto &f : frames)
+		vt.encodeAsync(f, [&nCallbacks](const boost::shared_ptr<VideoFramePacket>&, unsigned char){
+			nCallbacks++;
+		});
+
+	vt.stop();
+	EXPECT_EQ(frames.size(), nCallbacks);
+
+	// frames given after stop are dropped right away
+	EXPECT_FALSE(vt.encodeAsync(frames[0], [&nCallbacks](const boost::shared_ptr<VideoFramePacket>& fp, unsigned char){
+		EXPECT_FALSE(fp.get());
+		nCallbacks++;
+	}));
+	EXPECT_EQ(frames.size()+1, nCallbacks);
+}
 #endif
 
 TEST(TestAudioThread, TestRunOpusThread)
@@ -7,8 +7,10 @@
 
 #include <stdlib.h>
 #include <boost/regex.hpp>
+#include <boost/chrono.hpp>
 
 #include "gtest/gtest.h"
+#include "tests-helpers.hpp"
 #include "include/name-components.hpp"
 
 using namespace ndnrtc;
@@ -475,6 +477,151 @@ TEST(TestNameComponents, TestSuffixFiltering)
 	}
 }
 #endif
+namespace {
+	const char* Keywords[] = {"ndnrtc", "audio", "video", "_meta", "d", "k", "_parity", "_manifest"};
+
+	NamespaceInfo randomInfo()
+	{
+		NamespaceInfo info;
+		int nBase = 1+rand()%5;
+
+		for (int i = 0; i < nBase; ++i)
+			// base prefix may contain NDN-RTC keywords as well
+			if (rand()%4 == 0)
+				info.basePrefix_.append(std::string(Keywords[rand()%5]));
+			else
+				info.basePrefix_.append("p"+std::to_string(rand()));
+
+		info.apiVersion_ = 1+rand()%5;
+		info.streamType_ = (rand()%2 ? MediaStreamParams::MediaStreamType::MediaStreamTypeAudio :
+			MediaStreamParams::MediaStreamType::MediaStreamTypeVideo);
+		info.streamName_ = "s"+std::to_string(rand()%100);
+		info.threadName_ = "t"+std::to_string(rand()%100);
+		info.streamTimestamp_ = 1500000000000+rand();
+		info.isParity_ = (info.streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeVideo && rand()%3 == 0);
+		info.isDelta_ = (info.streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeAudio || rand()%5);
+		info.class_ = (info.isDelta_ ? SampleClass::Delta : SampleClass::Key);
+		info.segmentClass_ = (info.isParity_ ? SegmentClass::Parity : SegmentClass::Data);
+		info.hasSeqNo_ = info.hasSegNo_ = true;
+		info.sampleNo_ = rand()%100000;
+		info.segNo_ = rand()%50;
+
+		return info;
+	}
+
+	Name::Component randomComponent()
+	{
+		switch (rand()%4) {
+			case 0: return Name::Component(std::string(Keywords[rand()%8]));
+			case 1: return Name::Component::fromNumberWithMarker(rand(), (rand()%2 ? 0xFE : 0xFC));
+			default:
+			{
+				std::vector<uint8_t> value(rand()%10);
+				for (auto& b:value) b = rand()%256;
+				return Name::Component(value);
+			}
+		}
+	}
+
+	Name mutate(const Name& name)
+	{
+		Name mutated;
+		int idx = rand()%name.size();
+
+		switch (rand()%3) {
+			case 0: // replace component
+				for (int i = 0; i < name.size(); ++i)
+					mutated.append(i == idx ? randomComponent() : name[i]);
+				break;
+			case 1: // insert component
+				for (int i = 0; i < name.size(); ++i)
+				{
+					if (i == idx) mutated.append(randomComponent());
+					mutated.append(name[i]);
+				}
+				break;
+			default: // truncate
+				mutated = name.getPrefix(idx);
+				break;
+		}
+
+		return mutated;
+	}
+}
+
+TEST(TestNameComponents, TestFuzzExtraction)
+{
+	srand(0);
+	int nThrown = 0, nParsed = 0, nRuns = 20000;
+
+	for (int i = 0; i < nRuns; ++i)
+	{
+		NamespaceInfo info = randomInfo();
+		Name name = info.getPrefix(prefix_filter::Segment);
+
+		{ // well-formed names must round-trip
+			NamespaceInfo parsed;
+			ASSERT_TRUE(NameComponents::extractInfo(name, parsed)) << name;
+			EXPECT_EQ(info.basePrefix_, parsed.basePrefix_) << name;
+			EXPECT_EQ(info.apiVersion_, parsed.apiVersion_);
+			EXPECT_EQ(info.streamType_, parsed.streamType_);
+			EXPECT_EQ(info.streamName_, parsed.streamName_);
+			EXPECT_EQ(info.threadName_, parsed.threadName_);
+			EXPECT_EQ(info.streamTimestamp_, parsed.streamTimestamp_);
+			EXPECT_EQ(info.isDelta_, parsed.isDelta_);
+			EXPECT_EQ(info.class_, parsed.class_);
+			EXPECT_EQ(info.isParity_, parsed.isParity_);
+			EXPECT_EQ(info.segmentClass_, parsed.segmentClass_);
+			EXPECT_EQ(info.sampleNo_, parsed.sampleNo_);
+			EXPECT_EQ(info.segNo_, parsed.segNo_);
+			EXPECT_FALSE(parsed.isMeta_);
+			EXPECT_EQ(name, parsed.getPrefix(prefix_filter::Segment));
+		}
+		{ // malformed names must be either rejected or parsed, never crash
+			Name mutated = mutate(name);
+			NamespaceInfo parsed;
+
+			try {
+				if (NameComponents::extractInfo(mutated, parsed))
+				{
+					nParsed++;
+					EXPECT_EQ(Name::Component(NameComponents::NameComponentApp), mutated[parsed.basePrefix_.size()]);
+				}
+			}
+			catch (std::runtime_error& e)
+			{
+				nThrown++;
+			}
+		}
+	}
+
+	GT_PRINTF("%d mutated names: %d parsed, %d rejected with exception\n", nRuns, nParsed, nThrown);
+}
+
+TEST(TestNameComponents, TestBenchmarkExtraction)
+{
+	typedef boost::chrono::high_resolution_clock Clock;
+	int nNames = 1000, nRuns = 200;
+	std::vector<Name> names;
+
+	srand(0);
+	for (int i = 0; i < nNames; ++i)
+		names.push_back(randomInfo().getPrefix(prefix_filter::Segment));
+
+	NamespaceInfo info;
+	int nGood = 0;
+	Clock::time_point start = Clock::now();
+
+	for (int r = 0; r < nRuns; ++r)
+		for (auto& n:names)
+			nGood += NameComponents::extractInfo(n, info);
+
+	double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1E6;
+
+	EXPECT_EQ(nNames*nRuns, nGood);
+	GT_PRINTF("parsed %d names in %.3f sec: %.0f parses/sec\n", nNames*nRuns, sec, (double)(nNames*nRuns)/sec);
+}
+
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
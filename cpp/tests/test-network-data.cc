@@ -12,6 +12,7 @@
 #include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
 #include <ndn-cpp/digest-sha256-signature.hpp>
 #include <ndn-cpp/name.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
 
 #include "tests-helpers.hpp"
 #include "gtest/gtest.h"
@@ -735,6 +736,10 @@ TEST(TestDataSegment, TestSlice)
             EXPECT_EQ(wireLength, it->size());
         }
 
+        // wire data must be identical to what getNetworkData() produces
+        EXPECT_EQ(it->getNetworkData()->data(), *it->getWireData());
+        EXPECT_EQ(it->size(), it->getWireData()->size());
+
         EXPECT_EQ(header.interestNonce_ + idx, it->getHeader().interestNonce_);
         EXPECT_EQ(header.interestArrivalMs_ + idx, it->getHeader().interestArrivalMs_);
         EXPECT_EQ(header.generationDelayMs_, it->getHeader().generationDelayMs_);
@@ -860,6 +865,41 @@ TEST(TestVideoFramePacket, TestAddSyncList)
         EXPECT_EQ(buffer[i], fp.getFrame()._buffer[i]);
 }
 
+TEST(TestVideoFramePacket, TestAddSyncListEmptyThread)
+{
+    size_t frameLen = 4300;
+    int32_t size = webrtc::CalcBufferSize(webrtc::kI420, 640, 480);
+    uint8_t *buffer = (uint8_t *)malloc(frameLen);
+    for (int i = 0; i < frameLen; ++i)
+        buffer[i] = i % 255;
+
+    webrtc::EncodedImage frame(buffer, frameLen, size);
+    frame._encodedWidth = 640;
+    frame._encodedHeight = 480;
+    frame._frameType = webrtc::kVideoFrameKey;
+    frame._completeFrame = true;
+
+    VideoFramePacket fp(frame);
+    std::map<std::string, PacketNumber> syncList = boost::assign::map_list_of("", 7)("hi", 341);
+    size_t length = fp.getLength();
+
+    // empty thread name is not written, so no room is reserved for it
+    fp.setSyncList(syncList);
+    EXPECT_EQ(length + DataPacket::wireLength(std::string("hi").size()) +
+                  2 * DataPacket::wireLength(sizeof(PacketNumber)),
+              fp.getLength());
+
+    CommonHeader hdr;
+    hdr.sampleRate_ = 24.7;
+    fp.setHeader(hdr);
+
+    EXPECT_EQ(hdr.sampleRate_, fp.getHeader().sampleRate_);
+    EXPECT_EQ(frame._encodedWidth, fp.getFrame()._encodedWidth);
+    ASSERT_EQ(frameLen, fp.getFrame()._length);
+    for (int i = 0; i < frameLen; ++i)
+        EXPECT_EQ(buffer[i], fp.getFrame()._buffer[i]);
+}
+
 TEST(TestVideoFramePacket, TestFromNetworkData)
 {
     size_t frameLen = 4300;
@@ -1014,6 +1054,186 @@ TEST(TestVideoFramePacket, TestGetParity)
     }
 }
 
+TEST(TestVideoFramePacket, TestGetParityPooled)
+{
+    CommonHeader hdr;
+    hdr.sampleRate_ = 24.7;
+    hdr.publishTimestampMs_ = 488589553;
+    hdr.publishUnixTimestamp_ = 1460488589;
+
+    ParityBufferPool pool;
+    size_t frameLen = 12345;
+    std::vector<uint8_t> buffer(frameLen);
+    for (int i = 0; i < frameLen; ++i)
+        buffer[i] = std::rand() % 256;
+
+    webrtc::EncodedImage frame(buffer.data(), frameLen, frameLen);
+    frame._encodedWidth = 640;
+    frame._encodedHeight = 480;
+    frame._frameType = webrtc::kVideoFrameDelta;
+    frame._completeFrame = true;
+
+    VideoFramePacket vp(frame);
+    std::map<std::string, PacketNumber> syncList = boost::assign::map_list_of("hi", 341)("mid", 433)("low", 432);
+    vp.setSyncList(syncList);
+    vp.setHeader(hdr);
+
+    size_t frameSize = vp.getLength();
+    boost::shared_ptr<NetworkData> parity = vp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2);
+
+    // warm up pool and coder cache
+    vp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2, pool);
+    EXPECT_EQ(1, pool.getMissesNum());
+
+    size_t nFrames = 100;
+    countAllocations = true;
+    allocationsNum = 0;
+    for (int i = 0; i < nFrames; ++i)
+    {
+        boost::shared_ptr<NetworkData> pooledParity = vp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2, pool);
+        if (!pooledParity || pooledParity->data() != parity->data())
+        {
+            countAllocations = false;
+            FAIL() << "pooled parity differs from non-pooled one";
+        }
+    }
+    countAllocations = false;
+
+    EXPECT_EQ(0, allocationsNum.load());
+    EXPECT_EQ(nFrames, pool.getHitsNum());
+    EXPECT_EQ(1, pool.getMissesNum());
+    EXPECT_EQ(1, pool.size());
+    // frame data must stay intact
+    EXPECT_EQ(frameSize, vp.getLength());
+
+    { // buffers which are still referenced are not reused
+        boost::shared_ptr<NetworkData> p1 = vp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2, pool);
+        boost::shared_ptr<NetworkData> p2 = vp.getParityData(VideoFrameSegment::payloadLength(1000), 0.2, pool);
+        EXPECT_NE(p1.get(), p2.get());
+        EXPECT_EQ(2, pool.size());
+    }
+}
+
+TEST(TestVideoFramePacket, TestReset)
+{
+    std::vector<uint8_t> buffer1(4300), buffer2(1200);
+    for (int i = 0; i < buffer1.size(); ++i)
+        buffer1[i] = i % 255;
+    for (int i = 0; i < buffer2.size(); ++i)
+        buffer2[i] = 255 - i % 255;
+
+    webrtc::EncodedImage frame1(buffer1.data(), buffer1.size(), buffer1.size());
+    frame1._encodedWidth = 640;
+    frame1._encodedHeight = 480;
+    frame1._frameType = webrtc::kVideoFrameKey;
+    frame1._completeFrame = true;
+
+    webrtc::EncodedImage frame2(buffer2.data(), buffer2.size(), buffer2.size());
+    frame2._encodedWidth = 320;
+    frame2._encodedHeight = 240;
+    frame2._frameType = webrtc::kVideoFrameDelta;
+    frame2._completeFrame = true;
+
+    CommonHeader hdr;
+    hdr.sampleRate_ = 24.7;
+    hdr.publishTimestampMs_ = 488589553;
+    hdr.publishUnixTimestamp_ = 1460488589;
+    std::map<std::string, PacketNumber> syncList = boost::assign::map_list_of("hi", 341)("mid", 433)("low", 432);
+
+    VideoFramePacket fp(frame1);
+    fp.setSyncList(syncList);
+    fp.setHeader(hdr);
+    size_t capacity = fp.getCapacity();
+
+    fp.reset(frame2);
+    EXPECT_FALSE(fp.isValid());
+    EXPECT_EQ(capacity, fp.getCapacity());
+    EXPECT_TRUE(fp.getSyncList().empty());
+    EXPECT_EQ(frame2._encodedWidth, fp.getFrame()._encodedWidth);
+    EXPECT_EQ(frame2._encodedHeight, fp.getFrame()._encodedHeight);
+    EXPECT_EQ(frame2._frameType, fp.getFrame()._frameType);
+    EXPECT_EQ(frame2._length, fp.getFrame()._length);
+    EXPECT_EQ(buffer2, std::vector<uint8_t>(fp.getFrame()._buffer, fp.getFrame()._buffer + frame2._length));
+
+    EXPECT_NO_THROW(fp.setSyncList(syncList));
+    EXPECT_NO_THROW(fp.setHeader(hdr));
+    EXPECT_TRUE(fp.isValid());
+    EXPECT_EQ(syncList, fp.getSyncList());
+    EXPECT_EQ(hdr.publishTimestampMs_, fp.getHeader().publishTimestampMs_);
+
+    // packet restored from wire is the same as the one built from scratch
+    VideoFramePacket fp2(frame2);
+    fp2.setSyncList(syncList);
+    fp2.setHeader(hdr);
+    EXPECT_EQ(fp2.data(), fp.data());
+}
+
+TEST(TestVideoFramePacket, TestPacketPool)
+{
+    CommonHeader hdr;
+    hdr.sampleRate_ = 24.7;
+    hdr.publishTimestampMs_ = 488589553;
+    hdr.publishUnixTimestamp_ = 1460488589;
+    std::map<std::string, PacketNumber> syncList = boost::assign::map_list_of("hi", 341)("mid", 433)("low", 432);
+
+    size_t maxFrameLen = 30000;
+    std::vector<uint8_t> buffer(maxFrameLen);
+    for (int i = 0; i < buffer.size(); ++i)
+        buffer[i] = std::rand() % 256;
+
+    webrtc::EncodedImage frame(buffer.data(), maxFrameLen, maxFrameLen);
+    frame._encodedWidth = 640;
+    frame._encodedHeight = 480;
+    frame._frameType = webrtc::kVideoFrameKey;
+    frame._completeFrame = true;
+
+    VideoFramePacketPool pool(4);
+    // frame sizes vary, but key frame sets the maximum
+    std::vector<size_t> frameLengths = {maxFrameLen, 2000, 5000, 3500, 12000, 800};
+    // frames are released with a delay, like when they are being published
+    std::vector<boost::shared_ptr<VideoFramePacket>> inFlight(2);
+    auto encode = [&](size_t frameNo) {
+        frame._length = frameLengths[frameNo % frameLengths.size()];
+        frame._frameType = (frame._length == maxFrameLen ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta);
+
+        boost::shared_ptr<VideoFramePacket> fp = pool.acquire(frame);
+        fp->setSyncList(syncList);
+        fp->setHeader(hdr);
+
+        inFlight[frameNo % inFlight.size()] = fp;
+
+        return fp;
+    };
+
+    // warm up
+    for (int i = 0; i < frameLengths.size() * 2; ++i)
+        encode(i);
+    uint64_t nMisses = pool.getMissesNum();
+
+    size_t nFrames = 1000;
+    bool framesOk = true;
+    countAllocations = true;
+    allocationsNum = 0;
+    for (int i = 0; i < nFrames; ++i)
+    {
+        boost::shared_ptr<VideoFramePacket> fp = encode(i);
+        framesOk &= (fp->getFrame()._length == frame._length &&
+                     fp->getFrame()._frameType == frame._frameType &&
+                     memcmp(fp->getFrame()._buffer, buffer.data(), frame._length) == 0 &&
+                     fp->getHeader().publishTimestampMs_ == hdr.publishTimestampMs_);
+    }
+    countAllocations = false;
+
+    GT_PRINTF("%lu frames: %lu heap allocations, %lu pool hits, %lu misses, %lu packets\n",
+              nFrames, allocationsNum.load(), pool.getHitsNum(), pool.getMissesNum(), pool.size());
+
+    EXPECT_TRUE(framesOk);
+    EXPECT_EQ(syncList, inFlight[0]->getSyncList());
+    EXPECT_EQ(0, allocationsNum.load());
+    EXPECT_EQ(nMisses, pool.getMissesNum());
+    EXPECT_GE(4, pool.size());
+}
+
 TEST(TestAudioThreadMeta, TestCreate)
 {
     AudioThreadMeta meta(50, 146, "opus");
@@ -1618,6 +1838,40 @@ TEST(TestManifest, TestWithDummySignature)
         EXPECT_TRUE(im.hasData(*o));
 }
 
+TEST(TestManifest, TestHasDigest)
+{
+    std::string frameName = "/ndn/edu/ucla/remap/ndncon/instance1/ndnrtc/%FD%03/video/camera/hd/d/%FE%07";
+    VideoFramePacket vp = getVideoFramePacket(30000);
+    std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+    std::vector<boost::shared_ptr<ndn::Data>> dataObjects = dataFromSegments(frameName, segments);
+    std::vector<boost::shared_ptr<const ndn::Data>> manifestSegments;
+
+    for (auto &o : dataObjects)
+    {
+        o->setSignature(ndn::DigestSha256Signature());
+        o->wireEncode();
+        manifestSegments.push_back(o);
+    }
+
+    Manifest m(manifestSegments);
+    NetworkData nd(m);
+    Manifest im(boost::move(nd));
+
+    for (auto &o : dataObjects)
+    {
+        // digest of the wire encoding is the implicit digest of data object
+        uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+        ndn::CryptoLite::digestSha256(o->getDefaultWireEncoding().buf(), o->getDefaultWireEncoding().size(), digest);
+
+        EXPECT_TRUE(im.hasDigest(digest, sizeof(digest)));
+        EXPECT_EQ(ndn::Blob(digest, sizeof(digest)), (*o->getFullName())[-1].getValue());
+
+        digest[0] ^= 0xff;
+        EXPECT_FALSE(im.hasDigest(digest, sizeof(digest)));
+        EXPECT_FALSE(im.hasDigest(digest, sizeof(digest) - 1));
+    }
+}
+
 //******************************************************************************
 int main(int argc, char **argv)
 {
@@ -9,11 +9,13 @@
 #include <webrtc/common_video/libyuv/include/webrtc_libyuv.h>
 #include <boost/assign.hpp>
 #include <boost/asio.hpp>
+#include <set>
 #include <ndn-cpp/security/key-chain.hpp>
 #include <ndn-cpp/security/identity/memory-private-key-storage.hpp>
 #include <ndn-cpp/security/identity/memory-identity-storage.hpp>
 #include <ndn-cpp/security/policy/no-verify-policy-manager.hpp>
 #include <ndn-cpp/security/policy/self-verify-policy-manager.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
 
 #include "gtest/gtest.h"
 #include "tests-helpers.hpp"
@@ -922,6 +924,533 @@ TEST(TestPacketPublisher, TestBenchmarkNoSigning)
     }
 }
 
+TEST(TestPacketPublisher, TestBenchmarkSegmentCopies)
+{
+    int wireLength = 8000;
+    int nFrames = 100;
+    std::vector<int> frameLengths = boost::assign::list_of(5000)(30000)(150000);
+
+    for (auto frameLen : frameLengths)
+    {
+        uint8_t *buffer = (uint8_t *)malloc(frameLen);
+        for (int i = 0; i < frameLen; ++i)
+            buffer[i] = i % 255;
+
+        webrtc::EncodedImage frame(buffer, frameLen, frameLen);
+        frame._encodedWidth = 1920;
+        frame._encodedHeight = 1080;
+        frame._timeStamp = 1460488589;
+        frame.capture_time_ms_ = 1460488569;
+        frame._frameType = webrtc::kVideoFrameKey;
+        frame._completeFrame = true;
+
+        CommonHeader hdr;
+        hdr.sampleRate_ = 30;
+        hdr.publishTimestampMs_ = 488589553;
+        hdr.publishUnixTimestamp_ = 1460488589;
+
+        VideoFramePacket vp(frame);
+        vp.setHeader(hdr);
+
+        VideoFrameSegmentHeader segHdr;
+        segHdr.totalSegmentsNum_ = VideoFrameSegment::numSlices(vp, wireLength);
+        segHdr.playbackNo_ = 100;
+        segHdr.pairedSequenceNo_ = 67;
+
+        size_t allocsOld = 0, allocsNew = 0, bytesOld = 0, bytesNew = 0;
+        unsigned int durationOld = 0, durationNew = 0;
+
+        for (int i = 0; i < nFrames; ++i)
+        {
+            std::vector<VideoFrameSegment> segments = VideoFrameSegment::slice(vp, wireLength);
+            for (auto &s : segments)
+                s.setHeader(segHdr);
+
+            // both arms build ndn::Data, so the difference in heap usage is
+            // the payload copying done on the way to Data content
+            allocationsNum = 0;
+            allocatedBytes = 0;
+            countAllocations = true;
+            boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+            for (auto &s : segments)
+            {
+                boost::shared_ptr<NetworkData> nd = s.getNetworkData();
+                Data d;
+                d.setContent(nd->getData(), s.size());
+            }
+            boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+            countAllocations = false;
+            allocsOld += allocationsNum;
+            bytesOld += allocatedBytes;
+
+            bool zeroCopy = true;
+            allocationsNum = 0;
+            allocatedBytes = 0;
+            countAllocations = true;
+            boost::chrono::high_resolution_clock::time_point t3 = boost::chrono::high_resolution_clock::now();
+            for (auto &s : segments)
+            {
+                boost::shared_ptr<std::vector<uint8_t>> wire = s.getWireData();
+                Data d;
+                d.setContent(Blob(wire, false));
+                // content must reference segment's wire buffer
+                zeroCopy &= (wire->data() == d.getContent().buf());
+            }
+            boost::chrono::high_resolution_clock::time_point t4 = boost::chrono::high_resolution_clock::now();
+            countAllocations = false;
+            allocsNew += allocationsNum;
+            bytesNew += allocatedBytes;
+
+            EXPECT_TRUE(zeroCopy);
+            durationOld += boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count();
+            durationNew += boost::chrono::duration_cast<boost::chrono::microseconds>(t4 - t3).count();
+        }
+
+        GT_PRINTF("Frame size %d bytes (%d segments): getNetworkData() %.2fus, %lu allocations (%lu bytes) per frame; "
+                  "getWireData() %.2fus, %lu allocations (%lu bytes) per frame\n",
+                  frameLen, segHdr.totalSegmentsNum_,
+                  (double)durationOld / (double)nFrames, allocsOld / nFrames, bytesOld / nFrames,
+                  (double)durationNew / (double)nFrames, allocsNew / nFrames, bytesNew / nFrames);
+        // old path allocates payload twice (NetworkData and Data content)
+        EXPECT_LT(bytesNew, bytesOld);
+        free(buffer);
+    }
+}
+
+namespace {
+    VideoFramePacket makeFramePacket(uint8_t *buffer, size_t frameLen)
+    {
+        CommonHeader hdr;
+        hdr.sampleRate_ = 30;
+        hdr.publishTimestampMs_ = 488589553;
+        hdr.publishUnixTimestamp_ = 1460488589;
+
+        for (int i = 0; i < frameLen; ++i)
+            buffer[i] = i % 255;
+
+        webrtc::EncodedImage frame(buffer, frameLen, frameLen);
+        frame._encodedWidth = 1280;
+        frame._encodedHeight = 720;
+        frame._timeStamp = 1460488589;
+        frame.capture_time_ms_ = 1460488569;
+        frame._frameType = webrtc::kVideoFrameKey;
+        frame._completeFrame = true;
+
+        VideoFramePacket vp(frame);
+        vp.setHeader(hdr);
+        return vp;
+    }
+
+    // mimics MemoryContentCache: every lookup and every added data object
+    // scans the whole PIT
+    void setupMockCache(MockNdnMemoryCache &memoryCache, PendingInterests &pendingInterests,
+                        int &nLookups, int &nAdded)
+    {
+        EXPECT_CALL(memoryCache, getPendingInterestsForName(_, _))
+            .WillRepeatedly(Invoke([&pendingInterests, &nLookups](const Name &name, PendingInterests &interests) {
+                nLookups++;
+                interests.clear();
+                for (auto p : pendingInterests)
+                    if (p->getInterest()->matchesName(name))
+                        interests.push_back(p);
+            }));
+        EXPECT_CALL(memoryCache, getPendingInterestsWithPrefix(_, _))
+            .WillRepeatedly(Invoke([&pendingInterests, &nLookups](const Name &name, PendingInterests &interests) {
+                nLookups++;
+                interests.clear();
+                for (auto p : pendingInterests)
+                    if (name.match(p->getInterest()->getName()))
+                        interests.push_back(p);
+            }));
+        EXPECT_CALL(memoryCache, add(_))
+            .WillRepeatedly(Invoke([&pendingInterests, &nAdded](const Data &data) {
+                nAdded++;
+                int i = 0;
+                while (i < pendingInterests.size())
+                {
+                    if (pendingInterests[i]->getInterest()->matchesName(data.getName()))
+                        pendingInterests.erase(pendingInterests.begin() + i);
+                    else
+                        i++;
+                }
+            }));
+    }
+
+    void addPendingInterests(Face &face, const Name &name, int nInterests, uint32_t nonce,
+                             PendingInterests &pendingInterests)
+    {
+        for (int i = 0; i < nInterests; ++i)
+        {
+            boost::shared_ptr<Interest> in = boost::make_shared<Interest>(name, 2000);
+            in->getName().appendSegment(i);
+            in->setNonce(Blob((uint8_t *)&nonce, sizeof(nonce)));
+            pendingInterests.push_back(boost::make_shared<MemoryContentCache::PendingInterest>(in, face));
+        }
+    }
+}
+
+TEST(TestPacketPublisher, TestPublishVideoFrameBatchPit)
+{
+    Face face("aleph.ndn.ucla.edu");
+    MockNdnKeyChain keyChain;
+    MockNdnMemoryCache memoryCache;
+    MockSettings settings;
+    PendingInterests pendingInterests;
+    int nLookups = 0, nAdded = 0;
+    uint32_t nonce = 4321;
+
+    settings.keyChain_ = &keyChain;
+    settings.memoryCache_ = &memoryCache;
+    settings.segmentWireLength_ = 1000;
+    settings.freshnessPeriodMs_ = 1000;
+    settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+    settings.batchPit_ = true;
+
+    setupMockCache(memoryCache, pendingInterests, nLookups, nAdded);
+    EXPECT_CALL(keyChain, sign(_)).Times(AtLeast(1));
+
+    size_t frameLen = 30000;
+    uint8_t *buffer = (uint8_t *)malloc(frameLen);
+    VideoFramePacket vp = makeFramePacket(buffer, frameLen);
+    Name packetName("/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%02/video/camera/%FC%00%00%01c_%27%DE%D6/tiny/d");
+    packetName.appendSequenceNumber(0);
+
+    PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+
+    { // interests for all segments and some that go beyond frame
+        VideoFrameSegmentHeader segHdr;
+        segHdr.totalSegmentsNum_ = VideoFrameSegment::numSlices(vp, settings.segmentWireLength_);
+        segHdr.playbackNo_ = 100;
+        segHdr.pairedSequenceNo_ = 67;
+
+        addPendingInterests(face, packetName, segHdr.totalSegmentsNum_ + 5, nonce, pendingInterests);
+
+        PublishedDataPtrVector segments = publisher.publish(packetName, vp, segHdr, 1000, false, true);
+
+        EXPECT_EQ(1, nLookups);
+        EXPECT_EQ(segHdr.totalSegmentsNum_, segments.size());
+        EXPECT_EQ(segments.size(), nAdded);
+        EXPECT_EQ(5, pendingInterests.size());
+        EXPECT_EQ(nonce, segHdr.interestNonce_);
+        EXPECT_EQ(segHdr.totalSegmentsNum_, (*settings.statStorage_)[Indicator::InterestsReceivedNum]);
+
+        for (int i = 0; i < segments.size(); ++i)
+        {
+            Name segName(packetName);
+            EXPECT_EQ(segName.appendSegment(i), segments[i]->getName());
+
+            ImmutableHeaderPacket<VideoFrameSegmentHeader> packet(segments[i]->getContent());
+            EXPECT_EQ(nonce, packet.getHeader().interestNonce_);
+        }
+    }
+    { // no pending interests
+        VideoFrameSegmentHeader segHdr;
+        pendingInterests.clear();
+        nLookups = nAdded = 0;
+
+        PublishedDataPtrVector segments = publisher.publish(packetName, vp, segHdr, 1000, false, true);
+
+        EXPECT_EQ(1, nLookups);
+        EXPECT_EQ(segments.size(), nAdded);
+        EXPECT_EQ(0, segHdr.interestNonce_);
+        EXPECT_EQ(0, segHdr.generationDelayMs_);
+    }
+
+    free(buffer);
+}
+
+TEST(TestPacketPublisher, TestBenchmarkBatchPit)
+{
+    Face face("aleph.ndn.ucla.edu");
+    int nFrames = 100, nOtherPending = 200;
+    std::vector<int> frameLengths = boost::assign::list_of(10000)(30000)(60000);
+
+    for (auto frameLen : frameLengths)
+    {
+        uint8_t *buffer = (uint8_t *)malloc(frameLen);
+        VideoFramePacket vp = makeFramePacket(buffer, frameLen);
+        unsigned int duration[2] = {0, 0};
+        int lookups[2] = {0, 0};
+        size_t nSegments = VideoFrameSegment::numSlices(vp, 1000);
+
+        for (int batch = 0; batch < 2; ++batch)
+        {
+            MockNdnKeyChain keyChain;
+            MockNdnMemoryCache memoryCache;
+            MockSettings settings;
+            PendingInterests pendingInterests;
+            int nLookups = 0, nAdded = 0;
+
+            settings.keyChain_ = &keyChain;
+            settings.memoryCache_ = &memoryCache;
+            settings.segmentWireLength_ = 1000;
+            settings.freshnessPeriodMs_ = 1000;
+            settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+            settings.sign_ = false;
+            settings.batchPit_ = (batch == 1);
+
+            setupMockCache(memoryCache, pendingInterests, nLookups, nAdded);
+            PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+
+            for (int i = 0; i < nFrames; ++i)
+            {
+                Name packetName("/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%02/video/camera/%FC%00%00%01c_%27%DE%D6/tiny/d");
+                packetName.appendSequenceNumber(i);
+
+                VideoFrameSegmentHeader segHdr;
+                segHdr.totalSegmentsNum_ = nSegments;
+
+                // consumer pipelines interests for this and future frames
+                pendingInterests.clear();
+                addPendingInterests(face, packetName, nSegments, i, pendingInterests);
+                for (int j = 1; j <= nOtherPending / nSegments; ++j)
+                {
+                    Name futureName(packetName.getPrefix(-1));
+                    addPendingInterests(face, futureName.appendSequenceNumber(i + j), nSegments, i, pendingInterests);
+                }
+
+                boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+                publisher.publish(packetName, vp, segHdr, 1000, false, true);
+                boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+                duration[batch] += boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count();
+            }
+
+            lookups[batch] = nLookups;
+        }
+
+        GT_PRINTF("Frame size %d bytes (%lu segments, %d pending interests): per-segment PIT %.2fus/frame "
+                  "(%.1f lookups), batched PIT %.2fus/frame (%.1f lookups)\n",
+                  frameLen, nSegments, nOtherPending,
+                  (double)duration[0] / (double)nFrames, (double)lookups[0] / (double)nFrames,
+                  (double)duration[1] / (double)nFrames, (double)lookups[1] / (double)nFrames);
+
+        EXPECT_LT(lookups[1], lookups[0]);
+        free(buffer);
+    }
+}
+
+TEST(TestPacketPublisher, TestParallelSigning)
+{
+    MockNdnKeyChain keyChain;
+    MockNdnMemoryCache memoryCache;
+    MockSettings settings;
+    PendingInterests pendingInterests;
+    int nLookups = 0, nAdded = 0;
+    boost::shared_ptr<SigningPool> pool = boost::make_shared<SigningPool>(4);
+
+    settings.keyChain_ = &keyChain;
+    settings.memoryCache_ = &memoryCache;
+    settings.segmentWireLength_ = 1000;
+    settings.freshnessPeriodMs_ = 1000;
+    settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+    settings.batchPit_ = true;
+    settings.signingPool_ = pool.get();
+
+    setupMockCache(memoryCache, pendingInterests, nLookups, nAdded);
+
+    std::vector<Name> added;
+    EXPECT_CALL(memoryCache, add(_))
+        .WillRepeatedly(Invoke([&added](const Data &data) {
+            added.push_back(data.getName());
+        }));
+
+    size_t frameLen = 50000;
+    uint8_t *buffer = (uint8_t *)malloc(frameLen);
+    VideoFramePacket vp = makeFramePacket(buffer, frameLen);
+    Name packetName("/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%02/video/camera/%FC%00%00%01c_%27%DE%D6/tiny/d");
+    packetName.appendSequenceNumber(0);
+
+    { // key chain signing
+        boost::mutex m;
+        std::set<boost::thread::id> signingThreads;
+        EXPECT_CALL(keyChain, sign(_))
+            .WillRepeatedly(Invoke([&m, &signingThreads](Data &) {
+                boost::lock_guard<boost::mutex> scopedLock(m);
+                signingThreads.insert(boost::this_thread::get_id());
+            }));
+
+        PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+        VideoFrameSegmentHeader segHdr;
+        PublishedDataPtrVector segments = publisher.publish(packetName, vp, segHdr, 1000, false, true);
+
+        ASSERT_EQ(segments.size(), added.size());
+        for (int i = 0; i < added.size(); ++i)
+            EXPECT_EQ(i, added[i][-1].toSegment());
+        EXPECT_EQ(segments.size(), (*settings.statStorage_)[Indicator::SignNum]);
+        EXPECT_EQ(0, signingThreads.count(boost::this_thread::get_id()));
+        GT_PRINTF("%lu segments signed by %lu threads\n", segments.size(), signingThreads.size());
+    }
+    { // digest signing
+        settings.sign_ = false;
+        added.clear();
+        EXPECT_CALL(keyChain, sign(_)).Times(0);
+
+        PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+        VideoFrameSegmentHeader segHdr;
+        PublishedDataPtrVector segments = publisher.publish(packetName, vp, segHdr, 1000, false, true);
+
+        ASSERT_EQ(segments.size(), added.size());
+        for (int i = 0; i < segments.size(); ++i)
+        {
+            EXPECT_EQ(i, added[i][-1].toSegment());
+
+            uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+            SignedBlob encoding = segments[i]->wireEncode();
+            CryptoLite::digestSha256(encoding.signedBuf(), encoding.signedSize(), digest);
+
+            ASSERT_NE(nullptr, dynamic_cast<const DigestSha256Signature *>(segments[i]->getSignature()));
+            EXPECT_EQ(Blob(digest, sizeof(digest)), segments[i]->getSignature()->getSignature());
+        }
+    }
+    { // failed signing: segments from the failed one on are not cached
+        settings.sign_ = true;
+        added.clear();
+        EXPECT_CALL(keyChain, sign(_))
+            .WillRepeatedly(Invoke([](Data &data) {
+                if (data.getName()[-1].toSegment() == 3)
+                    throw 1;
+            }));
+
+        PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+        VideoFrameSegmentHeader segHdr;
+        EXPECT_ANY_THROW(publisher.publish(packetName, vp, segHdr, 1000, false, true));
+
+        ASSERT_EQ(3, added.size());
+        for (int i = 0; i < added.size(); ++i)
+            EXPECT_EQ(i, added[i][-1].toSegment());
+    }
+
+    free(buffer);
+}
+
+TEST(TestPacketPublisher, TestSliceSignCache)
+{
+    Face face("aleph.ndn.ucla.edu");
+    MockNdnKeyChain keyChain;
+    MockNdnMemoryCache memoryCache;
+    MockSettings settings;
+    PendingInterests pendingInterests;
+    int nLookups = 0, nAdded = 0;
+    uint32_t nonce = 4321;
+
+    settings.keyChain_ = &keyChain;
+    settings.memoryCache_ = &memoryCache;
+    settings.segmentWireLength_ = 1000;
+    settings.freshnessPeriodMs_ = 1000;
+    settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+    settings.batchPit_ = true;
+
+    setupMockCache(memoryCache, pendingInterests, nLookups, nAdded);
+
+    std::vector<Name> added;
+    EXPECT_CALL(memoryCache, add(_))
+        .WillRepeatedly(Invoke([&added](const Data &data) {
+            added.push_back(data.getName());
+        }));
+
+    boost::thread::id signingThread;
+    EXPECT_CALL(keyChain, sign(_))
+        .WillRepeatedly(Invoke([&signingThread](Data &) {
+            signingThread = boost::this_thread::get_id();
+        }));
+
+    size_t frameLen = 30000;
+    uint8_t *buffer = (uint8_t *)malloc(frameLen);
+    VideoFramePacket vp = makeFramePacket(buffer, frameLen);
+    Name packetName("/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%02/video/camera/%FC%00%00%01c_%27%DE%D6/tiny/d");
+    packetName.appendSequenceNumber(0);
+
+    PacketPublisher<VideoFrameSegment, MockSettings> publisher(settings);
+    VideoFrameSegmentHeader segHdr;
+    segHdr.totalSegmentsNum_ = VideoFrameSegment::numSlices(vp, settings.segmentWireLength_);
+
+    addPendingInterests(face, packetName, segHdr.totalSegmentsNum_ + 5, nonce, pendingInterests);
+
+    PacketPublisher<VideoFrameSegment, MockSettings>::SlicedSample sample =
+        publisher.slice(packetName, vp, segHdr, 1000);
+
+    EXPECT_EQ(1, nLookups);
+    EXPECT_EQ(segHdr.totalSegmentsNum_, sample.segments_.size());
+    EXPECT_EQ(5, sample.unmatched_.size());
+    EXPECT_EQ(nonce, segHdr.interestNonce_);
+    EXPECT_EQ(0, added.size());
+
+    // sample is signed on some other thread, while slicing thread is free
+    boost::thread t([&publisher, &sample]() { publisher.sign(sample); });
+    t.join();
+
+    EXPECT_NE(boost::thread::id(), signingThread);
+    EXPECT_NE(boost::this_thread::get_id(), signingThread);
+    EXPECT_EQ(0, added.size());
+
+    PublishedDataPtrVector segments = publisher.cache(sample, false, true);
+
+    ASSERT_EQ(segments.size(), added.size());
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        EXPECT_EQ(i, added[i][-1].toSegment());
+
+        ImmutableHeaderPacket<VideoFrameSegmentHeader> packet(segments[i]->getContent());
+        EXPECT_EQ(nonce, packet.getHeader().interestNonce_);
+    }
+    EXPECT_EQ(1, nLookups);
+    EXPECT_EQ(segments.size(), (*settings.statStorage_)[Indicator::SignNum]);
+    EXPECT_EQ(segments.size(), (*settings.statStorage_)[Indicator::PublishedSegmentsNum]);
+
+    free(buffer);
+}
+
+TEST(TestPacketPublisher, TestBenchmarkSigningPool)
+{
+    Face face("aleph.ndn.ucla.edu");
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    boost::shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+    boost::shared_ptr<MemoryContentCache> memCache = boost::make_shared<MemoryContentCache>(&face);
+    boost::shared_ptr<SigningPool> pool = boost::make_shared<SigningPool>(4);
+    std::vector<int> segmentNums = boost::assign::list_of(10)(30)(60);
+    int wireLength = 1000, nFrames = 50;
+
+    for (auto nSegments : segmentNums)
+    {
+        size_t frameLen = nSegments * VideoFrameSegment::payloadLength(wireLength) - 100;
+        uint8_t *buffer = (uint8_t *)malloc(frameLen);
+        VideoFramePacket vp = makeFramePacket(buffer, frameLen);
+
+        for (int mode = 0; mode < 4; ++mode)
+        {
+            bool useKeyChain = (mode < 2), usePool = (mode % 2 == 1);
+            PublisherSettings settings;
+
+            settings.keyChain_ = keyChain.get();
+            settings.memoryCache_ = memCache.get();
+            settings.segmentWireLength_ = wireLength;
+            settings.freshnessPeriodMs_ = 1000;
+            settings.statStorage_ = StatisticsStorage::createProducerStatistics();
+            settings.sign_ = useKeyChain;
+            settings.batchPit_ = true;
+            settings.signingPool_ = (usePool ? pool.get() : nullptr);
+
+            VideoPacketPublisher publisher(settings);
+            Name packetName("/test/frames");
+
+            boost::chrono::high_resolution_clock::time_point t1 = boost::chrono::high_resolution_clock::now();
+            for (int i = 0; i < nFrames; ++i)
+            {
+                VideoFrameSegmentHeader segHdr;
+                publisher.publish(Name(packetName).appendSequenceNumber(i), vp, segHdr, 1000, false, true);
+            }
+            boost::chrono::high_resolution_clock::time_point t2 = boost::chrono::high_resolution_clock::now();
+            double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(t2 - t1).count() / 1E6;
+
+            GT_PRINTF("%d segments per frame, %s signature, %s: %.1f frames/sec\n",
+                      nSegments, (useKeyChain ? "key chain" : "digest"),
+                      (usePool ? "4 signing threads" : "face thread"), (double)nFrames / sec);
+        }
+
+        free(buffer);
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
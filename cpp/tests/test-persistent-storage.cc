@@ -29,6 +29,7 @@
 #include <ndn-cpp/security/policy/no-verify-policy-manager.hpp>
 #include <ndn-cpp/security/policy/self-verify-policy-manager.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/filesystem.hpp>
@@ -41,12 +42,15 @@
 #include "client/src/video-source.hpp"
 #include "client/src/frame-io.hpp"
 #include "src/packet-publisher.hpp"
+#include "src/signing-pool.hpp"
 #include "mock-objects/ndn-cpp-mock.hpp"
 #include "frame-data.hpp"
 #include "video-thread.hpp"
 #include "interfaces.hpp"
 
 #include "persistent-storage/fetching-task.hpp"
+#include "persistent-storage/storage-key.hpp"
+#include "persistent-storage/data-cache.hpp"
 #include "storage-engine.hpp"
 #include "frame-fetcher.hpp"
 #include "frame-buffer.hpp"
@@ -1413,11 +1417,966 @@ TEST(TestPersistentStorage, TestFrameFetcherWithLocalStream)
 
     EXPECT_EQ(2, nFetched);
 
+    {
+        // scrub through deltas: decoder state of the GOP is reused, so every
+        // fetch, except for the first delta of a GOP, fetches only one frame
+        int nScrubbed = 0, nFramesTotal = 0, nLastFetched = 0, nScrubFrames = 60;
+        OnFrameFetched onScrubbed =
+            [&frameBuffer, &nScrubbed, &nFramesTotal, &nLastFetched, &fetchedFrameName](const boost::shared_ptr<IFrameFetcher>& fetcher,
+                                      const FrameInfo fi, int nFetchedFrames,
+                                      int width, int height, const uint8_t* buffer)
+            {
+                EXPECT_EQ(fetchedFrameName.toUri(), fi.ndnName_);
+                nScrubbed++;
+                nFramesTotal += nFetchedFrames;
+                nLastFetched = nFetchedFrames;
+                free(frameBuffer);
+            };
+
+        boost::chrono::high_resolution_clock::time_point start = boost::chrono::high_resolution_clock::now();
+        for (PacketNumber seqNo = 1; seqNo <= nScrubFrames; ++seqNo)
+        {
+            Name dataName(localStream.getPrefix());
+            dataName.append(localStream.getThreads()[0])
+                    .append(NameComponents::NameComponentDelta)
+                    .appendSequenceNumber(seqNo);
+            fetchedFrameName = dataName;
+            fetcher->fetch(dataName, onBufferAllocate, onScrubbed, onFetchFailure);
+            EXPECT_GE(2, nLastFetched);
+        }
+        int d = boost::chrono::duration_cast<boost::chrono::milliseconds>(boost::chrono::high_resolution_clock::now() - start).count();
+
+        EXPECT_EQ(nScrubFrames, nScrubbed);
+        GT_PRINTF("Scrubbing %d frames took %d ms (%.2f ms/frame), %d frames were fetched\n",
+                  nScrubbed, d, (double)d/nScrubbed, nFramesTotal);
+
+        // seeking back within the GOP doesn't refetch Key frame
+        Name dataName(localStream.getPrefix());
+        dataName.append(localStream.getThreads()[0])
+                .append(NameComponents::NameComponentDelta)
+                .appendSequenceNumber(nScrubFrames-1);
+        fetchedFrameName = dataName;
+
+        boost::shared_ptr<FrameFetcher> freshFetcher = boost::make_shared<FrameFetcher>(localStream.getStorage());
+        freshFetcher->fetch(dataName, onBufferAllocate, onScrubbed, onFetchFailure);
+        int nFetchedFresh = nLastFetched;
+        fetcher->fetch(dataName, onBufferAllocate, onScrubbed, onFetchFailure);
+
+        EXPECT_EQ(nScrubFrames+2, nScrubbed);
+        EXPECT_EQ(nFetchedFresh-1, nLastFetched);
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestBenchmarkRangeFetch)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb");
+#else
+    std::string dbPath("/data/local/tmp/testdb");
+#endif
+
+    boost::asio::io_service io_source;
+    boost::shared_ptr<boost::asio::io_service::work> work_source(boost::make_shared<boost::asio::io_service::work>(io_source));
+    boost::thread t_source([&io_source](){
+        io_source.run();
+    });
+
+    int runTime = 10*1000;
+    int width = 320, height = 240;
+    boost::shared_ptr<RawFrame> frame(boost::make_shared<ArgbFrame>(width,height));
+    std::string testVideoSource = resources_path+"/test-source-320x240.argb";
+    VideoSource source(io_source, testVideoSource, frame);
+    MockExternalCapturer capturer;
+    source.addCapturer(&capturer);
+
+    std::string appPrefix = "/ndn/edu/ucla/remap/peter/app";
+    boost::shared_ptr<Face> publisherFace(boost::make_shared<ThreadsafeFace>(io_source));
+    boost::shared_ptr<KeyChain> keyChain = memoryKeyChain(appPrefix);
+    publisherFace->setCommandSigningInfo(*keyChain, certName(keyName(appPrefix)));
+
+    MediaStreamSettings settings(io_source, getSampleVideoParams());
+    settings.face_ = publisherFace.get();
+    settings.keyChain_ = keyChain.get();
+    settings.storagePath_ = dbPath;
+    LocalVideoStream localStream(appPrefix, settings);
+
+    boost::function<int(const unsigned int,const unsigned int, unsigned char*, unsigned int)>
+      incomingRawFrame =[&localStream](const unsigned int w,const unsigned int h, unsigned char* data, unsigned int size){
+          EXPECT_NO_THROW(localStream.incomingArgbFrame(w, h, data, size));
+          return 0;
+      };
+    EXPECT_CALL(capturer, incomingArgbFrame(320, 240, _, _))
+        .WillRepeatedly(Invoke(incomingRawFrame));
+
+    source.start(30);
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(runTime));
+    work_source.reset();
+    io_source.stop();
+    t_source.join();
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    Name threadPrefix(localStream.getPrefix());
+    threadPrefix.append(localStream.getThreads()[0]);
+
+    std::vector<uint8_t> frameBuffer(width*height*4);
+    int nFrames = 0, nFramesFetched = 0;
+    PacketNumber start = 0, end = 199;
+
+    OnBufferAllocate onBufferAllocate =
+        [&frameBuffer](const boost::shared_ptr<IFrameFetcher>&, int w, int h)->uint8_t*
+        {
+            frameBuffer.resize(w*h*4);
+            return frameBuffer.data();
+        };
+    OnFrameFetched onFrameFetched =
+        [&nFrames, &nFramesFetched](const boost::shared_ptr<IFrameFetcher>&,
+                                    const FrameInfo fi, int nFetchedFrames,
+                                    int w, int h, const uint8_t* buffer)
+        {
+            nFrames++;
+            nFramesFetched += nFetchedFrames;
+        };
+    OnFetchFailure onFetchFailure =
+        [](const boost::shared_ptr<IFrameFetcher>& ff, std::string reason)
+        {
+            FAIL() << "Frame fetching failed (" << ff->getName() <<"): " << reason;
+        };
+
+    GT_PRINTF("extracting Delta frames %d-%d:\n", start, end);
+
+    for (unsigned int stride:{1, 10})
+    {
+        { // one fetcher per frame (like ndnrtc_FrameFetcher_fetch)
+            nFrames = nFramesFetched = 0;
+            Clock::time_point t = Clock::now();
+            for (PacketNumber seqNo = start; seqNo <= end; seqNo += stride)
+            {
+                boost::shared_ptr<FrameFetcher> fetcher = boost::make_shared<FrameFetcher>(localStream.getStorage());
+                fetcher->fetch(Name(threadPrefix).append(NameComponents::NameComponentDelta).appendSequenceNumber(seqNo),
+                               onBufferAllocate, onFrameFetched, onFetchFailure);
+            }
+            double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-t).count()/1000000.;
+
+            EXPECT_EQ((int)((end-start)/stride+1), nFrames);
+            GT_PRINTF("stride %2d, fetch per frame: %.1f frames/sec (%d frames fetched for %d frames)\n",
+                      stride, (double)nFrames/sec, nFramesFetched, nFrames);
+        }
+        { // range
+            nFrames = nFramesFetched = 0;
+            int nRangeFetched = 0;
+            Clock::time_point t = Clock::now();
+            boost::shared_ptr<FrameFetcher> fetcher = boost::make_shared<FrameFetcher>(localStream.getStorage());
+            fetcher->fetchRange(threadPrefix, start, end, stride,
+                                onBufferAllocate, onFrameFetched,
+                                [&nRangeFetched](const boost::shared_ptr<IFrameFetcher>&, int n){
+                                    nRangeFetched = n;
+                                },
+                                onFetchFailure);
+            double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-t).count()/1000000.;
+
+            EXPECT_EQ((int)((end-start)/stride+1), nFrames);
+            EXPECT_EQ(nFrames, nRangeFetched);
+            GT_PRINTF("stride %2d, range fetch:     %.1f frames/sec (%d frames fetched for %d frames)\n",
+                      stride, (double)nFrames/sec, nFramesFetched, nFrames);
+        }
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+}
+#endif
+
+namespace {
+    typedef std::vector<boost::shared_ptr<const ndn::Data>> FrameSegments;
+
+    // synthetic 30fps stream: key frame every 30 frames, 8000-byte segments
+    std::vector<FrameSegments> syntheticStream(const std::string& threadPrefix,
+                                               int nFrames, int nKeySegments,
+                                               int nDeltaSegments)
+    {
+        std::vector<FrameSegments> frames;
+        std::vector<uint8_t> payload(8000);
+        for (size_t i = 0; i < payload.size(); ++i) payload[i] = rand()%256;
+
+        for (int f = 0; f < nFrames; ++f)
+        {
+            bool isKey = (f%30 == 0);
+            Name frameName(threadPrefix);
+            frameName.append(std::string(isKey ? "k" : "d")).appendSequenceNumber(isKey ? f/30 : f);
+
+            FrameSegments segments;
+            for (int seg = 0; seg < (isKey ? nKeySegments : nDeltaSegments); ++seg)
+            {
+                boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(frameName).appendSegment(seg));
+                d->setContent(Blob(payload.data(), payload.size()));
+                SigningPool::digestSign(*d);
+                segments.push_back(d);
+            }
+            frames.push_back(segments);
+        }
+        return frames;
+    }
+}
+
+TEST(TestPersistentStorage, TestBenchmarkIngest)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-ingest");
+#else
+    std::string dbPath("/data/local/tmp/testdb-ingest");
+#endif
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nThreads = 3, nFrames = 300, nKeySegments = 20, nDeltaSegments = 4;
+    std::string streamPrefix = "/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera";
+    std::vector<std::vector<FrameSegments>> streams;
+    size_t nSegments = 0;
+
+    for (int t = 0; t < nThreads; ++t)
+    {
+        streams.push_back(syntheticStream(streamPrefix+"/thread"+std::to_string(t),
+                                          nFrames, nKeySegments, nDeltaSegments));
+        for (auto& f:streams.back()) nSegments += f.size();
+    }
+
+    StorageEngine::WriteSettings perPacket, perFrame, perN, perBudget, noWal, sync;
+    perFrame.batch_ = true;
+    perN.batch_ = true; perN.flushOnFrame_ = false; perN.batchSize_ = 64;
+    perBudget.batch_ = true; perBudget.flushOnFrame_ = false; perBudget.batchBudgetMs_ = 33;
+    noWal = perFrame; noWal.disableWal_ = true;
+    sync = perFrame; sync.sync_ = true;
+
+    std::vector<std::pair<std::string, StorageEngine::WriteSettings>> modes = {
+        {"per packet", perPacket}, {"batch per frame", perFrame},
+        {"batch per 64 packets", perN}, {"batch per 33ms", perBudget},
+        {"batch per frame, no WAL", noWal}, {"batch per frame, sync", sync}};
+
+    GT_PRINTF("ingesting %d threads x %d frames (%d segments total):\n",
+              nThreads, nFrames, nSegments);
+
+    for (auto& m:modes)
+    {
+        {
+            StorageEngine storage(dbPath);
+            storage.setWriteSettings(m.second);
+
+            Clock::time_point start = Clock::now();
+            std::vector<boost::shared_ptr<boost::thread>> threads;
+            for (auto& frames:streams)
+                threads.push_back(boost::make_shared<boost::thread>([&storage, &frames, &m](){
+                    for (auto& f:frames)
+                    {
+                        if (m.second.batch_)
+                            storage.put(f);
+                        else
+                            for (auto& d:f) storage.put(d);
+                    }
+                }));
+            for (auto& t:threads) t->join();
+            storage.flush();
+            double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000000.;
+
+            GT_PRINTF("%s: %.0f segments/sec (%.1fx realtime)\n", m.first.c_str(),
+                      (double)nSegments/sec, (double)(nThreads*nFrames)/30./sec);
+
+            for (auto& frames:streams)
+            {
+                EXPECT_TRUE(storage.get(frames.front().front()->getName()).get());
+                EXPECT_TRUE(storage.get(frames.back().back()->getName()).get());
+            }
+        }
+
+        db_namespace::Options options;
+        db_namespace::DestroyDB(dbPath, options);
+    }
+}
+
+TEST(TestPersistentStorage, TestStorageKeyOrder)
+{
+    Name prefix("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+    std::vector<uint64_t> frameNos = {0, 1, 255, 256, 1000, 65536, 5000000000ull};
+    std::string prefixKey = StorageKey::fromName(prefix), prevKey;
+
+    for (auto f:frameNos)
+        for (int seg = 0; seg < 300; seg += 100)
+        {
+            Name n(prefix);
+            n.appendSequenceNumber(f).appendSegment(seg);
+
+            std::string k = StorageKey::fromName(n);
+            EXPECT_EQ(n, StorageKey::toName(k.data(), k.size()));
+            EXPECT_EQ(n.size(), StorageKey::countComponents(k.data(), k.size()));
+            EXPECT_EQ(0, k.compare(0, prefixKey.size(), prefixKey));
+            EXPECT_LT(prevKey, k);
+            prevKey = k;
+        }
+
+    // components with zero bytes and non-canonical numbers survive round trip
+    uint8_t raw[] = {0xFE, 0x00, 0x00, 0x05};
+    Name n(prefix);
+    n.append(Name::Component(raw, sizeof(raw))).append(Name::Component(raw+1, 2));
+    std::string k = StorageKey::fromName(n);
+    EXPECT_EQ(n, StorageKey::toName(k.data(), k.size()));
+
+    // component is not a prefix of a longer one
+    std::string ka = StorageKey::fromName(Name("/a/b")), kb = StorageKey::fromName(Name("/a/bc"));
+    EXPECT_NE(0, kb.compare(0, ka.size(), ka));
+    EXPECT_LT(ka, kb);
+}
+
+TEST(TestPersistentStorage, TestIndexOverwrites)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-overwrites");
+#else
+    std::string dbPath("/data/local/tmp/testdb-overwrites");
+#endif
+
+    Name prefix("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+    auto makeData = [&prefix](int seg, size_t size) {
+        boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(prefix).appendSequenceNumber(0).appendSegment(seg));
+        std::vector<uint8_t> payload(size, 0xab);
+        d->setContent(Blob(payload.data(), payload.size()));
+        SigningPool::digestSign(*d);
+        return d;
+    };
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+
+    {
+        StorageEngine storage(dbPath);
+        boost::shared_ptr<Data> d0 = makeData(0, 100), d1 = makeData(1, 100);
+
+        // overwrite with a record of different size
+        storage.put(d0);
+        d0 = makeData(0, 200);
+        storage.put(d0);
+        EXPECT_EQ(1, storage.getKeysNum());
+        EXPECT_EQ(d0->wireEncode().size(), storage.getPayloadSize());
+
+        // batch overwrites stored record and its own one
+        boost::shared_ptr<Data> d1v2 = makeData(1, 300);
+        storage.put(std::vector<boost::shared_ptr<const Data>>({makeData(0, 50), d1, d1v2}));
+        EXPECT_EQ(2, storage.getKeysNum());
+        EXPECT_EQ(makeData(0, 50)->wireEncode().size() + d1v2->wireEncode().size(),
+                  storage.getPayloadSize());
+    }
+    {
+        // persisted index matches a full scan
+        StorageEngine storage(dbPath, true);
+        EXPECT_EQ(2, storage.getKeysNum());
+    }
+
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestDataCache)
+{
+    auto makeData = [](const std::string& name, uint8_t fill) {
+        boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(name));
+        std::vector<uint8_t> payload(100, fill);
+        d->setContent(Blob(payload.data(), payload.size()));
+        SigningPool::digestSign(*d);
+        return d;
+    };
+    boost::shared_ptr<Data> a = makeData("/a", 1), b = makeData("/b", 2), c = makeData("/c", 3);
+    size_t entrySize = a->getDefaultWireEncoding().size();
+
+    // one shard that fits two entries
+    ndnrtc::DataCache cache(2*entrySize, 1);
+    cache.put("a", a, cache.getVersion());
+    cache.put("b", b, cache.getVersion());
+    ASSERT_TRUE(cache.get("a").get());
+    EXPECT_EQ(a->getContent(), cache.get("a")->getContent());
+
+    // least recently used entry is evicted
+    cache.put("c", c, cache.getVersion());
+    EXPECT_FALSE(cache.get("b").get());
+    ASSERT_TRUE(cache.get("a").get());
+    EXPECT_EQ(a->getContent(), cache.get("a")->getContent());
+    ASSERT_TRUE(cache.get("c").get());
+    EXPECT_EQ(c->getContent(), cache.get("c")->getContent());
+
+    cache.get("a");
+    cache.put("b", b, cache.getVersion());
+    EXPECT_FALSE(cache.get("c").get());
+    EXPECT_TRUE(cache.get("a").get());
+    EXPECT_TRUE(cache.get("b").get());
+
+    ndnrtc::DataCache::Stats stats = cache.getStats();
+    EXPECT_EQ(2, stats.evictions_);
+    EXPECT_EQ(2, stats.nEntries_);
+    EXPECT_EQ(2*entrySize, stats.sizeBytes_);
+
+    // record read before an overwrite is not cached after it
+    uint64_t version = cache.getVersion();
+    cache.erase("a");
+    cache.put("a", a, version);
+    EXPECT_FALSE(cache.get("a").get());
+
+    boost::shared_ptr<Data> a2 = makeData("/a", 4);
+    cache.put("a", a2, cache.getVersion());
+    ASSERT_TRUE(cache.get("a").get());
+    EXPECT_EQ(a2->getContent(), cache.get("a")->getContent());
+
+    // versions of a replaced cache are stale for a new one
+    ndnrtc::DataCache newCache(2*entrySize, 1);
+    newCache.put("a", a, version);
+    EXPECT_FALSE(newCache.get("a").get());
+}
+
+TEST(TestPersistentStorage, TestCachedOverwrites)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-cached-overwrites");
+#else
+    std::string dbPath("/data/local/tmp/testdb-cached-overwrites");
+#endif
+
+    Name name("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+    name.appendSequenceNumber(0).appendSegment(0);
+    auto makeData = [&name](uint8_t fill) {
+        boost::shared_ptr<Data> d = boost::make_shared<Data>(name);
+        std::vector<uint8_t> payload(100, fill);
+        d->setContent(Blob(payload.data(), payload.size()));
+        SigningPool::digestSign(*d);
+        return d;
+    };
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+
+    {
+        StorageEngine storage(dbPath);
+        storage.setCacheSize(1024*1024);
+
+        boost::shared_ptr<Data> d = makeData(1);
+        storage.put(d);
+        ASSERT_TRUE(storage.get(name).get());
+        EXPECT_EQ(d->getContent(), storage.get(name)->getContent());
+        EXPECT_EQ(1, storage.getCacheStats().hits_);
+
+        d = makeData(2);
+        storage.put(d);
+        ASSERT_TRUE(storage.get(name).get());
+        EXPECT_EQ(d->getContent(), storage.get(name)->getContent());
+
+        // batched record replaces cached one only once it is committed
+        StorageEngine::WriteSettings ws;
+        ws.batch_ = true;
+        ws.flushOnFrame_ = false;
+        storage.setWriteSettings(ws);
+
+        boost::shared_ptr<Data> batched = makeData(3);
+        storage.put(std::vector<boost::shared_ptr<const Data>>({batched}));
+        ASSERT_TRUE(storage.get(name).get());
+        EXPECT_EQ(d->getContent(), storage.get(name)->getContent());
+
+        storage.flush();
+        Interest i(Name(name).getPrefix(-1), 1000);
+        i.setCanBePrefix(true);
+        ASSERT_TRUE(storage.read(i).get());
+        EXPECT_EQ(batched->getContent(), storage.read(i)->getContent());
+        EXPECT_EQ(batched->getContent(), storage.get(name)->getContent());
+    }
+
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestBenchmarkKeyFormats)
+{
+#ifndef __ANDROID__
+    std::string legacyDbPath("/tmp/testdb-legacy"), dbPath("/tmp/testdb-binary");
+#else
+    std::string legacyDbPath("/data/local/tmp/testdb-legacy"), dbPath("/data/local/tmp/testdb-binary");
+#endif
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nThreads = 3, nFrames = 3000, nSegments = 5, nLookups = 1000;
+    std::string streamPrefix = "/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera";
+    std::vector<uint8_t> payload(1000, 0xab);
+
+    { // populate DB with name URI keys, like the storage used to do
+        db_namespace::DB* db;
+        db_namespace::Options options;
+        options.create_if_missing = true;
+        ASSERT_TRUE(db_namespace::DB::Open(options, legacyDbPath, &db).ok());
+
+        for (int t = 0; t < nThreads; ++t)
+            for (int f = 0; f < nFrames; ++f)
+                for (int seg = 0; seg < nSegments; ++seg)
+                {
+                    Name n(streamPrefix+"/thread"+std::to_string(t)+"/d");
+                    n.appendSequenceNumber(f).appendSegment(seg);
+                    Data d(n);
+                    d.setContent(Blob(payload.data(), payload.size()));
+                    SigningPool::digestSign(d);
+                    db->Put(db_namespace::WriteOptions(), n.toUri(),
+                            db_namespace::Slice((const char*)d.wireEncode().buf(), d.wireEncode().size()));
+                }
+        delete db;
+    }
+
+    size_t nMigrated = StorageEngine::migrate(legacyDbPath, dbPath);
+    EXPECT_EQ(nThreads*nFrames*nSegments, nMigrated);
+    // destination already holds binary keys
+    EXPECT_THROW(StorageEngine::migrate(legacyDbPath, dbPath), std::runtime_error);
+
+    std::vector<std::pair<std::string, std::string>> dbs = {{"name URI keys", legacyDbPath},
+                                                            {"binary keys", dbPath}};
+    std::vector<Name> lookups;
+    for (int i = 0; i < nLookups; ++i)
+    {
+        Name n(streamPrefix+"/thread"+std::to_string(rand()%nThreads)+"/d");
+        n.appendSequenceNumber(rand()%nFrames);
+        lookups.push_back(n);
+    }
+
+    for (auto& db:dbs)
+    {
+        StorageEngine storage(db.second, true);
+        EXPECT_EQ(db.second == dbPath, storage.hasBinaryKeys());
+
+        boost::asio::io_service io;
+        std::vector<Name> prefixes;
+        Clock::time_point start = Clock::now();
+        storage.scanForLongestPrefixes(io, [&prefixes](const std::vector<Name>& pp){
+            prefixes = pp;
+        });
+        io.run();
+        double scanMs = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000.;
+
+        ASSERT_EQ(1, prefixes.size());
+        EXPECT_EQ(Name(streamPrefix), prefixes.front());
+        EXPECT_EQ(nMigrated, storage.getKeysNum());
+
+        start = Clock::now();
+        for (auto& n:lookups)
+        {
+            Interest i(n, 1000);
+            i.setCanBePrefix(true);
+            boost::shared_ptr<Data> d = storage.read(i);
+
+            ASSERT_TRUE(d.get());
+            EXPECT_TRUE(n.isPrefixOf(d->getName()));
+        }
+        double lookupUs = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/nLookups;
+
+        GT_PRINTF("%s: scan for longest prefixes %.2fms (%d keys), prefix lookup %.2fus\n",
+                  db.first.c_str(), scanMs, storage.getKeysNum(), lookupUs);
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(legacyDbPath, options);
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestBenchmarkChildSelection)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-children");
+#else
+    std::string dbPath("/data/local/tmp/testdb-children");
+#endif
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nSegments = 3, nLookups = 1000;
+    std::vector<uint8_t> payload(1000, 0xab);
+    Name threadPrefix("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+
+    for (int nFrames : {1000, 10000, 100000})
+    {
+        {
+            StorageEngine storage(dbPath);
+            StorageEngine::WriteSettings ws;
+            ws.batch_ = true;
+            storage.setWriteSettings(ws);
+
+            for (int f = 0; f < nFrames; ++f)
+            {
+                std::vector<boost::shared_ptr<const Data>> segments;
+                for (int seg = 0; seg < nSegments; ++seg)
+                {
+                    boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(threadPrefix).appendSequenceNumber(f).appendSegment(seg));
+                    d->setContent(Blob(payload.data(), payload.size()));
+                    SigningPool::digestSign(*d);
+                    segments.push_back(d);
+                }
+                storage.put(segments);
+            }
+
+            Interest rightmost(threadPrefix, 1000), leftmost(threadPrefix, 1000), frameOnly(threadPrefix, 1000);
+            rightmost.setCanBePrefix(true);
+            leftmost.setCanBePrefix(true);
+            leftmost.setChildSelector(0);
+            // none of the keys has less than two suffix components
+            frameOnly.setCanBePrefix(true);
+            frameOnly.setMaxSuffixComponents(1);
+
+            std::vector<std::pair<std::string, Interest*>> queries = {
+                {"rightmost", &rightmost}, {"leftmost", &leftmost}, {"rightmost, max suffix 1", &frameOnly}};
+
+            boost::shared_ptr<Data> d = storage.read(rightmost);
+            ASSERT_TRUE(d.get());
+            EXPECT_EQ(Name(threadPrefix).appendSequenceNumber(nFrames-1).appendSegment(nSegments-1), d->getName());
+            d = storage.read(leftmost);
+            ASSERT_TRUE(d.get());
+            EXPECT_EQ(Name(threadPrefix).appendSequenceNumber(0).appendSegment(0), d->getName());
+
+            for (auto& q:queries)
+            {
+                // exhaustive query is O(keys under prefix), run it fewer times
+                int n = (q.second == &frameOnly ? 10 : nLookups);
+                Clock::time_point start = Clock::now();
+                for (int i = 0; i < n; ++i)
+                    storage.read(*q.second);
+                double us = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/n;
+
+                GT_PRINTF("%d frames, %s: %.2fus per lookup\n", nFrames, q.first.c_str(), us);
+            }
+            EXPECT_FALSE(storage.read(frameOnly).get());
+        }
+
+        db_namespace::Options options;
+        db_namespace::DestroyDB(dbPath, options);
+    }
+}
+
+TEST(TestPersistentStorage, TestChildOrderKeyFormats)
+{
+#ifndef __ANDROID__
+    std::string legacyDbPath("/tmp/testdb-order-legacy"), dbPath("/tmp/testdb-order");
+#else
+    std::string legacyDbPath("/data/local/tmp/testdb-order-legacy"), dbPath("/data/local/tmp/testdb-order");
+#endif
+
+    Name frameName("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+    frameName.appendSequenceNumber(7);
+    std::vector<Name> names = {Name(frameName).appendSegment(0),
+                               Name(frameName).appendSegment(1),
+                               Name(frameName).appendSegment(256),
+                               Name(frameName).append(NameComponents::NameComponentParity).appendSegment(0),
+                               Name(frameName).append(NameComponents::NameComponentManifest)};
+    std::vector<boost::shared_ptr<const Data>> segments;
+    for (auto& n:names)
+    {
+        boost::shared_ptr<Data> d = boost::make_shared<Data>(n);
+        d->setContent(Blob(std::vector<uint8_t>(100, 0xab)));
+        SigningPool::digestSign(*d);
+        segments.push_back(d);
+    }
+
+    { // name URI keys
+        db_namespace::DB* db;
+        db_namespace::Options options;
+        options.create_if_missing = true;
+        ASSERT_TRUE(db_namespace::DB::Open(options, legacyDbPath, &db).ok());
+        for (auto& d:segments)
+            db->Put(db_namespace::WriteOptions(), d->getName().toUri(),
+                    db_namespace::Slice((const char*)d->wireEncode().buf(), d->wireEncode().size()));
+        delete db;
+    }
+    {
+        StorageEngine storage(dbPath);
+        storage.put(segments);
+    }
+
+    Interest rightmost(frameName, 1000), leftmost(frameName, 1000);
+    rightmost.setCanBePrefix(true);
+    leftmost.setCanBePrefix(true);
+    leftmost.setChildSelector(0);
+
+    { // "%00%00" < "%00%01" < "%00%01%00" < "_manifest" < "_parity"
+        StorageEngine storage(legacyDbPath, true);
+        ASSERT_FALSE(storage.hasBinaryKeys());
+        boost::shared_ptr<Data> d = storage.read(rightmost);
+        ASSERT_TRUE(d.get());
+        EXPECT_EQ(names[3], d->getName());
+        d = storage.read(leftmost);
+        ASSERT_TRUE(d.get());
+        EXPECT_EQ(names[0], d->getName());
+    }
+    { // "_manifest" < "_parity" < segment 0 < segment 1 < segment 256
+        StorageEngine storage(dbPath, true);
+        ASSERT_TRUE(storage.hasBinaryKeys());
+        boost::shared_ptr<Data> d = storage.read(rightmost);
+        ASSERT_TRUE(d.get());
+        EXPECT_EQ(names[2], d->getName());
+        d = storage.read(leftmost);
+        ASSERT_TRUE(d.get());
+        EXPECT_EQ(names[4], d->getName());
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(legacyDbPath, options);
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestBenchmarkConcurrentReads)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-reads");
+#else
+    std::string dbPath("/data/local/tmp/testdb-reads");
+#endif
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nFrames = 3000, nSegments = 5, nReads = 20000;
+    std::vector<uint8_t> payload(8000, 0xab);
+    Name threadPrefix("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/tiny/d");
+
+    {
+        StorageEngine storage(dbPath);
+        for (int f = 0; f < nFrames; ++f)
+        {
+            std::vector<boost::shared_ptr<const Data>> segments;
+            for (int seg = 0; seg < nSegments; ++seg)
+            {
+                boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(threadPrefix).appendSequenceNumber(f).appendSegment(seg));
+                d->setContent(Blob(payload.data(), payload.size()));
+                SigningPool::digestSign(*d);
+                segments.push_back(d);
+            }
+            storage.put(segments);
+        }
+    }
+
+    StorageEngine storage(dbPath, true);
+    double singleThreadRate = 0;
+
+    for (unsigned int nThreads = 1; nThreads <= std::max(4u, boost::thread::hardware_concurrency()); nThreads *= 2)
+    {
+        boost::atomic<int> nFailed(0);
+        std::vector<boost::shared_ptr<boost::thread>> threads;
+        Clock::time_point start = Clock::now();
+
+        for (unsigned int t = 0; t < nThreads; ++t)
+            threads.push_back(boost::make_shared<boost::thread>([&, t](){
+                unsigned int seed = t;
+                for (int i = 0; i < nReads/nThreads; ++i)
+                {
+                    Name n(threadPrefix);
+                    n.appendSequenceNumber(rand_r(&seed)%nFrames);
+
+                    boost::shared_ptr<Data> d;
+                    if (i%2)
+                        d = storage.get(n.appendSegment(rand_r(&seed)%nSegments));
+                    else
+                    {
+                        Interest interest(n, 1000);
+                        interest.setCanBePrefix(true);
+                        d = storage.read(interest);
+                    }
+
+                    if (!d || !n.isPrefixOf(d->getName()) || d->getContent().size() != 8000)
+                        nFailed++;
+                }
+            }));
+        for (auto& t:threads) t->join();
+
+        double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000000.;
+        double rate = (double)(nReads/nThreads*nThreads)/sec;
+        if (nThreads == 1) singleThreadRate = rate;
+
+        EXPECT_EQ(0, nFailed);
+        GT_PRINTF("%d threads: %.0f reads/sec (%.2fx)\n", nThreads, rate, rate/singleThreadRate);
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+}
+
+TEST(TestPersistentStorage, TestBenchmarkStartup)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-startup");
+#else
+    std::string dbPath("/data/local/tmp/testdb-startup");
+#endif
+
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nThreads = 3, nFrames = 10000, nSegments = 5;
+    std::vector<uint8_t> payload(1000, 0xab);
+    std::vector<std::string> streams = {"/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera",
+                                        "/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/audio/mic",
+                                        "/ndn/edu/wustl/jdd/clientA/ndnrtc/%FD%03/video/camera"};
+    size_t nKeys = 0, payloadSize = 0;
+
+    {
+        StorageEngine storage(dbPath);
+        for (auto& stream:streams)
+            for (int t = 0; t < nThreads; ++t)
+                for (int f = 0; f < nFrames; ++f)
+                {
+                    std::vector<boost::shared_ptr<const Data>> segments;
+                    for (int seg = 0; seg < nSegments; ++seg)
+                    {
+                        Name n(stream+"/thread"+std::to_string(t)+"/d");
+                        boost::shared_ptr<Data> d = boost::make_shared<Data>(n.appendSequenceNumber(f).appendSegment(seg));
+                        d->setContent(Blob(payload.data(), payload.size()));
+                        SigningPool::digestSign(*d);
+                        segments.push_back(d);
+                        payloadSize += d->wireEncode().size();
+                    }
+                    storage.put(segments);
+                    nKeys += segments.size();
+                }
+
+        // batched records are indexed only when the batch is committed
+        StorageEngine::WriteSettings ws;
+        ws.batch_ = true;
+        ws.flushOnFrame_ = false;
+        storage.setWriteSettings(ws);
+
+        boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(streams[0]+"/thread0/d").appendSequenceNumber(nFrames).appendSegment(0));
+        d->setContent(Blob(payload.data(), payload.size()));
+        SigningPool::digestSign(*d);
+        storage.put(d);
+        EXPECT_EQ(nKeys, storage.getKeysNum());
+
+        storage.flush();
+        nKeys++;
+        payloadSize += d->wireEncode().size();
+        EXPECT_EQ(nKeys, storage.getKeysNum());
+        EXPECT_EQ(payloadSize, storage.getPayloadSize());
+    }
+
+    std::vector<Name> indexedPrefixes, scannedPrefixes;
+    for (int rebuild = 0; rebuild < 2; ++rebuild)
+    {
+        if (rebuild)
+        {
+            // mark persisted index as stale, like after a crash of the writer
+            db_namespace::DB* db;
+            db_namespace::Options options;
+            ASSERT_TRUE(db_namespace::DB::Open(options, dbPath, &db).ok());
+            db->Put(db_namespace::WriteOptions(), StorageKey::IndexStateKey, "dirty");
+            delete db;
+        }
+
+        boost::asio::io_service io;
+        std::vector<Name>& prefixes = (rebuild ? scannedPrefixes : indexedPrefixes);
+        Clock::time_point start = Clock::now();
+        StorageEngine storage(dbPath, true);
+        storage.scanForLongestPrefixes(io, [&prefixes](const std::vector<Name>& pp){
+            prefixes = pp;
+        });
+        io.run();
+        double ms = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000.;
+
+        EXPECT_EQ(nKeys, storage.getKeysNum());
+        EXPECT_EQ(payloadSize, storage.getPayloadSize());
+        GT_PRINTF("%s: startup %.2fms (%d keys)\n", rebuild ? "full scan" : "persisted index",
+                  ms, storage.getKeysNum());
+    }
+
+    std::sort(indexedPrefixes.begin(), indexedPrefixes.end());
+    std::sort(scannedPrefixes.begin(), scannedPrefixes.end());
+    EXPECT_EQ(scannedPrefixes, indexedPrefixes);
+    // streams branch off right after the common /ndn/edu prefix
+    ASSERT_EQ(1, indexedPrefixes.size());
+    EXPECT_EQ(Name("/ndn/edu"), indexedPrefixes[0]);
+
     db_namespace::Options options;
     db_namespace::DestroyDB(dbPath, options);
 }
+
+TEST(TestPersistentStorage, TestBenchmarkScrubbing)
+{
+#ifndef __ANDROID__
+    std::string dbPath("/tmp/testdb-scrub");
+#else
+    std::string dbPath("/data/local/tmp/testdb-scrub");
 #endif
 
+    typedef boost::chrono::high_resolution_clock Clock;
+    int nFrames = 9000, gopSize = 30, nKeySegments = 10, nDeltaSegments = 2, nSeeks = 300;
+    std::vector<uint8_t> payload(8000, 0xab);
+    Name threadPrefix("/ndn/edu/ucla/remap/peter/app/ndnrtc/%FD%03/video/camera/hi");
+    size_t streamSize = 0;
+
+    // a frame is identified by its key (gop) number for key frames and by
+    // frame number for delta frames
+    boost::function<Name(int)> frameName = [&threadPrefix, gopSize](int f){
+        Name n(threadPrefix);
+        if (f%gopSize == 0)
+            n.append(std::string("k")).appendSequenceNumber(f/gopSize);
+        else
+            n.append(std::string("d")).appendSequenceNumber(f);
+        return n;
+    };
+
+    {
+        StorageEngine storage(dbPath);
+        for (int f = 0; f < nFrames; ++f)
+        {
+            std::vector<boost::shared_ptr<const Data>> segments;
+            for (int seg = 0; seg < (f%gopSize ? nDeltaSegments : nKeySegments); ++seg)
+            {
+                boost::shared_ptr<Data> d = boost::make_shared<Data>(Name(frameName(f)).appendSegment(seg));
+                d->setContent(Blob(payload.data(), payload.size()));
+                SigningPool::digestSign(*d);
+                segments.push_back(d);
+                streamSize += d->wireEncode().size();
+            }
+            storage.put(segments);
+        }
+    }
+
+    // seek targets are the same for every configuration; seeking to a frame
+    // needs its key frame and all deltas that precede it in the GOP
+    std::vector<int> seeks;
+    for (int i = 0; i < nSeeks; ++i)
+        seeks.push_back(rand()%nFrames);
+
+    StorageEngine storage(dbPath, true);
+    std::vector<std::pair<std::string, size_t>> configs = {{"no cache", 0},
+                                                           {"cache 10% of stream", streamSize/10},
+                                                           {"cache 50% of stream", streamSize/2}};
+
+    for (auto& c:configs)
+    {
+        storage.setCacheSize(c.second);
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            size_t nSegmentsRead = 0;
+            Clock::time_point start = Clock::now();
+
+            for (auto target:seeks)
+                for (int f = target - target%gopSize; f <= target; ++f)
+                {
+                    Interest i(frameName(f), 1000);
+                    i.setCanBePrefix(true);
+                    i.setChildSelector(0);
+
+                    boost::shared_ptr<Data> d = storage.read(i);
+                    ASSERT_TRUE(d.get());
+                    for (int seg = 1; seg < (f%gopSize ? nDeltaSegments : nKeySegments); ++seg)
+                    {
+                        d = storage.get(Name(frameName(f)).appendSegment(seg));
+                        ASSERT_TRUE(d.get());
+                    }
+                    nSegmentsRead += (f%gopSize ? nDeltaSegments : nKeySegments);
+                }
+
+            double ms = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000.;
+            StorageEngine::CacheStats stats = storage.getCacheStats();
+
+            GT_PRINTF("%s, pass %d: %.2fms per seek (%.1f segments), cache hits %llu misses %llu evictions %llu\n",
+                      c.first.c_str(), pass+1, ms/nSeeks, (double)nSegmentsRead/nSeeks,
+                      (unsigned long long)stats.hits_, (unsigned long long)stats.misses_,
+                      (unsigned long long)stats.evictions_);
+            EXPECT_LE(stats.sizeBytes_, c.second);
+        }
+    }
+
+    db_namespace::Options options;
+    db_namespace::DestroyDB(dbPath, options);
+}
+
 void handler(int sig) {
   void *array[10];
   size_t size;
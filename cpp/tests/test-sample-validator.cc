@@ -0,0 +1,142 @@
+//
+// test-sample-validator.cc
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <stdlib.h>
+#include <boost/asio.hpp>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/interest.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+
+#include "gtest/gtest.h"
+#include "src/frame-data.hpp"
+#include "src/frame-buffer.hpp"
+#include "src/sample-validator.hpp"
+#include "tests-helpers.hpp"
+#include "statistics.hpp"
+
+using namespace ndnrtc;
+using namespace ndnrtc::statistics;
+using namespace ndn;
+
+namespace {
+    // assembled frame and manifest of its segments
+    struct Frame {
+        std::vector<boost::shared_ptr<const Interest>> interests_;
+        std::vector<boost::shared_ptr<WireSegment>> segments_;
+        boost::shared_ptr<Manifest> manifest_;
+    };
+
+    Frame makeFrame(const std::string& frameName, size_t frameLen)
+    {
+        Frame frame;
+        VideoFramePacket vp = getVideoFramePacket(frameLen);
+        std::vector<VideoFrameSegment> segments = sliceFrame(vp);
+        std::vector<boost::shared_ptr<Data>> dataObjects = dataFromSegments(frameName, segments);
+        std::vector<boost::shared_ptr<Interest>> interests = getInterests(frameName, 0, dataObjects.size());
+        std::vector<boost::shared_ptr<const Data>> manifestSegments;
+
+        for (int i = 0; i < dataObjects.size(); ++i)
+        {
+            dataObjects[i]->setSignature(DigestSha256Signature());
+            dataObjects[i]->wireEncode();
+            manifestSegments.push_back(dataObjects[i]);
+            frame.segments_.push_back(boost::make_shared<WireData<VideoFrameSegmentHeader>>(dataObjects[i], interests[i]));
+        }
+
+        frame.interests_ = makeInterestsConst(interests);
+        frame.manifest_ = boost::make_shared<Manifest>(manifestSegments);
+
+        return frame;
+    }
+
+    void assemble(BufferSlot& slot, const Frame& frame)
+    {
+        slot.clear();
+        slot.segmentsRequested(frame.interests_);
+        for (auto& s:frame.segments_)
+            slot.segmentReceived(s);
+    }
+
+    // runs face thread handlers until slot's verification status is known
+    bool waitVerification(boost::asio::io_service& faceIo, const BufferSlot& slot)
+    {
+        for (int i = 0; i < 2000 && slot.getVerificationStatus() == BufferSlot::Verification::Unknown; ++i)
+        {
+            faceIo.poll();
+            faceIo.reset();
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+        }
+
+        return slot.getVerificationStatus() != BufferSlot::Verification::Unknown;
+    }
+}
+
+TEST(TestManifestValidator, TestVerifyInBackground)
+{
+    std::string frameName = "/ndn/edu/ucla/remap/ndncon/instance1/ndnrtc/%FD%03/video/camera/hd/d/%FE%07";
+    Frame frame = makeFrame(frameName, 30000);
+    boost::asio::io_service faceIo;
+    boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+    boost::shared_ptr<ManifestValidator> validator(boost::make_shared<ManifestValidator>(faceIo,
+        boost::shared_ptr<Face>(), boost::shared_ptr<KeyChain>(), storage, 2));
+    boost::shared_ptr<BufferSlot> slot(boost::make_shared<BufferSlot>());
+
+    assemble(*slot, frame);
+    ASSERT_EQ(BufferSlot::Ready, slot->getState());
+
+    validator->setManifest(slot, frame.manifest_);
+    EXPECT_EQ(BufferSlot::Verification::Unknown, slot->getVerificationStatus());
+
+    ASSERT_TRUE(waitVerification(faceIo, *slot));
+    EXPECT_EQ(BufferSlot::Verification::Verified, slot->getVerificationStatus());
+    EXPECT_EQ(1, (*storage)[Indicator::VerifySuccess]);
+    EXPECT_EQ(0, (*storage)[Indicator::VerifyFailure]);
+    EXPECT_LT(0, (*storage)[Indicator::VerifyLatency]);
+}
+
+TEST(TestManifestValidator, TestReuseSlotWhileVerifying)
+{
+    std::string threadPrefix = "/ndn/edu/ucla/remap/ndncon/instance1/ndnrtc/%FD%03/video/camera/hd/d/";
+    Frame frame1 = makeFrame(threadPrefix+"%FE%07", 30000);
+    Frame frame2 = makeFrame(threadPrefix+"%FE%08", 20000);
+    Frame frame3 = makeFrame(threadPrefix+"%FE%09", 10000);
+    boost::asio::io_service faceIo;
+    boost::shared_ptr<StatisticsStorage> storage(StatisticsStorage::createConsumerStatistics());
+    boost::shared_ptr<ManifestValidator> validator(boost::make_shared<ManifestValidator>(faceIo,
+        boost::shared_ptr<Face>(), boost::shared_ptr<KeyChain>(), storage, 2));
+    boost::shared_ptr<BufferSlot> slot(boost::make_shared<BufferSlot>());
+
+    // frame 1 is being verified in background, while slot is reused for
+    // frame 2; result for frame 1 is delivered on the face thread only
+    // after that, so it must be discarded and frame 2 verified instead
+    assemble(*slot, frame1);
+    validator->setManifest(slot, frame1.manifest_);
+    assemble(*slot, frame2);
+    validator->setManifest(slot, frame2.manifest_);
+    EXPECT_EQ(BufferSlot::Verification::Unknown, slot->getVerificationStatus());
+
+    ASSERT_TRUE(waitVerification(faceIo, *slot));
+    EXPECT_EQ(BufferSlot::Verification::Verified, slot->getVerificationStatus());
+    EXPECT_EQ(1, (*storage)[Indicator::VerifySuccess]);
+    EXPECT_EQ(0, (*storage)[Indicator::VerifyFailure]);
+
+    // reused slot checked against manifest of another frame fails
+    assemble(*slot, frame3);
+    validator->setManifest(slot, frame1.manifest_);
+
+    ASSERT_TRUE(waitVerification(faceIo, *slot));
+    EXPECT_EQ(BufferSlot::Verification::Failed, slot->getVerificationStatus());
+    EXPECT_EQ(1, (*storage)[Indicator::VerifySuccess]);
+    EXPECT_EQ(1, (*storage)[Indicator::VerifyFailure]);
+}
+
+//******************************************************************************
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
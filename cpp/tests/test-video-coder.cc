@@ -9,6 +9,8 @@
 #include <ctime>
 #include <stdlib.h>
 #include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <boost/make_shared.hpp>
 
 #include "gtest/gtest.h"
 #include "src/video-coder.hpp"
@@ -872,6 +874,111 @@ TEST(TestCoder, TestEnforceKeyTimed)
 }
 #endif
 
+TEST(TestFrameScaler, TestBufferPool)
+{
+    int width = 1280, height = 720;
+    WebRtcVideoFrame source(std::move(getFrame(width, height)));
+    FrameScaler scale(width / 2, height / 2, 2);
+
+    EXPECT_EQ(1, scale.getAllocatedNum());
+
+    { // frames that are released give their buffers back to the pool
+        for (int i = 0; i < 10; ++i)
+        {
+            WebRtcVideoFrame f = scale(source);
+            EXPECT_EQ(width / 2, f.width());
+            EXPECT_EQ(height / 2, f.height());
+        }
+        EXPECT_EQ(1, scale.getAllocatedNum());
+    }
+
+    { // frames that are held keep their buffers
+        std::vector<WebRtcVideoFrame> held;
+        for (int i = 0; i < 4; ++i)
+            held.push_back(scale(source));
+
+        EXPECT_EQ(4, scale.getAllocatedNum());
+        for (int i = 1; i < held.size(); ++i)
+            EXPECT_NE(held[i - 1].video_frame_buffer().get(), held[i].video_frame_buffer().get());
+    }
+
+    { // only pooled buffers are reused
+        WebRtcVideoFrame f1 = scale(source);
+        WebRtcVideoFrame f2 = scale(source);
+        EXPECT_EQ(4, scale.getAllocatedNum());
+    }
+
+    { // frames of target size are passed through
+        FrameScaler noScale(width, height);
+        WebRtcVideoFrame f = noScale(source);
+        EXPECT_EQ(source.video_frame_buffer().get(), f.video_frame_buffer().get());
+    }
+}
+
+namespace
+{
+// scales every frame to all levels, either from the source or from the
+// previous level
+void scaleFrames(const WebRtcVideoFrame &source, std::vector<boost::shared_ptr<FrameScaler>> &levels,
+                 bool cascaded, int nFrames)
+{
+    for (int i = 0; i < nFrames; ++i)
+    {
+        WebRtcVideoFrame f(source);
+        for (auto &scale : levels)
+            f = (*scale)(cascaded ? f : source);
+    }
+}
+}
+
+TEST(TestFrameScaler, TestBenchmarkScaling)
+{
+    int nFrames = 100;
+    WebRtcVideoFrame source(std::move(getFrame(1920, 1080)));
+    std::vector<std::pair<int, int>> resolutions = {{1280, 720}, {640, 360}, {320, 180}};
+
+    GT_PRINTF("Scaling 1080p into 720p, 360p and 180p, %d frames per stream\n", nFrames);
+
+    for (int nStreams = 1; nStreams <= 8; nStreams *= 2)
+    {
+        std::vector<std::vector<boost::shared_ptr<FrameScaler>>> scalers(nStreams);
+        for (auto &levels : scalers)
+            for (auto r : resolutions)
+                levels.push_back(boost::make_shared<FrameScaler>(r.first, r.second));
+
+        // all streams scaled on one thread
+        high_resolution_clock::time_point start = high_resolution_clock::now();
+        for (auto &levels : scalers)
+            scaleFrames(source, levels, false, nFrames);
+        double sharedMs = (double)duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.;
+
+        // each stream scaled on its own thread
+        double parallelMs[2];
+        for (int cascaded = 0; cascaded < 2; ++cascaded)
+        {
+            std::vector<boost::shared_ptr<boost::thread>> threads;
+            start = high_resolution_clock::now();
+            for (auto &levels : scalers)
+                threads.push_back(boost::make_shared<boost::thread>([&source, &levels, cascaded, nFrames]() {
+                    scaleFrames(source, levels, cascaded, nFrames);
+                }));
+            for (auto &t : threads)
+                t->join();
+            parallelMs[cascaded] = (double)duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1000.;
+        }
+
+        int total = nStreams * nFrames;
+        GT_PRINTF("%d streams: one thread %.0f fps, thread per stream %.0f fps, "
+                  "thread per stream cascaded %.0f fps\n",
+                  nStreams, 1000. * total / sharedMs, 1000. * total / parallelMs[0],
+                  1000. * total / parallelMs[1]);
+
+        for (auto &levels : scalers)
+            for (auto &scale : levels)
+                EXPECT_EQ(1, scale->getAllocatedNum());
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
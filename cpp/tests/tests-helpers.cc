@@ -5,6 +5,8 @@
 //  Copyright 2013-2016 Regents of the University of California
 //
 
+#include <stdlib.h>
+#include <new>
 #include <boost/assign.hpp>
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/threadsafe-face.hpp>
@@ -15,6 +17,28 @@ using namespace std;
 using namespace ndnrtc;
 using namespace ndn;
 
+std::atomic<bool> countAllocations(false);
+std::atomic<size_t> allocationsNum(0), allocatedBytes(0);
+
+void *operator new(std::size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+    {
+        allocationsNum.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
 static uint8_t DEFAULT_RSA_PUBLIC_KEY_DER[] = {
     0x30, 0x82, 0x01, 0x22, 0x30, 0x0d, 0x06, 0x09, 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01,
     0x01, 0x05, 0x00, 0x03, 0x82, 0x01, 0x0f, 0x00, 0x30, 0x82, 0x01, 0x0a, 0x02, 0x82, 0x01, 0x01,
@@ -11,6 +11,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <boost/thread.hpp>
 #include <boost/chrono.hpp>
 #include <boost/asio.hpp>
@@ -94,6 +95,13 @@ memoryKeyChain(const std::string name);
 
 bool checkNfd();
 
+// heap allocations made while countAllocations is set are counted in
+// allocationsNum (allocatedBytes in total); global operator new is replaced
+// in tests-helpers.cc. Counters are atomic, as face and worker threads
+// allocate while a count is running
+extern std::atomic<bool> countAllocations;
+extern std::atomic<size_t> allocationsNum, allocatedBytes;
+
 namespace testing
 {
 namespace internal
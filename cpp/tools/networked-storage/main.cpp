@@ -6,6 +6,7 @@
 //
 
 #include <iostream>
+#include <algorithm>
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +16,7 @@
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread.hpp>
+#include <boost/chrono.hpp>
 #include <ndn-cpp/threadsafe-face.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
 #include <ndn-cpp/security/certificate/identity-certificate.hpp>
@@ -27,17 +29,24 @@
 #include "../../include/name-components.hpp"
 #include "../../include/simple-log.hpp"
 #include "../../include/storage-engine.hpp"
+#include "storage-server.hpp"
 
 static const char USAGE[] =
 R"(Networked Storage.
 
     Usage:
-      networked-storage <db_path> [--verbose]
+      networked-storage <db_path> [--threads=<n>] [--cache=<n>] [--verbose]
+      networked-storage <db_path> --load-test [--interests=<n>] [--window=<n>] [--threads=<n>] [--cache=<n>] [--verbose]
 
     Arguments:
       <db_path>            Path to persistent storage DB
 
     Options:
+      -t --threads=<n>     Number of DB reader threads (0 - read on face thread) [default: 4]
+      -c --cache=<n>       Number of hot segments kept in memory [default: 10000]
+      -l --load-test       Serve locally generated interests (no NFD) and report throughput
+      -n --interests=<n>   Number of interests to generate in load test [default: 100000]
+      -w --window=<n>      Number of outstanding interests in load test [default: 64]
       -v --verbose         Verbose output
 )";
 
@@ -48,7 +57,9 @@ using namespace ndnrtc;
 static bool mustExit = false;
 
 void registerPrefix(boost::shared_ptr<Face> &face, const Name &prefix,
-                    boost::shared_ptr<StorageEngine> storage);
+                    boost::shared_ptr<StorageServer> server);
+int runLoadTest(boost::asio::io_service &io, boost::shared_ptr<StorageEngine> storage,
+                boost::shared_ptr<StorageServer> server, size_t nInterests, size_t window);
 
 void handler(int sig)
 {
@@ -105,8 +116,21 @@ int main(int argc, char **argv)
     });
 
     // setup storage
+    boost::chrono::steady_clock::time_point startupTime = boost::chrono::steady_clock::now();
     boost::shared_ptr<StorageEngine> storage = 
         boost::make_shared<StorageEngine>(args["<db_path>"].asString(), true);
+    boost::shared_ptr<StorageServer> server =
+        boost::make_shared<StorageServer>(io, storage, args["--threads"].asLong(), args["--cache"].asLong());
+    server->setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+
+    if (args["--load-test"].asBool())
+    {
+        err = runLoadTest(io, storage, server, args["--interests"].asLong(), args["--window"].asLong());
+        server.reset();
+        work.reset();
+        t.join();
+        return err;
+    }
 
     // setup face and keychain
     boost::shared_ptr<Face> face = boost::make_shared<ThreadsafeFace>(io);
@@ -115,8 +139,10 @@ int main(int argc, char **argv)
     face->setCommandSigningInfo(*keyChain, keyChain->getDefaultCertificateName());
 
     LogInfo("") << "Scanning available prefixes..." << std::endl;
-    storage->scanForLongestPrefixes(io, [&face, storage](const vector<Name>& pp){
-        LogInfo("") << "Scan completed. total keys: " << storage->getKeysNum() 
+    storage->scanForLongestPrefixes(io, [&face, storage, server, startupTime](const vector<Name>& pp){
+        LogInfo("") << "Scan completed in "
+            << boost::chrono::duration_cast<boost::chrono::milliseconds>(boost::chrono::steady_clock::now()-startupTime).count()
+            << "ms. total keys: " << storage->getKeysNum() 
             << ", payload size ~ " << storage->getPayloadSize()/1024/1024
             << "MB, number of longest prefixes: " << pp.size() << endl;
 
@@ -124,7 +150,7 @@ int main(int argc, char **argv)
             LogInfo("") << "\t" << n << endl;
 
         for (auto n:pp)
-            registerPrefix(face, n, storage);
+            registerPrefix(face, n, server);
     });
 
     {
@@ -137,6 +163,7 @@ int main(int argc, char **argv)
     LogInfo("") << "Shutting down gracefully..." << endl;
 
     keyChain.reset();
+    server.reset();
     face->shutdown();
     face.reset();
     work.reset();
@@ -147,25 +174,22 @@ int main(int argc, char **argv)
 }
 
 void registerPrefix(boost::shared_ptr<Face> &face, const Name &prefix, 
-    boost::shared_ptr<StorageEngine> storage)
+    boost::shared_ptr<StorageServer> server)
 {
     LogInfo("") << "Registering prefix " << prefix << std::endl;
     face->registerPrefix(prefix,
-                         [storage](const boost::shared_ptr<const Name> &prefix,
+                         [server](const boost::shared_ptr<const Name> &prefix,
                             const boost::shared_ptr<const Interest> &interest,
                             Face &face, uint64_t, const boost::shared_ptr<const InterestFilter> &) 
                             {
                              LogTrace("") << "Incoming interest " << interest->getName() << std::endl;
-                             boost::shared_ptr<Data> d = storage->read(*interest);
-
-                             if (d)
-                             {
-                                LogTrace("") << "Retrieved data of size " << d->getContent().size() 
-                                             << ": " << d->getName() << std::endl;
-                                face.putData(*d);
-                             }
-                             else
-                                LogTrace("") << "no data for " << interest->getName() << std::endl;
+                             server->onInterest(interest, 
+                                [&face](const boost::shared_ptr<const Interest>&,
+                                        const boost::shared_ptr<const Data>& d)
+                                {
+                                    if (d)
+                                        face.putData(*d);
+                                });
                          },
                          [](const boost::shared_ptr<const Name> &prefix) 
                          {
@@ -175,4 +199,111 @@ void registerPrefix(boost::shared_ptr<Face> &face, const Name &prefix,
                          {
                              LogInfo("") << "Successfully registered prefix " << *p << std::endl;
                          });
-}
\ No newline at end of file
+}
+
+// Issues interests for names sampled from the storage, keeping `window`
+// interests outstanding, and reports served interests/sec and latency.
+// 80% of interests go to 10% of names, to let hot segments stay in cache;
+// every tenth interest asks for a frame prefix instead of exact name.
+int runLoadTest(boost::asio::io_service &io, boost::shared_ptr<StorageEngine> storage,
+                boost::shared_ptr<StorageServer> server, size_t nInterests, size_t window)
+{
+    static const size_t MaxNames = 100000;
+    typedef boost::chrono::steady_clock Clock;
+
+    boost::asio::io_service scanIo;
+    storage->scanForLongestPrefixes(scanIo, [](const vector<Name>&){});
+    scanIo.run();
+
+    size_t stride = max<size_t>(1, storage->getKeysNum()/MaxNames), idx = 0;
+    vector<Name> names;
+    storage->scanNames([&names, &idx, stride](const Name& n){
+        if (idx++ % stride == 0)
+            names.push_back(n);
+        return names.size() < MaxNames;
+    });
+
+    if (names.size() == 0)
+    {
+        LogError("") << "storage is empty" << endl;
+        return 1;
+    }
+
+    random_shuffle(names.begin(), names.end());
+    size_t nHot = max<size_t>(1, names.size()/10);
+
+    vector<boost::shared_ptr<const Interest>> interests;
+    for (size_t i = 0; i < nInterests; ++i)
+    {
+        const Name& n = (rand()%10 < 8 ? names[rand()%nHot] : names[rand()%names.size()]);
+        boost::shared_ptr<Interest> interest;
+
+        if (i%10 == 0 && n.size() > 1)
+        {
+            interest = boost::make_shared<Interest>(n.getPrefix(-1), 1000);
+            interest->setCanBePrefix(true);
+        }
+        else
+            interest = boost::make_shared<Interest>(n, 1000);
+        interests.push_back(interest);
+    }
+
+    LogInfo("") << "sampled " << names.size() << " names out of " << storage->getKeysNum()
+                << ", issuing " << nInterests << " interests (window " << window << ")" << endl;
+
+    // accessed on the face thread, except for `finished`
+    vector<int64_t> latencies;
+    latencies.reserve(nInterests);
+    size_t nIssued = 0, nNoData = 0;
+    bool finished = false;
+    boost::mutex mtx;
+    boost::condition_variable done;
+    Clock::time_point start = Clock::now();
+
+    boost::function<void()> issueNext;
+    issueNext = [&]() {
+        if (nIssued == interests.size() || mustExit)
+        {
+            if (latencies.size() == nIssued)
+            {
+                boost::lock_guard<boost::mutex> scopedLock(mtx);
+                finished = true;
+                done.notify_one();
+            }
+            return;
+        }
+
+        Clock::time_point issued = Clock::now();
+        server->onInterest(interests[nIssued++],
+            [&, issued](const boost::shared_ptr<const Interest>&, const boost::shared_ptr<const Data>& d){
+                latencies.push_back(boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-issued).count());
+                if (!d) nNoData++;
+                // post, as cache hits complete synchronously
+                io.post([&](){ issueNext(); });
+            });
+    };
+
+    {
+        boost::unique_lock<boost::mutex> lock(mtx);
+        io.post([&](){
+            for (size_t i = 0; i < window; ++i)
+                issueNext();
+        });
+        while (!finished)
+            done.wait_for(lock, boost::chrono::milliseconds(100));
+    }
+
+    if (latencies.size() < interests.size())
+        return 1;
+
+    double sec = (double)boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now()-start).count()/1000000.;
+    sort(latencies.begin(), latencies.end());
+
+    const StorageServer::Stats& stats = server->getStats();
+    LogInfo("") << "served " << latencies.size()-nNoData << " of " << latencies.size() << " interests in " << sec << " sec: "
+                << (double)latencies.size()/sec << " interests/sec, latency p50 "
+                << latencies[latencies.size()/2] << "us, p99 " << latencies[latencies.size()*99/100]
+                << "us; cache hits " << stats.nCacheHits_ << ", evictions " << stats.nCacheEvictions_ << endl;
+
+    return 0;
+}
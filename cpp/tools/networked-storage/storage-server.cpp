@@ -0,0 +1,132 @@
+//
+// storage-server.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include "storage-server.hpp"
+
+#include <cstring>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/interest.hpp>
+
+#include "../../include/storage-engine.hpp"
+#include "../../src/persistent-storage/storage-key.hpp"
+
+using namespace std;
+using namespace ndnrtc;
+using namespace ndn;
+
+StorageServer::StorageServer(boost::asio::io_service& faceIo,
+                             const boost::shared_ptr<StorageEngine>& storage,
+                             unsigned int nThreads, size_t cacheSize)
+    : faceIo_(faceIo), storage_(storage),
+      work_(boost::make_shared<boost::asio::io_service::work>(workIo_)),
+      cacheSize_(cacheSize)
+{
+    description_ = "storage-server";
+    memset(&stats_, 0, sizeof(stats_));
+
+    for (unsigned int i = 0; i < nThreads; ++i)
+        threads_.push_back(boost::make_shared<boost::thread>([this]() {
+            workIo_.run();
+        }));
+}
+
+StorageServer::~StorageServer()
+{
+    work_.reset();
+    workIo_.stop();
+
+    for (auto &t : threads_)
+        t->join();
+}
+
+void StorageServer::onInterest(const boost::shared_ptr<const Interest>& interest,
+                               OnData onData)
+{
+    stats_.nInterests_++;
+
+    if (cacheSize_ && !interest->getCanBePrefix())
+    {
+        boost::shared_ptr<const Data> d = lookup(StorageKey::fromName(interest->getName()));
+        if (d)
+        {
+            stats_.nCacheHits_++;
+            stats_.nServed_++;
+            onData(interest, d);
+            return;
+        }
+    }
+
+    if (threads_.size() == 0)
+    {
+        onRead(interest, storage_->read(*interest), onData);
+        return;
+    }
+
+    boost::weak_ptr<StorageServer> me = boost::dynamic_pointer_cast<StorageServer>(shared_from_this());
+    boost::shared_ptr<StorageEngine> storage = storage_;
+    boost::asio::io_service& faceIo = faceIo_;
+
+    workIo_.post([me, storage, &faceIo, interest, onData]() {
+        boost::shared_ptr<const Data> d = storage->read(*interest);
+
+        faceIo.post([me, interest, d, onData]() {
+            boost::shared_ptr<StorageServer> server = me.lock();
+            if (server)
+                server->onRead(interest, d, onData);
+        });
+    });
+}
+
+//******************************************************************************
+boost::shared_ptr<const Data> StorageServer::lookup(const string& key)
+{
+    auto it = cache_.find(key);
+    if (it == cache_.end())
+        return boost::shared_ptr<const Data>();
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+void StorageServer::insert(const boost::shared_ptr<const Data>& data)
+{
+    string key = StorageKey::fromName(data->getName());
+    if (cache_.find(key) != cache_.end())
+        return;
+
+    lru_.push_front(make_pair(key, data));
+    cache_[key] = lru_.begin();
+
+    if (lru_.size() > cacheSize_)
+    {
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+        stats_.nCacheEvictions_++;
+    }
+}
+
+void StorageServer::onRead(const boost::shared_ptr<const Interest>& interest,
+                           const boost::shared_ptr<const Data>& data,
+                           OnData onData)
+{
+    if (data)
+    {
+        stats_.nServed_++;
+        if (cacheSize_)
+            insert(data);
+
+        LogTraceC << "retrieved data of size " << data->getContent().size()
+                  << ": " << data->getName() << std::endl;
+    }
+    else
+    {
+        stats_.nNoData_++;
+        LogTraceC << "no data for " << interest->getName() << std::endl;
+    }
+
+    onData(interest, data);
+}
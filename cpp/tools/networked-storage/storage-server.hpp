@@ -0,0 +1,89 @@
+//
+// storage-server.hpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#ifndef __storage_server_hpp__
+#define __storage_server_hpp__
+
+#include <list>
+#include <unordered_map>
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+#include "../../src/ndnrtc-object.hpp"
+
+namespace ndn {
+    class Data;
+    class Interest;
+}
+
+namespace ndnrtc {
+    class StorageEngine;
+
+    /**
+     * Answers interests from persistent storage. Interests are received on
+     * the face thread; DB reads are done by a pool of worker threads and
+     * results are passed back to the face thread. Most recently served
+     * segments are kept in memory and interests for exact names are answered
+     * from there without touching the DB.
+     */
+    class StorageServer : public NdnRtcComponent {
+    public:
+        typedef boost::function<void(const boost::shared_ptr<const ndn::Interest>&,
+                                     const boost::shared_ptr<const ndn::Data>&)> OnData;
+
+        typedef struct _Stats {
+            uint64_t nInterests_, nServed_, nNoData_;
+            uint64_t nCacheHits_, nCacheEvictions_;
+        } Stats;
+
+        /**
+         * @param faceIo io_service of the face thread
+         * @param storage Storage to read data from
+         * @param nThreads Number of reader threads. If 0, data is read on
+         *                 the face thread.
+         * @param cacheSize Maximum number of segments kept in memory
+         */
+        StorageServer(boost::asio::io_service& faceIo,
+                      const boost::shared_ptr<StorageEngine>& storage,
+                      unsigned int nThreads, size_t cacheSize);
+        ~StorageServer();
+
+        /**
+         * Must be called on the face thread. onData is called on the face
+         * thread with retrieved data or with invalid pointer if there is no
+         * data for the interest.
+         */
+        void onInterest(const boost::shared_ptr<const ndn::Interest>& interest,
+                        OnData onData);
+
+        const Stats& getStats() const { return stats_; }
+
+    private:
+        typedef std::list<std::pair<std::string, boost::shared_ptr<const ndn::Data>>> LruList;
+
+        boost::asio::io_service& faceIo_;
+        boost::shared_ptr<StorageEngine> storage_;
+        boost::asio::io_service workIo_;
+        boost::shared_ptr<boost::asio::io_service::work> work_;
+        std::vector<boost::shared_ptr<boost::thread>> threads_;
+
+        // accessed on the face thread only
+        size_t cacheSize_;
+        LruList lru_;
+        std::unordered_map<std::string, LruList::iterator> cache_;
+        Stats stats_;
+
+        boost::shared_ptr<const ndn::Data> lookup(const std::string& key);
+        void insert(const boost::shared_ptr<const ndn::Data>& data);
+        void onRead(const boost::shared_ptr<const ndn::Interest>& interest,
+                    const boost::shared_ptr<const ndn::Data>& data,
+                    OnData onData);
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+//
+// main.cpp
+//
+//  Copyright 2013-2019 Regents of the University of California
+//  For licensing details see the LICENSE file.
+//
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <boost/chrono.hpp>
+
+#include "../../contrib/docopt/docopt.h"
+#include "../../include/simple-log.hpp"
+#include "../../include/storage-engine.hpp"
+
+static const char USAGE[] =
+R"(Storage Migrate.
+    Converts persistent storage DB keyed by name URIs into DB keyed by
+    binary-encoded names.
+
+    Usage:
+      storage-migrate <legacy_db_path> <db_path> [--verbose]
+
+    Arguments:
+      <legacy_db_path>     Path to existing DB with name URI keys
+      <db_path>            Path to new DB
+
+    Options:
+      -v --verbose         Verbose output
+)";
+
+using namespace std;
+using namespace ndnrtc;
+
+int main(int argc, char **argv)
+{
+    ndnlog::new_api::Logger::initAsyncLogging();
+
+    map<string, docopt::value> args
+        = docopt::docopt(USAGE,
+                         { argv + 1, argv + argc },
+                         true,               // show help if requested
+                         (string("Storage Migrate ")+string(PACKAGE_VERSION)).c_str());  // version string
+
+    ndnlog::new_api::Logger::getLogger("").setLogLevel(args["--verbose"].asBool() ? ndnlog::NdnLoggerDetailLevelAll : ndnlog::NdnLoggerDetailLevelDefault);
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+    try
+    {
+        size_t nKeys = StorageEngine::migrate(args["<legacy_db_path>"].asString(),
+                                              args["<db_path>"].asString(),
+                                              [](size_t n){
+                                                  LogDebug("") << "copied " << n << " keys" << endl;
+                                              });
+        double sec = (double)boost::chrono::duration_cast<boost::chrono::milliseconds>(boost::chrono::steady_clock::now()-start).count()/1000.;
+
+        LogInfo("") << "migrated " << nKeys << " keys in " << sec << " sec" << endl;
+    }
+    catch (exception &e)
+    {
+        LogError("") << "migration failed: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -33,12 +33,13 @@ static const char USAGE[] =
 R"(Stream Recorder.
 
     Usage:
-      stream-recorder <thread_prefix> [--db-path=<db_path> --direction=<dir> | --seed=<seed_frame> | --noverify | --limit=<n_frames> | --pipeline=<p_size> | --lifetime=<ms> | --verbose]
+      stream-recorder <thread_prefix>... [--db-path=<db_path> --direction=<dir> | --seed=<seed_frame> | --noverify | --limit=<n_frames> | --pipeline=<p_size> | --max-pipeline=<p_max> | --lifetime=<ms> | --verbose]
 
     Arguments:
       <thread_prefix>      ndnrtc (API v3) stream prefix WITH thread name. For example:
                             /ndn/user/rtc/ndnrtc/%FD%03/video/camera/%FC%00%00%01fU%98%BBA/1080p
                            See [ndnrtc namespace](https://github.com/remap/ndnrtc/blob/master/docs/namespace.pdf) for more info.
+                           Several thread prefixes may be provided to record threads concurrently.
 
     Options:
       --db-path=<db_path>  Path for persistent storage DB [default: /tmp/ndnrtc-db]
@@ -47,7 +48,10 @@ R"(Stream Recorder.
       --noverify           Specifies, whether verification is not needed
       --limit=<n_frames>   Fetches only n_frames and quits. If omitted or zero - fetches all until stopped [default: 0]
       --lifetime=<ms>      Interests lifetime in milliseconds [default: 3000]
-      --pipeline=<p_size>  Specify pipeline size *in frames* [default: 5]
+      --pipeline=<p_size>  Specify initial (minimal) pipeline size *in frames* [default: 5]
+      --max-pipeline=<p_max>  Maximal pipeline size *in frames*; pipeline is adjusted to DRD,
+                           segment rate and lag behind live. Not greater than p_size disables
+                           adjustment [default: 60]
       -v --verbose         Verbose output
 )";
 
@@ -96,12 +100,17 @@ int main(int argc, char **argv)
 
     ndnlog::new_api::Logger::getLogger("").setLogLevel(args["--verbose"].asBool() ? ndnlog::NdnLoggerDetailLevelAll : ndnlog::NdnLoggerDetailLevelDefault);
 
-    NamespaceInfo prefixInfo;
-    if (!NameComponents::extractInfo(args["<thread_prefix>"].asString(), prefixInfo) ||
-            prefixInfo.threadName_ == "")
+    std::vector<NamespaceInfo> prefixInfos;
+    for (auto p:args["<thread_prefix>"].asStringList())
     {
-        LogError("") << "Bad thread prefix provided" << endl;
-        exit(1);
+        NamespaceInfo prefixInfo;
+        if (!NameComponents::extractInfo(p, prefixInfo) ||
+                prefixInfo.threadName_ == "")
+        {
+            LogError("") << "Bad thread prefix provided: " << p << endl;
+            exit(1);
+        }
+        prefixInfos.push_back(prefixInfo);
     }
 
     int err = 0;
@@ -134,14 +143,9 @@ int main(int argc, char **argv)
     // uint8_t directionMask;
     // StreamRecorder::FetchDirection::Forward
     {
-        StreamRecorder recorder(storage, prefixInfo, face, keyChain);
-        recorder.setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
-
-        LogInfo("") << "Will fetch stream " << prefixInfo.getPrefix(prefix_filter::Stream) 
-            << " (thread " << prefixInfo.threadName_ << ")" << endl;
-
         StreamRecorder::FetchSettings settings = StreamRecorder::Default;
         settings.pipelineSize_ = args["--pipeline"].asLong();
+        settings.maxPipelineSize_ = args["--max-pipeline"].asLong();
         settings.lifetime_ = args["--lifetime"].asLong();
         settings.recordLength_ = args["--limit"].asLong();
         settings.seedFrame_ = args["--seed"].asLong();
@@ -152,7 +156,21 @@ int main(int argc, char **argv)
         if (args["--direction"].asString() == "both")
             settings.direction_ = StreamRecorder::FetchDirection::Forward | StreamRecorder::FetchDirection::Backward;
         
-        recorder.start(settings);
+        // recorders share face and storage, all fetching happens on the
+        // face's io thread
+        std::vector<boost::shared_ptr<StreamRecorder>> recorders;
+        for (auto& prefixInfo:prefixInfos)
+        {
+            boost::shared_ptr<StreamRecorder> recorder =
+                boost::make_shared<StreamRecorder>(storage, prefixInfo, face, keyChain);
+            recorder->setLogger(ndnlog::new_api::Logger::getLoggerPtr(""));
+
+            LogInfo("") << "Will fetch stream " << prefixInfo.getPrefix(prefix_filter::Stream) 
+                << " (thread " << prefixInfo.threadName_ << ")" << endl;
+
+            recorder->start(settings);
+            recorders.push_back(recorder);
+        }
 
         StreamRecorder::Stats stats;
 
@@ -160,25 +178,35 @@ int main(int argc, char **argv)
         {
             if (!args["--verbose"].asBool())
             {
-                stats = recorder.getCurrentStats();
-                cout << "\r"
-                     << "[ " << stats.deltaStored_+stats.keyStored_
-                     << " (key " << stats.keyStored_ << " / delta " << stats.deltaStored_ << ")"
-                     << " err " << stats.keyFailed_+stats.deltaFailed_ 
-                     << " (key " << stats.keyFailed_ << " / delta " << stats.deltaFailed_ << ")"
-                     << " mnfst: " << stats.manifestsStored_
-                     << " smeta: " << stats.streamMetaStored_
-                     << " tmeta: " << stats.threadMetaStored_
-                     << " seg: " << stats.totalSegmentsStored_
-                     << " key #: " << stats.latestKeyFetched_
-                     << " delta #: " << stats.latestDeltaFetched_
-                     << " pp: " << stats.pendingFrames_
-                     << " ]" << flush;
+                cout << "\r";
+                for (auto& recorder:recorders)
+                {
+                    stats = recorder->getCurrentStats();
+                    if (recorders.size() > 1)
+                        cout << recorder->getThreadName() << " ";
+                    cout << "[ " << stats.deltaStored_+stats.keyStored_
+                         << " (key " << stats.keyStored_ << " / delta " << stats.deltaStored_ << ")"
+                         << " err " << stats.keyFailed_+stats.deltaFailed_ 
+                         << " (key " << stats.keyFailed_ << " / delta " << stats.deltaFailed_ << ")";
+                    if (recorders.size() == 1)
+                        cout << " mnfst: " << stats.manifestsStored_
+                             << " smeta: " << stats.streamMetaStored_
+                             << " tmeta: " << stats.threadMetaStored_
+                             << " seg: " << stats.totalSegmentsStored_
+                             << " key #: " << stats.latestKeyFetched_
+                             << " delta #: " << stats.latestDeltaFetched_;
+                    cout << " pp: " << stats.pendingFrames_ << "/" << stats.pipelineSize_
+                         << " drd: " << (int)stats.drdMs_ << "ms"
+                         << " lag: " << (int)stats.recordingLagMs_ << "ms"
+                         << " ] ";
+                }
+                cout << flush;
             }
             usleep(30000);
         }
 
-        recorder.stop();
+        for (auto& recorder:recorders)
+            recorder->stop();
     }
 
     LogInfo("") << "Shutting down gracefully..." << endl;
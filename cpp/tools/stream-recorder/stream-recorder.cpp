@@ -17,14 +17,22 @@
 #include "../../src/network-data.hpp"
 #include "../../src/ndnrtc-object.hpp"
 #include "../../src/segment-fetcher.hpp"
+#include "../../src/drd-estimator.hpp"
+#include "../../src/estimators.hpp"
+#include "../../src/clock.hpp"
 #include "../../src/persistent-storage/fetching-task.hpp"
 
+#define DEVIATION_ALPHA 1.
+#define DRD_WINDOW_MS 1000
+#define CATCHUP_INTERVAL_MS 2000 // when behind live, try to catch up within this interval
+
 using namespace std;
 using namespace ndnrtc;
+using namespace ndnrtc::estimators;
 using namespace ndn;
 
 const StreamRecorder::FetchSettings 
-StreamRecorder::Default = {3000, StreamRecorder::FetchDirection::Forward, 0, 0, 5, 100, 30};
+StreamRecorder::Default = {3000, StreamRecorder::FetchDirection::Forward, 0, 0, 5, 100, 30, 60};
 
 namespace ndnrtc {
     class StreamRecorderImpl : public NdnRtcComponent
@@ -55,8 +63,16 @@ namespace ndnrtc {
             bool isFetching_, isFetchingStream_;
             StreamRecorder::FetchSettings settings_;
             int32_t pipelineReserve_;
+            uint32_t pipelineSize_;
             pair<uint32_t, uint32_t> fetchIndex_;
 
+            boost::shared_ptr<DrdEstimator> drdEstimator_;
+            FreqMeter segmentRate_;
+            Average segmentsPerFrame_;
+            double streamRate_;
+            PacketNumber liveDeltaNo_, liveKeyNo_;
+            int64_t liveDeltaTimestamp_;
+
             FetchingTask::Settings fetchTaskSettings_;
             boost::shared_ptr<IFetchMethod> frameFetchMethod_;
             map<Name, boost::shared_ptr<FrameFetchingTask>> fetchingTasks_;
@@ -64,9 +80,13 @@ namespace ndnrtc {
 
             void fetchStreamMeta();
             void fetchThreadMeta();
-            void initiateStreamFetching(const Blob& meta);
+            void initiateStreamFetching();
+            void updateLive(const Blob& meta);
             void requestFrame(const NamespaceInfo& frameInfo);
             void requestNextFrame(const NamespaceInfo& fetchedFrame);
+            void fillPipeline();
+            void updatePipeline(const boost::shared_ptr<const BufferSlot>& slot);
+            double getLagFrames() const;
 
             void store(const boost::shared_ptr<const Data>&d);
     };
@@ -92,7 +112,11 @@ StreamRecorderImpl::StreamRecorderImpl(const boost::shared_ptr<StorageEngine>& s
                         const boost::shared_ptr<Face>& face, 
                         const boost::shared_ptr<KeyChain> keyChain):
     storage_(storageEngine), face_(face), keyChain_(keyChain),
-    ninfo_(ninfo), isFetching_(false), isFetchingStream_(false)
+    ninfo_(ninfo), isFetching_(false), isFetchingStream_(false),
+    drdEstimator_(boost::make_shared<DrdEstimator>(150, DRD_WINDOW_MS)),
+    segmentRate_(boost::make_shared<TimeWindow>(1000)),
+    segmentsPerFrame_(boost::make_shared<SampleWindow>(30)),
+    streamRate_(0), liveDeltaNo_(0), liveKeyNo_(0), liveDeltaTimestamp_(0)
 {
     if (ninfo_.streamType_ == MediaStreamParams::MediaStreamType::MediaStreamTypeAudio)
         throw runtime_error("audio streams are not supported yet");
@@ -108,9 +132,12 @@ StreamRecorderImpl::start(const StreamRecorder::FetchSettings& settings)
         throw runtime_error("Stream recorder is already fetching");
 
     settings_ = settings;
-    pipelineReserve_ = settings_.pipelineSize_;
+    pipelineSize_ = settings_.pipelineSize_;
+    pipelineReserve_ = pipelineSize_;
     fetchTaskSettings_ = {3, settings_.lifetime_};
     memset((void*)&stats_, 0, sizeof(StreamRecorder::Stats));
+    stats_.pipelineSize_ = pipelineSize_;
+    drdEstimator_->reset();
 
     LogInfoC << "recording direction: " 
         << ((settings_.direction_ & StreamRecorder::FetchDirection::Forward) && (settings_.direction_ & StreamRecorder::FetchDirection::Backward) ? "both" : 
@@ -118,7 +145,8 @@ StreamRecorderImpl::start(const StreamRecorder::FetchSettings& settings)
         << ", seed frame: " << settings_.seedFrame_
         << ", record length: " << settings_.recordLength_
         << ", interest lifetime: " << settings_.lifetime_
-        << ", pipeline: " << settings_.pipelineSize_ << endl;
+        << ", pipeline: " << (int)settings_.pipelineSize_
+        << "-" << (int)std::max(settings_.pipelineSize_, settings_.maxPipelineSize_) << endl;
 
     isFetching_ = true;
     fetchStreamMeta();
@@ -181,11 +209,12 @@ StreamRecorderImpl::fetchThreadMeta(){
                                         store(d);
                                     }
                                     stats_.threadMetaStored_++;
+                                    updateLive(content);
 
                                     if (isFetching_)
                                     {
                                         if (!isFetchingStream_)
-                                            initiateStreamFetching(content);
+                                            initiateStreamFetching();
                                         face_->callLater(settings_.threadMetaFetchInterval_, 
                                                          boost::bind(&StreamRecorderImpl::fetchThreadMeta, me));
                                     }
@@ -199,7 +228,7 @@ StreamRecorderImpl::fetchThreadMeta(){
 }
 
 void
-StreamRecorderImpl::initiateStreamFetching(const Blob &metaBlob)
+StreamRecorderImpl::initiateStreamFetching()
 {
     isFetchingStream_ = true;
     fetchIndex_.first = settings_.seedFrame_;
@@ -207,29 +236,18 @@ StreamRecorderImpl::initiateStreamFetching(const Blob &metaBlob)
 
     if (fetchIndex_.first == 0)
     {
-        // extract latest key and delta numbers from metadata
+        // start from latest key and delta numbers from metadata
         if (ninfo_.streamType_ == MediaStreamParams::MediaStreamTypeVideo)
         {
-            ImmutableHeaderPacket<DataSegmentHeader> packet(metaBlob);
-            NetworkData nd(packet.getPayload().size(), packet.getPayload().data());
-            VideoThreadMeta threadMeta(boost::move(nd));
-
-            fetchIndex_.first = threadMeta.getSeqNo().second;
-            fetchIndex_.second = threadMeta.getSeqNo().first;
+            fetchIndex_.first = liveKeyNo_;
+            fetchIndex_.second = liveDeltaNo_;
 
             NamespaceInfo frameInfo = ninfo_;
             frameInfo.class_ = SampleClass::Key;
             frameInfo.sampleNo_ = fetchIndex_.first;
             fetchIndex_.first++;
             requestFrame(frameInfo);
-
-            while (pipelineReserve_)
-            {
-                frameInfo.class_ = SampleClass::Delta;
-                frameInfo.sampleNo_ = fetchIndex_.second;
-                fetchIndex_.second++;
-                requestFrame(frameInfo);
-            }
+            fillPipeline();
         }
         else
             throw runtime_error("audio streams are not supported yet!");
@@ -238,6 +256,25 @@ StreamRecorderImpl::initiateStreamFetching(const Blob &metaBlob)
         throw runtime_error("Seed frame is not supported yet!");
 }
 
+void
+StreamRecorderImpl::updateLive(const Blob &metaBlob)
+{
+    if (ninfo_.streamType_ != MediaStreamParams::MediaStreamTypeVideo)
+        return;
+
+    // extract latest key and delta numbers from metadata
+    ImmutableHeaderPacket<DataSegmentHeader> packet(metaBlob);
+    NetworkData nd(packet.getPayload().size(), packet.getPayload().data());
+    VideoThreadMeta threadMeta(boost::move(nd));
+
+    liveDeltaNo_ = threadMeta.getSeqNo().first;
+    liveKeyNo_ = threadMeta.getSeqNo().second;
+    liveDeltaTimestamp_ = clock::millisecondTimestamp();
+    streamRate_ = threadMeta.getRate();
+
+    stats_.recordingLagMs_ = (streamRate_ > 0 ? getLagFrames()*1000./streamRate_ : 0);
+}
+
 void StreamRecorderImpl::requestFrame(const NamespaceInfo& frameInfo)
 {
     LogDebugC << "request " << frameInfo.getSuffix(suffix_filter::Thread) 
@@ -260,8 +297,14 @@ void StreamRecorderImpl::requestFrame(const NamespaceInfo& frameInfo)
                 fetchingTasks_.erase(frameInfo.getSuffix(suffix_filter::Thread));
                 pipelineReserve_++;
 
-                for (auto s:slot->getFetchedSegments())
+                const std::vector<boost::shared_ptr<const SlotSegment>> segments = slot->getFetchedSegments();
+                for (auto s:segments)
+                {
                     store(s->getData()->getData());
+                    drdEstimator_->newValue((double)s->getDrdUsec()/1000., s->isOriginal(), s->getDgen());
+                    segmentRate_.newValue(0);
+                }
+                segmentsPerFrame_.newValue(segments.size());
 
                 if (frameInfo.class_ == SampleClass::Delta)
                 {
@@ -277,6 +320,7 @@ void StreamRecorderImpl::requestFrame(const NamespaceInfo& frameInfo)
                 LogDebugC << "stored frame " << frameInfo.getSuffix(suffix_filter::Thread) 
                          << "(" << frameInfo.sampleNo_ << ")" << endl;
 
+                updatePipeline(slot);
                 if (isFetching_)
                     requestNextFrame(frameInfo);
             },
@@ -332,13 +376,83 @@ void StreamRecorderImpl::requestFrame(const NamespaceInfo& frameInfo)
 void
 StreamRecorderImpl::requestNextFrame(const NamespaceInfo& fetchedFrame)
 {
-    NamespaceInfo nextFrame(fetchedFrame);
-    if (nextFrame.class_ == SampleClass::Key)
+    // one Key frame is always requested, the rest of the pipeline is
+    // filled with Delta frames
+    if (fetchedFrame.class_ == SampleClass::Key)
+    {
+        NamespaceInfo nextFrame(fetchedFrame);
         nextFrame.sampleNo_ = fetchIndex_.first++;
-    else
-        nextFrame.sampleNo_ = fetchIndex_.second++;
+        requestFrame(nextFrame);
+    }
+
+    fillPipeline();
+}
+
+void
+StreamRecorderImpl::fillPipeline()
+{
+    NamespaceInfo frameInfo = ninfo_;
+    frameInfo.class_ = SampleClass::Delta;
+
+    while (pipelineReserve_ > 0)
+    {
+        frameInfo.sampleNo_ = fetchIndex_.second++;
+        requestFrame(frameInfo);
+    }
+}
+
+void
+StreamRecorderImpl::updatePipeline(const boost::shared_ptr<const BufferSlot>& slot)
+{
+    const Average& drd = drdEstimator_->getLatestUpdatedAverage();
+    double lagFrames = getLagFrames();
+
+    stats_.drdMs_ = drd.value();
+    stats_.segmentRate_ = segmentRate_.value();
+    stats_.recordingLagMs_ = (streamRate_ > 0 ? lagFrames*1000./streamRate_ : 0);
+
+    if (settings_.maxPipelineSize_ <= settings_.pipelineSize_ || drd.count() == 0)
+        return;
+
+    // frame is fetched once its' last segment arrives: frame delay is DRD
+    // plus the time to receive all segments of a frame at current rate
+    double frameDelayMs = drd.value() + DEVIATION_ALPHA*drd.deviation();
+    if (segmentRate_.value() > 0)
+        frameDelayMs += 1000.*segmentsPerFrame_.value()/segmentRate_.value();
+
+    // frames must be requested at stream rate plus the rate that allows to
+    // catch up with live edge; pipeline covers frame delay at that rate
+    double rate = (streamRate_ > 0 ? streamRate_ : slot->getHeader().sampleRate_);
+    double targetRate = rate + lagFrames*1000./CATCHUP_INTERVAL_MS;
+    int newSize = (int)ceil(frameDelayMs*targetRate/1000. + 0.5);
+
+    newSize = std::max(newSize, (int)settings_.pipelineSize_);
+    newSize = std::min(newSize, (int)settings_.maxPipelineSize_);
+
+    if (newSize != (int)pipelineSize_)
+    {
+        LogDebugC << "pipeline " << pipelineSize_ << " -> " << newSize
+                  << " (frame delay " << frameDelayMs << "ms, rate " << targetRate
+                  << ", lag " << lagFrames << " frames)" << endl;
+
+        pipelineReserve_ += newSize - (int)pipelineSize_;
+        pipelineSize_ = newSize;
+        stats_.pipelineSize_ = pipelineSize_;
+    }
+}
+
+double
+StreamRecorderImpl::getLagFrames() const
+{
+    if (!liveDeltaTimestamp_ || !stats_.deltaStored_)
+        return 0;
+
+    // live edge has moved since last thread meta was received
+    double liveDeltaNo = liveDeltaNo_ +
+        (clock::millisecondTimestamp() - liveDeltaTimestamp_)*streamRate_/1000.;
+    double lag = liveDeltaNo - stats_.latestDeltaFetched_;
 
-    requestFrame(nextFrame);
+    return (lag > 0 ? lag : 0);
 }
 
 void
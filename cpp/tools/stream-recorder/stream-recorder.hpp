@@ -40,6 +40,15 @@ namespace ndnrtc {
      * frame).
      * StreamRecroder can be intialized for fetching N frames. In this case, only
      * data packets associated with N frames (Key and Delta) will be fetched.
+     * Fetching pipeline (number of frames requested at a time) starts with
+     * pipelineSize_ frames and is adjusted as frames arrive, up to
+     * maxPipelineSize_: it is sized to cover measured DRD plus the time it
+     * takes to receive all segments of a frame at measured segment rate, for
+     * the stream's frame rate plus the rate needed to catch up with the live
+     * edge. Setting maxPipelineSize_ not greater than pipelineSize_ disables
+     * adjustment.
+     * One StreamRecorder records one thread; several recorders may share
+     * the face and the storage in order to record several threads at once.
      */
     class StreamRecorder {
         public: 
@@ -56,6 +65,7 @@ namespace ndnrtc {
             uint32_t recordLength_;
             uint8_t pipelineSize_;
             uint32_t streamMetaFetchInterval_, threadMetaFetchInterval_;
+            uint8_t maxPipelineSize_;
         } FetchSettings;
 
         typedef struct _Stats {
@@ -67,6 +77,9 @@ namespace ndnrtc {
             uint64_t totalSegmentsStored_;
             size_t deltaFailed_, keyFailed_;
             size_t pendingFrames_;
+            size_t pipelineSize_;
+            double drdMs_, segmentRate_;
+            double recordingLagMs_; // how far latest fetched frame is behind live
         } Stats;
 
         static const FetchSettings Default;